@@ -142,8 +142,9 @@ syntax keyword vifmOption contained aproposprg autocd autochpos caseoptions
 		\ cdpath cd chaselinks classify columns co confirm cf cpoptions cpo
 		\ cvoptions deleteprg dotdirs dotfiles dirsize fastrun fillchars fcs findprg
 		\ followlinks fusehome gdefault grepprg histcursor history hi hlsearch hls
-		\ iec ignorecase ic iooptions incsearch is laststatus lines locateprg ls
-		\ lsoptions lsview mediaprg milleroptions millerview mintimeoutlen mouse
+		\ iec ignorecase ic iooptions incsearch is laststatus lines locateprg
+		\ locateroots ls lsoptions lsview mediaprg milleroptions millerview
+		\ mintimeoutlen mouse
 		\ navoptions number nu numberwidth nuw previewoptions previewprg quickview
 		\ relativenumber rnu rulerformat ruf runexec scrollbind scb scrolloff
 		\ sessionoptions ssop so sort sortgroups sortorder sortnumbers shell sh
@@ -24,6 +24,9 @@
 #define MYVIFMRC_EV "MYVIFMRC"
 #define TRASH "Trash"
 #define LOG "log"
+#define FPCACHE "fpcache"
+#define VCACHE "vcache"
+#define LOCATE_INDEX "locate-index"
 #define VIFMRC "vifmrc"
 
 #ifndef __APPLE__
@@ -170,6 +173,7 @@ cfg_init(void)
 			"-type d \\( ! -readable -o ! -executable \\) -prune");
 	cfg.grep_prg = strdup("grep -n -H -I -r %i %a %s");
 	cfg.locate_prg = strdup("locate %a");
+	cfg.locate_roots = strdup("~");
 	cfg.delete_prg = strdup("");
 	cfg.media_prg = format_str("%s/" SAMPLE_MEDIAPRG, get_installed_data_dir());
 
@@ -205,6 +209,8 @@ cfg_init(void)
 	cfg.hard_graphics_clear = 0;
 	cfg.top_tree_stats = 0;
 	cfg.max_tree_depth = 0;
+	cfg.preview_prefetch = 0;
+	cfg.preview_disk_cache = 0;
 
 	cfg.timeout_len = 1000;
 	cfg.min_timeout_len = 150;
@@ -219,6 +225,9 @@ cfg_init(void)
 	cfg.view_dir_size = VDS_SIZE;
 
 	cfg.log_file[0] = '\0';
+	cfg.fpcache_file[0] = '\0';
+	cfg.vcache_dir[0] = '\0';
+	cfg.locate_index_file[0] = '\0';
 
 	cfg_set_shell(env_get_def("SHELL", DEFAULT_SHELL_CMD));
 	cfg.shell_cmd_flag = strdup((curr_stats.shell_type == ST_CMD) ? "/C" : "-c");
@@ -601,6 +610,10 @@ store_config_paths(const char data_dir[])
 	free(trash_base);
 
 	snprintf(cfg.log_file, sizeof(cfg.log_file), "%s/" LOG, base);
+	snprintf(cfg.fpcache_file, sizeof(cfg.fpcache_file), "%s/" FPCACHE, base);
+	snprintf(cfg.vcache_dir, sizeof(cfg.vcache_dir), "%s/" VCACHE, base);
+	snprintf(cfg.locate_index_file, sizeof(cfg.locate_index_file),
+			"%s/" LOCATE_INDEX, base);
 
 	char *fuse_home = format_str("%s/fuse/", base);
 	(void)cfg_set_fuse_home(fuse_home);
@@ -180,6 +180,12 @@ typedef struct config_t
 	/* This one should be set using trash_set_specs() function. */
 	char trash_dir[PATH_MAX + 64];
 	char log_file[PATH_MAX + 8];
+	/* File of persistent cache of fingerprints or an empty string. */
+	char fpcache_file[PATH_MAX + 16];
+	/* Directory of persistent cache of previews or an empty string. */
+	char vcache_dir[PATH_MAX + 16];
+	/* File of index of file names for :locate or an empty string. */
+	char locate_index_file[PATH_MAX + 16];
 	char *vi_command;
 	int vi_cmd_bg;
 	char *vi_x_command;
@@ -267,6 +273,8 @@ typedef struct config_t
 	char *find_prg;    /* find tool calling pattern. */
 	char *grep_prg;    /* grep tool calling pattern. */
 	char *locate_prg;  /* locate tool calling pattern. */
+	/* Comma-separated list of directories indexed for built-in :locate. */
+	char *locate_roots;
 	char *delete_prg;  /* File removal application. */
 	char *media_prg;   /* Helper for managing media devices. */
 
@@ -331,6 +339,10 @@ typedef struct config_t
 	int top_tree_stats;
 	/* Max depth of preview tree.  Zero means "no limit". */
 	int max_tree_depth;
+	/* Number of neighbouring files to preview in advance.  Zero disables it. */
+	int preview_prefetch;
+	/* Size of persistent cache of previews in MiB.  Zero disables it. */
+	int preview_disk_cache;
 
 	int timeout_len;     /* Maximum period on waiting for the input. */
 	int min_timeout_len; /* Minimum period on waiting for the input. */
@@ -2249,6 +2249,8 @@ store_global_options(JSON_Object *root)
 	append_dstr(options, format_str("lines=%d", cfg.lines));
 	append_dstr(options, format_str("locateprg=%s",
 				escape_spaces(cfg.locate_prg)));
+	append_dstr(options, format_str("locateroots=%s",
+				escape_spaces(cfg.locate_roots)));
 	append_dstr(options, format_str("mediaprg=%s",
 				escape_spaces(cfg.media_prg)));
 	append_dstr(options, format_str("mintimeoutlen=%d", cfg.min_timeout_len));
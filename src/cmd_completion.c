@@ -542,6 +542,8 @@ complete_compare(const char str[])
 
 		{ "withicase",       "force ignoring case on comparing names" },
 		{ "withrcase",       "force respecting case on comparing names" },
+
+		{ "withbytecmp",     "verify matched contents byte-by-byte" },
 	};
 
 	complete_from_string_list(str, lines, ARRAY_LEN(lines), 0);
@@ -996,8 +996,9 @@ static struct
 	/* For :find command. */
 	struct
 	{
-		char *last_args;   /* Last arguments passed to the command */
-		int includes_path; /* Whether last_args contains path to search in. */
+		char *last_args; /* Last arguments passed to the command */
+		char *path;      /* Parsed path to search in from last_args or NULL. */
+		char *pattern;   /* Part of last_args after the path or NULL. */
 	}
 	find;
 }
@@ -2171,6 +2172,11 @@ parse_compare_properties(const cmd_info_t *cmd_info, CompareType *ct,
 			*flags |= CF_RESPECT_CASE;
 		}
 
+		else if(strcmp(property, "withbytecmp") == 0)
+		{
+			*flags |= CF_BYTE_CHECK;
+		}
+
 		else
 		{
 			ui_sb_errf("Unknown comparison property: %s", property);
@@ -2647,12 +2653,14 @@ find_cmd(const cmd_info_t *cmd_info)
 {
 	if(cmd_info->argc > 0)
 	{
-		if(cmd_info->argc == 1)
-			cmds_state.find.includes_path = 0;
-		else if(is_dir(cmd_info->argv[0]))
-			cmds_state.find.includes_path = 1;
-		else
-			cmds_state.find.includes_path = 0;
+		update_string(&cmds_state.find.path, NULL);
+		update_string(&cmds_state.find.pattern, NULL);
+		if(cmd_info->argc > 1 && is_dir(cmd_info->argv[0]))
+		{
+			update_string(&cmds_state.find.path, cmd_info->argv[0]);
+			update_string(&cmds_state.find.pattern,
+					cmd_info->args + cmd_info->argvp[1][0]);
+		}
 
 		(void)replace_string(&cmds_state.find.last_args, cmd_info->args);
 	}
@@ -2662,7 +2670,13 @@ find_cmd(const cmd_info_t *cmd_info)
 		return CMDS_ERR_CUSTOM;
 	}
 
-	return show_find_menu(curr_view, cmds_state.find.includes_path,
+	const char *pattern = cmds_state.find.pattern;
+	if(pattern == NULL)
+	{
+		pattern = cmds_state.find.last_args;
+	}
+
+	return show_find_menu(curr_view, cmds_state.find.path, pattern,
 			cmds_state.find.last_args) != 0;
 }
 
@@ -5783,7 +5797,8 @@ TSTATIC void
 cmds_drop_state(void)
 {
 	update_string(&cmds_state.find.last_args, NULL);
-	cmds_state.find.includes_path = 0;
+	update_string(&cmds_state.find.path, NULL);
+	update_string(&cmds_state.find.pattern, NULL);
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
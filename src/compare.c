@@ -20,11 +20,12 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* size_t */
-#include <stdint.h> /* INTPTR_MAX INT64_MAX */
-#include <stdio.h> /* FILE fclose() feof() fopen() fread() */
-#include <stdlib.h> /* free() malloc() */
+#include <stdint.h> /* INTPTR_MAX INT64_MAX uint64_t */
+#include <stdio.h> /* FILE fclose() feof() ferror() fopen() fread() */
+#include <stdlib.h> /* calloc() free() malloc() */
 #include <string.h> /* memcmp() */
 
+#include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "compat/reallocarray.h"
@@ -33,9 +34,11 @@
 #include "ui/statusbar.h"
 #include "ui/ui.h"
 #include "utils/dynarray.h"
+#include "utils/fpcache.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
 #include "utils/macros.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -63,28 +66,97 @@
  *       * compute contents fingerprint for current file and insert it
  *   - there is more than one conflicting file:
  *       * compute contents fingerprint for current file and insert it
+ *
+ * Reading files is what takes most of the time, so before doing the above
+ * contents fingerprints of files which are certain to need them (those that
+ * share size with some other file) are computed in parallel.  The rest of the
+ * algorithm then just picks them up, which keeps results the same as if
+ * everything was done sequentially.
+ *
+ * Matching fingerprints don't guarantee identical contents, so files are
+ * compared by 128-bit digests of their full contents, which are computed at
+ * most once per file and then kept in compare records.  Byte-by-byte
+ * comparison is performed only if requested.
+ *
+ * Computed fingerprints and digests are also stored in a persistent cache,
+ * which allows skipping reading of files that haven't changed since the last
+ * comparison.
  */
 
-/* This is the only unit that uses xxhash, so import it directly here. */
+/* Import xxhash directly, it's used only by a couple of units. */
 #define XXH_PRIVATE_API
 #include "utils/xxhash.h"
 
 /* Amount of data to read at once. */
 #define BLOCK_SIZE (32*1024)
 
-/* Amount of data to hash for coarse comparison. */
+/* Amount of data to hash for coarse comparison.  Changing this requires
+ * discarding contents of persistent cache of fingerprints. */
 #define PREFIX_SIZE (4*1024)
 
+/* Limits on number of files in persistent cache of fingerprints. */
+#define FPCACHE_MIN_CAPACITY (64*1024)
+#define FPCACHE_MAX_CAPACITY (1024*1024)
+
+/* State of lazily computed digest of full contents of a file. */
+typedef enum
+{
+	DS_PENDING, /* Digest wasn't computed yet. */
+	DS_READY,   /* Digest was computed successfully. */
+	DS_FAILED,  /* Digest couldn't be computed. */
+}
+DigestState;
+
+/* Lazily computed digest of full contents of a file. */
+typedef struct
+{
+	DigestState state;       /* State of the digest. */
+	fpcache_digest_t digest; /* The digest itself if it's ready. */
+}
+full_digest_t;
+
 /* Entry in singly-bounded list of files that have matched fingerprints. */
 typedef struct compare_record_t
 {
 	char *path;                    /* Full path to file with sample content. */
+	char *fingerprint;             /* Precomputed contents fingerprint or NULL. */
+	full_digest_t digest;          /* Digest of full contents of the file. */
 	int id;                        /* Chosen id. */
 	int is_partial;                /* Shows that fingerprinting was lazy. */
 	struct compare_record_t *next; /* Next entry in the list of conflicts. */
+	struct compare_record_t *last; /* Last entry of the list (head only). */
 }
 compare_record_t;
 
+/* Entry of a list of files sorted by size. */
+typedef struct
+{
+	unsigned long long size; /* Size of the file. */
+	int idx;                 /* Index of the file in the list of entries. */
+}
+size_bucket_t;
+
+/* State of computing contents fingerprints in parallel. */
+typedef struct
+{
+	const entries_t *list;    /* Entries to process. */
+	const strlist_t *paths;   /* Paths of entries indexed by their tags. */
+	const int *order;         /* Indexes of entries to process. */
+	int count;                /* Number of elements in the order array. */
+	char **fingerprints;      /* Output fingerprints indexed like the list. */
+	int last_progress;        /* Last reported progress in percents. */
+}
+prefetch_t;
+
+/* Persistent cache of fingerprints, which is open only while comparing files by
+ * their contents. */
+static fpcache_t *fpcache;
+/* Number of files listed for comparison while the cache is open. */
+static int fpcache_nfiles;
+
+static void open_fingerprint_cache(CompareType ct);
+static void reserve_fingerprint_cache(int nfiles);
+static void close_fingerprint_cache(void);
 static void make_unique_lists(entries_t curr, entries_t other);
 static void leave_only_dups(entries_t *curr, entries_t *other);
 static int is_not_duplicate(view_t *view, const dir_entry_t *entry, void *arg);
@@ -106,13 +178,25 @@ static void list_files_recursively(const view_t *view, const char path[],
 		int skip_dot_files, strlist_t *list);
 static char * get_file_fingerprint(const char path[], const dir_entry_t *entry,
 		CompareType ct, int flags, int lazy);
+static char ** prefetch_fingerprints(trie_t *trie, const entries_t *list,
+		const strlist_t *paths, int dups_only);
+static int size_bucket_sorter(const void *first, const void *second);
+static void prefetch_fingerprint(int idx, int worker, void *arg);
+static void report_progress(const char what[], int i, int total,
+		int *last_progress);
 static char * get_contents_fingerprint(const char path[],
 		unsigned long long size);
 static int add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
-		CompareType ct, int dups_only, int flags, int *next_id);
+		CompareType ct, int dups_only, int flags, int *next_id,
+		const char precomputed[]);
+static int contents_match(const char a_path[], full_digest_t *a_digest,
+		const char b_path[], full_digest_t *b_digest, int flags);
+static int ensure_digest(const char path[], full_digest_t *digest);
+static int get_contents_digest(const char path[], fpcache_digest_t *digest);
 static int files_are_identical(const char a[], const char b[]);
-static void put_file_id(trie_t *trie, const char path[],
-		const char fingerprint[], int id, int is_partial, CompareType ct);
+static compare_record_t * put_file_id(trie_t *trie, const char path[],
+		const char fingerprint[], int id, int is_partial, CompareType ct,
+		const char precomputed[]);
 static void free_compare_records(void *ptr);
 static void compare_move_entry(ops_t *ops, view_t *from, view_t *to, int idx);
 
@@ -138,10 +222,12 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 
 	trie_t *const trie = trie_create(&free_compare_records);
 	ui_cancellation_push_on();
+	open_fingerprint_cache(ct);
 
 	curr = make_diff_list(trie, curr_view, &next_id, ct, /*dups_only=*/0, flags);
 	other = make_diff_list(trie, other_view, &next_id, ct, lt == LT_DUPS, flags);
 
+	close_fingerprint_cache();
 	ui_cancellation_pop();
 	trie_free(trie);
 
@@ -227,6 +313,54 @@ compare_two_panes(CompareType ct, ListType lt, int flags)
 	return 0;
 }
 
+/* Opens persistent cache of fingerprints if it's going to be used for the
+ * specified type of comparison. */
+static void
+open_fingerprint_cache(CompareType ct)
+{
+	assert(fpcache == NULL && "Cache of fingerprints is already open.");
+	if(ct == CT_CONTENTS && cfg.fpcache_file[0] != '\0')
+	{
+		fpcache = fpcache_open(cfg.fpcache_file, FPCACHE_MIN_CAPACITY);
+		fpcache_nfiles = 0;
+	}
+}
+
+/* Grows persistent cache of fingerprints if it's open to make it big enough
+ * for files of all lists that are being compared. */
+static void
+reserve_fingerprint_cache(int nfiles)
+{
+	if(fpcache == NULL)
+	{
+		return;
+	}
+
+	fpcache_nfiles += nfiles;
+
+	/* Records are spread unevenly, so leave some room and grow the cache in big
+	 * steps to not recreate it on every comparison. */
+	int capacity = fpcache_capacity(fpcache);
+	while(capacity < fpcache_nfiles*2 && capacity < FPCACHE_MAX_CAPACITY)
+	{
+		capacity *= 2;
+	}
+
+	if(capacity != fpcache_capacity(fpcache))
+	{
+		fpcache_close(fpcache);
+		fpcache = fpcache_open(cfg.fpcache_file, capacity);
+	}
+}
+
+/* Closes persistent cache of fingerprints if it's open. */
+static void
+close_fingerprint_cache(void)
+{
+	fpcache_close(fpcache);
+	fpcache = NULL;
+}
+
 /* Composes two views containing only files that are unique to each of them.
  * Assumes that both lists are sorted by id. */
 static void
@@ -605,9 +739,11 @@ compare_one_pane(view_t *view, CompareType ct, ListType lt, int flags)
 
 	trie_t *trie = trie_create(&free_compare_records);
 	ui_cancellation_push_on();
+	open_fingerprint_cache(ct);
 
 	curr = make_diff_list(trie, view, &next_id, ct, /*dups_only=*/0, flags);
 
+	close_fingerprint_cache();
 	ui_cancellation_pop();
 	trie_free(trie);
 
@@ -717,7 +853,7 @@ make_diff_list(trie_t *trie, view_t *view, int *next_id, CompareType ct,
 {
 	const int skip_empty = flags & CF_SKIP_EMPTY;
 
-	int i;
+	int i, j;
 	strlist_t files = {};
 	entries_t r = {};
 	int last_progress = 0;
@@ -732,11 +868,11 @@ make_diff_list(trie_t *trie, view_t *view, int *next_id, CompareType ct,
 	{
 		list_files_recursively(view, flist_get_dir(view), view->hide_dot, &files);
 	}
+	reserve_fingerprint_cache(files.nitems);
 
 	show_progress("Querying...", 0);
 	for(i = 0; i < files.nitems && !ui_cancellation_requested(); ++i)
 	{
-		int progress;
 		const char *const path = files.items[i];
 		dir_entry_t *const entry = entry_list_add(view, &r.entries, &r.nentries,
 				path);
@@ -755,31 +891,193 @@ make_diff_list(trie_t *trie, view_t *view, int *next_id, CompareType ct,
 		}
 
 		entry->tag = i;
+		report_progress("Querying...", i, files.nitems, &last_progress);
+	}
+
+	char **fingerprints = NULL;
+	if(ct == CT_CONTENTS && !ui_cancellation_requested())
+	{
+		fingerprints = prefetch_fingerprints(trie, &r, &files, dups_only);
+	}
+
+	last_progress = 0;
+	show_progress("Comparing...", 0);
+	for(i = 0, j = 0; i < r.nentries; ++i)
+	{
+		dir_entry_t *const entry = &r.entries[i];
+		if(ui_cancellation_requested())
+		{
+			fentry_free(entry);
+			continue;
+		}
+
+		const char *const path = files.items[entry->tag];
 		entry->id = add_file_to_diff(trie, path, entry, ct, dups_only, flags,
-				next_id);
+				next_id, (fingerprints == NULL ? NULL : fingerprints[i]));
 
 		if(entry->id == -1)
 		{
 			fentry_free(entry);
-			--r.nentries;
+			continue;
 		}
 
-		progress = (i*100)/files.nitems;
-		if(progress != last_progress)
+		if(i != j)
 		{
-			char progress_msg[128];
-
-			last_progress = progress;
-			snprintf(progress_msg, sizeof(progress_msg), "Querying... %d (% 2d%%)", i,
-					progress);
-			show_progress(progress_msg, -1);
+			r.entries[j] = *entry;
 		}
+		++j;
+
+		report_progress("Comparing...", i, r.nentries, &last_progress);
 	}
 
+	if(fingerprints != NULL)
+	{
+		free_string_array(fingerprints, r.nentries);
+	}
+	r.nentries = j;
+
 	free_string_array(files.items, files.nitems);
 	return r;
 }
 
+/* Computes contents fingerprints in parallel for files that are certain to
+ * need them because their size matches size of some other file.  Files are
+ * processed in groups by size.  Returns array of fingerprints (NULL for
+ * unprocessed files) indexed like list entries or NULL on error. */
+static char **
+prefetch_fingerprints(trie_t *trie, const entries_t *list,
+		const strlist_t *paths, int dups_only)
+{
+	int i, j;
+	int count = 0;
+
+	if(list->nentries == 0)
+	{
+		return NULL;
+	}
+
+	size_bucket_t *const buckets = reallocarray(NULL, list->nentries,
+			sizeof(*buckets));
+	int *const order = reallocarray(NULL, list->nentries, sizeof(*order));
+	char **const fingerprints = calloc(list->nentries, sizeof(*fingerprints));
+	if(buckets == NULL || order == NULL || fingerprints == NULL)
+	{
+		free(buckets);
+		free(order);
+		free(fingerprints);
+		return NULL;
+	}
+
+	for(i = 0; i < list->nentries; ++i)
+	{
+		buckets[i].size = list->entries[i].size;
+		buckets[i].idx = i;
+	}
+	safe_qsort(buckets, list->nentries, sizeof(*buckets), &size_bucket_sorter);
+
+	for(i = 0; i < list->nentries; i = j)
+	{
+		for(j = i + 1; j < list->nentries; ++j)
+		{
+			if(buckets[j].size != buckets[i].size)
+			{
+				break;
+			}
+		}
+
+		/* Duplicates-only mode doesn't add files to the trie, so files of this list
+		 * can only match files from the trie. */
+		int shared = (!dups_only && j - i > 1);
+		if(!shared)
+		{
+			char size_fingerprint[32];
+			void *data;
+			snprintf(size_fingerprint, sizeof(size_fingerprint), "%" PRINTF_ULL,
+					buckets[i].size);
+			shared = (trie_get(trie, size_fingerprint, &data) == 0);
+		}
+
+		if(shared)
+		{
+			int k;
+			for(k = i; k < j; ++k)
+			{
+				order[count++] = buckets[k].idx;
+			}
+		}
+	}
+
+	prefetch_t prefetch = {
+		.list = list,
+		.paths = paths,
+		.order = order,
+		.count = count,
+		.fingerprints = fingerprints,
+	};
+
+	show_progress("Hashing...", 0);
+	(void)parallel_for(count, parallel_get_nworkers(), &prefetch_fingerprint,
+			&prefetch, &ui_cancellation_info);
+
+	free(buckets);
+	free(order);
+	return fingerprints;
+}
+
+/* qsort() comparer that sorts files by size in ascending order keeping
+ * original order of files of the same size.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+size_bucket_sorter(const void *first, const void *second)
+{
+	const size_bucket_t *a = first;
+	const size_bucket_t *b = second;
+	if(a->size != b->size)
+	{
+		return (a->size < b->size ? -1 : 1);
+	}
+	return a->idx - b->idx;
+}
+
+/* Computes contents fingerprint of a single file.  Implements parallel_func
+ * for parallel_for(). */
+static void
+prefetch_fingerprint(int idx, int worker, void *arg)
+{
+	prefetch_t *const prefetch = arg;
+	const int entry_idx = prefetch->order[idx];
+	const dir_entry_t *const entry = &prefetch->list->entries[entry_idx];
+	const char *const path = prefetch->paths->items[entry->tag];
+
+	prefetch->fingerprints[entry_idx] = get_contents_fingerprint(path,
+			entry->size);
+
+	/* Only the main thread can interact with the user.  Items are handed out in
+	 * order, so index of the item is a good enough estimation of progress. */
+	if(worker == 0)
+	{
+		report_progress("Hashing...", idx, prefetch->count,
+				&prefetch->last_progress);
+	}
+}
+
+/* Displays progress of a long stage of comparison if it has changed since the
+ * last call. */
+static void
+report_progress(const char what[], int i, int total, int *last_progress)
+{
+	const int progress = (i*100)/total;
+	if(progress != *last_progress)
+	{
+		char progress_msg[128];
+
+		*last_progress = progress;
+		snprintf(progress_msg, sizeof(progress_msg), "%s %d (% 2d%%)", what, i,
+				progress);
+		show_progress(progress_msg, -1);
+	}
+}
+
 /* Fills the list with entries of the view in hierarchical order (pre-order tree
  * traversal). */
 static void
@@ -945,6 +1243,19 @@ get_file_fingerprint(const char path[], const dir_entry_t *entry,
 static char *
 get_contents_fingerprint(const char path[], unsigned long long size)
 {
+	/* Information about the file is obtained only when it's going to be used,
+	 * the size must match to not cache a digest of a file that has changed. */
+	fpcache_key_t key;
+	const int cacheable = (fpcache != NULL && fpcache_key_of(path, &key) == 0 &&
+			key.size == size);
+
+	uint64_t digest;
+	if(cacheable && fpcache_get_prefix(fpcache, &key, &digest) == 0)
+	{
+		return format_str("%" PRINTF_ULL "|%" PRINTF_ULL, size,
+				(unsigned long long)digest);
+	}
+
 	char block[BLOCK_SIZE];
 	size_t to_read = PREFIX_SIZE;
 	FILE *in = os_fopen(path, "rb");
@@ -967,12 +1278,14 @@ get_contents_fingerprint(const char path[], unsigned long long size)
 		return strdup("");
 	}
 
+	int error = 0;
 	while(to_read != 0U)
 	{
 		const size_t portion = MIN(sizeof(block), to_read);
 		const size_t nread = fread(&block, 1, portion, in);
 		if(nread == 0U)
 		{
+			error = ferror(in);
 			break;
 		}
 
@@ -981,17 +1294,24 @@ get_contents_fingerprint(const char path[], unsigned long long size)
 	}
 	fclose(in);
 
-	const unsigned long long digest = XXH3_64bits_digest(st);
+	digest = XXH3_64bits_digest(st);
 	XXH3_freeState(st);
 
-	return format_str("%" PRINTF_ULL "|%" PRINTF_ULL, size, digest);
+	if(cacheable && !error)
+	{
+		fpcache_set_prefix(fpcache, &key, digest);
+	}
+
+	return format_str("%" PRINTF_ULL "|%" PRINTF_ULL, size,
+			(unsigned long long)digest);
 }
 
 /* Looks up file in the trie by its fingerprint.  Returns id for the file or -1
  * if it should be skipped. */
 static int
 add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
-		CompareType ct, int dups_only, int flags, int *next_id)
+		CompareType ct, int dups_only, int flags, int *next_id,
+		const char precomputed[])
 {
 	char *fingerprint = get_file_fingerprint(path, entry, ct, flags, /*lazy=*/1);
 	if(is_null_or_empty(fingerprint))
@@ -1007,6 +1327,7 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 
 	compare_record_t *record = data;
 	int is_partial = (ct == CT_CONTENTS);
+	full_digest_t digest = { .state = DS_PENDING };
 
 	/* Comparison by contents is the only one when we need to account for lazy
 	 * fingerprint computation or resolve fingerprint conflicts. */
@@ -1015,7 +1336,9 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 		free(fingerprint);
 		is_partial = 0;
 
-		fingerprint = get_file_fingerprint(path, entry, ct, flags, /*lazy=*/0);
+		fingerprint = (precomputed == NULL)
+		            ? get_file_fingerprint(path, entry, ct, flags, /*lazy=*/0)
+		            : strdup(precomputed);
 		if(is_null_or_empty(fingerprint))
 		{
 			/* In case we couldn't obtain fingerprint (e.g., comparing by contents and
@@ -1028,8 +1351,10 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 		{
 			/* There is another file of the same size whose contents fingerprint
 			 * hasn't been computed yet.  Do it here. */
-			char *other_fingerprint = get_contents_fingerprint(record->path,
-					entry->size);
+			char *other_fingerprint = (record->fingerprint == NULL)
+			                         ? get_contents_fingerprint(record->path,
+			                                                    entry->size)
+			                         : strdup(record->fingerprint);
 			if(is_null_or_empty(fingerprint))
 			{
 				/* That other file has issues, don't update it and skip any other file
@@ -1041,7 +1366,7 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 			}
 
 			put_file_id(trie, record->path, other_fingerprint, record->id,
-					/*is_partial=*/0, ct);
+					/*is_partial=*/0, ct, /*precomputed=*/NULL);
 			free(other_fingerprint);
 
 			record->is_partial = 0;
@@ -1053,15 +1378,14 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 
 		/* Fingerprint does not guarantee a match, go through files and find file
 		 * with identical contents. */
-		do
+		while(record != NULL)
 		{
-			if(files_are_identical(path, record->path))
+			if(contents_match(path, &digest, record->path, &record->digest, flags))
 			{
 				break;
 			}
 			record = record->next;
 		}
-		while(record != NULL);
 	}
 
 	if(record != NULL)
@@ -1078,12 +1402,108 @@ add_file_to_diff(trie_t *trie, const char path[], dir_entry_t *entry,
 
 	int id = *next_id;
 	++*next_id;
-	put_file_id(trie, path, fingerprint, id, is_partial, ct);
+	record = put_file_id(trie, path, fingerprint, id, is_partial, ct,
+			is_partial ? precomputed : NULL);
+	if(record != NULL)
+	{
+		/* Keep digest if it was computed to not do it again. */
+		record->digest = digest;
+	}
 
 	free(fingerprint);
 	return id;
 }
 
+/* Checks whether two files hold identical content by comparing digests of
+ * their contents, which are computed if necessary.  Performs byte-by-byte
+ * comparison if flags contain CF_BYTE_CHECK.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+contents_match(const char a_path[], full_digest_t *a_digest,
+		const char b_path[], full_digest_t *b_digest, int flags)
+{
+	if(!ensure_digest(a_path, a_digest) || !ensure_digest(b_path, b_digest))
+	{
+		return 0;
+	}
+
+	if(a_digest->digest.low != b_digest->digest.low ||
+			a_digest->digest.high != b_digest->digest.high)
+	{
+		return 0;
+	}
+
+	return !(flags & CF_BYTE_CHECK) || files_are_identical(a_path, b_path);
+}
+
+/* Computes digest of full contents of a file unless it was attempted before.
+ * Returns non-zero if digest is available, otherwise zero is returned. */
+static int
+ensure_digest(const char path[], full_digest_t *digest)
+{
+	if(digest->state == DS_PENDING)
+	{
+		digest->state = (get_contents_digest(path, &digest->digest) == 0)
+		              ? DS_READY
+		              : DS_FAILED;
+	}
+	return (digest->state == DS_READY);
+}
+
+/* Computes 128-bit digest of full contents of a file.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+get_contents_digest(const char path[], fpcache_digest_t *digest)
+{
+	fpcache_key_t key;
+	const int cacheable = (fpcache != NULL && fpcache_key_of(path, &key) == 0);
+	if(cacheable && fpcache_get_full(fpcache, &key, digest) == 0)
+	{
+		return 0;
+	}
+
+	FILE *const in = os_fopen(path, "rb");
+	if(in == NULL)
+	{
+		return 1;
+	}
+
+	XXH3_state_t *const st = XXH3_createState();
+	if(st == NULL || XXH3_128bits_reset(st) == XXH_ERROR)
+	{
+		XXH3_freeState(st);
+		fclose(in);
+		return 1;
+	}
+
+	char block[BLOCK_SIZE];
+	size_t nread;
+	while((nread = fread(&block, 1, sizeof(block), in)) != 0U)
+	{
+		XXH3_128bits_update(st, block, nread);
+	}
+
+	const int error = ferror(in);
+	fclose(in);
+
+	const XXH128_hash_t hash = XXH3_128bits_digest(st);
+	XXH3_freeState(st);
+
+	if(error)
+	{
+		return 1;
+	}
+
+	digest->low = hash.low64;
+	digest->high = hash.high64;
+
+	if(cacheable)
+	{
+		fpcache_set_full(fpcache, &key, digest);
+	}
+	return 0;
+}
+
 /* Checks whether two files specified by their names hold identical content.
  * Returns non-zero if so, otherwise zero is returned. */
 static int
@@ -1130,37 +1550,51 @@ files_are_identical(const char a[], const char b[])
 	return 1;
 }
 
-/* Stores id of a file with given fingerprint in the trie. */
-static void
+/* Stores id of a file with given fingerprint in the trie.  precomputed is
+ * contents fingerprint of a partial record if it's known or NULL.  Returns
+ * newly added record or NULL on error. */
+static compare_record_t *
 put_file_id(trie_t *trie, const char path[], const char fingerprint[], int id,
-		int is_partial, CompareType ct)
+		int is_partial, CompareType ct, const char precomputed[])
 {
 	compare_record_t *const record = malloc(sizeof(*record));
+	if(record == NULL)
+	{
+		return NULL;
+	}
 
+	record->fingerprint = (precomputed == NULL ? NULL : strdup(precomputed));
+	record->digest.state = DS_PENDING;
 	record->id = id;
 	record->is_partial = is_partial;
 	record->next = NULL;
+	record->last = record;
 
 	/* Comparison by contents is the only one when we need to resolve fingerprint
 	 * conflicts. */
 	record->path = (ct == CT_CONTENTS ? strdup(path) : NULL);
 
-	/* Just add new entry to the list if something is already there. */
+	/* Just add new entry to the end of the list if something is already
+	 * there. */
 	void *data = NULL;
 	(void)trie_get(trie, fingerprint, &data);
-	compare_record_t *prev = data;
-	if(prev != NULL)
+	compare_record_t *head = data;
+	if(head != NULL)
 	{
-		prev->next = record;
-		return;
+		head->last->next = record;
+		head->last = record;
+		return record;
 	}
 
 	/* Otherwise we're the head of the list. */
 	if(trie_set(trie, fingerprint, record) < 0)
 	{
+		free(record->fingerprint);
 		free(record->path);
 		free(record);
+		return NULL;
 	}
+	return record;
 }
 
 /* Frees list of compare entries.  Implements data free function for
@@ -1173,6 +1607,7 @@ free_compare_records(void *ptr)
 	{
 		compare_record_t *const current = record;
 		record = record->next;
+		free(current->fingerprint);
 		free(current->path);
 		free(current);
 	}
@@ -1278,7 +1713,10 @@ compare_move_entry(ops_t *ops, view_t *from, view_t *to, int idx)
 		int match = (strcmp(from_fingerprint, to_fingerprint) == 0);
 		if(match && ct == CT_CONTENTS)
 		{
-			match = files_are_identical(from_path, to_path);
+			full_digest_t from_digest = { .state = DS_PENDING };
+			full_digest_t to_digest = { .state = DS_PENDING };
+			match = contents_match(from_path, &from_digest, to_path, &to_digest,
+					flags);
 		}
 		if(match)
 		{
@@ -39,6 +39,9 @@ typedef enum
 
 	CF_SINGLE_PANE       = 256, /* Single pane mode */
 
+	CF_BYTE_CHECK        = 512, /* Compare contents byte-by-byte in addition to
+	                               comparing their hashes. */
+
 	/* Mask of show* flags. */
 	CF_SHOW = CF_SHOW_IDENTICAL
 	        | CF_SHOW_DIFFERENT
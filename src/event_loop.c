@@ -36,6 +36,7 @@
 #include "engine/keys.h"
 #include "engine/mode.h"
 #include "lua/vlua.h"
+#include "menus/menus.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/modes.h"
 #include "modes/wk.h"
@@ -54,6 +55,7 @@
 #include "filelist.h"
 #include "instance.h"
 #include "ipc.h"
+#include "locate_index.h"
 #include "registers.h"
 #include "status.h"
 #include "vcache.h"
@@ -150,6 +152,7 @@ event_loop(const int *quit, int manage_marking)
 			modes_periodic();
 
 			bg_check();
+			locidx_check();
 
 			/* Lua might not be initialized in tests. */
 			if(input_buf_pos == 0 && !wait_for_enter && vle_mode_is(NORMAL_MODE) &&
@@ -176,6 +179,11 @@ event_loop(const int *quit, int manage_marking)
 			if(!got_input && (input_buf_pos == 0 || last_result == KEYS_WAIT))
 			{
 				timeout = cfg.timeout_len;
+				if(input_buf_pos == 0 && !wait_for_enter && vle_mode_is(NORMAL_MODE))
+				{
+					/* Cursor stays in place, good time to look ahead. */
+					qv_prefetch(curr_view);
+				}
 				continue;
 			}
 
@@ -401,6 +409,8 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 				stats_redraw_later();
 			}
 
+			menus_check_capture();
+
 			wtimeout(win, delay_slice);
 			timeout -= delay_slice;
 
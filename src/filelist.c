@@ -28,7 +28,17 @@
 
 #include <curses.h>
 
-#include <sys/stat.h> /* stat */
+#ifdef __linux__
+#include <sys/syscall.h> /* SYS_getdents64 */
+#endif
+
+#ifndef _WIN32
+#include <dirent.h> /* DIR closedir() fdopendir() readdir() */
+#include <fcntl.h> /* AT_* O_* fstatat() open() */
+#include <unistd.h> /* close() syscall() */
+#endif
+
+#include <sys/stat.h> /* stat statx() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
@@ -39,11 +49,13 @@
 #include <stdlib.h> /* calloc() free() */
 #include <string.h> /* memcmp() memcpy() memset() strcat() strcmp() strcpy()
                        strdup() strlen() */
+#include <time.h> /* CLOCK_REALTIME clock_gettime() timespec */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "compat/pthread.h"
+#include "compat/reallocarray.h"
 #include "engine/autocmds.h"
 #include "engine/mode.h"
 #include "int/fuse.h"
@@ -65,9 +77,11 @@
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/matcher.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
+#include "utils/str_arena.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "utils/trie.h"
@@ -78,6 +92,7 @@
 #include "flist_pos.h"
 #include "flist_sel.h"
 #include "fops_misc.h"
+#include "locate_index.h"
 #include "macros.h"
 #include "marks.h"
 #include "opt_handlers.h"
@@ -87,6 +102,75 @@
 #include "status.h"
 #include "types.h"
 
+/* Whether statx() is available (appeared in glibc 2.28). */
+#if defined(__linux__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 28))
+#define HAS_STATX 1
+#else
+#define HAS_STATX 0
+#endif
+
+/* Number of changed files beyond a quarter of the list after which directory is
+ * relisted instead of applying changes one by one. */
+#define DELTA_RELOAD_MIN 16
+
+/* Number of shared listings that are kept around when nothing uses them. */
+#define SPARE_LISTINGS 8
+
+#if HAS_STATX
+
+/* Size of buffer for reading directory entries in batches. */
+#define DIRENTS_BUF_SIZE (256*1024)
+
+/* Properties of files that are always queried. */
+#define STATX_REQUIRED \
+	(STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_INO | STATX_SIZE | STATX_MTIME)
+
+/* Properties of files that can be loaded later by fentry_load_stats(). */
+#define STATX_LAZY (STATX_UID | STATX_GID | STATX_ATIME | STATX_CTIME)
+
+/* Record produced by getdents64() system call. */
+typedef struct
+{
+	uint64_t d_ino;          /* Inode number. */
+	int64_t d_off;           /* Offset of the next record. */
+	unsigned short d_reclen; /* Size of this record. */
+	unsigned char d_type;    /* Type of the file. */
+	char d_name[];           /* Null-terminated name of the file. */
+}
+linux_dirent64_t;
+
+/* Number of entries that reader thread accumulates before publishing them. */
+#define DIR_READER_BATCH 512
+
+/* Interval between updates of partially loaded list in milliseconds. */
+#define DIR_READER_REDRAW_MS 100
+
+/* State shared by the thread that reads a directory and the main thread which
+ * adds entries to the view. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects fields up to the next comment. */
+	pthread_cond_t cond;  /* Signaled when reading is over. */
+	dir_entry_t *ready;   /* Entries not yet taken by the main thread. */
+	int nready;           /* Number of elements in the ready array. */
+	int done;             /* Whether the thread has finished. */
+	int failed;           /* Whether reading stopped because of an error. */
+	int cancelled;        /* Whether the main thread isn't interested anymore. */
+
+	/* Fields below are read-only while the thread is running. */
+	view_t *view;      /* View for which the list is loaded. */
+	int dir_fd;        /* Descriptor of the directory. */
+	unsigned int mask; /* Properties that need to be queried. */
+	int hide_dot;      /* Whether dot files are filtered out. */
+
+	str_arena_t *arena; /* Arena for names which is used by the thread. */
+	int nhidden;        /* Number of dot files skipped by the thread. */
+}
+dir_reader_t;
+
+#endif
+
 /* State of a fold. */
 typedef enum
 {
@@ -99,6 +183,65 @@ typedef enum
 }
 FoldState;
 
+/* Unfiltered and unsorted listing of a directory, which is shared by views.  It
+ * stays valid until a change of the directory is noticed, in which case a new
+ * listing replaces it. */
+typedef struct flist_listing_t
+{
+	char *path;           /* Path to the directory. */
+	fswatch_t *watch;     /* Watcher that detects changes of the directory. */
+	dir_entry_t *entries; /* Files of the directory with their origin at path. */
+	int nentries;         /* Number of entries. */
+	int refs;             /* Number of users of the listing. */
+	int outdated;         /* Whether the listing was replaced by a newer one. */
+}
+flist_listing_t;
+
+/* File of a directory listed in advance for building a tree. */
+typedef struct
+{
+	dir_entry_t info;          /* Information about the file without strings and
+	                              link details. */
+	int is_dir;                /* Whether it's a directory or a link to one. */
+	int failed;                /* Whether querying information has failed. */
+	struct tree_scan_t *child; /* Listing of the directory or NULL. */
+}
+tree_scan_file_t;
+
+/* Directory listed in advance for building a tree. */
+typedef struct tree_scan_t
+{
+	char *path;              /* Path to the directory. */
+	int depth;               /* Allowed depth of nesting below the directory. */
+	char **names;            /* Names of files in order of listing. */
+	tree_scan_file_t *files; /* Information about the files. */
+	int count;               /* Number of files. */
+	int capacity;            /* Number of allocated elements in both arrays. */
+	int failed;              /* Whether directory wasn't listed. */
+}
+tree_scan_t;
+
+#ifndef _WIN32
+
+/* State shared by threads that list directories of a tree. */
+typedef struct
+{
+	view_t *view;           /* View for which the tree is built. */
+	trie_t *excluded_paths; /* Paths to skip. */
+	trie_t *folded_paths;   /* States of folds. */
+	pthread_mutex_t lock;   /* Serializes checking files against filters. */
+	const cancellation_t *cancellation; /* Cancellation state. */
+}
+tree_scanner_t;
+
+#endif
+
+/* Listings of directories ordered from least to most recently used.  Outdated
+ * listings aren't stored here. */
+static flist_listing_t **listings;
+/* Number of elements in the listings array. */
+static int nlistings;
+
 static void init_flist(view_t *view);
 static void reset_view(view_t *view);
 static void init_view_history(view_t *view);
@@ -109,12 +252,16 @@ static void on_custom_view_leave(view_t *view);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const struct dirent *d);
+static void set_entry_stats(dir_entry_t *entry, const struct stat *s);
+static void fill_link_info(dir_entry_t *entry, const char path[]);
 static int data_is_dir_entry(const struct dirent *d, const char path[]);
 #else
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const WIN32_FIND_DATAW *ffd);
 static int data_is_dir_entry(const WIN32_FIND_DATAW *ffd, const char path[]);
 #endif
+static dir_entry_t * custom_add(view_t *view, const char path[],
+		const dir_entry_t *info);
 static int flist_custom_finish_internal(view_t *view, CVType type, int reload,
 		const char dir[], int allow_empty);
 static void on_location_change(view_t *view, int force);
@@ -145,10 +292,33 @@ static void fix_tree_links(dir_entry_t *entries, dir_entry_t *entry,
 		int old_idx, int new_idx, int displacement, int correction);
 static int is_dir_big(const char path[]);
 static void free_view_entries(view_t *view);
-static int update_dir_list(view_t *view, int reload);
+static int update_dir_list(view_t *view, int reload, int incremental,
+		int *interrupted);
 static void start_dir_list_change(view_t *view, dir_entry_t **entries, int *len,
 		int reload);
 static void finish_dir_list_change(view_t *view, dir_entry_t *entries, int len);
+static int list_dir(view_t *view, int reload, int incremental,
+		int *interrupted);
+#if HAS_STATX
+static int open_dir_for_statx(const char path[]);
+static int list_dir_statx(view_t *view);
+static int list_dir_incrementally(view_t *view, int *interrupted);
+static void * dir_reader_thread(void *arg);
+static int publish_read_entries(dir_reader_t *reader, dir_entry_t **entries,
+		int *count);
+static int take_read_entries(view_t *view, dir_entry_t *entries, int count);
+static void show_partial_list(view_t *view);
+static int add_statx_entry(view_t *view, int dir_fd, unsigned int mask,
+		const linux_dirent64_t *d);
+static int fill_dir_entry_statx(dir_entry_t *entry, int dir_fd,
+		unsigned int mask, const struct dirent *d);
+static int query_dir_entry_statx(dir_entry_t *entry, int dir_fd,
+		unsigned int mask, const struct dirent *d);
+static unsigned int get_statx_mask(const view_t *view);
+#endif
+static dir_entry_t * start_file_entry(view_t *view, const char name[],
+		const void *data, int *error);
+static void finish_file_entry(view_t *view, dir_entry_t *entry, int error);
 static int add_file_entry_to_view(const char name[], const void *data,
 		void *param);
 static void sort_dir_list(int msg, view_t *view);
@@ -162,9 +332,46 @@ static int correct_pos(view_t *view, int pos, int dist, int closest);
 static int rescue_from_empty_filelist(view_t *view);
 static void add_parent_entry(view_t *view, dir_entry_t **entries, int *count);
 static void init_dir_entry(view_t *view, dir_entry_t *entry, const char name[]);
+static void init_dir_entry_in(view_t *view, str_arena_t *arena,
+		dir_entry_t *entry, const char name[]);
+static char * dup_entry_str(str_arena_t *arena, const char str[],
+		int *in_arena);
+static void release_entry_str(char str[], int in_arena);
+static void renew_names_arena(view_t *view);
+static dir_entry_t * entry_list_put(view_t *view, dir_entry_t **list,
+		int *list_size, const char path[], const dir_entry_t *info);
+static void copy_entry_info(dir_entry_t *entry, const dir_entry_t *info,
+		const char path[]);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
+static void check_tree_for_changes(view_t *view);
 static int tree_has_changed(const dir_entry_t *entries, size_t nchildren);
-static FSWatchState poll_watcher(fswatch_t *watch, const char path[]);
+static fswatch_t * make_tree_watch(view_t *view);
+static int add_tree_watches(fswatch_t *watch, const dir_entry_t *entries,
+		int count);
+static int reload_subtrees(view_t *view, const strlist_t *changed);
+static int is_covered_path(const strlist_t *paths, int pos);
+static int reload_subtree(view_t *view, const char path[], int *nfiltered);
+static void merge_subtree(view_t *view, dir_entry_t *prev, int prev_count,
+		dir_entry_t *entries, int count);
+static void drop_tree_watch(view_t *view);
+static int apply_dir_changes(view_t *view, const fswatch_changes_t *changes);
+static int find_changed_entries(view_t *view, const fswatch_changes_t *changes,
+		int positions[]);
+static flist_listing_t * get_listing(view_t *view, const char path[],
+		int create);
+static flist_listing_t * make_listing(view_t *view, const char path[]);
+static void add_listing(flist_listing_t *listing);
+static void drop_listing(int idx);
+static void put_listing(flist_listing_t *listing);
+static void trim_listings(void);
+static void free_listing(flist_listing_t *listing);
+static entries_t copy_listing(view_t *view, const flist_listing_t *listing,
+		int only_dirs, int can_include_parent);
+static int list_dir_from_listing(view_t *view);
+static FSWatchState poll_watcher(fswatch_t *watch, const char path[],
+		fswatch_changes_t *changes);
+static int update_fold_in_place(view_t *view, dir_entry_t *dir,
+		const char path[]);
 static void remove_child_entries(view_t *view, dir_entry_t *entry);
 static void find_dir_in_cdpath(const char base_dir[], const char dst[],
 		char buf[], size_t buf_size);
@@ -187,8 +394,26 @@ static int complete_tree(const char name[], int valid, const void *parent_data,
 static void reset_entry_list(view_t *view, dir_entry_t **entries, int *count);
 static void drop_tops(dir_entry_t *entries, int *nentries, int extra);
 static int add_files_recursively(view_t *view, const char path[],
-		trie_t *excluded_paths, trie_t *folded_paths, int parent_pos,
-		int no_direct_parent, int depth);
+		const tree_scan_t *scan, trie_t *excluded_paths, trie_t *folded_paths,
+		int parent_pos, int no_direct_parent, int depth);
+static dir_entry_t * add_scanned_file(view_t *view, const char path[],
+		const tree_scan_file_t *file);
+static tree_scan_t * scan_tree(view_t *view, const char path[],
+		trie_t *excluded_paths, trie_t *folded_paths, int depth);
+#ifndef _WIN32
+static void scan_tree_task(parallel_pool_t *pool, void *task, int worker,
+		void *arg);
+static void list_tree_dir(parallel_pool_t *pool, int worker,
+		tree_scanner_t *scanner, tree_scan_t *scan, DIR *dir);
+static int scan_tree_file(parallel_pool_t *pool, int worker,
+		tree_scanner_t *scanner, tree_scan_t *scan, int dir_fd, const char name[],
+		FoldState parent_fold);
+static int should_scan_dir(tree_scanner_t *scanner, const tree_scan_t *scan,
+		const char name[], const char full_path[], FoldState parent_fold);
+static void drop_tree_scan_task(void *task, void *arg);
+#endif
+static tree_scan_t * make_tree_scan(const char path[], int depth);
+static void free_tree_scan(tree_scan_t *scan);
 static FoldState get_fold_state(trie_t *folded_paths, const char full_path[]);
 static int set_fold_state(trie_t *folded_paths, const char full_path[],
 		FoldState state);
@@ -275,12 +500,18 @@ flist_free_view(view_t *view)
 
 	free_dir_entries(&view->custom.full.entries, &view->custom.full.nentries);
 
-	/* Two pointer fields below don't contain valid data that needs to be freed,
+	str_arena_free(view->names_arena);
+	view->names_arena = NULL;
+
+	/* Pointer fields below don't contain valid data that needs to be freed,
 	 * zeroing them for tests and to at least mention them to signal that they
 	 * weren't forgotten. */
 	view->local_filter.unfiltered = NULL;
 	view->local_filter.saved = NULL;
 	view->local_filter.unfiltered_count = 0;
+	view->local_filter.matched = NULL;
+	view->local_filter.matched_filter = NULL;
+	view->local_filter.matched_len = 0;
 
 	update_string(&view->local_filter.prev, NULL);
 	free(view->local_filter.poshist);
@@ -300,6 +531,7 @@ flist_free_view(view_t *view)
 	fswatch_free(view->watch);
 	view->watch = NULL;
 	update_string(&view->watched_dir, NULL);
+	drop_tree_watch(view);
 
 	update_string(&view->last_dir, NULL);
 
@@ -854,6 +1086,7 @@ flist_custom_start(view_t *view, const char title[])
 {
 	free_dir_entries(&view->custom.entries, &view->custom.entry_count);
 	(void)replace_string(&view->custom.next_title, title);
+	renew_names_arena(view);
 
 	trie_free(view->custom.paths_cache);
 	view->custom.paths_cache = trie_create(/*free_func=*/NULL);
@@ -861,6 +1094,14 @@ flist_custom_start(view_t *view, const char title[])
 
 dir_entry_t *
 flist_custom_add(view_t *view, const char path[])
+{
+	return custom_add(view, path, NULL);
+}
+
+/* Adds an entry to custom list.  Information about the file is taken from info
+ * unless it's NULL.  Returns the entry or NULL on error or for a duplicate. */
+static dir_entry_t *
+custom_add(view_t *view, const char path[], const dir_entry_t *info)
 {
 	char canonic_path[PATH_MAX + 1];
 	to_canonic_path(path, flist_get_dir(view), canonic_path,
@@ -872,8 +1113,8 @@ flist_custom_add(view_t *view, const char path[])
 		return NULL;
 	}
 
-	return entry_list_add(view, &view->custom.entries, &view->custom.entry_count,
-			canonic_path);
+	return entry_list_put(view, &view->custom.entries,
+			&view->custom.entry_count, canonic_path, info);
 }
 
 dir_entry_t *
@@ -947,33 +1188,47 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		return 1;
 	}
 
-	entry->size = (uintmax_t)s.st_size;
-	entry->uid = s.st_uid;
-	entry->gid = s.st_gid;
-	entry->mode = s.st_mode;
-	entry->inode = s.st_ino;
-	entry->mtime = s.st_mtime;
-	entry->atime = s.st_atime;
-	entry->ctime = s.st_ctime;
-	entry->nlinks = s.st_nlink;
+	set_entry_stats(entry, &s);
 
 	if(entry->type == FT_LINK)
 	{
-		struct stat s;
-
-		const SymLinkType symlink_type = get_symlink_type(path);
-		entry->dir_link = (symlink_type != SLT_UNKNOWN);
-
-		/* Query mode of symbolic link target. */
-		if(symlink_type != SLT_SLOW && os_stat(entry->name, &s) == 0)
-		{
-			entry->mode = s.st_mode;
-		}
+		fill_link_info(entry, path);
 	}
 
 	return 0;
 }
 
+/* Fills fields of the entry except for its type from stat information. */
+static void
+set_entry_stats(dir_entry_t *entry, const struct stat *s)
+{
+	entry->size = (uintmax_t)s->st_size;
+	entry->uid = s->st_uid;
+	entry->gid = s->st_gid;
+	entry->mode = s->st_mode;
+	entry->inode = s->st_ino;
+	entry->mtime = s->st_mtime;
+	entry->atime = s->st_atime;
+	entry->ctime = s->st_ctime;
+	entry->nlinks = s->st_nlink;
+}
+
+/* Fills fields of the entry that describe target of a symbolic link. */
+static void
+fill_link_info(dir_entry_t *entry, const char path[])
+{
+	struct stat s;
+
+	const SymLinkType symlink_type = get_symlink_type(path);
+	entry->dir_link = (symlink_type != SLT_UNKNOWN);
+
+	/* Query mode of symbolic link target. */
+	if(symlink_type != SLT_SLOW && os_stat(path, &s) == 0)
+	{
+		entry->mode = s.st_mode;
+	}
+}
+
 /* Checks whether file is a directory.  Returns non-zero if so, otherwise zero
  * is returned. */
 static int
@@ -1079,6 +1334,9 @@ flist_custom_finish_internal(view_t *view, CVType type, int reload,
 	trie_free(view->custom.paths_cache);
 	view->custom.paths_cache = NULL;
 
+	/* Directories of the new list will be watched when it's checked next time. */
+	drop_tree_watch(view);
+
 	if(empty_view && !allow_empty)
 	{
 		free_dir_entries(&view->custom.entries, &view->custom.entry_count);
@@ -1394,9 +1652,14 @@ flist_custom_clone(view_t *to, const view_t *from, int as_tree)
 			continue;
 		}
 
+		int in_arena;
 		dst[j] = src[i];
-		dst[j].name = strdup(dst[j].name);
-		dst[j].origin = (dst[j].owns_origin ? strdup(dst[j].origin) : to->curr_dir);
+		dst[j].name = dup_entry_str(to->names_arena, src[i].name, &in_arena);
+		dst[j].arena_name = in_arena;
+		dst[j].origin = (dst[j].owns_origin
+		              ? dup_entry_str(to->names_arena, src[i].origin, &in_arena)
+		              : to->curr_dir);
+		dst[j].arena_origin = (dst[j].owns_origin && in_arena);
 
 		if(!dst_is_tree)
 		{
@@ -1704,6 +1967,7 @@ static int
 populate_dir_list_internal(view_t *view, int reload)
 {
 	char *saved_cwd;
+	int interrupted = 0;
 
 	view->filtered = 0;
 
@@ -1721,7 +1985,8 @@ populate_dir_list_internal(view_t *view, int reload)
 		return populate_custom_view(view, reload);
 	}
 
-	if(!reload && is_dir_big(view->curr_dir) && !modes_is_cmdline_like())
+	const int big = (!reload && is_dir_big(view->curr_dir));
+	if(big && !modes_is_cmdline_like())
 	{
 		ui_sb_quick_msgf("%s", "Reading directory...");
 	}
@@ -1745,7 +2010,7 @@ populate_dir_list_internal(view_t *view, int reload)
 			stroscmp(view->watched_dir, view->curr_dir) == 0)
 	{
 		/* Drain all events that happened before this point. */
-		(void)poll_watcher(view->watch, view->curr_dir);
+		(void)poll_watcher(view->watch, view->curr_dir, NULL);
 	}
 
 	if(is_unc_root(view->curr_dir))
@@ -1765,7 +2030,7 @@ populate_dir_list_internal(view_t *view, int reload)
 					"Can't load list of shares of %s", view->curr_dir);
 
 			leave_invalid_dir(view);
-			if(update_dir_list(view, reload) != 0)
+			if(update_dir_list(view, reload, 0, &interrupted) != 0)
 			{
 				/* We don't have read access, only execute, or there were other
 				 * problems. */
@@ -1775,14 +2040,19 @@ populate_dir_list_internal(view_t *view, int reload)
 		}
 #endif
 	}
-	else if(update_dir_list(view, reload) != 0)
+	else if(update_dir_list(view, reload, big, &interrupted) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
 		add_parent_dir(view);
 	}
 
-	if(!reload && !modes_is_cmdline_like())
+	if(interrupted)
+	{
+		ui_sb_errf("Reading of directory was interrupted, %d files are listed",
+				view->list_rows);
+	}
+	else if(!reload && !modes_is_cmdline_like())
 	{
 		ui_sb_clear();
 	}
@@ -1999,7 +2269,7 @@ zap_compare_view(view_t *view, view_t *other, zap_filter filter, void *arg)
 				}
 				continue;
 			}
-			replace_string(&entry->name, "");
+			(void)fentry_set_name(entry, "");
 			entry->type = FT_UNK;
 			entry->id = other->dir_entry[i].id;
 		}
@@ -2283,17 +2553,20 @@ free_view_entries(view_t *view)
 	free_dir_entries(&view->dir_entry, &view->list_rows);
 }
 
-/* Updates file list with files from current directory.  Returns zero on
- * success, otherwise non-zero is returned. */
+/* Updates file list with files from current directory.  incremental flag
+ * enables showing the list while it's being loaded, *interrupted is set to
+ * non-zero if the user has cancelled loading.  Returns zero on success,
+ * otherwise non-zero is returned. */
 static int
-update_dir_list(view_t *view, int reload)
+update_dir_list(view_t *view, int reload, int incremental, int *interrupted)
 {
 	dir_entry_t *prev_dir_entries;
 	int prev_list_rows;
 
 	start_dir_list_change(view, &prev_dir_entries, &prev_list_rows, reload);
+	renew_names_arena(view);
 
-	if(enum_dir_content(view->curr_dir, &add_file_entry_to_view, view) != 0)
+	if(list_dir(view, reload, incremental && !reload, interrupted) != 0)
 	{
 		LOG_SERROR_MSG(errno, "Can't opendir() \"%s\"", view->curr_dir);
 		free_dir_entries(&prev_dir_entries, &prev_list_rows);
@@ -2354,599 +2627,2201 @@ finish_dir_list_change(view_t *view, dir_entry_t *entries, int len)
 	view->dir_entry = dynarray_shrink(view->dir_entry);
 }
 
-/* enum_dir_content() callback that appends files to file list.  Returns zero on
- * success or non-zero to indicate failure and stop enumeration. */
+/* Fills file list of the view with files of its current directory.  Unless
+ * reloading, listing shared with other views can be used.  When incremental
+ * flag is set, loading can be cancelled by the user, in which case
+ * *interrupted is set to non-zero.  Returns zero on success, otherwise non-zero
+ * is returned. */
 static int
-add_file_entry_to_view(const char name[], const void *data, void *param)
+list_dir(view_t *view, int reload, int incremental, int *interrupted)
 {
-	view_t *const view = param;
-	dir_entry_t *entry;
+	*interrupted = 0;
 
-	/* Always ignore the "." and ".." directories. */
-	if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+	if(!reload && list_dir_from_listing(view) == 0)
 	{
 		return 0;
 	}
 
-	if(!entry_is_visible(view, name, data))
-	{
-		++view->filtered;
-		return 0;
-	}
+#if HAS_STATX
+	int result;
 
-	entry = alloc_dir_entry(&view->dir_entry, view->list_rows);
-	if(entry == NULL)
+	if(incremental)
 	{
-		show_error_msg("Memory Error", "Unable to allocate enough memory");
-		return 1;
+		result = list_dir_incrementally(view, interrupted);
+		if(result <= 0)
+		{
+			return result;
+		}
 	}
 
-	init_dir_entry(view, entry, name);
-
-	if(fill_dir_entry(entry, entry->name, data) == 0)
-	{
-		++view->list_rows;
-	}
-	else
+	result = list_dir_statx(view);
+	if(result <= 0)
 	{
-		fentry_free(entry);
+		return result;
 	}
+#endif
 
-	return 0;
+	return enum_dir_content(view->curr_dir, &add_file_entry_to_view, view);
 }
 
-void
-resort_dir_list(int msg, view_t *view)
+#if HAS_STATX
+
+/* Opens directory for listing it via statx().  Returns file descriptor, -1 on
+ * error or -2 if statx() can't be used. */
+static int
+open_dir_for_statx(const char path[])
 {
-	char full_path[PATH_MAX + 1];
-	const int top_delta = view->list_pos - view->top_line;
-	if(view->list_pos < view->list_rows)
+	static int unavailable;
+	if(unavailable)
 	{
-		get_current_full_path(view, sizeof(full_path), full_path);
+		return -2;
 	}
 
-	sort_dir_list(msg, view);
-
-	if(view->list_pos < view->list_rows)
+	const int fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd == -1)
 	{
-		flist_goto_by_path(view, full_path);
-		view->top_line = view->list_pos - top_delta;
+		return -1;
 	}
-}
 
-/* Resorts view without reloading it.  msg parameter controls whether to show
- * "Sorting..." status bar message. */
-static void
-sort_dir_list(int msg, view_t *view)
-{
-	if(msg && view->list_rows > 2048 && !modes_is_cmdline_like())
+	/* statx() can be missing in the kernel or be forbidden by a sandbox. */
+	struct statx stx;
+	if(statx(fd, ".", AT_STATX_DONT_SYNC, STATX_TYPE, &stx) != 0 &&
+			(errno == ENOSYS || errno == EPERM))
 	{
-		ui_sb_quick_msgf("%s", "Sorting directory...");
+		unavailable = 1;
+		close(fd);
+		return -2;
 	}
 
-	sort_view(view);
-
-	if(msg && !modes_is_cmdline_like())
-	{
-		ui_sb_clear();
-	}
+	return fd;
 }
 
-/* Merges elements from previous list into the new one. */
-static void
-merge_lists(view_t *view, dir_entry_t *entries, int len)
+/* Lists current directory of the view by reading its entries in large batches
+ * and querying properties of files relative to directory descriptor.  Only
+ * properties needed for all files are requested and file systems aren't asked
+ * to synchronize attributes, which matters for network file systems.  Returns
+ * zero on success, positive number if this kind of listing isn't available and
+ * negative number on error. */
+static int
+list_dir_statx(view_t *view)
 {
-	int i;
-	int closest_dist;
-	const int prev_pos = view->list_pos;
-	trie_t *prev_names = trie_create(/*free_func=*/NULL);
-
-	for(i = 0; i < len; ++i)
+	const int fd = open_dir_for_statx(view->curr_dir);
+	if(fd < 0)
 	{
-		add_to_trie(prev_names, view, &entries[i]);
+		return (fd == -1 ? -1 : 1);
+	}
 
-		/* We won't use the name later, so free some memory. */
-		update_string(&entries[i].name, NULL);
+	char *const buf = malloc(DIRENTS_BUF_SIZE);
+	if(buf == NULL)
+	{
+		close(fd);
+		return 1;
 	}
 
-	closest_dist = INT_MIN;
-	for(i = 0; i < view->list_rows; ++i)
+	const unsigned int mask = get_statx_mask(view);
+
+	int stop = 0;
+	while(!stop)
 	{
-		int dist;
-		void *data;
-		dir_entry_t *const entry = &view->dir_entry[i];
-		if(!is_in_trie(prev_names, view, entry, &data))
+		/* Read errors are treated as the end of the list like with readdir(). */
+		const long len = syscall(SYS_getdents64, fd, buf, DIRENTS_BUF_SIZE);
+		if(len <= 0)
 		{
-			continue;
+			break;
 		}
 
-		/* Transfer information from previous entry to the new one. */
-		merge_entries(entry, data);
-
-		/* Update number of selected files (should have been zeroed beforehand). */
-		view->selected_files += (entry->selected != 0);
-
-		/* Update cursor position in a smart way. */
-		dist = (dir_entry_t *)data - entries - prev_pos;
-		closest_dist = correct_pos(view, i, dist, closest_dist);
+		long pos = 0;
+		while(pos < len && !stop)
+		{
+			const linux_dirent64_t *const d = (const void *)(buf + pos);
+			stop = add_statx_entry(view, fd, mask, d);
+			pos += d->d_reclen;
+		}
 	}
 
-	trie_free(prev_names);
+	free(buf);
+	close(fd);
+	return 0;
 }
 
-/* Checks that entries don't have the same name (for non-cv).  And if there are
- * duplicates shows a warning to the user (shown each time broken directory is
- * entered) and drops duplicates. */
-TSTATIC void
-check_file_uniqueness(view_t *view)
+/* Lists current directory of the view like list_dir_statx() does, but reads
+ * and queries files on a separate thread while periodically displaying what
+ * was loaded so far (in the order of reading) and letting the user to cancel
+ * the process, in which case *interrupted is set to non-zero and partial list
+ * is kept.  Returns zero on success, positive number if this kind of listing
+ * isn't available or failed midway (the list is emptied then) and negative
+ * number on error. */
+static int
+list_dir_incrementally(view_t *view, int *interrupted)
 {
-	trie_t *file_names = trie_create(/*free_func=*/NULL);
+	const int fd = open_dir_for_statx(view->curr_dir);
+	if(fd < 0)
+	{
+		return (fd == -1 ? -1 : 1);
+	}
 
-	int had_dups = view->has_dups;
+	dir_reader_t reader = {
+		.view = view,
+		.dir_fd = fd,
+		.mask = get_statx_mask(view),
+		.hide_dot = view->hide_dot,
+		.arena = str_arena_create(),
+	};
 
-	int i;
-	for(i = 0; i < view->list_rows; ++i)
+	if(pthread_mutex_init(&reader.lock, NULL) != 0)
 	{
-		add_to_trie(file_names, view, &view->dir_entry[i]);
+		str_arena_free(reader.arena);
+		close(fd);
+		return 1;
+	}
+	if(pthread_cond_init(&reader.cond, NULL) != 0)
+	{
+		(void)pthread_mutex_destroy(&reader.lock);
+		str_arena_free(reader.arena);
+		close(fd);
+		return 1;
 	}
 
-	trie_free(file_names);
+	pthread_t thread;
+	if(pthread_create(&thread, NULL, &dir_reader_thread, &reader) != 0)
+	{
+		(void)pthread_cond_destroy(&reader.cond);
+		(void)pthread_mutex_destroy(&reader.lock);
+		str_arena_free(reader.arena);
+		close(fd);
+		return 1;
+	}
 
-	if(view->has_dups)
+	const int filtered = view->filtered;
+	int failed = 0;
+
+	ui_cancellation_push_on();
+
+	(void)pthread_mutex_lock(&reader.lock);
+	while(1)
 	{
-		(void)exclude_temporary_entries(view);
-		if(!had_dups)
+		if(!reader.done)
 		{
-			show_error_msg("Broken File System", "Underlying file system seems to "
-					"report duplicated file names.  Only one entry will be shown.");
+			struct timespec deadline;
+			(void)clock_gettime(CLOCK_REALTIME, &deadline);
+			deadline.tv_nsec += DIR_READER_REDRAW_MS*1000000L;
+			deadline.tv_sec += deadline.tv_nsec/1000000000L;
+			deadline.tv_nsec %= 1000000000L;
+
+			while(!reader.done &&
+					pthread_cond_timedwait(&reader.cond, &reader.lock, &deadline) == 0)
+			{
+				/* Spurious wake up. */
+			}
 		}
-	}
-}
 
-/* Adds view entry into the trie mapping its name to entry structure.
- * Duplicated entries of a non-custom view are marked as temporary. */
-static void
-add_to_trie(trie_t *trie, view_t *view, dir_entry_t *entry)
-{
-	if(flist_custom_active(view))
-	{
-		char full_path[PATH_MAX + 1];
-		get_full_path_of(entry, sizeof(full_path), full_path);
+		dir_entry_t *const entries = reader.ready;
+		const int count = reader.nready;
+		const int done = reader.done;
+		reader.ready = NULL;
+		reader.nready = 0;
+		(void)pthread_mutex_unlock(&reader.lock);
 
-		int error = trie_set(trie, full_path, entry);
-		assert(error == 0 && "Duplicated file names in the list?");
-		(void)error;
-		return;
+		failed = take_read_entries(view, entries, count);
+		if(done)
+		{
+			break;
+		}
+
+		*interrupted = !failed && ui_cancellation_requested();
+		if(failed || *interrupted)
+		{
+			(void)pthread_mutex_lock(&reader.lock);
+			reader.cancelled = 1;
+			(void)pthread_mutex_unlock(&reader.lock);
+			break;
+		}
+
+		show_partial_list(view);
+
+		(void)pthread_mutex_lock(&reader.lock);
 	}
 
-	if(trie_set(trie, entry->name, entry) != 0)
+	ui_cancellation_pop();
+
+	(void)pthread_join(thread, NULL);
+	view->filtered += reader.nhidden;
+	free_dir_entries(&reader.ready, &reader.nready);
+	str_arena_free(reader.arena);
+	(void)pthread_cond_destroy(&reader.cond);
+	(void)pthread_mutex_destroy(&reader.lock);
+	close(fd);
+
+	if(failed || reader.failed)
 	{
-		LOG_INFO_MSG("Duplicated entry is `%s` in `%s`", entry->name,
-				entry->origin);
-		entry->temporary = 1;
-		view->has_dups = 1;
+		/* Drop partial list to let the caller list the directory anew. */
+		free_view_entries(view);
+		view->filtered = filtered;
+		return 1;
 	}
+
+	return 0;
 }
 
-/* Looks up entry in the trie by its name.  Retrieves directory entry stored by
- * add_to_trie() into *data (unchanged on lookup failure).  Returns non-zero if
- * item was successfully retrieved and zero otherwise. */
-static int
-is_in_trie(trie_t *trie, view_t *view, dir_entry_t *entry, void **data)
+/* Entry point of the thread that reads directory and queries properties of its
+ * files.  Doesn't touch the view and doesn't depend on current working
+ * directory.  Returns NULL. */
+static void *
+dir_reader_thread(void *arg)
 {
-	int error;
+	dir_reader_t *const reader = arg;
+
+	block_all_thread_signals();
+
+	dir_entry_t *entries = NULL;
+	int count = 0;
+
+	char *const buf = malloc(DIRENTS_BUF_SIZE);
+	int failed = (buf == NULL);
+	int stop = failed;
+	while(!stop)
+	{
+		/* Read errors are treated as the end of the list like with readdir(). */
+		const long len = syscall(SYS_getdents64, reader->dir_fd, buf,
+				DIRENTS_BUF_SIZE);
+		if(len <= 0)
+		{
+			break;
+		}
+
+		long pos;
+		for(pos = 0; pos < len && !stop; )
+		{
+			const linux_dirent64_t *const d = (const void *)(buf + pos);
+			pos += d->d_reclen;
+
+			/* Always ignore the "." and ".." directories. */
+			if(strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0)
+			{
+				continue;
+			}
+			/* Other filters are applied by the main thread. */
+			if(reader->hide_dot && d->d_name[0] == '.')
+			{
+				++reader->nhidden;
+				continue;
+			}
+
+			dir_entry_t *const entry = alloc_dir_entry(&entries, count);
+			if(entry == NULL)
+			{
+				failed = 1;
+				stop = 1;
+				break;
+			}
+
+			struct dirent dentry;
+			dentry.d_ino = d->d_ino;
+			dentry.d_type = d->d_type;
+			copy_str(dentry.d_name, sizeof(dentry.d_name), d->d_name);
+
+			init_dir_entry_in(reader->view, reader->arena, entry, dentry.d_name);
+			if(query_dir_entry_statx(entry, reader->dir_fd, reader->mask,
+						&dentry) > 0)
+			{
+				fentry_free(entry);
+				continue;
+			}
+			/* Negative result leaves type unknown for the main thread to fill the
+			 * entry in a regular way. */
+			++count;
+
+			if(count == DIR_READER_BATCH)
+			{
+				stop = publish_read_entries(reader, &entries, &count);
+			}
+		}
+	}
+	free(buf);
+
+	if(!failed)
+	{
+		(void)publish_read_entries(reader, &entries, &count);
+	}
+	free_dir_entries(&entries, &count);
+
+	(void)pthread_mutex_lock(&reader->lock);
+	reader->failed |= failed;
+	reader->done = 1;
+	(void)pthread_cond_signal(&reader->cond);
+	(void)pthread_mutex_unlock(&reader->lock);
+
+	return NULL;
+}
+
+/* Hands over entries read by the thread to the main thread.  Returns non-zero
+ * if reading should be stopped because of cancellation or an error. */
+static int
+publish_read_entries(dir_reader_t *reader, dir_entry_t **entries, int *count)
+{
+	int stop;
+
+	(void)pthread_mutex_lock(&reader->lock);
+
+	stop = reader->cancelled;
+	if(!stop && *count != 0)
+	{
+		if(reader->ready == NULL)
+		{
+			reader->ready = *entries;
+			reader->nready = *count;
+			*entries = NULL;
+			*count = 0;
+		}
+		else
+		{
+			void *const ready = dynarray_extend(reader->ready,
+					sizeof(**entries)*(*count));
+			if(ready == NULL)
+			{
+				reader->failed = 1;
+				stop = 1;
+			}
+			else
+			{
+				reader->ready = ready;
+				memcpy(&reader->ready[reader->nready], *entries,
+						sizeof(**entries)*(*count));
+				reader->nready += *count;
+				/* Entries are now owned by the other array. */
+				dynarray_free(*entries);
+				*entries = NULL;
+				*count = 0;
+			}
+		}
+	}
+
+	(void)pthread_mutex_unlock(&reader->lock);
+
+	return stop;
+}
+
+/* Finishes filling entries produced by reader thread, filters them and appends
+ * the rest to the file list of the view.  Frees the array.  Returns non-zero
+ * if loading should be stopped because of an error. */
+static int
+take_read_entries(view_t *view, dir_entry_t *entries, int count)
+{
+	int failed = 0;
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+
+		int error = failed;
+		if(!error && entry->type == FT_UNK)
+		{
+			error = fill_dir_entry(entry, entry->name, NULL);
+		}
+		else if(!error && entry->type == FT_LINK)
+		{
+			fill_link_info(entry, entry->name);
+		}
+
+		if(!error && !filters_file_is_visible(view, flist_get_dir(view),
+					entry->name, fentry_is_dir(entry), /*apply_local_filter=*/1))
+		{
+			++view->filtered;
+			error = 1;
+		}
+
+		dir_entry_t *const slot = error ? NULL
+		                                : alloc_dir_entry(&view->dir_entry,
+		                                                  view->list_rows);
+		if(slot == NULL)
+		{
+			if(!error)
+			{
+				show_error_msg("Memory Error", "Unable to allocate enough memory");
+				failed = 1;
+			}
+			fentry_free(entry);
+			continue;
+		}
+
+		*slot = *entry;
+		++view->list_rows;
+	}
+
+	dynarray_free(entries);
+	return failed;
+}
+
+/* Draws what was loaded so far along with a progress message. */
+static void
+show_partial_list(view_t *view)
+{
+	if(modes_is_cmdline_like())
+	{
+		return;
+	}
+
+	if(view->list_rows != 0)
+	{
+		view->list_pos = 0;
+		view->top_line = 0;
+		fview_update_geometry(view);
+		draw_dir_list_only(view);
+	}
+
+	ui_sb_quick_msgf("Reading directory... %d (press Ctrl-C to cancel)",
+			view->list_rows);
+}
+
+/* Appends file described by the record to file list of the view.  Returns zero
+ * on success or non-zero to indicate failure and stop enumeration. */
+static int
+add_statx_entry(view_t *view, int dir_fd, unsigned int mask,
+		const linux_dirent64_t *d)
+{
+	/* Filters and fallback code expect standard structure. */
+	struct dirent dentry;
+	dentry.d_ino = d->d_ino;
+	dentry.d_type = d->d_type;
+	copy_str(dentry.d_name, sizeof(dentry.d_name), d->d_name);
+
+	int error;
+	dir_entry_t *const entry = start_file_entry(view, dentry.d_name, &dentry,
+			&error);
+	if(entry != NULL)
+	{
+		finish_file_entry(view, entry,
+				fill_dir_entry_statx(entry, dir_fd, mask, &dentry));
+	}
+	return error;
+}
+
+/* Fills fields of the entry by querying properties specified by the mask for
+ * the file relative to directory descriptor.  d is optional source of file
+ * type.  Returns zero on success, otherwise non-zero is returned. */
+static int
+fill_dir_entry_statx(dir_entry_t *entry, int dir_fd, unsigned int mask,
+		const struct dirent *d)
+{
+	const int result = query_dir_entry_statx(entry, dir_fd, mask, d);
+	if(result < 0)
+	{
+		/* File system doesn't provide something that is always needed. */
+		return fill_dir_entry(entry, entry->name, d);
+	}
+
+	if(result == 0 && entry->type == FT_LINK)
+	{
+		fill_link_info(entry, entry->name);
+	}
+
+	return result;
+}
+
+/* Fills fields of the entry except for information about target of a symbolic
+ * link by querying properties specified by the mask for the file relative to
+ * directory descriptor.  Doesn't depend on current working directory.  d is
+ * optional source of file type.  Returns zero on success, negative number if
+ * file system can't provide all of the required information and positive number
+ * on error. */
+static int
+query_dir_entry_statx(dir_entry_t *entry, int dir_fd, unsigned int mask,
+		const struct dirent *d)
+{
+	const int flags = AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT | AT_STATX_DONT_SYNC;
+
+	struct statx stx;
+	if(statx(dir_fd, entry->name, flags, mask, &stx) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Can't statx() \"%s\"", entry->name);
+		return 1;
+	}
+
+	if((stx.stx_mask & STATX_REQUIRED) != STATX_REQUIRED)
+	{
+		return -1;
+	}
+
+	entry->type = get_type_from_mode(stx.stx_mode);
+	if(entry->type == FT_UNK)
+	{
+		entry->type = (d == NULL) ? FT_UNK : type_from_dir_entry(d, entry->name);
+	}
+	if(entry->type == FT_UNK)
+	{
+		LOG_ERROR_MSG("Can't determine type of \"%s\"", entry->name);
+		return 1;
+	}
+
+	entry->size = (uintmax_t)stx.stx_size;
+	entry->mode = stx.stx_mode;
+	entry->inode = stx.stx_ino;
+	entry->mtime = stx.stx_mtime.tv_sec;
+	entry->nlinks = stx.stx_nlink;
+
+	/* File systems are free to return more than was requested. */
+	if((stx.stx_mask & STATX_LAZY) == STATX_LAZY)
+	{
+		entry->uid = stx.stx_uid;
+		entry->gid = stx.stx_gid;
+		entry->atime = stx.stx_atime.tv_sec;
+		entry->ctime = stx.stx_ctime.tv_sec;
+	}
+	else
+	{
+		entry->partial_stats = 1;
+	}
+
+	return 0;
+}
+
+/* Computes properties of files that need to be loaded for all files of the
+ * view based on its sorting and columns.  Returns mask for statx(). */
+static unsigned int
+get_statx_mask(const view_t *view)
+{
+	int i;
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		if(fentry_key_needs_stats(abs(view->sort[i])))
+		{
+			return STATX_REQUIRED | STATX_LAZY;
+		}
+	}
+
+	if(view->columns != NULL && ui_view_displays_columns(view))
+	{
+		int key;
+		for(key = 1; key <= SK_LAST; ++key)
+		{
+			if(fentry_key_needs_stats(key) && columns_has_column(view->columns, key))
+			{
+				return STATX_REQUIRED | STATX_LAZY;
+			}
+		}
+	}
+
+	return STATX_REQUIRED;
+}
+
+#endif
+
+/* Allocates and initializes entry for a file of current directory of the view
+ * unless the file is filtered out.  *error is set to non-zero on failure that
+ * should stop enumeration.  Returns the entry or NULL. */
+static dir_entry_t *
+start_file_entry(view_t *view, const char name[], const void *data,
+		int *error)
+{
+	*error = 0;
+
+	/* Always ignore the "." and ".." directories. */
+	if(strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+	{
+		return NULL;
+	}
+
+	if(!entry_is_visible(view, name, data))
+	{
+		++view->filtered;
+		return NULL;
+	}
+
+	dir_entry_t *const entry = alloc_dir_entry(&view->dir_entry,
+			view->list_rows);
+	if(entry == NULL)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		*error = 1;
+		return NULL;
+	}
+
+	init_dir_entry(view, entry, name);
+	return entry;
+}
+
+/* Either accepts or discards an entry created by start_file_entry() depending
+ * on whether filling it has failed. */
+static void
+finish_file_entry(view_t *view, dir_entry_t *entry, int error)
+{
+	if(!error)
+	{
+		++view->list_rows;
+	}
+	else
+	{
+		fentry_free(entry);
+	}
+}
+
+/* enum_dir_content() callback that appends files to file list.  Returns zero on
+ * success or non-zero to indicate failure and stop enumeration. */
+static int
+add_file_entry_to_view(const char name[], const void *data, void *param)
+{
+	view_t *const view = param;
+
+	int error;
+	dir_entry_t *const entry = start_file_entry(view, name, data, &error);
+	if(entry != NULL)
+	{
+		finish_file_entry(view, entry, fill_dir_entry(entry, entry->name, data));
+	}
+	return error;
+}
+
+void
+resort_dir_list(int msg, view_t *view)
+{
+	char full_path[PATH_MAX + 1];
+	const int top_delta = view->list_pos - view->top_line;
+	if(view->list_pos < view->list_rows)
+	{
+		get_current_full_path(view, sizeof(full_path), full_path);
+	}
+
+	sort_dir_list(msg, view);
+
+	if(view->list_pos < view->list_rows)
+	{
+		flist_goto_by_path(view, full_path);
+		view->top_line = view->list_pos - top_delta;
+	}
+}
+
+/* Resorts view without reloading it.  msg parameter controls whether to show
+ * "Sorting..." status bar message. */
+static void
+sort_dir_list(int msg, view_t *view)
+{
+	if(msg && view->list_rows > 2048 && !modes_is_cmdline_like())
+	{
+		ui_sb_quick_msgf("%s", "Sorting directory...");
+	}
+
+	sort_view(view);
+
+	if(msg && !modes_is_cmdline_like())
+	{
+		ui_sb_clear();
+	}
+}
+
+/* Merges elements from previous list into the new one. */
+static void
+merge_lists(view_t *view, dir_entry_t *entries, int len)
+{
+	int i;
+	int closest_dist;
+	const int prev_pos = view->list_pos;
+	trie_t *prev_names = trie_create(/*free_func=*/NULL);
+
+	for(i = 0; i < len; ++i)
+	{
+		add_to_trie(prev_names, view, &entries[i]);
+
+		/* We won't use the name later, so free some memory. */
+		release_entry_str(entries[i].name, entries[i].arena_name);
+		entries[i].name = NULL;
+		entries[i].arena_name = 0;
+	}
+
+	closest_dist = INT_MIN;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		int dist;
+		void *data;
+		dir_entry_t *const entry = &view->dir_entry[i];
+		if(!is_in_trie(prev_names, view, entry, &data))
+		{
+			continue;
+		}
+
+		/* Transfer information from previous entry to the new one. */
+		merge_entries(entry, data);
+
+		/* Update number of selected files (should have been zeroed beforehand). */
+		view->selected_files += (entry->selected != 0);
+
+		/* Update cursor position in a smart way. */
+		dist = (dir_entry_t *)data - entries - prev_pos;
+		closest_dist = correct_pos(view, i, dist, closest_dist);
+	}
+
+	trie_free(prev_names);
+}
+
+/* Checks that entries don't have the same name (for non-cv).  And if there are
+ * duplicates shows a warning to the user (shown each time broken directory is
+ * entered) and drops duplicates. */
+TSTATIC void
+check_file_uniqueness(view_t *view)
+{
+	trie_t *file_names = trie_create(/*free_func=*/NULL);
+
+	int had_dups = view->has_dups;
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		add_to_trie(file_names, view, &view->dir_entry[i]);
+	}
+
+	trie_free(file_names);
+
+	if(view->has_dups)
+	{
+		(void)exclude_temporary_entries(view);
+		if(!had_dups)
+		{
+			show_error_msg("Broken File System", "Underlying file system seems to "
+					"report duplicated file names.  Only one entry will be shown.");
+		}
+	}
+}
+
+/* Adds view entry into the trie mapping its name to entry structure.
+ * Duplicated entries of a non-custom view are marked as temporary. */
+static void
+add_to_trie(trie_t *trie, view_t *view, dir_entry_t *entry)
+{
+	if(flist_custom_active(view))
+	{
+		char full_path[PATH_MAX + 1];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+
+		int error = trie_set(trie, full_path, entry);
+		assert(error == 0 && "Duplicated file names in the list?");
+		(void)error;
+		return;
+	}
+
+	if(trie_set(trie, entry->name, entry) != 0)
+	{
+		LOG_INFO_MSG("Duplicated entry is `%s` in `%s`", entry->name,
+				entry->origin);
+		entry->temporary = 1;
+		view->has_dups = 1;
+	}
+}
+
+/* Looks up entry in the trie by its name.  Retrieves directory entry stored by
+ * add_to_trie() into *data (unchanged on lookup failure).  Returns non-zero if
+ * item was successfully retrieved and zero otherwise. */
+static int
+is_in_trie(trie_t *trie, view_t *view, dir_entry_t *entry, void **data)
+{
+	int error;
 
 	if(flist_custom_active(view))
 	{
-		char full_path[PATH_MAX + 1];
-		get_full_path_of(entry, sizeof(full_path), full_path);
-		error = trie_get(trie, full_path, data);
+		char full_path[PATH_MAX + 1];
+		get_full_path_of(entry, sizeof(full_path), full_path);
+		error = trie_get(trie, full_path, data);
+	}
+	else
+	{
+		error = trie_get(trie, entry->name, data);
+	}
+
+	return (error == 0);
+}
+
+/* Merges data from previous entry into the new one.  Both entries should
+ * correspond to the same file (their names must match). */
+static void
+merge_entries(dir_entry_t *new, const dir_entry_t *prev)
+{
+	new->id = prev->id;
+
+	new->selected = prev->selected;
+	new->was_selected = prev->was_selected;
+	new->folded = prev->folded;
+
+	/* No need to check for name here, because only entries with exactly the same
+	 * names are merged. */
+	if(new->type == prev->type)
+	{
+		new->hi_num = prev->hi_num;
+		new->name_dec_num = prev->name_dec_num;
+	}
+}
+
+/* Corrects selected item position in the list.  Returns updated value of the
+ * closest variable, which initially should be INT_MIN. */
+static int
+correct_pos(view_t *view, int pos, int dist, int closest)
+{
+	if(dist == 0)
+	{
+		closest = 0;
+		view->list_pos = pos;
+	}
+	else if((closest < 0 && dist > closest) || (closest > 0 && dist < closest))
+	{
+		closest = dist;
+		view->list_pos = pos;
+	}
+	return closest;
+}
+
+/* Performs actions needed to rescue from abnormal situation with empty
+ * filelist.  Returns non-zero if file list was reloaded. */
+static int
+rescue_from_empty_filelist(view_t *view)
+{
+	/* It is possible to set the file name filter so that no files are showing
+	 * in the / directory.  All other directories will always show at least the
+	 * ../ file.  This resets the filter and reloads the directory. */
+	if(name_filters_empty(view))
+	{
+		return 0;
+	}
+
+	show_error_msgf("Filter error",
+			"The %s\"%s\" pattern did not match any files. It was reset.",
+			view->invert ? "" : "inverted ", matcher_get_expr(view->manual_filter));
+
+	name_filters_drop(view);
+
+	load_dir_list(view, 1);
+	if(view->list_rows < 1)
+	{
+		leave_invalid_dir(view);
+		(void)change_directory(view, view->curr_dir);
+		load_dir_list(view, 0);
+	}
+
+	return 1;
+}
+
+void
+add_parent_dir(view_t *view)
+{
+	add_parent_entry(view, &view->dir_entry, &view->list_rows);
+}
+
+/* Adds parent directory entry (..) to specified list of entries. */
+static void
+add_parent_entry(view_t *view, dir_entry_t **entries, int *count)
+{
+	dir_entry_t *const dir_entry = alloc_dir_entry(entries, *count);
+	if(dir_entry == NULL)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return;
+	}
+
+	if(init_parent_entry(view, dir_entry, "..") == 0)
+	{
+		++*count;
+	}
+}
+
+/* Initializes dir_entry_t with name and all other fields with default
+ * values. */
+static void
+init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
+{
+	init_dir_entry_in(view, view->names_arena, entry, name);
+}
+
+/* Initializes dir_entry_t with name allocated from the arena (can be NULL) and
+ * all other fields with default values. */
+static void
+init_dir_entry_in(view_t *view, str_arena_t *arena, dir_entry_t *entry,
+		const char name[])
+{
+	int in_arena;
+	entry->name = dup_entry_str(arena, name, &in_arena);
+	entry->arena_name = in_arena;
+	entry->arena_origin = 0;
+	entry->origin = &view->curr_dir[0];
+
+	entry->size = 0ULL;
+#ifndef _WIN32
+	entry->uid = (uid_t)-1;
+	entry->gid = (gid_t)-1;
+	entry->mode = (mode_t)0;
+	entry->inode = (ino_t)0;
+#else
+	entry->attrs = 0;
+#endif
+
+	entry->mtime = (time_t)0;
+	entry->atime = (time_t)0;
+	entry->ctime = (time_t)0;
+
+	entry->type = FT_UNK;
+	entry->nlinks = 0;
+	entry->dir_link = 0;
+	entry->hi_num = -1;
+	entry->name_dec_num = -1;
+
+	entry->child_count = 0;
+	entry->child_pos = 0;
+
+	/* All files start as unselected, unmatched and unmarked. */
+	entry->selected = 0;
+	entry->was_selected = 0;
+	entry->search_match = 0;
+	entry->marked = 0;
+	entry->temporary = 0;
+	entry->owns_origin = 0;
+	entry->folded = 0;
+	entry->partial_stats = 0;
+
+	entry->tag = -1;
+	entry->id = -1;
+}
+
+void
+replace_dir_entries(view_t *view, dir_entry_t **entries, int *count,
+		const dir_entry_t *with_entries, int with_count)
+{
+	dir_entry_t *new;
+	int i;
+
+	new = dynarray_extend(NULL, with_count*sizeof(*new));
+	if(new == NULL)
+	{
+		return;
+	}
+
+	memcpy(new, with_entries, sizeof(*new)*with_count);
+
+	for(i = 0; i < with_count; ++i)
+	{
+		dir_entry_t *const entry = &new[i];
+
+		entry->name = strdup(entry->name);
+		entry->origin = strdup(entry->origin);
+		entry->owns_origin = 1;
+		entry->arena_name = 0;
+		entry->arena_origin = 0;
+
+		if(entry->name == NULL || entry->origin == NULL)
+		{
+			int count_so_far = i + 1;
+			free_dir_entries(&new, &count_so_far);
+			return;
+		}
+	}
+
+	free_dir_entries(entries, count);
+	*entries = new;
+	*count = with_count;
+}
+
+void
+free_dir_entries(dir_entry_t **entries, int *count)
+{
+	int i;
+	for(i = 0; i < *count; ++i)
+	{
+		fentry_free(&(*entries)[i]);
+	}
+
+	dynarray_free(*entries);
+	*entries = NULL;
+	*count = 0;
+}
+
+void
+fentry_free(dir_entry_t *entry)
+{
+	release_entry_str(entry->name, entry->arena_name);
+	entry->name = NULL;
+	entry->arena_name = 0;
+
+	if(entry->owns_origin)
+	{
+		release_entry_str(entry->origin, entry->arena_origin);
+		entry->origin = NULL;
+		entry->arena_origin = 0;
+	}
+}
+
+int
+fentry_from_path(view_t *view, const char path[], dir_entry_t *entry)
+{
+	init_dir_entry_in(view, NULL, entry, get_last_path_component(path));
+
+	char origin[PATH_MAX + 1];
+	copy_str(origin, sizeof(origin), path);
+	remove_last_path_component(origin);
+
+	entry->origin = strdup(origin);
+	entry->owns_origin = 1;
+
+	if(entry->name == NULL || entry->origin == NULL ||
+			fill_dir_entry_by_path(entry, path) != 0)
+	{
+		fentry_free(entry);
+		return 1;
+	}
+
+	return 0;
+}
+
+int
+fentry_set_name(dir_entry_t *entry, const char name[])
+{
+	char *const copy = strdup(name);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	release_entry_str(entry->name, entry->arena_name);
+	entry->name = copy;
+	entry->arena_name = 0;
+	return 0;
+}
+
+int
+fentry_set_origin(dir_entry_t *entry, const char origin[])
+{
+	char *const copy = strdup(origin);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	if(entry->owns_origin)
+	{
+		release_entry_str(entry->origin, entry->arena_origin);
+	}
+	entry->origin = copy;
+	entry->owns_origin = 1;
+	entry->arena_origin = 0;
+	return 0;
+}
+
+/* Makes a copy of the string for an entry.  The copy is allocated from the
+ * arena if it's not NULL and that succeeds, otherwise on a heap.  *in_arena is
+ * set accordingly.  Returns the copy or NULL on error. */
+static char *
+dup_entry_str(str_arena_t *arena, const char str[], int *in_arena)
+{
+	char *copy = (arena == NULL ? NULL : str_arena_dup(arena, str));
+	*in_arena = (copy != NULL);
+	if(copy == NULL)
+	{
+		copy = strdup(str);
+	}
+	return copy;
+}
+
+/* Frees string of an entry which might have been allocated from an arena. */
+static void
+release_entry_str(char str[], int in_arena)
+{
+	if(in_arena)
+	{
+		str_arena_release(str);
+	}
+	else
+	{
+		free(str);
+	}
+}
+
+/* Starts new arena for entries of the view, so that strings of the next list
+ * don't share chunks with the previous one. */
+static void
+renew_names_arena(view_t *view)
+{
+	str_arena_free(view->names_arena);
+	view->names_arena = str_arena_create();
+}
+
+dir_entry_t *
+add_dir_entry(dir_entry_t **list, size_t *list_size, const dir_entry_t *entry)
+{
+	dir_entry_t *const new_entry = alloc_dir_entry(list, *list_size);
+	if(new_entry == NULL)
+	{
+		return NULL;
+	}
+
+	*new_entry = *entry;
+	++*list_size;
+	return new_entry;
+}
+
+dir_entry_t *
+entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
+		const char path[])
+{
+	return entry_list_put(view, list, list_size, path, NULL);
+}
+
+/* Adds an entry for the path to the list.  Information about the file is taken
+ * from info unless it's NULL, in which case it's queried.  Returns the entry or
+ * NULL on error. */
+static dir_entry_t *
+entry_list_put(view_t *view, dir_entry_t **list, int *list_size,
+		const char path[], const dir_entry_t *info)
+{
+	dir_entry_t *const dir_entry = alloc_dir_entry(list, *list_size);
+	if(dir_entry == NULL)
+	{
+		return NULL;
+	}
+
+	init_dir_entry(view, dir_entry, get_last_path_component(path));
+
+	char origin[PATH_MAX + 1];
+	copy_str(origin, sizeof(origin), path);
+	remove_last_path_component(origin);
+
+	int in_arena;
+	dir_entry->origin = dup_entry_str(view->names_arena, origin, &in_arena);
+	dir_entry->owns_origin = 1;
+	dir_entry->arena_origin = in_arena;
+
+	if(info != NULL)
+	{
+		copy_entry_info(dir_entry, info, path);
+	}
+	else if(fill_dir_entry_by_path(dir_entry, path) != 0)
+	{
+		fentry_free(dir_entry);
+		return NULL;
+	}
+
+	++*list_size;
+	return dir_entry;
+}
+
+/* Copies information about a file queried in advance into the entry. */
+static void
+copy_entry_info(dir_entry_t *entry, const dir_entry_t *info, const char path[])
+{
+	entry->type = info->type;
+	entry->size = info->size;
+#ifndef _WIN32
+	entry->uid = info->uid;
+	entry->gid = info->gid;
+	entry->mode = info->mode;
+	entry->inode = info->inode;
+#else
+	entry->attrs = info->attrs;
+#endif
+	entry->mtime = info->mtime;
+	entry->atime = info->atime;
+	entry->ctime = info->ctime;
+	entry->nlinks = info->nlinks;
+
+#ifndef _WIN32
+	if(entry->type == FT_LINK)
+	{
+		fill_link_info(entry, path);
+	}
+#endif
+}
+
+/* Allocates one more directory entry for the *list of size list_size by
+ * extending it.  Returns pointer to new entry or NULL on failure. */
+static dir_entry_t *
+alloc_dir_entry(dir_entry_t **list, int list_size)
+{
+	dir_entry_t *new_entry_list = dynarray_extend(*list, sizeof(dir_entry_t));
+	if(new_entry_list == NULL)
+	{
+		return NULL;
+	}
+
+	*list = new_entry_list;
+	return &new_entry_list[list_size];
+}
+
+void
+check_if_filelist_has_changed(view_t *view)
+{
+	int failed, changed;
+	const char *const curr_dir = flist_get_dir(view);
+
+	if(!flist_custom_active(view) || !cv_tree(view->custom.type))
+	{
+		drop_tree_watch(view);
+	}
+
+	if(view->on_slow_fs ||
+			(flist_custom_active(view) && !cv_tree(view->custom.type)) ||
+			is_unc_root(curr_dir))
+	{
+		return;
+	}
+
+	/* Changes of regular lists can be applied without relisting directory. */
+	fswatch_changes_t changes = {};
+	int incremental = 0;
+
+	if(view->watch == NULL)
+	{
+		/* If watch is not initialized, try to do this, but don't fail on error. */
+
+		update_dir_watcher(view);
+		failed = 0;
+		changed = (view->watch != NULL);
+	}
+	else
+	{
+		const int regular = !flist_custom_active(view);
+		FSWatchState state = poll_watcher(view->watch, curr_dir,
+				regular ? &changes : NULL);
+		changed = (state != FSWS_UNCHANGED);
+		failed = (state == FSWS_ERRORED);
+		incremental = (regular && state == FSWS_UPDATED && changes.complete);
+
+		if(state == FSWS_UPDATED || state == FSWS_REPLACED)
+		{
+			locidx_dir_changed(curr_dir);
+		}
+	}
+
+	/* Check if we still have permission to visit this directory. */
+	if(os_access(curr_dir, X_OK) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Can't access(X_OK) \"%s\"", curr_dir);
+		log_cwd();
+		failed = 1;
+	}
+
+	if(failed)
+	{
+		show_error_msgf("Directory Check", "Cannot open %s", curr_dir);
+
+		leave_invalid_dir(view);
+		(void)change_directory(view, curr_dir);
+		flist_sel_stash(view);
+		ui_view_schedule_reload(view);
+		fswatch_free_changes(&changes);
+		return;
+	}
+
+	if(changed)
+	{
+		if(incremental && apply_dir_changes(view, &changes) == 0)
+		{
+			ui_view_schedule_redraw(view);
+		}
+		else
+		{
+			ui_view_schedule_reload(view);
+		}
+	}
+	else if(flist_custom_active(view) && cv_tree(view->custom.type))
+	{
+		if(flist_is_fs_backed(view))
+		{
+			check_tree_for_changes(view);
+		}
+	}
+	else
+	{
+		if(flist_update_cache(view, &view->left_column, view->left_column.dir) ||
+				flist_update_cache(view, &view->right_column, view->right_column.dir))
+		{
+			ui_view_schedule_redraw(view);
+		}
+	}
+
+	fswatch_free_changes(&changes);
+}
+
+/* Applies changes of files of current directory to the file list of the view
+ * without listing the directory, which matters for large directories.  Returns
+ * zero on success and non-zero if the list needs to be reloaded instead. */
+static int
+apply_dir_changes(view_t *view, const fswatch_changes_t *changes)
+{
+	/* Relisting is cheap enough for small directories and handles bulk changes
+	 * better. */
+	if(view->local_filter.in_progress ||
+			changes->count > view->list_rows/4 + DELTA_RELOAD_MIN)
+	{
+		return 1;
+	}
+
+	/* ".." is added to an empty list even if it's not to be displayed. */
+	if(view->list_rows == 1 && is_parent_dir(view->dir_entry[0].name) &&
+			!cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)))
+	{
+		return 1;
+	}
+
+	int *const positions = reallocarray(NULL, changes->count,
+			sizeof(*positions));
+	dir_entry_t *const pending = reallocarray(NULL, changes->count,
+			sizeof(*pending));
+	char *const dropped = calloc(view->list_rows, 1);
+	if(positions == NULL || pending == NULL || dropped == NULL ||
+			find_changed_entries(view, changes, positions) != 0)
+	{
+		free(positions);
+		free(pending);
+		free(dropped);
+		return 1;
+	}
+
+	/* Symbolic links are resolved relative to current directory. */
+	char *const saved_cwd = save_cwd();
+	(void)vifm_chdir(view->curr_dir);
+
+	int npending = 0;
+	/* Position of cursor entry in pending array or -1. */
+	int cursor_pending = -1;
+
+	int i;
+	for(i = 0; i < changes->count; ++i)
+	{
+		const char *const name = changes->names[i];
+		const int pos = positions[i];
+
+		dir_entry_t entry;
+		if(pos >= 0)
+		{
+			entry = view->dir_entry[pos];
+			dropped[pos] = 1;
+		}
+		else
+		{
+			init_dir_entry(view, &entry, name);
+		}
+
+		char full_path[PATH_MAX + 1];
+		snprintf(full_path, sizeof(full_path), "%s/%s", flist_get_dir(view), name);
+
+		const int exists = (fill_dir_entry_by_path(&entry, full_path) == 0);
+		const int visible = exists
+		                 && tree_candidate_is_visible(view, view->curr_dir, name,
+		                                              fentry_is_dir(&entry), 1);
+
+		/* A file that existed, but wasn't listed, must have been filtered out. */
+		if(pos < 0 && !changes->added[i])
+		{
+			--view->filtered;
+		}
+		if(exists && !visible)
+		{
+			++view->filtered;
+		}
+
+		if(visible)
+		{
+			/* Reset cached data that depends on the file. */
+			entry.hi_num = -1;
+			entry.name_dec_num = -1;
+
+			if(pos == view->list_pos)
+			{
+				cursor_pending = npending;
+			}
+			pending[npending++] = entry;
+			continue;
+		}
+
+		if(pos >= 0)
+		{
+			view->selected_files -= (entry.selected != 0);
+			view->matches -= (entry.search_match != 0);
+		}
+		fentry_free(&entry);
+	}
+
+	restore_cwd(saved_cwd);
+
+	/* Remove entries that have changed, keeping cursor on the same entry if it's
+	 * still there. */
+	int j = 0, removed_before_cursor = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(dropped[i])
+		{
+			removed_before_cursor += (i < view->list_pos);
+			continue;
+		}
+		view->dir_entry[j++] = view->dir_entry[i];
+	}
+	view->list_rows = j;
+	view->list_pos -= removed_before_cursor;
+
+	free(dropped);
+	free(positions);
+
+	int resort = 0;
+	dir_entry_t *const extended = (npending == 0)
+	                            ? view->dir_entry
+	                            : dynarray_extend(view->dir_entry,
+	                                              sizeof(*pending)*npending);
+	if(extended == NULL)
+	{
+		for(i = 0; i < npending; ++i)
+		{
+			fentry_free(&pending[i]);
+		}
+		npending = 0;
+		resort = 1;
 	}
 	else
 	{
-		error = trie_get(trie, entry->name, data);
+		view->dir_entry = extended;
 	}
 
-	return (error == 0);
-}
+	/* Put changed entries at their places in sorted list. */
+	for(i = 0; i < npending; ++i)
+	{
+		int pos = (resort ? -1 : sort_find_insert_pos(view, &pending[i]));
+		if(pos < 0)
+		{
+			pos = view->list_rows;
+			resort = 1;
+		}
 
-/* Merges data from previous entry into the new one.  Both entries should
- * correspond to the same file (their names must match). */
-static void
-merge_entries(dir_entry_t *new, const dir_entry_t *prev)
-{
-	new->id = prev->id;
+		memmove(&view->dir_entry[pos + 1], &view->dir_entry[pos],
+				sizeof(*pending)*(view->list_rows - pos));
+		view->dir_entry[pos] = pending[i];
+		++view->list_rows;
 
-	new->selected = prev->selected;
-	new->was_selected = prev->was_selected;
-	new->folded = prev->folded;
+		if(i == cursor_pending)
+		{
+			view->list_pos = pos;
+		}
+		else if(pos <= view->list_pos)
+		{
+			++view->list_pos;
+		}
+	}
 
-	/* No need to check for name here, because only entries with exactly the same
-	 * names are merged. */
-	if(new->type == prev->type)
+	free(pending);
+
+	if(view->filtered < 0)
 	{
-		new->hi_num = prev->hi_num;
-		new->name_dec_num = prev->name_dec_num;
+		view->filtered = 0;
+	}
+
+	if(view->list_rows == 0)
+	{
+		/* Leave the view in a usable state until it's reloaded. */
+		add_parent_dir(view);
+		return 1;
+	}
+
+	if(view->list_pos >= view->list_rows)
+	{
+		view->list_pos = view->list_rows - 1;
 	}
+
+	if(resort)
+	{
+		resort_dir_list(0, view);
+	}
+
+	fview_list_updated(view);
+	return extended == NULL;
 }
 
-/* Corrects selected item position in the list.  Returns updated value of the
- * closest variable, which initially should be INT_MIN. */
+/* Looks up entries that correspond to changed files.  Sets positions[i] to
+ * index of entry of i-th file or to -1 if it's not in the list.  Returns zero
+ * on success, otherwise non-zero is returned. */
 static int
-correct_pos(view_t *view, int pos, int dist, int closest)
+find_changed_entries(view_t *view, const fswatch_changes_t *changes,
+		int positions[])
 {
-	if(dist == 0)
+	trie_t *const names = trie_create(/*free_func=*/NULL);
+
+	int i;
+	for(i = 0; i < changes->count; ++i)
 	{
-		closest = 0;
-		view->list_pos = pos;
+		positions[i] = -1;
+		if(trie_set(names, changes->names[i], &positions[i]) < 0)
+		{
+			trie_free(names);
+			return 1;
+		}
 	}
-	else if((closest < 0 && dist > closest) || (closest > 0 && dist < closest))
+
+	/* One pass over the list is cheaper than a lookup per name. */
+	for(i = 0; i < view->list_rows; ++i)
 	{
-		closest = dist;
-		view->list_pos = pos;
+		void *data;
+		if(trie_get(names, view->dir_entry[i].name, &data) == 0)
+		{
+			*(int *)data = i;
+		}
 	}
-	return closest;
+
+	trie_free(names);
+	return 0;
 }
 
-/* Performs actions needed to rescue from abnormal situation with empty
- * filelist.  Returns non-zero if file list was reloaded. */
-static int
-rescue_from_empty_filelist(view_t *view)
+/* Checks whether any of directories of a tree view has changed and reloads
+ * either changed subtrees or the whole view. */
+static void
+check_tree_for_changes(view_t *view)
 {
-	/* It is possible to set the file name filter so that no files are showing
-	 * in the / directory.  All other directories will always show at least the
-	 * ../ file.  This resets the filter and reloads the directory. */
-	if(name_filters_empty(view))
+	if(view->tree_watch == NULL)
 	{
-		return 0;
-	}
+		/* Trying again on every check would be even worse than polling, because
+		 * failure is likely caused by running out of watches. */
+		if(!view->tree_watch_failed)
+		{
+			view->tree_watch = make_tree_watch(view);
+			view->tree_watch_failed = (view->tree_watch == NULL);
+		}
 
-	show_error_msgf("Filter error",
-			"The %s\"%s\" pattern did not match any files. It was reset.",
-			view->invert ? "" : "inverted ", matcher_get_expr(view->manual_filter));
+		/* Changes made before the watch was set up aren't reported by it and
+		 * without the watch directories are polled. */
+		if(tree_has_changed(view->dir_entry, view->list_rows))
+		{
+			ui_view_schedule_reload(view);
+		}
+		return;
+	}
 
-	name_filters_drop(view);
+	strlist_t changed = {};
+	const FSWatchState state = fswatch_poll_set(view->tree_watch, &changed);
 
-	load_dir_list(view, 1);
-	if(view->list_rows < 1)
+	int i;
+	for(i = 0; i < changed.nitems; ++i)
 	{
-		leave_invalid_dir(view);
-		(void)change_directory(view, view->curr_dir);
-		load_dir_list(view, 0);
+		locidx_dir_changed(changed.items[i]);
 	}
 
-	return 1;
+	if(state == FSWS_ERRORED ||
+			(state == FSWS_UPDATED && reload_subtrees(view, &changed) != 0))
+	{
+		ui_view_schedule_reload(view);
+	}
+	free_string_array(changed.items, changed.nitems);
 }
 
-void
-add_parent_dir(view_t *view)
+/* Checks whether tree-view needs a reload (any of subdirectories were changed).
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+tree_has_changed(const dir_entry_t *entries, size_t nchildren)
 {
-	add_parent_entry(view, &view->dir_entry, &view->list_rows);
+	size_t pos = 0U;
+	while(pos < nchildren)
+	{
+		const dir_entry_t *const entry = &entries[pos];
+		if(entry->type == FT_DIR && !is_parent_dir(entry->name))
+		{
+			char full_path[PATH_MAX + 1];
+			struct stat s;
+
+			get_full_path_of(entry, sizeof(full_path), full_path);
+			if(os_stat(full_path, &s) != 0 || entry->mtime != s.st_mtime)
+			{
+				return 1;
+			}
+
+			if(tree_has_changed(entry + 1, entry->child_count))
+			{
+				return 1;
+			}
+		}
+
+		pos += entry->child_count + 1;
+	}
+	return 0;
 }
 
-/* Adds parent directory entry (..) to specified list of entries. */
-static void
-add_parent_entry(view_t *view, dir_entry_t **entries, int *count)
+/* Creates a watcher for all directories of a tree view whose contents are
+ * displayed.  Returns the watcher or NULL on error. */
+static fswatch_t *
+make_tree_watch(view_t *view)
 {
-	dir_entry_t *const dir_entry = alloc_dir_entry(entries, *count);
-	if(dir_entry == NULL)
+	fswatch_t *const watch = fswatch_create_set();
+	if(watch == NULL)
 	{
-		show_error_msg("Memory Error", "Unable to allocate enough memory");
-		return;
+		return NULL;
 	}
 
-	if(init_parent_entry(view, dir_entry, "..") == 0)
+	if(add_tree_watches(watch, view->dir_entry, view->list_rows) != 0)
 	{
-		++*count;
+		fswatch_free(watch);
+		return NULL;
 	}
+
+	return watch;
 }
 
-/* Initializes dir_entry_t with name and all other fields with default
- * values. */
-static void
-init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
+/* Adds unfolded directories among the entries to the watcher.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+add_tree_watches(fswatch_t *watch, const dir_entry_t *entries, int count)
 {
-	entry->name = strdup(name);
-	entry->origin = &view->curr_dir[0];
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		const dir_entry_t *const entry = &entries[i];
+		if(entry->type == FT_DIR && !entry->folded && !is_parent_dir(entry->name))
+		{
+			char full_path[PATH_MAX + 1];
+			get_full_path_of(entry, sizeof(full_path), full_path);
+			if(fswatch_add(watch, full_path) != 0)
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
 
-	entry->size = 0ULL;
-#ifndef _WIN32
-	entry->uid = (uid_t)-1;
-	entry->gid = (gid_t)-1;
-	entry->mode = (mode_t)0;
-	entry->inode = (ino_t)0;
-#else
-	entry->attrs = 0;
-#endif
+/* Reloads subtrees of a tree view rooted at changed directories.  Returns zero
+ * on success and non-zero if the whole view needs to be reloaded instead. */
+static int
+reload_subtrees(view_t *view, const strlist_t *changed)
+{
+	/* With local filter files can be attached to ancestors of their directories
+	 * (see add_files_recursively()), so subtrees aren't self-contained. */
+	if(view->custom.type != CV_TREE ||
+			!filter_is_empty(&view->local_filter.filter))
+	{
+		return 1;
+	}
 
-	entry->mtime = (time_t)0;
-	entry->atime = (time_t)0;
-	entry->ctime = (time_t)0;
+	char full_path[PATH_MAX + 1];
+	get_current_full_path(view, sizeof(full_path), full_path);
 
-	entry->type = FT_UNK;
-	entry->nlinks = 0;
-	entry->dir_link = 0;
-	entry->hi_num = -1;
-	entry->name_dec_num = -1;
+	int i;
+	for(i = 0; i < changed->nitems; ++i)
+	{
+		int nfiltered;
+		if(!is_covered_path(changed, i) &&
+				reload_subtree(view, changed->items[i], &nfiltered) != 0)
+		{
+			return 1;
+		}
+	}
 
-	entry->child_count = 0;
-	entry->child_pos = 0;
+	sort_dir_list(0, view);
 
-	/* All files start as unselected, unmatched and unmarked. */
-	entry->selected = 0;
-	entry->was_selected = 0;
-	entry->search_match = 0;
-	entry->marked = 0;
-	entry->temporary = 0;
-	entry->owns_origin = 0;
-	entry->folded = 0;
+	if(full_path[0] != '\0')
+	{
+		(void)set_position_by_path(view, full_path);
+	}
+	fpos_ensure_valid_pos(view);
 
-	entry->tag = -1;
-	entry->id = -1;
+	ui_view_schedule_redraw(view);
+	return 0;
 }
 
-void
-replace_dir_entries(view_t *view, dir_entry_t **entries, int *count,
-		const dir_entry_t *with_entries, int with_count)
+/* Checks whether reloading another path of the list reloads the path at the
+ * specified position as well.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_covered_path(const strlist_t *paths, int pos)
 {
-	dir_entry_t *new;
 	int i;
+	for(i = 0; i < paths->nitems; ++i)
+	{
+		/* Of identical paths only the first one isn't covered. */
+		if(i != pos && path_starts_with(paths->items[pos], paths->items[i]) &&
+				(i < pos || stroscmp(paths->items[pos], paths->items[i]) != 0))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Replaces entries of a subtree of a tree view with fresh ones.  *nfiltered is
+ * set to number of files filtered out within the new subtree.  Returns zero on
+ * success and non-zero if the whole view needs to be reloaded instead. */
+static int
+reload_subtree(view_t *view, const char path[], int *nfiltered)
+{
+	*nfiltered = 0;
+
+	const dir_entry_t *const dir = entry_from_path(view, view->dir_entry,
+			view->list_rows, path);
+	if(dir == NULL || dir->folded)
+	{
+		/* Contents of the directory isn't displayed (e.g., it was excluded). */
+		return 0;
+	}
+
+	/* Custom list is used below, so make sure it's not being filled. */
+	if(dir->type != FT_DIR || view->custom.entry_count != 0 ||
+			view->custom.paths_cache != NULL)
+	{
+		return 1;
+	}
+
+	const int pos = dir - view->dir_entry;
+	const int old_count = dir->child_count + 1;
+	const int child_pos = dir->child_pos;
+
+	/* Build the subtree in the custom list as if it was a separate tree. */
+	int filtered = -1;
+	view->custom.paths_cache = trie_create(/*free_func=*/NULL);
+	if(flist_custom_add(view, path) != NULL)
+	{
+		ui_cancellation_push_on();
+		tree_scan_t *const scan = scan_tree(view, path,
+				view->custom.excluded_paths, view->custom.folded_paths, INT_MAX);
+		filtered = add_files_recursively(view, path, scan,
+				view->custom.excluded_paths, view->custom.folded_paths, 0, 0, INT_MAX);
+		free_tree_scan(scan);
+		ui_cancellation_pop();
+		ui_sb_quick_msg_clear();
+	}
+	trie_free(view->custom.paths_cache);
+	view->custom.paths_cache = NULL;
 
-	new = dynarray_extend(NULL, with_count*sizeof(*new));
-	if(new == NULL)
+	if(filtered < 0 || ui_cancellation_requested())
 	{
-		return;
+		free_dir_entries(&view->custom.entries, &view->custom.entry_count);
+		return 1;
 	}
+	*nfiltered = filtered;
 
-	memcpy(new, with_entries, sizeof(*new)*with_count);
+	const int new_count = view->custom.entry_count;
+	const int delta = new_count - old_count;
 
-	for(i = 0; i < with_count; ++i)
+	if(delta > 0)
 	{
-		dir_entry_t *const entry = &new[i];
+		dir_entry_t *const extended = dynarray_extend(view->dir_entry,
+				sizeof(*extended)*delta);
+		if(extended == NULL)
+		{
+			free_dir_entries(&view->custom.entries, &view->custom.entry_count);
+			return 1;
+		}
+		view->dir_entry = extended;
+	}
 
-		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
-		entry->owns_origin = 1;
+	dir_entry_t *const entries = view->custom.entries;
+	entries[0].child_count = new_count - 1;
+	entries[0].child_pos = child_pos;
 
-		if(entry->name == NULL || entry->origin == NULL)
+	merge_subtree(view, &view->dir_entry[pos], old_count, entries, new_count);
+
+	int i;
+	for(i = 0; i < old_count; ++i)
+	{
+		fentry_free(&view->dir_entry[pos + i]);
+	}
+
+	/* Entries that follow the subtree and have parents before it move away from
+	 * their parents. */
+	for(i = pos + old_count; i < view->list_rows; ++i)
+	{
+		if(i - view->dir_entry[i].child_pos < pos)
 		{
-			int count_so_far = i + 1;
-			free_dir_entries(&new, &count_so_far);
-			return;
+			view->dir_entry[i].child_pos += delta;
 		}
 	}
 
-	free_dir_entries(entries, count);
-	*entries = new;
-	*count = with_count;
+	memmove(&view->dir_entry[pos + new_count], &view->dir_entry[pos + old_count],
+			sizeof(*entries)*(view->list_rows - (pos + old_count)));
+	memcpy(&view->dir_entry[pos], entries, sizeof(*entries)*new_count);
+	view->list_rows += delta;
+
+	dynarray_free(view->custom.entries);
+	view->custom.entries = NULL;
+	view->custom.entry_count = 0;
+
+	/* Ancestors of the subtree precede it and their positions don't change. */
+	dir_entry_t *entry = &view->dir_entry[pos];
+	while(entry->child_pos != 0)
+	{
+		entry -= entry->child_pos;
+		entry->child_count += delta;
+	}
+
+	/* Watch directories that have appeared in the subtree.  Missing watcher will
+	 * pick them up on its creation. */
+	if(view->tree_watch == NULL)
+	{
+		return 0;
+	}
+	return add_tree_watches(view->tree_watch, &view->dir_entry[pos], new_count);
 }
 
-void
-free_dir_entries(dir_entry_t **entries, int *count)
+/* Transfers state of entries of a subtree to their counterparts in its new
+ * version. */
+static void
+merge_subtree(view_t *view, dir_entry_t *prev, int prev_count,
+		dir_entry_t *entries, int count)
 {
+	trie_t *const prev_paths = trie_create(/*free_func=*/NULL);
+
 	int i;
-	for(i = 0; i < *count; ++i)
+	for(i = 0; i < prev_count; ++i)
 	{
-		fentry_free(&(*entries)[i]);
+		add_to_trie(prev_paths, view, &prev[i]);
+		view->selected_files -= (prev[i].selected != 0);
 	}
 
-	dynarray_free(*entries);
-	*entries = NULL;
-	*count = 0;
+	for(i = 0; i < count; ++i)
+	{
+		void *data;
+		if(is_in_trie(prev_paths, view, &entries[i], &data))
+		{
+			merge_entries(&entries[i], data);
+		}
+		view->selected_files += (entries[i].selected != 0);
+	}
+
+	trie_free(prev_paths);
 }
 
-void
-fentry_free(dir_entry_t *entry)
+/* Frees watcher of tree view directories if it's present and allows setting
+ * it up again. */
+static void
+drop_tree_watch(view_t *view)
 {
-	free(entry->name);
-	entry->name = NULL;
+	fswatch_free(view->tree_watch);
+	view->tree_watch = NULL;
+	view->tree_watch_failed = 0;
+}
 
-	if(entry->owns_origin)
+int
+flist_update_cache(view_t *view, cached_entries_t *cache, const char path[])
+{
+	if(path == NULL)
 	{
-		free(entry->origin);
-		entry->origin = NULL;
+		return 0;
 	}
-}
 
-dir_entry_t *
-add_dir_entry(dir_entry_t **list, size_t *list_size, const dir_entry_t *entry)
-{
-	dir_entry_t *const new_entry = alloc_dir_entry(list, *list_size);
-	if(new_entry == NULL)
+	flist_listing_t *const listing = get_listing(view, path, /*create=*/1);
+	if(listing == NULL || listing->watch == NULL)
 	{
-		return NULL;
+		/* Reset the cache on failure to list or to watch the directory to do not
+		 * accidentally provide incorrect data. */
+		put_listing(listing);
+		flist_free_cache(cache);
+		return 0;
 	}
 
-	*new_entry = *entry;
-	++*list_size;
-	return new_entry;
+	if(listing == cache->listing)
+	{
+		put_listing(listing);
+		return 0;
+	}
+
+	flist_free_cache(cache);
+	cache->listing = listing;
+	replace_string(&cache->dir, path);
+	cache->entries = copy_listing(view, listing, 0, 1);
+	return 1;
 }
 
-dir_entry_t *
-entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
-		const char path[])
+/* Retrieves up to date listing of a directory reusing the shared one if
+ * possible.  If listing isn't available and create flag is set, the directory
+ * is listed.  The listing should be released via put_listing().  Returns the
+ * listing or NULL. */
+static flist_listing_t *
+get_listing(view_t *view, const char path[], int create)
 {
-	dir_entry_t *const dir_entry = alloc_dir_entry(list, *list_size);
-	if(dir_entry == NULL)
+	int i;
+	for(i = 0; i < nlistings; ++i)
 	{
-		return NULL;
+		if(stroscmp(listings[i]->path, path) == 0)
+		{
+			break;
+		}
 	}
 
-	init_dir_entry(view, dir_entry, get_last_path_component(path));
+	if(i < nlistings)
+	{
+		flist_listing_t *const listing = listings[i];
+		drop_listing(i);
 
-	dir_entry->origin = strdup(path);
-	dir_entry->owns_origin = 1;
-	remove_last_path_component(dir_entry->origin);
+		if(poll_watcher(listing->watch, path, NULL) == FSWS_UNCHANGED)
+		{
+			++listing->refs;
+			add_listing(listing);
+			return listing;
+		}
+
+		listing->outdated = 1;
+		if(listing->refs == 0)
+		{
+			free_listing(listing);
+		}
+	}
 
-	if(fill_dir_entry_by_path(dir_entry, path) != 0)
+	if(!create)
 	{
-		fentry_free(dir_entry);
 		return NULL;
 	}
 
-	++*list_size;
-	return dir_entry;
+	flist_listing_t *const listing = make_listing(view, path);
+	if(listing != NULL && listing->watch != NULL)
+	{
+		add_listing(listing);
+		trim_listings();
+	}
+	return listing;
 }
 
-/* Allocates one more directory entry for the *list of size list_size by
- * extending it.  Returns pointer to new entry or NULL on failure. */
-static dir_entry_t *
-alloc_dir_entry(dir_entry_t **list, int list_size)
+/* Lists all files of a directory.  Returns new listing with one reference or
+ * NULL on error.  The listing is marked as outdated if the directory can't be
+ * watched. */
+static flist_listing_t *
+make_listing(view_t *view, const char path[])
 {
-	dir_entry_t *new_entry_list = dynarray_extend(*list, sizeof(dir_entry_t));
-	if(new_entry_list == NULL)
+	flist_listing_t *const listing = calloc(1, sizeof(*listing));
+	if(listing == NULL)
 	{
 		return NULL;
 	}
 
-	*list = new_entry_list;
-	return &new_entry_list[list_size];
-}
+	listing->path = strdup(path);
+	if(listing->path == NULL)
+	{
+		free(listing);
+		return NULL;
+	}
 
-void
-check_if_filelist_has_changed(view_t *view)
-{
-	int failed, changed;
-	const char *const curr_dir = flist_get_dir(view);
+	/* Start watching before reading the directory to not miss any changes. */
+	listing->watch = fswatch_create(path);
+	listing->outdated = (listing->watch == NULL);
+	listing->refs = 1;
 
-	if(view->on_slow_fs ||
-			(flist_custom_active(view) && !cv_tree(view->custom.type)) ||
-			is_unc_root(curr_dir))
+	int len;
+	char **list = list_all_files(path, &len);
+	if(len < 0)
 	{
-		return;
+		free_listing(listing);
+		return NULL;
 	}
 
-	if(view->watch == NULL)
+	int i;
+	for(i = 0; i < len; ++i)
 	{
-		/* If watch is not initialized, try to do this, but don't fail on error. */
+		dir_entry_t *const entry = alloc_dir_entry(&listing->entries,
+				listing->nentries);
+		if(entry == NULL)
+		{
+			break;
+		}
 
-		update_dir_watcher(view);
-		failed = 0;
-		changed = (view->watch != NULL);
-	}
-	else
-	{
-		FSWatchState state = poll_watcher(view->watch, curr_dir);
-		changed = (state != FSWS_UNCHANGED);
-		failed = (state == FSWS_ERRORED);
+		init_dir_entry_in(view, NULL, entry, list[i]);
+		entry->origin = listing->path;
+
+		char *const full_path = format_str("%s/%s", path, list[i]);
+		if(fill_dir_entry_by_path(entry, full_path) == 0)
+		{
+			++listing->nentries;
+		}
+		else
+		{
+			fentry_free(entry);
+		}
+		free(full_path);
 	}
+	free_string_array(list, len);
 
-	/* Check if we still have permission to visit this directory. */
-	if(os_access(curr_dir, X_OK) != 0)
+	return listing;
+}
+
+/* Appends listing to the list of shared ones marking it as most recently
+ * used. */
+static void
+add_listing(flist_listing_t *listing)
+{
+	flist_listing_t **const new_listings = reallocarray(listings, nlistings + 1,
+			sizeof(*listings));
+	if(new_listings == NULL)
 	{
-		LOG_SERROR_MSG(errno, "Can't access(X_OK) \"%s\"", curr_dir);
-		log_cwd();
-		failed = 1;
+		listing->outdated = 1;
+		return;
 	}
 
-	if(failed)
-	{
-		show_error_msgf("Directory Check", "Cannot open %s", curr_dir);
+	listings = new_listings;
+	listings[nlistings++] = listing;
+}
 
-		leave_invalid_dir(view);
-		(void)change_directory(view, curr_dir);
-		flist_sel_stash(view);
-		ui_view_schedule_reload(view);
+/* Removes listing from the list of shared ones without freeing it. */
+static void
+drop_listing(int idx)
+{
+	memmove(&listings[idx], &listings[idx + 1],
+			sizeof(*listings)*(nlistings - 1 - idx));
+	--nlistings;
+}
+
+/* Releases a reference to the listing.  listing can be NULL. */
+static void
+put_listing(flist_listing_t *listing)
+{
+	if(listing == NULL || --listing->refs != 0)
+	{
 		return;
 	}
 
-	if(changed)
+	if(listing->outdated)
 	{
-		ui_view_schedule_reload(view);
+		free_listing(listing);
 	}
-	else if(flist_custom_active(view) && cv_tree(view->custom.type))
+	else
 	{
-		if(flist_is_fs_backed(view) &&
-				tree_has_changed(view->dir_entry, view->list_rows))
-		{
-			ui_view_schedule_reload(view);
-		}
+		trim_listings();
 	}
-	else
+}
+
+/* Frees least recently used listings that aren't referenced if there are too
+ * many of them. */
+static void
+trim_listings(void)
+{
+	int nspare = 0;
+	int i;
+	for(i = nlistings - 1; i >= 0; --i)
 	{
-		if(flist_update_cache(view, &view->left_column, view->left_column.dir) ||
-				flist_update_cache(view, &view->right_column, view->right_column.dir))
+		if(listings[i]->refs == 0 && ++nspare > SPARE_LISTINGS)
 		{
-			ui_view_schedule_redraw(view);
+			flist_listing_t *const listing = listings[i];
+			drop_listing(i);
+			free_listing(listing);
 		}
 	}
 }
 
-/* Checks whether tree-view needs a reload (any of subdirectories were changed).
- * Returns non-zero if so, otherwise zero is returned. */
-static int
-tree_has_changed(const dir_entry_t *entries, size_t nchildren)
+/* Frees listing which isn't in the list of shared ones. */
+static void
+free_listing(flist_listing_t *listing)
 {
-	size_t pos = 0U;
-	while(pos < nchildren)
+	free_dir_entries(&listing->entries, &listing->nentries);
+	fswatch_free(listing->watch);
+	free(listing->path);
+	free(listing);
+}
+
+/* Makes filtered copy of the listing for the view.  Returns the copy. */
+static entries_t
+copy_listing(view_t *view, const flist_listing_t *listing, int only_dirs,
+		int can_include_parent)
+{
+	entries_t copy = {};
+
+	int i;
+	for(i = 0; i < listing->nentries; ++i)
 	{
-		const dir_entry_t *const entry = &entries[pos];
-		if(entry->type == FT_DIR && !is_parent_dir(entry->name))
-		{
-			char full_path[PATH_MAX + 1];
-			struct stat s;
+		const dir_entry_t *const entry = &listing->entries[i];
+		const int is_dir = fentry_is_dir(entry);
 
-			get_full_path_of(entry, sizeof(full_path), full_path);
-			if(os_stat(full_path, &s) != 0 || entry->mtime != s.st_mtime)
-			{
-				return 1;
-			}
+		if((view->hide_dot && entry->name[0] == '.') || (only_dirs && !is_dir) ||
+				!filters_file_is_visible(view, listing->path, entry->name, is_dir, 0))
+		{
+			continue;
+		}
 
-			if(tree_has_changed(entry + 1, entry->child_count))
-			{
-				return 1;
-			}
+		dir_entry_t *const new_entry = alloc_dir_entry(&copy.entries,
+				copy.nentries);
+		if(new_entry == NULL)
+		{
+			break;
 		}
 
-		pos += entry->child_count + 1;
+		int in_arena;
+		*new_entry = *entry;
+		new_entry->name = dup_entry_str(view->names_arena, entry->name, &in_arena);
+		new_entry->arena_name = in_arena;
+		new_entry->origin = dup_entry_str(view->names_arena, listing->path,
+				&in_arena);
+		new_entry->arena_origin = in_arena;
+		new_entry->owns_origin = 1;
+		++copy.nentries;
 	}
-	return 0;
+
+	if(can_include_parent &&
+			cfg_parent_dir_is_visible(is_root_dir(listing->path)))
+	{
+		char *const full_path = format_str("%s/..", listing->path);
+		entry_list_add(view, &copy.entries, &copy.nentries, full_path);
+		free(full_path);
+	}
+
+	return copy;
 }
 
-int
-flist_update_cache(view_t *view, cached_entries_t *cache, const char path[])
+/* Fills file list of the view from a shared listing of its current directory
+ * if it's available and up to date.  Listings whose watchers can miss changes
+ * of files aren't used, because entering a directory is expected to show its
+ * actual state.  Returns zero on success, otherwise non-zero is returned. */
+static int
+list_dir_from_listing(view_t *view)
 {
-	int update = 0;
+	flist_listing_t *const listing = get_listing(view, view->curr_dir,
+			/*create=*/0);
+	if(listing == NULL)
+	{
+		return 1;
+	}
 
-	if(path == NULL)
+	if(!fswatch_tracks_files(listing->watch))
 	{
-		return 0;
+		put_listing(listing);
+		return 1;
 	}
 
-	if(cache->watch == NULL || stroscmp(cache->dir, path) != 0)
+	int i;
+	for(i = 0; i < listing->nentries; ++i)
 	{
-		fswatch_free(cache->watch);
+		dir_entry_t entry = listing->entries[i];
+
+#ifndef _WIN32
+		/* Watcher of a directory doesn't see changes of targets of symbolic
+		 * links. */
+		if(entry.type == FT_LINK)
+		{
+			char *const full_path = format_str("%s/%s", view->curr_dir, entry.name);
+			if(full_path != NULL)
+			{
+				fill_link_info(&entry, full_path);
+				free(full_path);
+			}
+		}
+#endif
 
-		cache->watch = fswatch_create(path);
-		if(cache->watch == NULL)
+		if((view->hide_dot && entry.name[0] == '.') ||
+				!filters_file_is_visible(view, view->curr_dir, entry.name,
+					fentry_is_dir(&entry), /*apply_local_filter=*/1))
 		{
-			/* Reset the cache on failure to create a watcher to do not accidentally
-			 * provide incorrect data. */
-			flist_free_cache(cache);
-			return 0;
+			++view->filtered;
+			continue;
 		}
 
-		replace_string(&cache->dir, path);
-
-		update = 1;
-	}
+		dir_entry_t *const new_entry = alloc_dir_entry(&view->dir_entry,
+				view->list_rows);
+		if(new_entry == NULL)
+		{
+			break;
+		}
 
-	if(poll_watcher(cache->watch, path) != FSWS_UNCHANGED || update)
-	{
-		free_dir_entries(&cache->entries.entries, &cache->entries.nentries);
-		cache->entries = flist_list_in(view, path, 0, 1);
-		return 1;
+		int in_arena;
+		*new_entry = entry;
+		new_entry->name = dup_entry_str(view->names_arena, entry.name, &in_arena);
+		new_entry->arena_name = in_arena;
+		new_entry->origin = &view->curr_dir[0];
+		new_entry->owns_origin = 0;
+		++view->list_rows;
 	}
 
+	put_listing(listing);
 	return 0;
 }
 
 /* Polls file-system watcher and re-enters current working directory of the
- * process if necessary.  Returns watcher's state. */
+ * process if necessary.  Names of changed files are collected into *changes
+ * unless it's NULL.  Returns watcher's state. */
 static FSWatchState
-poll_watcher(fswatch_t *watch, const char path[])
+poll_watcher(fswatch_t *watch, const char path[], fswatch_changes_t *changes)
 {
-	FSWatchState state = fswatch_poll(watch);
+	FSWatchState state = (changes == NULL)
+	                   ? fswatch_poll(watch)
+	                   : fswatch_poll_changes(watch, changes);
 
 	if(state == FSWS_ERRORED || state == FSWS_REPLACED)
 	{
@@ -2970,8 +4845,19 @@ flist_free_cache(cached_entries_t *cache)
 {
 	free_dir_entries(&cache->entries.entries, &cache->entries.nentries);
 	update_string(&cache->dir, NULL);
-	fswatch_free(cache->watch);
-	cache->watch = NULL;
+	put_listing(cache->listing);
+	cache->listing = NULL;
+}
+
+void
+flist_free_listing_watchers(void)
+{
+	int i;
+	for(i = 0; i < nlistings; ++i)
+	{
+		fswatch_free(listings[i]->watch);
+		listings[i]->watch = NULL;
+	}
 }
 
 void
@@ -3022,14 +4908,58 @@ flist_toggle_fold(view_t *view)
 	if(set_fold_state(view->custom.folded_paths, full_path, state))
 	{
 		curr->folded = !curr->folded;
-		/* We reload even on folding to update number of filtered entries
-		 * properly. */
-		ui_view_schedule_reload(view);
+		if(update_fold_in_place(view, curr, full_path) != 0)
+		{
+			ui_view_schedule_reload(view);
+		}
+	}
+}
+
+/* Updates list of a tree view after a fold of a directory was toggled without
+ * rereading the whole tree.  Folded directories aren't read on building a tree,
+ * so contents of the directory is read only on unfolding it.  Returns zero on
+ * success and non-zero if the whole view needs to be reloaded instead. */
+static int
+update_fold_in_place(view_t *view, dir_entry_t *dir, const char path[])
+{
+	/* With local filter files can be attached to ancestors of their directories
+	 * (see add_files_recursively()), so subtrees aren't self-contained. */
+	if(view->custom.type != CV_TREE ||
+			!filter_is_empty(&view->local_filter.filter))
+	{
+		return 1;
+	}
+
+	if(dir->folded)
+	{
+		/* Number of files filtered out within the subtree isn't known, but there
+		 * are none if nothing is filtered out. */
+		if(view->filtered != 0)
+		{
+			return 1;
+		}
+		remove_child_entries(view, dir);
+	}
+	else
+	{
+		int nfiltered;
+		if(reload_subtree(view, path, &nfiltered) != 0)
+		{
+			return 1;
+		}
+		view->filtered += nfiltered;
+
+		sort_dir_list(0, view);
+		(void)set_position_by_path(view, path);
 	}
+
+	fpos_ensure_valid_pos(view);
+	ui_view_schedule_redraw(view);
+	return 0;
 }
 
 /* Folds a single entry by removing all of its children and updating tree
- * metadata accordingly. */
+ * metadata and counters of the view accordingly. */
 static void
 remove_child_entries(view_t *view, dir_entry_t *entry)
 {
@@ -3041,7 +4971,10 @@ remove_child_entries(view_t *view, dir_entry_t *entry)
 	int i;
 	for(i = 0; i < child_count; ++i)
 	{
-		fentry_free(&entry[1 + i]);
+		dir_entry_t *const child = &entry[1 + i];
+		view->selected_files -= (child->selected != 0);
+		view->matches -= (child->search_match != 0);
+		fentry_free(child);
 	}
 
 	fix_tree_links(view->dir_entry, entry, pos, pos, 0, -child_count);
@@ -3360,54 +5293,16 @@ static entries_t
 flist_list_in(view_t *view, const char path[], int only_dirs,
 		int can_include_parent)
 {
-	entries_t siblings = {};
-	int len, i;
-	char **list;
-
-	list = list_all_files(path, &len);
-	if(len < 0)
+	flist_listing_t *const listing = get_listing(view, path, /*create=*/1);
+	if(listing == NULL)
 	{
-		siblings.nentries = -1;
+		entries_t siblings = { .nentries = -1 };
 		return siblings;
 	}
 
-	for(i = 0; i < len; ++i)
-	{
-		dir_entry_t *entry;
-		int is_dir;
-
-		if(view->hide_dot && list[i][0] == '.')
-		{
-			continue;
-		}
-
-		char *full_path = format_str("%s/%s", path, list[i]);
-		entry = entry_list_add(view, &siblings.entries, &siblings.nentries,
-				full_path);
-		free(full_path);
-
-		if(entry == NULL)
-		{
-			continue;
-		}
-
-		is_dir = fentry_is_dir(entry);
-		if((only_dirs && !is_dir) ||
-				!filters_file_is_visible(view, path, list[i], is_dir, 0))
-		{
-			fentry_free(entry);
-			--siblings.nentries;
-		}
-	}
-	free_string_array(list, len);
-
-	if(can_include_parent && cfg_parent_dir_is_visible(is_root_dir(path)))
-	{
-		char *const full_path = format_str("%s/..", path);
-		entry_list_add(view, &siblings.entries, &siblings.nentries, full_path);
-		free(full_path);
-	}
-
+	entries_t siblings = copy_listing(view, listing, only_dirs,
+			can_include_parent);
+	put_listing(listing);
 	return siblings;
 }
 
@@ -3503,6 +5398,56 @@ fentry_get_size(const view_t *view, const dir_entry_t *entry)
 	return (size == DCACHE_UNKNOWN ? entry->size : size);
 }
 
+int
+fentry_key_needs_stats(int key)
+{
+	switch(key)
+	{
+		case SK_BY_TIME_ACCESSED:
+		case SK_BY_TIME_CHANGED:
+#ifndef _WIN32
+		case SK_BY_GROUP_ID:
+		case SK_BY_GROUP_NAME:
+		case SK_BY_OWNER_ID:
+		case SK_BY_OWNER_NAME:
+#endif
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+void
+fentry_load_stats(const dir_entry_t *entry)
+{
+#ifndef _WIN32
+	if(!entry->partial_stats)
+	{
+		return;
+	}
+
+	/* The fields are logically part of the entry, they just weren't loaded. */
+	dir_entry_t *const mutable_entry = (dir_entry_t *)entry;
+	mutable_entry->partial_stats = 0;
+
+	char full_path[PATH_MAX + 1];
+	get_full_path_of(entry, sizeof(full_path), full_path);
+
+	struct stat s;
+	if(os_lstat(full_path, &s) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Can't lstat() \"%s\"", full_path);
+		return;
+	}
+
+	mutable_entry->uid = s.st_uid;
+	mutable_entry->gid = s.st_gid;
+	mutable_entry->atime = s.st_atime;
+	mutable_entry->ctime = s.st_ctime;
+#endif
+}
+
 int
 iter_selected_entries(view_t *view, dir_entry_t **entry)
 {
@@ -3810,16 +5755,19 @@ void
 fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 {
 	char *const old_name = entry->name;
+	const int old_in_arena = entry->arena_name;
 
 	/* Rename file in internal structures for correct positioning of cursor
 	 * after reloading, as cursor will be positioned on the file with the same
-	 * name. */
+	 * name.  New name is put on a heap, because arena of the view might be
+	 * shared with unrelated lists by now. */
 	entry->name = strdup(to);
 	if(entry->name == NULL)
 	{
 		entry->name = old_name;
 		return;
 	}
+	entry->arena_name = 0;
 
 	/* Name change can affect name specific highlight and decorations, so reset
 	 * the caches. */
@@ -3849,10 +5797,11 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 				chosp(new_origin);
 				if(e->owns_origin)
 				{
-					free(e->origin);
+					release_entry_str(e->origin, e->arena_origin);
 				}
 				e->origin = new_origin;
 				e->owns_origin = 1;
+				e->arena_origin = 0;
 
 				/* Clone visible child folds. */
 				e->folded = 0;
@@ -3882,7 +5831,7 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 		}
 	}
 
-	free(old_name);
+	release_entry_str(old_name, old_in_arena);
 }
 
 int
@@ -4049,8 +5998,11 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 	}
 	else
 	{
-		nfiltered = add_files_recursively(view, path, excluded_paths, folded_paths,
-				-1, 0, depth);
+		tree_scan_t *const scan = scan_tree(view, path, excluded_paths,
+				folded_paths, depth);
+		nfiltered = add_files_recursively(view, path, scan, excluded_paths,
+				folded_paths, -1, 0, depth);
+		free_tree_scan(scan);
 		type = CV_TREE;
 	}
 	ui_cancellation_pop();
@@ -4244,21 +6196,32 @@ drop_tops(dir_entry_t *entries, int *nentries, int extra)
 	}
 }
 
-/* Adds custom view entries corresponding to file system tree.  parent_pos is
- * expected to be negative for the outermost invocation.  The depth parameter
- * is used to limit nesting level, when it's negative, parent node is just
- * marked as folded.  Returns number of filtered out files on success or partial
- * success and negative value on serious error. */
+/* Adds custom view entries corresponding to file system tree.  Listing of the
+ * directory is taken from the scan if it's not NULL, otherwise the directory is
+ * read.  parent_pos is expected to be negative for the outermost invocation.
+ * The depth parameter is used to limit nesting level, when it's negative,
+ * parent node is just marked as folded.  Returns number of filtered out files
+ * on success or partial success and negative value on serious error. */
 static int
-add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
-		trie_t *folded_paths, int parent_pos, int no_direct_parent, int depth)
+add_files_recursively(view_t *view, const char path[], const tree_scan_t *scan,
+		trie_t *excluded_paths, trie_t *folded_paths, int parent_pos,
+		int no_direct_parent, int depth)
 {
 	int i;
 	const int prev_count = view->custom.entry_count;
 	int nfiltered = 0;
 
 	int len;
-	char **lst = list_all_files(path, &len);
+	char **lst;
+	if(scan == NULL)
+	{
+		lst = list_all_files(path, &len);
+	}
+	else
+	{
+		lst = scan->names;
+		len = (scan->failed ? -1 : scan->count);
+	}
 	if(len < 0)
 	{
 		return -1;
@@ -4272,6 +6235,9 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		void *dummy;
 		dir_entry_t *entry;
 		char *const full_path = format_str("%s/%s", path, lst[i]);
+		const tree_scan_file_t *const file = (scan == NULL) ? NULL
+		                                                   : &scan->files[i];
+		const tree_scan_t *const child = (file == NULL ? NULL : file->child);
 
 		if(trie_get(excluded_paths, full_path, &dummy) == 0)
 		{
@@ -4279,10 +6245,11 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			continue;
 		}
 
-		dir = is_dir(full_path);
+		dir = (file == NULL ? is_dir(full_path) : file->is_dir);
 		if(!tree_candidate_is_visible(view, path, lst[i], dir, 1))
 		{
-			const int real_dir = (dir && !is_symlink(full_path));
+			const int real_dir = dir && (file == NULL ? !is_symlink(full_path)
+			                                          : file->info.type == FT_DIR);
 
 			FoldState state;
 			if(real_dir)
@@ -4307,8 +6274,8 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			{
 				if(state != FOLD_AUTO_CLOSED && state != FOLD_USER_CLOSED)
 				{
-					nfiltered += add_files_recursively(view, full_path, excluded_paths,
-							folded_paths, parent_pos, 1, depth - 1);
+					nfiltered += add_files_recursively(view, full_path, child,
+							excluded_paths, folded_paths, parent_pos, 1, depth - 1);
 				}
 			}
 
@@ -4317,11 +6284,15 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			continue;
 		}
 
-		entry = flist_custom_add(view, full_path);
+		entry = (file == NULL ? flist_custom_add(view, full_path)
+		                      : add_scanned_file(view, full_path, file));
 		if(entry == NULL)
 		{
 			free(full_path);
-			free_string_array(lst, len);
+			if(scan == NULL)
+			{
+				free_string_array(lst, len);
+			}
 			return -1;
 		}
 
@@ -4349,7 +6320,7 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			else
 			{
 				const int idx = view->custom.entry_count - 1;
-				const int filtered = add_files_recursively(view, full_path,
+				const int filtered = add_files_recursively(view, full_path, child,
 						excluded_paths, folded_paths, idx, 0, depth - 1);
 				/* Keep going in case of error and load partial list. */
 				if(filtered >= 0)
@@ -4368,7 +6339,10 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		show_progress("Building tree...", 1000);
 	}
 
-	free_string_array(lst, len);
+	if(scan == NULL)
+	{
+		free_string_array(lst, len);
+	}
 
 	/* The prev_count != 0 check is to make sure that we won't create leaf instead
 	 * of the whole tree (this is handled in flist_custom_finish()). */
@@ -4387,6 +6361,279 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 	return nfiltered;
 }
 
+/* Adds custom view entry for a file listed in advance.  Returns the entry or
+ * NULL on error. */
+static dir_entry_t *
+add_scanned_file(view_t *view, const char path[], const tree_scan_file_t *file)
+{
+	return (file->failed ? NULL : custom_add(view, path, &file->info));
+}
+
+/* Lists directories of a tree in parallel ahead of building it.  Which
+ * directories are listed is decided in the same way as add_files_recursively()
+ * does it.  Returns the listing, which might be incomplete, or NULL if it's
+ * unavailable. */
+static tree_scan_t *
+scan_tree(view_t *view, const char path[], trie_t *excluded_paths,
+		trie_t *folded_paths, int depth)
+{
+#ifndef _WIN32
+	tree_scanner_t scanner = {
+		.view = view,
+		.excluded_paths = excluded_paths,
+		.folded_paths = folded_paths,
+		.cancellation = &ui_cancellation_info,
+	};
+
+	if(pthread_mutex_init(&scanner.lock, NULL) != 0)
+	{
+		return NULL;
+	}
+
+	tree_scan_t *const scan = make_tree_scan(path, depth);
+	if(scan != NULL)
+	{
+		parallel_run(scan, parallel_get_nworkers(), &scan_tree_task,
+				&drop_tree_scan_task, &scanner, scanner.cancellation);
+	}
+
+	(void)pthread_mutex_destroy(&scanner.lock);
+	return scan;
+#else
+	return NULL;
+#endif
+}
+
+#ifndef _WIN32
+
+/* Lists a single directory of a tree and queues listing of its
+ * subdirectories. */
+static void
+scan_tree_task(parallel_pool_t *pool, void *task, int worker, void *arg)
+{
+	tree_scanner_t *const scanner = arg;
+	tree_scan_t *const scan = task;
+
+	const int fd = open(scan->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	DIR *const dir = (fd == -1 ? NULL : fdopendir(fd));
+	if(dir == NULL)
+	{
+		if(fd != -1)
+		{
+			close(fd);
+		}
+		scan->failed = 1;
+		return;
+	}
+
+	list_tree_dir(pool, worker, scanner, scan, dir);
+	closedir(dir);
+}
+
+/* Reads directory entries and queries information about them. */
+static void
+list_tree_dir(parallel_pool_t *pool, int worker, tree_scanner_t *scanner,
+		tree_scan_t *scan, DIR *dir)
+{
+	const int dir_fd = dirfd(dir);
+	const FoldState parent_fold = get_fold_state(scanner->folded_paths,
+			scan->path);
+
+	struct dirent *d;
+	while((d = readdir(dir)) != NULL)
+	{
+		if(cancellation_requested(scanner->cancellation))
+		{
+			scan->failed = 1;
+			break;
+		}
+
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		if(scan_tree_file(pool, worker, scanner, scan, dir_fd, d->d_name,
+					parent_fold) != 0)
+		{
+			scan->failed = 1;
+			break;
+		}
+
+		/* Only the thread that started the scan can update UI. */
+		if(worker == 0)
+		{
+			show_progress("Building tree...", 1000);
+		}
+	}
+}
+
+/* Appends a file to directory listing and queues listing of the file if it's a
+ * directory that will be needed.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+scan_tree_file(parallel_pool_t *pool, int worker, tree_scanner_t *scanner,
+		tree_scan_t *scan, int dir_fd, const char name[], FoldState parent_fold)
+{
+	if(scan->count == scan->capacity)
+	{
+		const int capacity = (scan->capacity == 0 ? 16 : scan->capacity*2);
+
+		tree_scan_file_t *const files = reallocarray(scan->files, capacity,
+				sizeof(*files));
+		if(files == NULL)
+		{
+			return 1;
+		}
+		scan->files = files;
+
+		char **const names = reallocarray(scan->names, capacity, sizeof(*names));
+		if(names == NULL)
+		{
+			return 1;
+		}
+		scan->names = names;
+
+		scan->capacity = capacity;
+	}
+
+	char *const name_copy = strdup(name);
+	if(name_copy == NULL)
+	{
+		return 1;
+	}
+
+	scan->names[scan->count] = name_copy;
+	tree_scan_file_t *const file = &scan->files[scan->count++];
+	memset(file, 0, sizeof(*file));
+
+	char full_path[PATH_MAX + 1];
+	snprintf(full_path, sizeof(full_path), "%s/%s", scan->path, name);
+
+	void *dummy;
+	if(trie_get(scanner->excluded_paths, full_path, &dummy) == 0)
+	{
+		/* Excluded files are skipped on building the tree. */
+		return 0;
+	}
+
+	struct stat s;
+	if(fstatat(dir_fd, name, &s, AT_SYMLINK_NOFOLLOW) != 0)
+	{
+		file->failed = 1;
+		return 0;
+	}
+
+	file->info.type = get_type_from_mode(s.st_mode);
+	if(file->info.type == FT_UNK)
+	{
+		file->failed = 1;
+		return 0;
+	}
+	set_entry_stats(&file->info, &s);
+
+	if(file->info.type == FT_LINK)
+	{
+		struct stat target;
+		file->is_dir = (fstatat(dir_fd, name, &target, 0) == 0)
+		            && S_ISDIR(target.st_mode);
+		return 0;
+	}
+
+	file->is_dir = (file->info.type == FT_DIR);
+	if(file->is_dir && should_scan_dir(scanner, scan, name, full_path,
+				parent_fold))
+	{
+		file->child = make_tree_scan(full_path, scan->depth - 1);
+		if(file->child != NULL)
+		{
+			parallel_push(pool, worker, file->child);
+		}
+	}
+
+	return 0;
+}
+
+/* Checks whether subdirectory will be traversed by add_files_recursively().
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+should_scan_dir(tree_scanner_t *scanner, const tree_scan_t *scan,
+		const char name[], const char full_path[], FoldState parent_fold)
+{
+	if(scan->depth <= 0)
+	{
+		return 0;
+	}
+
+	const FoldState state = get_fold_state(scanner->folded_paths, full_path);
+	if(state == FOLD_USER_CLOSED || state == FOLD_AUTO_CLOSED ||
+			(state == FOLD_UNDEFINED && parent_fold == FOLD_AUTO_OPENED))
+	{
+		return 0;
+	}
+
+	/* Directories hidden by local filter are traversed as well. */
+	(void)pthread_mutex_lock(&scanner->lock);
+	const int visible = tree_candidate_is_visible(scanner->view, scan->path,
+			name, 1, 0);
+	(void)pthread_mutex_unlock(&scanner->lock);
+
+	return visible;
+}
+
+/* Marks directory that won't be listed due to cancellation. */
+static void
+drop_tree_scan_task(void *task, void *arg)
+{
+	tree_scan_t *const scan = task;
+	scan->failed = 1;
+}
+
+#endif
+
+/* Allocates listing of a directory.  Returns the listing or NULL on error. */
+static tree_scan_t *
+make_tree_scan(const char path[], int depth)
+{
+	tree_scan_t *const scan = calloc(1, sizeof(*scan));
+	if(scan == NULL)
+	{
+		return NULL;
+	}
+
+	scan->path = strdup(path);
+	if(scan->path == NULL)
+	{
+		free(scan);
+		return NULL;
+	}
+
+	scan->depth = depth;
+	return scan;
+}
+
+/* Frees listing of a directory along with listings of its subdirectories.
+ * scan can be NULL. */
+static void
+free_tree_scan(tree_scan_t *scan)
+{
+	if(scan == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < scan->count; ++i)
+	{
+		free_tree_scan(scan->files[i].child);
+	}
+
+	free_string_array(scan->names, scan->count);
+	free(scan->files);
+	free(scan->path);
+	free(scan);
+}
+
 /* Retrieves state of the fold if present.  Returns the state or
  * FOLD_UNDEFINED. */
 static FoldState
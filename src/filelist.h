@@ -193,6 +193,13 @@ void set_view_path(view_t *view, const char path[]);
 /* Retrieves size of the entry, possibly using cached or calculated value.
  * Returns the size. */
 uint64_t fentry_get_size(const view_t *view, const dir_entry_t *entry);
+/* Checks whether sorting or displaying files by the key needs properties which
+ * are loaded lazily (see fentry_load_stats()).  Returns non-zero if so,
+ * otherwise zero is returned. */
+int fentry_key_needs_stats(int key);
+/* Loads owner and access/change times of the entry if they weren't queried on
+ * listing its directory.  This doesn't change entry logically, hence const. */
+void fentry_load_stats(const dir_entry_t *entry);
 /* Loads pointer to the next selected entry in file list of the view.  *entry
  * should be NULL for the first call and result of previous call otherwise.
  * Returns zero when there is no more entries to supply, otherwise non-zero is
@@ -281,6 +288,18 @@ dir_entry_t * entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 void free_dir_entries(dir_entry_t **entries, int *count);
 /* Frees single directory entry. */
 void fentry_free(dir_entry_t *entry);
+/* Initializes the entry with information about the file at the path without
+ * using string arena of the view, so it can be called on any thread.  The
+ * entry is suitable for flist_custom_put() and should be freed with
+ * fentry_free() otherwise.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int fentry_from_path(view_t *view, const char path[], dir_entry_t *entry);
+/* Replaces name of the entry with a copy of the string without any additional
+ * updates.  Returns zero on success, otherwise non-zero is returned. */
+int fentry_set_name(dir_entry_t *entry, const char name[]);
+/* Makes the entry own a copy of the origin.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int fentry_set_origin(dir_entry_t *entry, const char origin[]);
 /* Adds parent directory entry (..) to filelist. */
 void add_parent_dir(view_t *view);
 /* Changes name of a file entry, performing additional required updates. */
@@ -312,6 +331,9 @@ int flist_update_cache(view_t *view, cached_entries_t *cache,
 		const char path[]);
 /* Frees the cache. */
 void flist_free_cache(cached_entries_t *cache);
+/* Frees watchers of directory listings shared by caches.  Meant to be used
+ * right before exec(). */
+void flist_free_listing_watchers(void);
 /* Updates non-heap-allocated origin pointers of entries in file list
  * entries. */
 void flist_update_origins(view_t *view);
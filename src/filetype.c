@@ -20,10 +20,11 @@
 #include "filetype.h"
 
 #include <assert.h> /* assert() */
-#include <ctype.h> /* isspace() */
+#include <ctype.h> /* isspace() tolower() */
+#include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() */
-#include <string.h> /* strchr() strdup() strcasecmp() */
+#include <string.h> /* memmove() strchr() strcmp() strdup() strrchr() */
 
 #include "compat/fs_limits.h"
 #include "compat/reallocarray.h"
@@ -34,6 +35,45 @@
 #include "utils/path.h"
 #include "utils/utils.h"
 
+/* Association of a key (lower case name or extension of a file) with an item of
+ * a list of associations. */
+typedef struct
+{
+	char *key; /* The key or NULL for items that aren't indexed. */
+	int assoc; /* Index of the association in the list. */
+}
+index_entry_t;
+
+/* Index of a list of associations which allows checking only associations that
+ * might match a file.  Entries of each array are sorted by keys and then by
+ * indexes of associations. */
+struct assoc_index_t
+{
+	index_entry_t *names;  /* Associations by names of files. */
+	int nnames;            /* Number of elements in names. */
+	index_entry_t *exts;   /* Associations by extensions of files. */
+	int nexts;             /* Number of elements in exts. */
+	index_entry_t *others; /* Associations that need to be always checked. */
+	int nothers;           /* Number of elements in others. */
+};
+
+/* Iterator over associations that might match a file, which preserves order of
+ * associations in the list. */
+typedef struct
+{
+	const assoc_list_t *list;     /* List that is being traversed. */
+	const index_entry_t *pos[3];  /* Next candidates in name, extension and
+	                                 other lists. */
+	const index_entry_t *end[3];  /* Ends of the candidate ranges. */
+	int next;                     /* Next association of unindexed list. */
+}
+assoc_iter_t;
+
+static void assoc_iter_init(assoc_iter_t *iter, const assoc_list_t *list,
+		const char file[]);
+static void find_key_range(const index_entry_t entries[], int count,
+		const char key[], const index_entry_t **pos, const index_entry_t **end);
+static const assoc_t * assoc_iter_next(assoc_iter_t *iter);
 static const char * find_existing_cmd(const assoc_list_t *record_list,
 		const char file[]);
 static assoc_record_t find_existing_cmd_record(const assoc_records_t *records);
@@ -44,6 +84,12 @@ static void register_assoc(assoc_t assoc, int for_x, int in_x);
 static assoc_records_t clone_all_matching_records(const char file[],
 		const assoc_list_t *record_list);
 static int add_assoc(assoc_list_t *assoc_list, assoc_t assoc);
+static int index_assoc(struct assoc_index_t *index, const assoc_t *assoc,
+		int pos);
+static int add_index_entry(index_entry_t **entries, int *count,
+		const char key[], int assoc);
+static void free_index(struct assoc_index_t *index);
+static void free_index_entries(index_entry_t *entries, int count);
 static void assoc_viewers(matchers_t *matchers, const assoc_records_t *viewers);
 static assoc_records_t clone_assoc_records(const assoc_records_t *records,
 		const char pattern[], const assoc_list_t *dst);
@@ -116,11 +162,11 @@ ft_get_viewers(const char file[])
 {
 	strlist_t viewers = {};
 
-	int i;
-	for(i = 0; i < fileviewers.count; ++i)
+	assoc_iter_t iter;
+	const assoc_t *assoc;
+	assoc_iter_init(&iter, &fileviewers, file);
+	while((assoc = assoc_iter_next(&iter)) != NULL)
 	{
-		assoc_t *const assoc = &fileviewers.list[i];
-
 		if(!matchers_match(assoc->matchers, file))
 		{
 			continue;
@@ -142,17 +188,131 @@ ft_get_viewers(const char file[])
 	return viewers;
 }
 
+/* Prepares iterator over associations of the list that might match the
+ * file. */
+static void
+assoc_iter_init(assoc_iter_t *iter, const assoc_list_t *list,
+		const char file[])
+{
+	const struct assoc_index_t *const index = list->index;
+
+	iter->list = list;
+	iter->next = (index == NULL ? 0 : list->count);
+	iter->pos[0] = iter->end[0] = NULL;
+	iter->pos[1] = iter->end[1] = NULL;
+	iter->pos[2] = iter->end[2] = NULL;
+
+	if(index == NULL)
+	{
+		return;
+	}
+
+	char name[NAME_MAX + 2];
+	if(copy_str(name, sizeof(name), get_last_path_component(file)) ==
+			sizeof(name))
+	{
+		/* The name might have been truncated, don't rely on the index. */
+		iter->next = 0;
+		return;
+	}
+
+	char *c;
+	for(c = name; *c != '\0'; ++c)
+	{
+		*c = tolower((unsigned char)*c);
+	}
+
+	find_key_range(index->names, index->nnames, name, &iter->pos[0],
+			&iter->end[0]);
+
+	const char *const dot = strrchr(name, '.');
+	if(dot != NULL)
+	{
+		find_key_range(index->exts, index->nexts, dot + 1, &iter->pos[1],
+				&iter->end[1]);
+	}
+
+	iter->pos[2] = index->others;
+	iter->end[2] = index->others + index->nothers;
+}
+
+/* Finds range of entries with the key in a sorted array. */
+static void
+find_key_range(const index_entry_t entries[], int count, const char key[],
+		const index_entry_t **pos, const index_entry_t **end)
+{
+	int l = 0, r = count;
+	while(l < r)
+	{
+		const int m = l + (r - l)/2;
+		if(strcmp(entries[m].key, key) < 0)
+		{
+			l = m + 1;
+		}
+		else
+		{
+			r = m;
+		}
+	}
+
+	r = l;
+	while(r < count && strcmp(entries[r].key, key) == 0)
+	{
+		++r;
+	}
+
+	*pos = entries + l;
+	*end = entries + r;
+}
+
+/* Advances iterator to the next association.  Returns the association or NULL
+ * at the end. */
+static const assoc_t *
+assoc_iter_next(assoc_iter_t *iter)
+{
+	if(iter->next < iter->list->count)
+	{
+		return &iter->list->list[iter->next++];
+	}
+
+	int i;
+	int best = INT_MAX;
+	for(i = 0; i < 3; ++i)
+	{
+		if(iter->pos[i] != iter->end[i] && iter->pos[i]->assoc < best)
+		{
+			best = iter->pos[i]->assoc;
+		}
+	}
+
+	if(best == INT_MAX)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < 3; ++i)
+	{
+		while(iter->pos[i] != iter->end[i] && iter->pos[i]->assoc == best)
+		{
+			++iter->pos[i];
+		}
+	}
+
+	return &iter->list->list[best];
+}
+
 /* Finds first existing command which pattern matches given file.  Returns the
  * command (its lifetime is managed by this unit) or NULL on failure. */
 static const char *
 find_existing_cmd(const assoc_list_t *record_list, const char file[])
 {
-	int i;
+	assoc_iter_t iter;
+	const assoc_t *assoc;
 
-	for(i = 0; i < record_list->count; ++i)
+	assoc_iter_init(&iter, record_list, file);
+	while((assoc = assoc_iter_next(&iter)) != NULL)
 	{
 		assoc_record_t prog;
-		assoc_t *const assoc = &record_list->list[i];
 
 		if(!matchers_match(assoc->matchers, file))
 		{
@@ -281,12 +441,13 @@ ft_get_all_viewers(const char file[])
 static assoc_records_t
 clone_all_matching_records(const char file[], const assoc_list_t *record_list)
 {
-	int i;
 	assoc_records_t result = {};
 
-	for(i = 0; i < record_list->count; ++i)
+	assoc_iter_t iter;
+	const assoc_t *assoc;
+	assoc_iter_init(&iter, record_list, file);
+	while((assoc = assoc_iter_next(&iter)) != NULL)
 	{
-		assoc_t *const assoc = &record_list->list[i];
 		if(matchers_match(assoc->matchers, file))
 		{
 			ft_assoc_record_add_all(&result, &assoc->records);
@@ -353,9 +514,121 @@ add_assoc(assoc_list_t *assoc_list, assoc_t assoc)
 	assoc_list->list = p;
 	assoc_list->list[assoc_list->count] = assoc;
 	assoc_list->count++;
+
+	/* Index is created only along with the list to make sure it covers every
+	 * association. */
+	if(assoc_list->count == 1)
+	{
+		assoc_list->index = calloc(1U, sizeof(*assoc_list->index));
+	}
+	if(assoc_list->index != NULL &&
+			index_assoc(assoc_list->index, &assoc, assoc_list->count - 1) != 0)
+	{
+		/* Fallback to checking all associations. */
+		free_index(assoc_list->index);
+		assoc_list->index = NULL;
+	}
+
+	return 0;
+}
+
+/* Adds association at specified position to the index.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+index_assoc(struct assoc_index_t *index, const assoc_t *assoc, int pos)
+{
+	strlist_t names = {}, exts = {};
+	if(matchers_get_name_keys(assoc->matchers, &names, &exts) != 0)
+	{
+		return add_index_entry(&index->others, &index->nothers, NULL, pos);
+	}
+
+	int error = 0;
+	int i;
+	for(i = 0; i < names.nitems && !error; ++i)
+	{
+		error = add_index_entry(&index->names, &index->nnames, names.items[i],
+				pos);
+	}
+	for(i = 0; i < exts.nitems && !error; ++i)
+	{
+		error = add_index_entry(&index->exts, &index->nexts, exts.items[i], pos);
+	}
+
+	free_string_array(names.items, names.nitems);
+	free_string_array(exts.items, exts.nitems);
+	return error;
+}
+
+/* Inserts an entry into sorted array of index entries.  The association must
+ * not precede any of the associations that are already in the array.  key can
+ * be NULL.  Returns zero on success, otherwise non-zero is returned. */
+static int
+add_index_entry(index_entry_t **entries, int *count, const char key[],
+		int assoc)
+{
+	int pos = *count;
+	if(key != NULL)
+	{
+		while(pos > 0 && strcmp((*entries)[pos - 1].key, key) > 0)
+		{
+			--pos;
+		}
+
+		if(pos > 0 && (*entries)[pos - 1].assoc == assoc &&
+				strcmp((*entries)[pos - 1].key, key) == 0)
+		{
+			/* Association is already in the index under this key. */
+			return 0;
+		}
+	}
+
+	index_entry_t *const p = reallocarray(*entries, *count + 1,
+			sizeof(**entries));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	*entries = p;
+
+	char *const key_copy = (key == NULL ? NULL : strdup(key));
+	if(key != NULL && key_copy == NULL)
+	{
+		return 1;
+	}
+
+	memmove(&p[pos + 1], &p[pos], sizeof(*p)*(*count - pos));
+	p[pos].key = key_copy;
+	p[pos].assoc = assoc;
+	++*count;
 	return 0;
 }
 
+/* Frees the index.  index can be NULL. */
+static void
+free_index(struct assoc_index_t *index)
+{
+	if(index != NULL)
+	{
+		free_index_entries(index->names, index->nnames);
+		free_index_entries(index->exts, index->nexts);
+		free_index_entries(index->others, index->nothers);
+		free(index);
+	}
+}
+
+/* Frees array of index entries along with their keys. */
+static void
+free_index_entries(index_entry_t *entries, int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(entries[i].key);
+	}
+	free(entries);
+}
+
 ViewerKind
 ft_viewer_kind(const char viewer[])
 {
@@ -422,6 +695,9 @@ reset_list_head(assoc_list_t *assoc_list)
 	free(assoc_list->list);
 	assoc_list->list = NULL;
 	assoc_list->count = 0;
+
+	free_index(assoc_list->index);
+	assoc_list->index = NULL;
 }
 
 static void
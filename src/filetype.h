@@ -70,6 +70,8 @@ typedef struct
 {
 	assoc_t *list;
 	int count;
+	struct assoc_index_t *index; /* Index of the list by names of files or NULL
+	                                if all items should be checked. */
 }
 assoc_list_t;
 
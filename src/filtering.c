@@ -19,8 +19,11 @@
 
 #include "filtering.h"
 
+#include <regex.h> /* REG_ICASE */
+
 #include <assert.h> /* assert() */
-#include <string.h> /* strdup() */
+#include <stdlib.h> /* free() realloc() */
+#include <string.h> /* memset() strcspn() strdup() strstr() */
 
 #include "cfg/config.h"
 #include "compat/reallocarray.h"
@@ -45,6 +48,10 @@ static int load_unfiltered_list(view_t *view);
 static int list_is_incomplete(view_t *view);
 static void store_local_filter_position(view_t *view, int pos);
 static int update_filtering_lists(view_t *view, int add, int clear);
+static int filter_is_narrowed(const struct local_filter_t *lf);
+static int is_literal(const char pattern[]);
+static void prepare_matched(struct local_filter_t *lf);
+static void drop_matched(struct local_filter_t *lf);
 static void reparent_tree_node(dir_entry_t *original, dir_entry_t *filtered);
 static void ensure_filtered_list_not_empty(view_t *view,
 		dir_entry_t *parent_entry);
@@ -71,6 +78,9 @@ filters_view_reset(view_t *view)
 	view->local_filter.saved = NULL;
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
+	view->local_filter.matched = NULL;
+	view->local_filter.matched_len = 0U;
+	view->local_filter.matched_filter = NULL;
 }
 
 /* Resets filter to empty state (either initializes or clears it). */
@@ -528,11 +538,20 @@ update_filtering_lists(view_t *view, int add, int clear)
 {
 	/* filters_drop_temporaries() is a similar function. */
 
+	struct local_filter_t *const lf = &view->local_filter;
 	size_t i;
 	size_t list_size = 0U;
 	dir_entry_t *parent_entry = NULL;
 	int parent_added = 0;
 
+	/* Entries which didn't match the filter can't match its refinement, which
+	 * saves checking most of the entries when the filter is being typed. */
+	const int narrowed = (add && filter_is_narrowed(lf));
+	if(add)
+	{
+		prepare_matched(lf);
+	}
+
 	for(i = 0; i < view->local_filter.unfiltered_count; ++i)
 	{
 		/* FIXME: some very long file names won't be matched against some
@@ -542,6 +561,14 @@ update_filtering_lists(view_t *view, int add, int clear)
 		dir_entry_t *const entry = &view->local_filter.unfiltered[i];
 		const char *name = entry->name;
 
+		/* Entries that aren't checked below (like "..") are assumed to match. */
+		char *const matched = (add && i < lf->matched_len ? &lf->matched[i] : NULL);
+		const int was_matched = (matched == NULL || *matched);
+		if(matched != NULL)
+		{
+			*matched = 1;
+		}
+
 		if(is_parent_dir(name))
 		{
 			if(entry->child_pos == 0)
@@ -574,7 +601,8 @@ update_filtering_lists(view_t *view, int add, int clear)
 		/* tag links to position of nodes passed through filter in list of visible
 		 * files.  Nodes that didn't pass have -1. */
 		entry->tag = -1;
-		if(filter_matches(&view->local_filter.filter, name) != 0)
+		if((was_matched || !narrowed) &&
+				filter_matches(&view->local_filter.filter, name) != 0)
 		{
 			if(add)
 			{
@@ -590,6 +618,10 @@ update_filtering_lists(view_t *view, int add, int clear)
 		}
 		else
 		{
+			if(matched != NULL)
+			{
+				*matched = 0;
+			}
 			if(clear)
 			{
 				fentry_free(entry);
@@ -597,6 +629,18 @@ update_filtering_lists(view_t *view, int add, int clear)
 		}
 	}
 
+	if(add && lf->matched != NULL)
+	{
+		if(replace_string(&lf->matched_filter, lf->filter.raw) == 0)
+		{
+			lf->matched_cflags = lf->filter.cflags;
+		}
+		else
+		{
+			drop_matched(lf);
+		}
+	}
+
 	if(clear)
 	{
 		/* XXX: the check of name pointer is horrible, but is needed to prevent
@@ -620,6 +664,75 @@ update_filtering_lists(view_t *view, int add, int clear)
 	return 0;
 }
 
+/* Checks whether current value of the local filter can't match entries that
+ * didn't match the value which produced the matched array.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+filter_is_narrowed(const struct local_filter_t *lf)
+{
+	if(lf->matched == NULL || lf->matched_filter == NULL)
+	{
+		return 0;
+	}
+
+	/* Only literal patterns are handled, for them having old value as a
+	 * substring is enough.  The check is case-sensitive, so it's also correct
+	 * when old pattern ignored case. */
+	if(!is_literal(lf->matched_filter) || !is_literal(lf->filter.raw))
+	{
+		return 0;
+	}
+	if(!(lf->matched_cflags & REG_ICASE) && (lf->filter.cflags & REG_ICASE))
+	{
+		return 0;
+	}
+	return (strstr(lf->filter.raw, lf->matched_filter) != NULL);
+}
+
+/* Checks whether regular expression matches only itself.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_literal(const char pattern[])
+{
+	return pattern[strcspn(pattern, "\\^$.[]|()*+?{}")] == '\0';
+}
+
+/* Resizes matched array of the local filter to cover all unfiltered entries.
+ * New elements are marked as matching. */
+static void
+prepare_matched(struct local_filter_t *lf)
+{
+	const size_t len = lf->unfiltered_count;
+	if(lf->matched_len == len)
+	{
+		return;
+	}
+
+	char *const matched = realloc(lf->matched, len == 0U ? 1U : len);
+	if(matched == NULL)
+	{
+		drop_matched(lf);
+		return;
+	}
+
+	if(len > lf->matched_len)
+	{
+		memset(matched + lf->matched_len, 1, len - lf->matched_len);
+	}
+	lf->matched = matched;
+	lf->matched_len = len;
+}
+
+/* Frees results of the last matching of the local filter. */
+static void
+drop_matched(struct local_filter_t *lf)
+{
+	free(lf->matched);
+	lf->matched = NULL;
+	lf->matched_len = 0U;
+	update_string(&lf->matched_filter, NULL);
+}
+
 /* Reparents *filtered node by attaching it to the closes ancestor of *original
  * mapped onto the list of filtered nodes.  tag field of entries is used to
  * perform the mapping. */
@@ -846,6 +959,8 @@ local_filter_finish(view_t *view)
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
+
+	drop_matched(&view->local_filter);
 }
 
 void
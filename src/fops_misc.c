@@ -19,13 +19,19 @@
 
 #include "fops_misc.h"
 
-#include <sys/stat.h> /* stat */
+#include <sys/stat.h> /* stat fstatat() */
 #include <sys/types.h> /* gid_t uid_t */
+#ifndef _WIN32
+#include <dirent.h> /* DIR DT_* closedir() fdopendir() readdir() */
+#include <fcntl.h> /* AT_SYMLINK_NOFOLLOW O_* open() */
+#include <unistd.h> /* close() */
+#endif
 
 #include <string.h> /* strdup() strlen() */
 
 #include "cfg/config.h"
 #include "compat/os.h"
+#include "compat/pthread.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/cancellation.h"
 #include "ui/fileview.h"
@@ -33,6 +39,7 @@
 #include "ui/ui.h"
 #include "utils/cancellation.h"
 #include "utils/fs.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -63,6 +70,32 @@ typedef struct
 }
 verify_args_t;
 
+#ifndef _WIN32
+
+/* Directory whose size is being calculated by several threads. */
+typedef struct size_node_t
+{
+	struct size_node_t *parent; /* Parent directory or NULL for the root. */
+	char *path;                 /* Full path to the directory. */
+	uint64_t inode;             /* Inode of the directory for the cache. */
+	uint64_t size;              /* Size accumulated so far. */
+	int pending;                /* Listing of the directory plus number of its
+	                               subdirectories which aren't done yet. */
+	int failed;                 /* Whether directory couldn't be listed. */
+}
+size_node_t;
+
+/* State shared by all threads calculating size of a directory. */
+typedef struct
+{
+	pthread_mutex_t lock;               /* Protects pending and size of nodes. */
+	int force_update;                   /* Whether cache should be ignored. */
+	const cancellation_t *cancellation; /* Cancellation state. */
+}
+size_walker_t;
+
+#endif
+
 static int delete_file(dir_entry_t *entry, ops_t *ops, int reg, int use_trash,
 		int nested);
 static const char * get_top_dir(const view_t *view);
@@ -91,6 +124,17 @@ static void dir_size_bg(bg_op_t *bg_op, void *arg);
 static void dir_size(bg_op_t *bg_op, const char path[], int force);
 static int bg_cancellation_hook(void *arg);
 #ifndef _WIN32
+static uint64_t calc_dir_size(const char path[], uint64_t inode,
+		int force_update, const cancellation_t *cancellation);
+static void size_dir_task(parallel_pool_t *pool, void *task, int worker,
+		void *arg);
+static uint64_t list_dir_sizes(parallel_pool_t *pool, int worker,
+		size_walker_t *walker, size_node_t *node, int fd);
+static size_node_t * make_size_node(size_node_t *parent, const char path[],
+		uint64_t inode);
+static void drop_size_task(void *task, void *arg);
+static void finish_size_node(size_walker_t *walker, size_node_t *node,
+		uint64_t size);
 static void change_owner_cb(const char new_owner[], void *arg);
 static int complete_owner(const char str[], void *arg);
 static void change_group_cb(const char new_group[], void *arg);
@@ -1318,10 +1362,6 @@ uint64_t
 fops_dir_size(const char path[], int force_update,
 		const cancellation_t *cancellation)
 {
-	struct dirent *dentry;
-	const char *slash;
-	uint64_t size;
-
 	time_t mtime = 0;
 	uint64_t inode = DCACHE_UNKNOWN;
 	struct stat s;
@@ -1343,6 +1383,13 @@ fops_dir_size(const char path[], int force_update,
 		}
 	}
 
+#ifndef _WIN32
+	return calc_dir_size(path, inode, force_update, cancellation);
+#else
+	struct dirent *dentry;
+	const char *slash;
+	uint64_t size;
+
 	DIR *dir = os_opendir(path);
 	if(dir == NULL)
 	{
@@ -1384,8 +1431,224 @@ fops_dir_size(const char path[], int force_update,
 	 * up memory, because interest in size sort of excludes interest in nitems. */
 	(void)dcache_set_at(path, inode, size, DCACHE_UNKNOWN);
 	return size;
+#endif
+}
+
+#ifndef _WIN32
+
+/* Calculates size of a directory by processing each subdirectory as a separate
+ * task in a pool of threads.  Returns size of the directory or zero on error or
+ * cancellation. */
+static uint64_t
+calc_dir_size(const char path[], uint64_t inode, int force_update,
+		const cancellation_t *cancellation)
+{
+	size_walker_t walker = {
+		.force_update = force_update,
+		.cancellation = cancellation,
+	};
+
+	if(pthread_mutex_init(&walker.lock, NULL) != 0)
+	{
+		return 0U;
+	}
+
+	size_node_t root = {
+		.path = (char *)path,
+		.inode = inode,
+		.pending = 1,
+	};
+
+	parallel_run(&root, parallel_get_nworkers(), &size_dir_task,
+			&drop_size_task, &walker, cancellation);
+
+	(void)pthread_mutex_destroy(&walker.lock);
+
+	if(root.failed || cancellation_requested(cancellation))
+	{
+		return 0U;
+	}
+	return root.size;
+}
+
+/* Lists a single directory adding sizes of its files and queueing its
+ * subdirectories. */
+static void
+size_dir_task(parallel_pool_t *pool, void *task, int worker, void *arg)
+{
+	size_walker_t *const walker = arg;
+	size_node_t *const node = task;
+
+	uint64_t size = 0U;
+
+	const int fd = open(node->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd == -1)
+	{
+		node->failed = 1;
+	}
+	else
+	{
+		size = list_dir_sizes(pool, worker, walker, node, fd);
+	}
+
+	finish_size_node(walker, node, size);
+}
+
+/* Sums up sizes of files in the directory, reuses cached sizes of its
+ * subdirectories and adds tasks for the rest of them.  Takes ownership of the
+ * fd.  Returns size of files of the directory and of cached subdirectories. */
+static uint64_t
+list_dir_sizes(parallel_pool_t *pool, int worker, size_walker_t *walker,
+		size_node_t *node, int fd)
+{
+	DIR *const dir = fdopendir(fd);
+	if(dir == NULL)
+	{
+		close(fd);
+		node->failed = 1;
+		return 0U;
+	}
+
+	const char *const slash = (ends_with_slash(node->path) ? "" : "/");
+	uint64_t size = 0U;
+
+	struct dirent *dentry;
+	while((dentry = readdir(dir)) != NULL)
+	{
+		if(is_builtin_dir(dentry->d_name))
+		{
+			continue;
+		}
+
+		if(cancellation_requested(walker->cancellation))
+		{
+			break;
+		}
+
+		/* Special files have no size, so don't waste time on querying it. */
+		const int type = dentry->d_type;
+		if(type == DT_FIFO || type == DT_SOCK || type == DT_CHR || type == DT_BLK)
+		{
+			continue;
+		}
+
+		struct stat s;
+		if(fstatat(fd, dentry->d_name, &s, AT_SYMLINK_NOFOLLOW) != 0 ||
+				s.st_ino == 0)
+		{
+			continue;
+		}
+
+		if(!S_ISDIR(s.st_mode))
+		{
+			size += (uint64_t)s.st_size;
+			continue;
+		}
+
+		char full_path[PATH_MAX + 1];
+		snprintf(full_path, sizeof(full_path), "%s%s%s", node->path, slash,
+				dentry->d_name);
+
+		if(!walker->force_update)
+		{
+			uint64_t dir_size;
+			dcache_get_at(full_path, s.st_mtime, s.st_ino, &dir_size, NULL);
+			if(dir_size != DCACHE_UNKNOWN)
+			{
+				size += dir_size;
+				continue;
+			}
+		}
+
+		size_node_t *const child = make_size_node(node, full_path, s.st_ino);
+		if(child == NULL)
+		{
+			continue;
+		}
+
+		(void)pthread_mutex_lock(&walker->lock);
+		++node->pending;
+		(void)pthread_mutex_unlock(&walker->lock);
+
+		parallel_push(pool, worker, child);
+	}
+
+	closedir(dir);
+	return size;
 }
 
+/* Allocates node for a subdirectory.  Returns the node or NULL on error. */
+static size_node_t *
+make_size_node(size_node_t *parent, const char path[], uint64_t inode)
+{
+	size_node_t *const node = malloc(sizeof(*node));
+	if(node == NULL)
+	{
+		return NULL;
+	}
+
+	node->path = strdup(path);
+	if(node->path == NULL)
+	{
+		free(node);
+		return NULL;
+	}
+
+	node->parent = parent;
+	node->inode = inode;
+	node->size = 0U;
+	node->pending = 1;
+	node->failed = 0;
+	return node;
+}
+
+/* Accounts for a directory that won't be listed due to cancellation. */
+static void
+drop_size_task(void *task, void *arg)
+{
+	finish_size_node(arg, task, 0U);
+}
+
+/* Adds size to the node and completes part of its processing.  Once all parts
+ * are done, size of the directory is cached and added to its parent, which is
+ * completed in turn. */
+static void
+finish_size_node(size_walker_t *walker, size_node_t *node, uint64_t size)
+{
+	while(node != NULL)
+	{
+		(void)pthread_mutex_lock(&walker->lock);
+		node->size += size;
+		const int done = (--node->pending == 0);
+		(void)pthread_mutex_unlock(&walker->lock);
+
+		if(!done)
+		{
+			break;
+		}
+
+		/* Nothing else refers to the node at this point. */
+		size = node->size;
+		if(!node->failed && !cancellation_requested(walker->cancellation))
+		{
+			/* Could calculate nitems here, but they aren't recursive and might only
+			 * take up memory, because interest in size sort of excludes interest in
+			 * nitems. */
+			(void)dcache_set_at(node->path, node->inode, size, DCACHE_UNKNOWN);
+		}
+
+		size_node_t *const parent = node->parent;
+		if(parent != NULL)
+		{
+			free(node->path);
+			free(node);
+		}
+		node = parent;
+	}
+}
+
+#endif
+
 #ifndef _WIN32
 
 int
@@ -1416,6 +1679,9 @@ fops_chown(int u, int g, uid_t uid, gid_t gid)
 		char full_path[PATH_MAX + 1];
 		get_full_path_of(entry, sizeof(full_path), full_path);
 
+		/* Previous owner and group are needed for undo. */
+		fentry_load_stats(entry);
+
 		if(u && perform_operation(OP_CHOWN, ops, V(uid), full_path, NULL) ==
 				OPS_SUCCEEDED)
 		{
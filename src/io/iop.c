@@ -25,12 +25,15 @@
 #ifndef _WIN32
 #include <sys/ioctl.h> /* ioctl() */
 #endif
+#ifdef __linux__
+#include <sys/sendfile.h> /* sendfile() */
+#endif
 #include <sys/stat.h> /* stat */
 #include <sys/types.h> /* mode_t */
-#include <unistd.h> /* symlink() unlink() */
+#include <unistd.h> /* copy_file_range() ssize_t symlink() unlink() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* EEXIST ENOENT EISDIR errno */
+#include <errno.h> /* EEXIST EINTR ENOENT ENOSYS EISDIR errno */
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* FILE fpos_t fclose() fgetpos() fflush() fread() fseek()
                       fsetpos() fwrite() snprintf() */
@@ -54,9 +57,30 @@
 /* Amount of data to transfer at once. */
 #define BLOCK_SIZE 32*1024
 
+/* Amount of data to ask the kernel to transfer at once.  Defines how often
+ * progress is reported and cancellation is checked during in-kernel copying. */
+#define KERNEL_BLOCK_SIZE 8*1024*1024
+
 /* Amount of data after which data flush should be performed. */
 #define FLUSH_SIZE 256*1024*1024
 
+/* Whether copy_file_range() is available (appeared in glibc 2.27). */
+#if defined(__linux__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define HAS_COPY_FILE_RANGE 1
+#else
+#define HAS_COPY_FILE_RANGE 0
+#endif
+
+/* Kinds of in-kernel data copying in the order of preference. */
+typedef enum
+{
+	KC_COPY_FILE_RANGE, /* copy_file_range() system call. */
+	KC_SENDFILE,        /* sendfile() system call. */
+	KC_COUNT            /* Number of kinds of copying. */
+}
+KernelCopy;
+
 /* Type of io function used by retry_wrapper(). */
 typedef IoRes (*iop_func)(io_args_t *args);
 
@@ -66,6 +90,14 @@ static IoRes iop_rmfile_internal(io_args_t *args);
 static IoRes iop_rmdir_internal(io_args_t *args);
 static IoRes iop_cp_internal(io_args_t *args);
 static int clone_file(int dst_fd, int src_fd);
+#ifndef _WIN32
+static int kernel_copy(io_args_t *args, int dst_fd, int src_fd, uint64_t size,
+		size_t *ncopied);
+static ssize_t kernel_copy_block(KernelCopy kind, int dst_fd, int src_fd,
+		size_t len);
+static void sync_copied_data(io_args_t *args, int dst_fd, size_t *ncopied,
+		size_t len);
+#endif
 #ifdef _WIN32
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
 		LARGE_INTEGER transferred, LARGE_INTEGER stream_size,
@@ -541,11 +573,10 @@ iop_cp_internal(io_args_t *args)
 		if(clone_file(fileno(out), fileno(in)) == 0)
 		{
 			cloned = 1;
+			ioeta_update(args->estim, NULL, NULL, 0, st.st_size);
 		}
 	}
 
-	/* TODO: use sendfile() if platform supports it. */
-
 	if(!error && !cloned)
 	{
 		char block[BLOCK_SIZE];
@@ -553,9 +584,16 @@ iop_cp_internal(io_args_t *args)
 		size_t nread = (size_t)-1;
 #ifndef _WIN32
 		size_t ncopied = 0U;
-		const int data_sync = args->arg4.data_sync;
+
+		/* Let the kernel copy as much as it can, whatever is left (possibly the
+		 * whole file) is copied below by reading and writing blocks of data.  This
+		 * is skipped on appending, because kernel doesn't like O_APPEND. */
+		if(crs != IO_CRS_APPEND_TO_FILES)
+		{
+			error = kernel_copy(args, fileno(out), fileno(in), st.st_size, &ncopied);
+		}
 #endif
-		while((nread = fread(&block, 1, sizeof(block), in)) != 0U)
+		while(!error && (nread = fread(&block, 1, sizeof(block), in)) != 0U)
 		{
 			if(io_cancelled(args))
 			{
@@ -574,14 +612,9 @@ iop_cp_internal(io_args_t *args)
 			ioeta_update(args->estim, NULL, NULL, 0, nread);
 
 #ifndef _WIN32
-			/* Force flushing data to disk to not pollute RAM with this data too
-			 * much. */
-			ncopied += nread;
-			if(data_sync && ncopied >= FLUSH_SIZE)
-			{
-				(void)os_fdatasync(fileno(out));
-				ncopied -= FLUSH_SIZE;
-			}
+			/* fwrite() buffers data, but it's a single block which is of no concern
+			 * given the size of FLUSH_SIZE. */
+			sync_copied_data(args, fileno(out), &ncopied, nread);
 #endif
 		}
 
@@ -650,17 +683,18 @@ iop_cp_internal(io_args_t *args)
 	return io_res_from_code(error);
 }
 
-/* Try to clone file fast on btrfs.  Returns 0 on success, otherwise non-zero is
- * returned. */
+/* Try to clone file fast on file systems that support sharing data blocks
+ * among files (btrfs, XFS, OCFS2, etc.).  Returns 0 on success, otherwise
+ * non-zero is returned. */
 static int
 clone_file(int dst_fd, int src_fd)
 {
 #ifdef __linux__
-#undef BTRFS_IOCTL_MAGIC
-#define BTRFS_IOCTL_MAGIC 0x94
-#undef BTRFS_IOC_CLONE
-#define BTRFS_IOC_CLONE _IOW(BTRFS_IOCTL_MAGIC, 9, int)
-	return ioctl(dst_fd, BTRFS_IOC_CLONE, src_fd);
+	/* FICLONE is a generic version of BTRFS_IOC_CLONE and has the same value, but
+	 * linux/fs.h header doesn't combine well with sys/mount.h. */
+#undef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+	return ioctl(dst_fd, FICLONE, src_fd);
 #else
 	(void)dst_fd;
 	(void)src_fd;
@@ -668,6 +702,107 @@ clone_file(int dst_fd, int src_fd)
 #endif
 }
 
+#ifndef _WIN32
+
+/* Copies up to size bytes of data from current position of src_fd to current
+ * position of dst_fd without passing it through user space.  Tries available
+ * methods one by one moving to the next one when current one fails, so on
+ * return the data might be copied only partially.  *ncopied is used for data
+ * synchronization.  Returns non-zero if the operation was cancelled, otherwise
+ * zero is returned. */
+static int
+kernel_copy(io_args_t *args, int dst_fd, int src_fd, uint64_t size,
+		size_t *ncopied)
+{
+	uint64_t copied = 0U;
+	KernelCopy kind = 0;
+
+	while(kind < KC_COUNT && copied < size)
+	{
+		if(io_cancelled(args))
+		{
+			return 1;
+		}
+
+		const uint64_t left = size - copied;
+		const size_t len = (left < KERNEL_BLOCK_SIZE ? left : KERNEL_BLOCK_SIZE);
+
+		/* Reading nothing before reaching the expected size either means that the
+		 * file got shorter or that it's a special file (like those in /proc) which
+		 * reports zero size.  Either way, further copying is left for the caller,
+		 * which reads until the end of file is reached. */
+		const ssize_t nwritten = kernel_copy_block(kind, dst_fd, src_fd, len);
+		if(nwritten == 0)
+		{
+			break;
+		}
+		if(nwritten < 0)
+		{
+			/* Method is either not supported or failed, try the next one.  File
+			 * offsets remain valid, so copying can just continue.  Real errors will
+			 * be detected and reported by user-space copying. */
+			++kind;
+			continue;
+		}
+
+		copied += nwritten;
+		ioeta_update(args->estim, NULL, NULL, 0, nwritten);
+		sync_copied_data(args, dst_fd, ncopied, nwritten);
+	}
+
+	return 0;
+}
+
+/* Performs single step of copying of at most len bytes using the specified
+ * kind of in-kernel copying.  Returns number of bytes copied or -1 on error or
+ * if the method is not available. */
+static ssize_t
+kernel_copy_block(KernelCopy kind, int dst_fd, int src_fd, size_t len)
+{
+	ssize_t result;
+	do
+	{
+		/* In case the method isn't available. */
+		result = -1;
+		errno = ENOSYS;
+
+		switch(kind)
+		{
+			case KC_COPY_FILE_RANGE:
+#if HAS_COPY_FILE_RANGE
+				result = copy_file_range(src_fd, NULL, dst_fd, NULL, len, 0U);
+#endif
+				break;
+			case KC_SENDFILE:
+#ifdef __linux__
+				result = sendfile(dst_fd, src_fd, NULL, len);
+#endif
+				break;
+			case KC_COUNT:
+				assert(0 && "Invalid kind of kernel copying.");
+				break;
+		}
+	}
+	while(result < 0 && errno == EINTR);
+	return result;
+}
+
+/* Accounts for len more bytes being copied and forces flushing data to disk
+ * once enough of it was written if data synchronization is enabled.  This is
+ * to not pollute RAM with this data too much. */
+static void
+sync_copied_data(io_args_t *args, int dst_fd, size_t *ncopied, size_t len)
+{
+	*ncopied += len;
+	if(args->arg4.data_sync && *ncopied >= FLUSH_SIZE)
+	{
+		(void)os_fdatasync(dst_fd);
+		*ncopied -= FLUSH_SIZE;
+	}
+}
+
+#endif
+
 #ifdef _WIN32
 
 static DWORD CALLBACK win_progress_cb(LARGE_INTEGER total,
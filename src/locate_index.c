@@ -0,0 +1,298 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "locate_index.h"
+
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+#include <time.h> /* time_t time() */
+
+#include "cfg/config.h"
+#include "compat/fs_limits.h"
+#include "compat/pthread.h"
+#include "ui/cancellation.h"
+#include "ui/statusbar.h"
+#include "utils/cancellation.h"
+#include "utils/findex.h"
+#include "utils/parallel.h"
+#include "utils/path.h"
+#include "utils/str.h"
+#include "utils/string_array.h"
+#include "background.h"
+
+/* Period of full rescans of the index in seconds. */
+#define RESCAN_PERIOD (60*60)
+
+/* Minimal period between writes of updates of the index in seconds. */
+#define SAVE_PERIOD (5*60)
+
+static int get_roots(strlist_t *roots);
+static findex_t * load_index(const strlist_t *roots);
+static void save_index(void);
+static void start_rescan(void);
+static void rescan_bg(bg_op_t *bg_op, void *arg);
+static int bg_cancellation_hook(void *arg);
+
+/* Protects state of the unit from concurrent access by background rescans. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Current index or NULL. */
+static findex_t *curr_index;
+/* Whether a rescan is running in background. */
+static int scanning;
+/* Whether the index has changes that aren't written to disk. */
+static int dirty;
+/* Time of the last full scan. */
+static time_t last_scan;
+/* Time of the last write of the index to disk. */
+static time_t last_save;
+
+const char *
+locidx_query(const char pattern[], strlist_t *results)
+{
+	strlist_t roots = {};
+	if(get_roots(&roots) != 0)
+	{
+		return "'locateroots' has no absolute paths";
+	}
+
+	const char *error = NULL;
+
+	pthread_mutex_lock(&lock);
+
+	if(curr_index == NULL ||
+			!findex_has_roots(curr_index, roots.items, roots.nitems))
+	{
+		findex_free(curr_index);
+		curr_index = load_index(&roots);
+	}
+
+	if(curr_index == NULL)
+	{
+		ui_sb_msg("Indexing files...");
+		ui_cancellation_push_on();
+		curr_index = findex_build(roots.items, roots.nitems,
+				parallel_get_nworkers(), &ui_cancellation_info);
+		ui_cancellation_pop();
+
+		if(curr_index != NULL)
+		{
+			last_scan = time(NULL);
+			dirty = 1;
+			save_index();
+		}
+	}
+
+	if(curr_index == NULL)
+	{
+		error = "Indexing of files failed or was cancelled";
+	}
+	else if(findex_query(curr_index, pattern, results) != 0)
+	{
+		error = "Invalid pattern";
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	free_string_array(roots.items, roots.nitems);
+	return error;
+}
+
+void
+locidx_check(void)
+{
+	const time_t now = time(NULL);
+
+	pthread_mutex_lock(&lock);
+	if(curr_index != NULL && dirty && now - last_save >= SAVE_PERIOD)
+	{
+		save_index();
+	}
+	/* Index is loaded only by a query, so options are consulted only after
+	 * checking that there is one. */
+	const int rescan = (curr_index != NULL && !scanning &&
+			cfg.locate_prg[0] == '\0' && now - last_scan >= RESCAN_PERIOD);
+	scanning |= rescan;
+	pthread_mutex_unlock(&lock);
+
+	if(rescan)
+	{
+		start_rescan();
+	}
+}
+
+void
+locidx_dir_changed(const char path[])
+{
+	pthread_mutex_lock(&lock);
+	if(curr_index != NULL && findex_update_dir(curr_index, path))
+	{
+		dirty = 1;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void
+locidx_finish(void)
+{
+	pthread_mutex_lock(&lock);
+	if(curr_index != NULL && dirty)
+	{
+		save_index();
+	}
+	findex_free(curr_index);
+	curr_index = NULL;
+	pthread_mutex_unlock(&lock);
+}
+
+/* Parses value of 'locateroots' into a list of canonical absolute paths
+ * without trailing slashes.  Returns zero on success and non-zero if the list
+ * is empty. */
+static int
+get_roots(strlist_t *roots)
+{
+	char *const list = strdup(cfg.locate_roots);
+	if(list == NULL)
+	{
+		return 1;
+	}
+
+	char *part = list, *state = NULL;
+	while((part = split_and_get(part, ',', &state)) != NULL)
+	{
+		char *const expanded = expand_tilde(part);
+		if(expanded != NULL && is_path_absolute(expanded))
+		{
+			char canonic[PATH_MAX + 1];
+			to_canonic_path(expanded, "/", canonic, sizeof(canonic));
+			if(!is_root_dir(canonic))
+			{
+				chosp(canonic);
+			}
+			roots->nitems = add_to_string_array(&roots->items, roots->nitems,
+					canonic);
+		}
+		free(expanded);
+	}
+
+	free(list);
+	return (roots->nitems == 0);
+}
+
+/* Reads index of the roots from disk.  Returns the index or NULL if it's
+ * missing or is for different roots. */
+static findex_t *
+load_index(const strlist_t *roots)
+{
+	if(cfg.locate_index_file[0] == '\0')
+	{
+		return NULL;
+	}
+
+	findex_t *const index = findex_load(cfg.locate_index_file);
+	if(index == NULL || !findex_has_roots(index, roots->items, roots->nitems))
+	{
+		findex_free(index);
+		return NULL;
+	}
+
+	last_scan = findex_scan_time(index);
+	last_save = time(NULL);
+	dirty = 0;
+	return index;
+}
+
+/* Writes current index to disk.  Should be called with the lock held. */
+static void
+save_index(void)
+{
+	/* Don't retry on failure until the next period. */
+	last_save = time(NULL);
+
+	if(cfg.locate_index_file[0] == '\0' ||
+			findex_save(curr_index, cfg.locate_index_file) == 0)
+	{
+		dirty = 0;
+	}
+}
+
+/* Starts building new version of the index in background. */
+static void
+start_rescan(void)
+{
+	strlist_t *const roots = calloc(1, sizeof(*roots));
+	if(roots == NULL || get_roots(roots) != 0 ||
+			bg_execute("Updating index of files", "...", BG_UNDEFINED_TOTAL, 0,
+				&rescan_bg, roots) != 0)
+	{
+		if(roots != NULL)
+		{
+			free_string_array(roots->items, roots->nitems);
+		}
+		free(roots);
+
+		pthread_mutex_lock(&lock);
+		scanning = 0;
+		last_scan = time(NULL);
+		pthread_mutex_unlock(&lock);
+	}
+}
+
+/* Entry point of a background task that rescans roots of the index. */
+static void
+rescan_bg(bg_op_t *bg_op, void *arg)
+{
+	strlist_t *const roots = arg;
+
+	const cancellation_t cancellation = {
+		.hook = &bg_cancellation_hook,
+		.arg = bg_op,
+	};
+	findex_t *index = findex_build(roots->items, roots->nitems,
+			parallel_get_nworkers(), &cancellation);
+
+	pthread_mutex_lock(&lock);
+	/* Roots could have changed or the index could have been dropped while the
+	 * scan was running. */
+	if(index != NULL && curr_index != NULL &&
+			findex_has_roots(curr_index, roots->items, roots->nitems))
+	{
+		findex_t *const old_index = curr_index;
+		curr_index = index;
+		index = old_index;
+
+		dirty = 1;
+		save_index();
+	}
+	scanning = 0;
+	last_scan = time(NULL);
+	pthread_mutex_unlock(&lock);
+
+	findex_free(index);
+	free_string_array(roots->items, roots->nitems);
+	free(roots);
+}
+
+/* Implementation of cancellation hook for background tasks. */
+static int
+bg_cancellation_hook(void *arg)
+{
+	return bg_op_cancelled(arg);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
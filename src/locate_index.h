@@ -0,0 +1,47 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__LOCATE_INDEX_H__
+#define VIFM__LOCATE_INDEX_H__
+
+/* This unit maintains persistent index of file names under directories listed
+ * in 'locateroots' for built-in :locate.  The index is built on first use,
+ * refreshed by periodic rescans in background and updated by changes of
+ * directories noticed by views. */
+
+struct strlist_t;
+
+/* Appends paths that match the pattern to the list building the index first if
+ * necessary.  Returns NULL on success, otherwise pointer to a statically
+ * allocated error message is returned. */
+const char * locidx_query(const char pattern[], struct strlist_t *results);
+
+/* Performs periodic maintenance: starts rescans of outdated index and stores
+ * its updates. */
+void locidx_check(void);
+
+/* Notifies the unit that contents of the directory has changed. */
+void locidx_dir_changed(const char path[]);
+
+/* Stores unsaved changes and frees the index. */
+void locidx_finish(void);
+
+#endif /* VIFM__LOCATE_INDEX_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -66,6 +66,8 @@ vifmentry_new(lua_State *lua, const dir_entry_t *entry)
 {
 	lua_createtable(lua, /*narr=*/0, /*nrec=*/16); /* entry */
 
+	fentry_load_stats(entry);
+
 	lua_pushstring(lua, entry->name);
 	lua_setfield(lua, -2, "name");
 	lua_pushstring(lua, entry->origin);
@@ -19,29 +19,73 @@
 
 #include "find_menu.h"
 
-#include <stdlib.h> /* free() */
+#include <stddef.h> /* size_t */
+#include <stdlib.h> /* calloc() free() */
 #include <string.h> /* strdup() */
 
 #include "../cfg/config.h"
+#include "../compat/fs_limits.h"
+#include "../compat/pthread.h"
 #include "../modes/dialogs/msg_dialog.h"
+#include "../ui/cancellation.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/dynarray.h"
+#include "../utils/fswalk.h"
 #include "../utils/macros.h"
+#include "../utils/matcher.h"
+#include "../utils/matchers.h"
+#include "../utils/parallel.h"
+#include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/utils.h"
+#include "../filelist.h"
+#include "../filtering.h"
+#include "../flist_pos.h"
 #include "../macros.h"
 #include "menus.h"
 
 #ifdef _WIN32
 #define DEFAULT_PREDICATE "-iname"
+#define DEFAULT_CASE_SENSITIVITY 0
 #else
 #define DEFAULT_PREDICATE "-name"
+#define DEFAULT_CASE_SENSITIVITY 1
 #endif
 
+/* Files found by a single thread. */
+typedef struct
+{
+	dir_entry_t *entries; /* Entries of the files (dynarray). */
+	int count;            /* Number of elements in the entries array. */
+}
+found_t;
+
+/* State of built-in search shared by threads. */
+typedef struct
+{
+	view_t *view;         /* View whose dot files and filters are respected. */
+	matchers_t *matchers; /* Pattern for names of files. */
+	pthread_mutex_t lock; /* Serializes matching when it isn't thread-safe. */
+	int need_lock;        /* Whether matching needs to be serialized. */
+	found_t *found;       /* Per-thread results. */
+}
+finder_t;
+
+static int find_builtin(view_t *view, const char path[], const char pattern[],
+		const char args[]);
+static void find_in_selection(finder_t *finder, int nworkers);
+static int visit_file(const char path[], const char name[], int is_dir,
+		int worker, void *arg);
+static int check_file(finder_t *finder, const char dir[], const char name[],
+		int is_dir, int worker);
+static int show_found(view_t *view, const char args[], finder_t *finder,
+		int nworkers, int cancelled);
 static int execute_find_cb(view_t *view, menu_data_t *m);
 
 int
-show_find_menu(view_t *view, int with_path, const char args[])
+show_find_menu(view_t *view, const char path[], const char pattern[],
+		const char args[])
 {
 	enum { M_s, M_a, M_A, M_p, M_u, M_U, };
 
@@ -64,7 +108,12 @@ show_find_menu(view_t *view, int with_path, const char args[])
 
 	static menu_data_t m;
 
-	if(with_path)
+	if(cfg.find_prg[0] == '\0')
+	{
+		return find_builtin(view, path, pattern, args);
+	}
+
+	if(path != NULL)
 	{
 		macros[M_s].value = args;
 		macros[M_a].value = "";
@@ -128,6 +177,217 @@ show_find_menu(view_t *view, int with_path, const char args[])
 	return save_msg;
 }
 
+/* Looks for files whose names match the pattern in selected files or under
+ * current directory of the view (or the path) without calling an external
+ * program and puts them into a custom view.  Returns non-zero if status bar
+ * message should be saved. */
+static int
+find_builtin(view_t *view, const char path[], const char pattern[],
+		const char args[])
+{
+	char root[PATH_MAX + 1];
+
+	if(path != NULL)
+	{
+		char *const expanded = expand_tilde(path);
+		if(expanded == NULL)
+		{
+			show_error_msg("Find", "Not enough memory.");
+			return 0;
+		}
+
+		to_canonic_path(expanded, flist_get_dir(view), root, sizeof(root));
+		free(expanded);
+	}
+
+	char *error;
+	matchers_t *const ms = matchers_alloc(pattern, DEFAULT_CASE_SENSITIVITY,
+			/*glob_by_def=*/1, "", &error);
+	if(ms == NULL)
+	{
+		show_error_msgf("Find", "Invalid pattern: %s",
+				(error == NULL ? "out of memory" : error));
+		free(error);
+		return 0;
+	}
+
+	const int nworkers = parallel_get_nworkers();
+	finder_t finder = {
+		.view = view,
+		.matchers = ms,
+		/* Only detection of mime types isn't thread-safe. */
+		.need_lock = matchers_use_mime(ms) ||
+		             matcher_uses_mime(view->manual_filter),
+		.found = calloc(nworkers, sizeof(*finder.found)),
+	};
+	if(finder.found == NULL)
+	{
+		matchers_free(ms);
+		show_error_msg("Find", "Not enough memory.");
+		return 0;
+	}
+	pthread_mutex_init(&finder.lock, NULL);
+
+	ui_sb_msg("find...");
+	ui_cancellation_push_on();
+	show_progress("Finding...", 0);
+
+	if(path != NULL)
+	{
+		fswalk(root, nworkers, &visit_file, &finder, &ui_cancellation_info);
+	}
+	else if(view->selected_files != 0 ||
+			(view->pending_marking && flist_count_marked(view) != 0))
+	{
+		find_in_selection(&finder, nworkers);
+	}
+	else
+	{
+		fswalk(flist_get_dir(view), nworkers, &visit_file, &finder,
+				&ui_cancellation_info);
+	}
+
+	const int cancelled = ui_cancellation_requested();
+	ui_cancellation_pop();
+
+	pthread_mutex_destroy(&finder.lock);
+	matchers_free(ms);
+
+	return show_found(view, args, &finder, nworkers, cancelled);
+}
+
+/* Checks selected files and walks selected directories like "find" does for
+ * its starting points. */
+static void
+find_in_selection(finder_t *finder, int nworkers)
+{
+	view_t *const view = finder->view;
+	check_marking(view, 0, NULL);
+
+	dir_entry_t *entry = NULL;
+	while(iter_marked_entries(view, &entry) && !ui_cancellation_requested())
+	{
+		char path[PATH_MAX + 1];
+		get_full_path_of(entry, sizeof(path), path);
+
+		const int is_dir = (entry->type == FT_DIR);
+		if(check_file(finder, entry->origin, entry->name, is_dir, 0) && is_dir)
+		{
+			fswalk(path, nworkers, &visit_file, finder, &ui_cancellation_info);
+		}
+	}
+}
+
+/* Checks a single file found during a walk.  Implements fswalk_func. */
+static int
+visit_file(const char path[], const char name[], int is_dir, int worker,
+		void *arg)
+{
+	finder_t *const finder = arg;
+
+	/* Directory part of the path without trailing slash unless it's a root. */
+	char dir[PATH_MAX + 1];
+	const size_t dir_len = (name - path > 1 ? name - path - 1 : 1);
+	copy_str(dir, MIN(sizeof(dir), dir_len + 1U), path);
+
+	const int visible = check_file(finder, dir, name, is_dir, worker);
+
+	/* Only the main thread can interact with the user. */
+	if(worker == 0)
+	{
+		show_progress("Finding...", 1000);
+	}
+
+	return visible;
+}
+
+/* Checks visibility of a file and records it if its name matches.  Returns
+ * non-zero if the file is visible in the view. */
+static int
+check_file(finder_t *finder, const char dir[], const char name[], int is_dir,
+		int worker)
+{
+	if(finder->view->hide_dot && name[0] == '.')
+	{
+		return 0;
+	}
+
+	char *const path = join_paths(dir, name);
+	if(path == NULL)
+	{
+		return 0;
+	}
+
+	if(finder->need_lock)
+	{
+		pthread_mutex_lock(&finder->lock);
+	}
+	const int visible = filters_file_is_visible(finder->view, dir, name, is_dir,
+			0);
+	const int matches = visible && (matchers_match(finder->matchers, path) ||
+			(is_dir && matchers_match_dir(finder->matchers, path)));
+	if(finder->need_lock)
+	{
+		pthread_mutex_unlock(&finder->lock);
+	}
+
+	found_t *const found = &finder->found[worker];
+	if(matches)
+	{
+		dir_entry_t *const entries = dynarray_extend(found->entries,
+				sizeof(*entries));
+		if(entries != NULL)
+		{
+			found->entries = entries;
+			if(fentry_from_path(finder->view, path, &entries[found->count]) == 0)
+			{
+				++found->count;
+			}
+		}
+	}
+
+	free(path);
+	return visible;
+}
+
+/* Replaces contents of the view with found files.  Returns non-zero if status
+ * bar message should be saved. */
+static int
+show_found(view_t *view, const char args[], finder_t *finder, int nworkers,
+		int cancelled)
+{
+	char *const title = format_str("Find %s", args);
+	flist_custom_start(view, title);
+	free(title);
+
+	int i;
+	for(i = 0; i < nworkers; ++i)
+	{
+		found_t *const found = &finder->found[i];
+
+		int j;
+		for(j = 0; j < found->count; ++j)
+		{
+			if(flist_custom_put(view, &found->entries[j]) == NULL)
+			{
+				fentry_free(&found->entries[j]);
+			}
+		}
+
+		dynarray_free(found->entries);
+	}
+	free(finder->found);
+
+	if(flist_custom_finish(view, CV_REGULAR, 0) != 0)
+	{
+		ui_sb_msg(cancelled ? "No files found (cancelled)" : "No files found");
+		return 1;
+	}
+
+	fpos_set_pos(view, 0);
+	return 0;
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
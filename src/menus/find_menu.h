@@ -22,8 +22,11 @@
 
 struct view_t;
 
-/* Returns non-zero if status bar message should be saved. */
-int show_find_menu(struct view_t *view, int with_path, const char args[]);
+/* Path is parsed path to search in from the args or NULL, pattern is the part
+ * of args that follows the path (or all of them).  Returns non-zero if status
+ * bar message should be saved. */
+int show_find_menu(struct view_t *view, const char path[],
+		const char pattern[], const char args[]);
 
 #endif /* VIFM__MENUS__FIND_MENU_H__ */
 
@@ -19,19 +19,52 @@
 
 #include "grep_menu.h"
 
-#include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <sys/stat.h> /* S_ISDIR S_ISREG stat */
+
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strchr() strdup() strlen() */
 
 #include "../cfg/config.h"
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
 #include "../modes/dialogs/msg_dialog.h"
+#include "../ui/cancellation.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/fs.h"
+#include "../utils/grep.h"
 #include "../utils/macros.h"
+#include "../utils/parallel.h"
+#include "../utils/path.h"
+#include "../utils/regexp.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
 #include "../utils/utils.h"
+#include "../filelist.h"
+#include "../filtering.h"
 #include "../macros.h"
 #include "menus.h"
 
+/* State of built-in search shared by threads. */
+typedef struct
+{
+	const grep_t *grep; /* Pattern to look for. */
+	strlist_t paths;    /* Paths of files to search in. */
+	strlist_t names;    /* Names of the files to display in results. */
+	strlist_t *results; /* Matches per file. */
+}
+search_t;
+
+static int grep_builtin(view_t *view, menu_data_t *m, const char pattern[],
+		int invert);
+static void collect_files(view_t *view, search_t *search);
+static void add_target(view_t *view, const char path[], const char name[],
+		search_t *search);
+static void list_files(view_t *view, const char path[], const char name[],
+		search_t *search);
+static void grep_file_task(int idx, int worker, void *arg);
+static void take_results(search_t *search, menu_data_t *m);
 static int execute_grep_cb(view_t *view, menu_data_t *m);
 
 int
@@ -56,13 +89,6 @@ show_grep_menu(view_t *view, const char args[], int invert)
 
 	static menu_data_t m;
 
-	targets = menus_get_targets(view);
-	if(targets == NULL)
-	{
-		show_error_msg("Grep", "Failed to setup target directory.");
-		return 0;
-	}
-
 	menus_init_data(&m, view, format_str("Grep %s", args),
 			format_str("No matches found: %s", args));
 
@@ -70,6 +96,19 @@ show_grep_menu(view_t *view, const char args[], int invert)
 	m.execute_handler = &execute_grep_cb;
 	m.key_handler = &menus_def_khandler;
 
+	if(cfg.grep_prg[0] == '\0')
+	{
+		return grep_builtin(view, &m, args, invert);
+	}
+
+	targets = menus_get_targets(view);
+	if(targets == NULL)
+	{
+		menus_reset_data(&m);
+		show_error_msg("Grep", "Failed to setup target directory.");
+		return 0;
+	}
+
 	macros[M_i].value = invert ? "-v" : "";
 	macros[M_a].value = args;
 	macros[M_s].value = targets;
@@ -102,6 +141,224 @@ show_grep_menu(view_t *view, const char args[], int invert)
 	return save_msg;
 }
 
+/* Searches for lines that match the pattern in selected files or in all files
+ * under current directory of the view without calling an external program.
+ * Returns non-zero if status bar message should be saved. */
+static int
+grep_builtin(view_t *view, menu_data_t *m, const char pattern[], int invert)
+{
+	char *error;
+	const int nworkers = parallel_get_nworkers();
+	grep_t *const grep = grep_compile(pattern,
+			regexp_should_ignore_case(pattern), invert, nworkers, &error);
+	if(grep == NULL)
+	{
+		menus_reset_data(m);
+		show_error_msgf("Grep", "Invalid pattern: %s",
+				(error == NULL ? "out of memory" : error));
+		free(error);
+		return 0;
+	}
+
+	search_t search = { .grep = grep };
+
+	ui_sb_msg("grep...");
+	ui_cancellation_push_on();
+
+	show_progress("Listing...", 0);
+	collect_files(view, &search);
+
+	search.results = calloc(search.paths.nitems, sizeof(*search.results));
+	if(search.results != NULL)
+	{
+		show_progress("Searching...", 0);
+		(void)parallel_for(search.paths.nitems, nworkers,
+				&grep_file_task, &search, &ui_cancellation_info);
+		take_results(&search, m);
+	}
+
+	if(ui_cancellation_requested())
+	{
+		size_t len = strlen(m->title);
+		(void)strappend(&m->title, &len, "(cancelled)");
+		len = strlen(m->empty_msg);
+		(void)strappend(&m->empty_msg, &len, " (cancelled)");
+	}
+
+	ui_cancellation_pop();
+
+	free(search.results);
+	free_string_array(search.paths.items, search.paths.nitems);
+	free_string_array(search.names.items, search.names.nitems);
+	grep_free(grep);
+
+	return menus_enter(m->state, view);
+}
+
+/* Fills lists of files to search in with selected files of the view or with
+ * all files under its current directory if nothing is selected. */
+static void
+collect_files(view_t *view, search_t *search)
+{
+	if(view->selected_files == 0 &&
+			(!view->pending_marking || flist_count_marked(view) == 0))
+	{
+		list_files(view, flist_get_dir(view), "", search);
+		return;
+	}
+
+	check_marking(view, 0, NULL);
+
+	dir_entry_t *entry = NULL;
+	while(iter_marked_entries(view, &entry) && !ui_cancellation_requested())
+	{
+		char path[PATH_MAX + 1];
+		char name[PATH_MAX + 1];
+		get_full_path_of(entry, sizeof(path), path);
+		get_short_path_of(view, entry, NF_NONE, 0, sizeof(name), name);
+		add_target(view, path, name, search);
+	}
+}
+
+/* Adds a file or files of a directory to the lists of files to search in.
+ * Symbolic links are followed like for arguments of grep. */
+static void
+add_target(view_t *view, const char path[], const char name[],
+		search_t *search)
+{
+	struct stat st;
+	if(os_stat(path, &st) != 0)
+	{
+		return;
+	}
+
+	if(S_ISDIR(st.st_mode))
+	{
+		list_files(view, path, name, search);
+	}
+	else if(S_ISREG(st.st_mode))
+	{
+		search->paths.nitems = add_to_string_array(&search->paths.items,
+				search->paths.nitems, path);
+		search->names.nitems = add_to_string_array(&search->names.items,
+				search->names.nitems, name);
+	}
+}
+
+/* Adds regular files of a directory and its subdirectories to the lists of
+ * files to search in.  Dot files and filters of the view are respected,
+ * symbolic links are skipped like "grep -r" does.  name is a prefix of names
+ * to display. */
+static void
+list_files(view_t *view, const char path[], const char name[],
+		search_t *search)
+{
+	int len;
+	char **lst = list_sorted_files(path, &len);
+	if(len < 0)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < len && !ui_cancellation_requested(); ++i)
+	{
+		if(view->hide_dot && lst[i][0] == '.')
+		{
+			continue;
+		}
+
+		char *const full_path = join_paths(path, lst[i]);
+
+		struct stat st;
+		if(os_lstat(full_path, &st) == 0 &&
+				(S_ISDIR(st.st_mode) || S_ISREG(st.st_mode)) &&
+				filters_file_is_visible(view, path, lst[i], S_ISDIR(st.st_mode), 1))
+		{
+			char *const full_name = (name[0] == '\0')
+			                      ? strdup(lst[i])
+			                      : join_paths(name, lst[i]);
+			if(full_name != NULL)
+			{
+				add_target(view, full_path, full_name, search);
+				free(full_name);
+			}
+		}
+
+		free(full_path);
+		show_progress("Listing...", 1000);
+	}
+
+	free_string_array(lst, len);
+}
+
+/* Searches a single file.  Implements parallel_func for parallel_for(). */
+static void
+grep_file_task(int idx, int worker, void *arg)
+{
+	search_t *const search = arg;
+	(void)grep_file(search->grep, worker, search->paths.items[idx],
+			search->names.items[idx], &search->results[idx]);
+
+	/* Only the main thread can interact with the user. */
+	if(worker == 0)
+	{
+		show_progress("Searching...", 100);
+	}
+}
+
+/* Moves results of all files to the menu in the order of files. */
+static void
+take_results(search_t *search, menu_data_t *m)
+{
+	int i, total = m->len;
+	for(i = 0; i < search->paths.nitems; ++i)
+	{
+		total += search->results[i].nitems;
+	}
+
+	if(total == m->len)
+	{
+		return;
+	}
+
+	char **const items = reallocarray(m->items, total, sizeof(*items));
+	if(items != NULL)
+	{
+		m->items = items;
+	}
+
+	for(i = 0; i < search->paths.nitems; ++i)
+	{
+		strlist_t *const results = &search->results[i];
+
+		int j;
+		for(j = 0; j < results->nitems; ++j)
+		{
+			char *line = results->items[j];
+			if(items == NULL)
+			{
+				free(line);
+				continue;
+			}
+
+			if(strchr(line, '\t') != NULL)
+			{
+				char *const expanded = expand_tabulation_a(line, cfg.tab_stop);
+				if(expanded != NULL)
+				{
+					free(line);
+					line = expanded;
+				}
+			}
+
+			m->items[m->len++] = line;
+		}
+
+		free(results->items);
+	}
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
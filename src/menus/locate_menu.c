@@ -23,15 +23,19 @@
 #include <string.h> /* strdup() */
 
 #include "../cfg/config.h"
+#include "../modes/dialogs/msg_dialog.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
 #include "../utils/macros.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
 #include "../utils/utils.h"
+#include "../locate_index.h"
 #include "../macros.h"
 #include "../running.h"
 #include "menus.h"
 
+static int locate_builtin(view_t *view, menu_data_t *m, const char pattern[]);
 static int execute_locate_cb(view_t *view, menu_data_t *m);
 
 int
@@ -43,10 +47,16 @@ show_locate_menu(view_t *view, const char args[])
 	char *margs;
 	int save_msg;
 
+	static menu_data_t m;
+
+	if(cfg.locate_prg[0] == '\0')
+	{
+		return locate_builtin(view, &m, args);
+	}
+
 	margs = (args[0] == '-') ? strdup(args)
 	                         : shell_arg_escape(args, curr_stats.shell_type);
 
-	static menu_data_t m;
 	menus_init_data(&m, view, format_str("Locate %s", margs),
 			strdup("No files found"));
 
@@ -81,6 +91,35 @@ show_locate_menu(view_t *view, const char args[])
 	return save_msg;
 }
 
+/* Looks up paths that match the pattern in index of file names maintained by
+ * vifm itself.  Returns non-zero if status bar message should be saved. */
+static int
+locate_builtin(view_t *view, menu_data_t *m, const char pattern[])
+{
+	menus_init_data(m, view, format_str("Locate %s", pattern),
+			strdup("No files found"));
+
+	m->stashable = 1;
+	m->execute_handler = &execute_locate_cb;
+	m->key_handler = &menus_def_khandler;
+
+	ui_sb_msg("locate...");
+
+	strlist_t found = {};
+	const char *const error = locidx_query(pattern, &found);
+	if(error != NULL)
+	{
+		free_string_array(found.items, found.nitems);
+		menus_reset_data(m);
+		show_error_msg("Locate", error);
+		return 0;
+	}
+
+	m->items = found.items;
+	m->len = found.nitems;
+	return menus_enter(m->state, view);
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
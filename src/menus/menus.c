@@ -21,12 +21,16 @@
 
 #include <curses.h>
 
-#include <assert.h> /* assert() */
+#ifndef _WIN32
+#include <fcntl.h> /* F_GETFL F_SETFL O_NONBLOCK fcntl() */
+#endif
+
+#include <errno.h> /* EAGAIN errno */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* memmove() memset() strdup() strcat() strncat() strchr()
-                       strlen() strrchr() */
+#include <stdio.h> /* FILE clearerr() fclose() feof() ferror() fread() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memchr() memcpy() memmove() memset() strdup() strcat()
+                       strncat() strchr() strlen() strrchr() */
 #include <wchar.h> /* wchar_t wcscmp() */
 
 #include "../cfg/config.h"
@@ -50,6 +54,7 @@
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/regexp.h"
+#include "../utils/selector.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
 #include "../utils/utf8.h"
@@ -64,6 +69,17 @@
 #include "../search.h"
 #include "../status.h"
 
+/* State of loading output of a command into a menu. */
+typedef struct
+{
+	menu_data_t *menu;  /* Menu that receives lines of the output. */
+	bg_job_t *job;      /* Job that produces the output or NULL. */
+	int capacity;       /* Number of allocated elements of menu items. */
+	char *partial;      /* Incomplete last line of the output or NULL. */
+	size_t partial_len; /* Length of the incomplete line. */
+}
+menu_capture_t;
+
 static void reset_menu_state(menu_state_t *ms);
 static void show_position_in_menu(const menu_data_t *m);
 static void open_selected_file(const char path[], int line_num);
@@ -74,13 +90,21 @@ static void draw_search_match(char str[], int start, int end, int line,
 static void normalize_top(menu_state_t *m);
 static void draw_menu_frame(const menu_state_t *m);
 static void output_handler(const char line[], void *arg);
+static int append_line(menu_capture_t *capture, const char line[]);
+#ifndef _WIN32
+static int start_capture(view_t *view, const char cmd[], menu_data_t *m);
+#endif
+static int pull_capture(int delay);
+static void split_capture(const char text[], size_t len);
+static void stop_capture(int cancel);
+static void update_search_matches(menu_state_t *ms, int from);
 static void append_to_string(char **str, const char suffix[]);
-static char * expand_tabulation_a(const char line[], size_t tab_stops);
 static void init_menu_state(menu_state_t *ms, view_t *view);
 static const char * get_relative_path_base(const menu_data_t *m,
 		const view_t *view);
 static int menu_and_view_are_in_sync(const menu_data_t *m, const view_t *view);
 static int search_menu(menu_state_t *ms, int start_pos, int print_errors);
+static int match_menu_items(menu_state_t *ms, int from, int print_errors);
 static int search_menu_forwards(menu_state_t *m, int start_pos);
 static int search_menu_backwards(menu_state_t *m, int start_pos);
 static int navigate_to_match(menu_state_t *m, int pos);
@@ -110,6 +134,10 @@ menu_state;
 /* Temporary storage for data of the last stashable menu. */
 static menu_data_t menu_data_stash;
 
+/* Loading of command output into a menu that goes on after the menu was
+ * displayed. */
+static menu_capture_t capture;
+
 void
 menus_remove_current(menu_state_t *ms)
 {
@@ -192,6 +220,11 @@ menus_reset_data(menu_data_t *m)
 		return;
 	}
 
+	if(capture.job != NULL && capture.menu == m)
+	{
+		stop_capture(/*cancel=*/1);
+	}
+
 	/* On releasing of non-empty stashable menu, but not the stash. */
 	if(m->stashable && m->len > 0 && m != &menu_data_stash)
 	{
@@ -618,15 +651,38 @@ draw_menu_frame(const menu_state_t *m)
 static void
 output_handler(const char line[], void *arg)
 {
-	menu_data_t *const m = arg;
-	char *expanded_line;
+	(void)append_line(arg, line);
+}
+
+/* Appends a line to the menu growing storage of its items geometrically.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+append_line(menu_capture_t *capture, const char line[])
+{
+	menu_data_t *const m = capture->menu;
+
+	if(m->len == capture->capacity)
+	{
+		const int new_capacity = (capture->capacity == 0)
+		                       ? 64
+		                       : capture->capacity*2;
+		char **const items = reallocarray(m->items, new_capacity, sizeof(*items));
+		if(items == NULL)
+		{
+			return 1;
+		}
+		m->items = items;
+		capture->capacity = new_capacity;
+	}
 
-	m->items = reallocarray(m->items, m->len + 1, sizeof(char *));
-	expanded_line = expand_tabulation_a(line, cfg.tab_stop);
-	if(expanded_line != NULL)
+	char *const expanded_line = expand_tabulation_a(line, cfg.tab_stop);
+	if(expanded_line == NULL)
 	{
-		m->items[m->len++] = expanded_line;
+		return 1;
 	}
+
+	m->items[m->len++] = expanded_line;
+	return 0;
 }
 
 /* Replaces *str with a copy of the with string extended by the suffix.  *str
@@ -645,29 +701,6 @@ append_to_string(char **str, const char suffix[])
 	}
 }
 
-/* Clones the line replacing all occurrences of horizontal tabulation character
- * with appropriate number of spaces.  The tab_stops parameter shows how many
- * character position are taken by one tabulation.  Returns newly allocated
- * string. */
-static char *
-expand_tabulation_a(const char line[], size_t tab_stops)
-{
-	const size_t tab_count = chars_in_str(line, '\t');
-	const size_t extra_line_len = tab_count*tab_stops;
-	const size_t expanded_line_len = (strlen(line) - tab_count) + extra_line_len;
-	char *const expanded_line = malloc(expanded_line_len + 1);
-
-	if(expanded_line != NULL)
-	{
-		const char *const end = expand_tabulation(line, (size_t)-1, tab_stops,
-				expanded_line);
-		assert(*end == '\0' && "The line should be processed till the end");
-		(void)end;
-	}
-
-	return expanded_line;
-}
-
 int
 menus_enter(menu_state_t *m, view_t *view)
 {
@@ -871,8 +904,19 @@ menus_capture(view_t *view, const char cmd[], int user_sh, menu_data_t *m,
 
 	FILE *input_tmp = make_in_file(view, flags);
 
+#ifndef _WIN32
+	/* Output is loaded in the background only for commands that don't need input
+	 * and run in a regular shell.  It's also pointless to do before UI is fully
+	 * loaded (see modmenu_enter()). */
+	if(input_tmp == NULL && !user_sh && curr_stats.load_stage >= 2)
+	{
+		return start_capture(view, cmd, m);
+	}
+#endif
+
+	menu_capture_t sync_capture = { .menu = m, .capacity = m->len };
 	if(process_cmd_output("Loading menu", cmd, input_tmp, user_sh, 0,
-				&output_handler, m) != 0)
+				&output_handler, &sync_capture) != 0)
 	{
 		show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
 		return 0;
@@ -892,6 +936,249 @@ menus_capture(view_t *view, const char cmd[], int user_sh, menu_data_t *m,
 	return menus_enter(m->state, view);
 }
 
+#ifndef _WIN32
+/* Starts loading output of a command into the menu.  The menu is displayed as
+ * soon as there is something to show and the rest of the output is loaded by
+ * menus_check_capture().  Returns non-zero if status bar message should be
+ * saved. */
+static int
+start_capture(view_t *view, const char cmd[], menu_data_t *m)
+{
+	LOG_INFO_MSG("Capturing output of the command: %s", cmd);
+
+	bg_job_t *const job = bg_run_external_job(cmd, BJF_CAPTURE_OUT);
+	if(job == NULL)
+	{
+		show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
+		return 0;
+	}
+
+	/* Report errors like for any other background job. */
+	job->skip_errors = 0;
+
+	/* Enable non-blocking read from output pipe. */
+	const int fd = fileno(job->output);
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+	stop_capture(/*cancel=*/1);
+	capture.menu = m;
+	capture.job = job;
+	capture.capacity = m->len;
+
+	ui_cancellation_push_on();
+	while(m->len == 0 && capture.job != NULL)
+	{
+		if(ui_cancellation_requested())
+		{
+			stop_capture(/*cancel=*/1);
+			break;
+		}
+
+		if(pull_capture(/*delay=*/100))
+		{
+			stop_capture(/*cancel=*/0);
+		}
+	}
+	ui_cancellation_pop();
+
+	return menus_enter(m->state, view);
+}
+#endif
+
+void
+menus_check_capture(void)
+{
+	if(capture.job == NULL)
+	{
+		return;
+	}
+
+	menu_data_t *const m = capture.menu;
+	const int prev_len = m->len;
+
+	if(pull_capture(/*delay=*/0))
+	{
+		stop_capture(/*cancel=*/0);
+	}
+
+	menu_state_t *const ms = m->state;
+	if(m->len == prev_len || ms == NULL)
+	{
+		return;
+	}
+
+	update_search_matches(ms, prev_len);
+
+	if(vle_mode_get_primary() != MENU_MODE)
+	{
+		return;
+	}
+
+	if(prev_len < m->top + (ms->win_rows - 2))
+	{
+		menus_partial_redraw(ms);
+		if(!modes_is_cmdline_like())
+		{
+			checked_wmove(menu_win, ms->current, 2);
+		}
+	}
+	else
+	{
+		show_position_in_menu(m);
+	}
+	ui_refresh_win(menu_win);
+}
+
+/* Reads lines of command output that are available into the menu waiting for
+ * them to appear for at most delay milliseconds.  Returns non-zero on reaching
+ * end of the output, otherwise zero is returned. */
+static int
+pull_capture(int delay)
+{
+	/* Maximum number of bytes to process at once to keep UI responsive. */
+	enum { READ_BUDGET = 1024*1024 };
+
+	FILE *const fp = capture.job->output;
+
+	selector_t *const selector = selector_alloc();
+	if(selector == NULL)
+	{
+		return 0;
+	}
+	const int fd = fileno(fp);
+#ifndef _WIN32
+	selector_add(selector, fd);
+#else
+	selector_add(selector, (HANDLE)_get_osfhandle(fd));
+#endif
+
+	int at_end = 0;
+	size_t budget = READ_BUDGET;
+	while(budget > 0 && selector_wait(selector, delay))
+	{
+		char piece[4096];
+		const size_t len = fread(piece, 1, sizeof(piece), fp);
+		if(len == 0)
+		{
+			at_end = feof(fp) || (ferror(fp) && errno != EAGAIN);
+			clearerr(fp);
+			break;
+		}
+		clearerr(fp);
+
+		split_capture(piece, len);
+		budget -= MIN(len, budget);
+		delay = 0;
+	}
+
+	selector_free(selector);
+	return at_end;
+}
+
+/* Breaks piece of command output into lines and appends complete ones to the
+ * menu.  Both new line and null characters end lines. */
+static void
+split_capture(const char text[], size_t len)
+{
+	while(len != 0)
+	{
+		const char *const nl = memchr(text, '\n', len);
+		const char *const null = memchr(text, '\0', len);
+		const char *const end = (nl == NULL || (null != NULL && null < nl))
+		                      ? null
+		                      : nl;
+		const size_t piece_len = (end == NULL ? len : (size_t)(end - text));
+
+		char *const partial = realloc(capture.partial,
+				capture.partial_len + piece_len + 1);
+		if(partial == NULL)
+		{
+			return;
+		}
+		memcpy(partial + capture.partial_len, text, piece_len);
+		capture.partial = partial;
+		capture.partial_len += piece_len;
+		capture.partial[capture.partial_len] = '\0';
+
+		if(end == NULL)
+		{
+			return;
+		}
+
+		/* Empty lines are meaningful only in newline-separated output. */
+		if(capture.partial_len != 0 || end == nl)
+		{
+			if(capture.partial_len != 0 &&
+					capture.partial[capture.partial_len - 1] == '\r')
+			{
+				capture.partial[--capture.partial_len] = '\0';
+			}
+			(void)append_line(&capture, capture.partial);
+		}
+		capture.partial_len = 0;
+
+		text = end + 1;
+		len -= piece_len + 1;
+	}
+}
+
+/* Stops loading command output into a menu keeping lines that were read.  The
+ * cancel flag specifies whether the command might not have finished yet. */
+static void
+stop_capture(int cancel)
+{
+	if(capture.job == NULL)
+	{
+		return;
+	}
+
+	if(cancel)
+	{
+		(void)bg_job_cancel(capture.job);
+		/* Closing the pipe makes sure the command won't block on writing. */
+		fclose(capture.job->output);
+		capture.job->output = NULL;
+
+		append_to_string(&capture.menu->title, "(cancelled)");
+		append_to_string(&capture.menu->empty_msg, " (cancelled)");
+	}
+
+	if(capture.partial_len != 0)
+	{
+		(void)append_line(&capture, capture.partial);
+	}
+
+	bg_job_decref(capture.job);
+	free(capture.partial);
+
+	capture.menu = NULL;
+	capture.job = NULL;
+	capture.capacity = 0;
+	capture.partial = NULL;
+	capture.partial_len = 0;
+}
+
+/* Finds search matches among menu items starting with the specified one if
+ * search is active. */
+static void
+update_search_matches(menu_state_t *ms, int from)
+{
+	if(ms->matches == NULL)
+	{
+		return;
+	}
+
+	short int (*const matches)[2] = reallocarray(ms->matches, ms->d->len,
+			sizeof(*ms->matches));
+	if(matches == NULL)
+	{
+		return;
+	}
+
+	ms->matches = matches;
+	(void)match_menu_items(ms, from, /*print_errors=*/0);
+}
+
 void
 menus_search_repeat(menu_state_t *m, int backward)
 {
@@ -961,18 +1248,28 @@ static int
 search_menu(menu_state_t *ms, int start_pos, int print_errors)
 {
 	menu_data_t *const m = ms->d;
-	int cflags;
-	regex_t re;
-	int err;
-	int i;
 
 	if(ms->matches == NULL)
 	{
 		ms->matches = reallocarray(NULL, m->len, sizeof(*ms->matches));
 	}
 
-	memset(ms->matches, -1, 2*sizeof(**ms->matches)*m->len);
 	ms->matching_entries = 0;
+	return match_menu_items(ms, 0, print_errors);
+}
+
+/* Marks menu items starting with the specified one that match search pattern.
+ * Returns non-zero on error. */
+static int
+match_menu_items(menu_state_t *ms, int from, int print_errors)
+{
+	menu_data_t *const m = ms->d;
+	int cflags;
+	regex_t re;
+	int err;
+	int i;
+
+	memset(ms->matches + from, -1, 2*sizeof(**ms->matches)*(m->len - from));
 
 	if(ms->regexp[0] == '\0')
 	{
@@ -991,7 +1288,7 @@ search_menu(menu_state_t *ms, int start_pos, int print_errors)
 		return -1;
 	}
 
-	for(i = 0; i < m->len; ++i)
+	for(i = from; i < m->len; ++i)
 	{
 		regmatch_t matches[1];
 		const char *item = m->items[i];
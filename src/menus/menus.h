@@ -119,6 +119,10 @@ int menus_to_custom_view(menu_state_t *m, struct view_t *view, int very);
 int menus_capture(struct view_t *view, const char cmd[], int user_sh,
 		menu_data_t *m, MacroFlags flags);
 
+/* Loads more output of a command that goes on running after menus_capture()
+ * displayed a menu and redraws the menu if it's visible. */
+void menus_check_capture(void);
+
 /* Menu drawing. */
 
 /* Erases current menu item in menu window. */
@@ -166,6 +166,7 @@ enter_attr_mode(view_t *active_view)
 		diff |= (entry->mode ^ fmode);
 		file_is_dir |= fentry_is_dir(entry);
 
+		fentry_load_stats(entry);
 		if(uid != 0 && entry->uid != uid)
 		{
 			show_error_msgf("Access error", "You are not owner of %s", entry->name);
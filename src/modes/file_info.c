@@ -169,6 +169,7 @@ fill_items(view_t *view, draw_ctx_t *ctx)
 {
 	char buf[256];
 	const dir_entry_t *curr = get_current_entry(view);
+	fentry_load_stats(curr);
 
 	char *escaped = escape_unreadable(curr->origin);
 	print_item("Path", escaped, ctx);
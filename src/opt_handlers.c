@@ -148,6 +148,7 @@ static void iooptions_handler(OPT_OP op, optval_t val);
 static void laststatus_handler(OPT_OP op, optval_t val);
 static void lines_handler(OPT_OP op, optval_t val);
 static void locateprg_handler(OPT_OP op, optval_t val);
+static void locateroots_handler(OPT_OP op, optval_t val);
 #ifndef _WIN32
 static void mediaprg_handler(OPT_OP op, optval_t val);
 #endif
@@ -360,9 +361,11 @@ static const char *navoptions_vals[][2] = {
 
 /* Possible values of 'previewoptions'. */
 static const char *previewoptions_vals[][2] = {
+	{ "diskcache:",        "size of persistent cache of previews in MiB" },
 	{ "graphicsdelay:",    "delay before drawing graphics" },
 	{ "hardgraphicsclear", "redraw screen to get rid of graphics" },
 	{ "maxtreedepth:",     "how many tree levels too display" },
+	{ "prefetch:",         "how many neighbouring files to preview in advance" },
 	{ "toptreestats",      "show file counts on top of the tree" },
 };
 
@@ -738,6 +741,10 @@ options[] = {
 	  OPT_STR, 0, NULL, &locateprg_handler, NULL,
 	  { .ref.str_val = &cfg.locate_prg },
 	},
+	{ "locateroots", "", "directories indexed for :locate",
+	  OPT_STRLIST, 0, NULL, &locateroots_handler, NULL,
+	  { .ref.str_val = &cfg.locate_roots },
+	},
 #ifndef _WIN32
 	{ "mediaprg", "", "helper for :media menu",
 	  OPT_STR, 0, NULL, &mediaprg_handler, NULL,
@@ -1276,6 +1283,18 @@ init_previewoptions(optval_t *val)
 	{
 		(void)sstrappend(buf, &len, sizeof(buf), "toptreestats,");
 	}
+	if(cfg.preview_disk_cache > 0)
+	{
+		char item[32];
+		snprintf(item, sizeof(item), "diskcache:%d,", cfg.preview_disk_cache);
+		(void)sstrappend(buf, &len, sizeof(buf), item);
+	}
+	if(cfg.preview_prefetch > 0)
+	{
+		char item[32];
+		snprintf(item, sizeof(item), "prefetch:%d,", cfg.preview_prefetch);
+		(void)sstrappend(buf, &len, sizeof(buf), item);
+	}
 	if(cfg.max_tree_depth > 0)
 	{
 		snprintf(buf + len, sizeof(buf) - len, "maxtreedepth:%d,",
@@ -2343,6 +2362,13 @@ locateprg_handler(OPT_OP op, optval_t val)
 	(void)replace_string(&cfg.locate_prg, val.str_val);
 }
 
+/* Handles updates of the 'locateroots' option. */
+static void
+locateroots_handler(OPT_OP op, optval_t val)
+{
+	(void)replace_string(&cfg.locate_roots, val.str_val);
+}
+
 #ifndef _WIN32
 
 /* Handles updates of the 'mediaprg' option. */
@@ -2471,10 +2497,28 @@ previewoptions_handler(OPT_OP op, optval_t val)
 	int hard_graphics_clear = 0;
 	int top_tree_stats = 0;
 	int max_tree_depth = 0;
+	int prefetch = 0;
+	int disk_cache = 0;
 
 	while((part = split_and_get(part, ',', &state)) != NULL)
 	{
-		if(starts_with_lit(part, "graphicsdelay:"))
+		if(starts_with_lit(part, "diskcache:"))
+		{
+			const char *const num = after_first(part, ':');
+			if(!read_int(num, &disk_cache))
+			{
+				vle_tb_append_linef(vle_err,
+						"Failed to parse \"diskcache\" value: %s", num);
+				break;
+			}
+			if(disk_cache < 0)
+			{
+				vle_tb_append_linef(vle_err,
+						"\"diskcache\" can't be negative, got: %s", num);
+				break;
+			}
+		}
+		else if(starts_with_lit(part, "graphicsdelay:"))
 		{
 			const char *const num = after_first(part, ':');
 			if(!read_int(num, &graphics_delay))
@@ -2506,6 +2550,22 @@ previewoptions_handler(OPT_OP op, optval_t val)
 				break;
 			}
 		}
+		else if(starts_with_lit(part, "prefetch:"))
+		{
+			const char *const num = after_first(part, ':');
+			if(!read_int(num, &prefetch))
+			{
+				vle_tb_append_linef(vle_err,
+						"Failed to parse \"prefetch\" value: %s", num);
+				break;
+			}
+			if(prefetch < 0)
+			{
+				vle_tb_append_linef(vle_err,
+						"\"prefetch\" can't be negative, got: %s", num);
+				break;
+			}
+		}
 		else if(strcmp(part, "hardgraphicsclear") == 0)
 		{
 			hard_graphics_clear = 1;
@@ -2533,6 +2593,8 @@ previewoptions_handler(OPT_OP op, optval_t val)
 		cfg.hard_graphics_clear = hard_graphics_clear;
 		cfg.top_tree_stats = top_tree_stats;
 		cfg.max_tree_depth = max_tree_depth;
+		cfg.preview_prefetch = prefetch;
+		cfg.preview_disk_cache = disk_cache;
 
 		if(need_update)
 		{
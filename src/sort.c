@@ -23,8 +23,10 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() */
-#include <string.h> /* strcmp() strrchr() */
+#include <limits.h> /* UCHAR_MAX */
+#include <stddef.h> /* size_t */
+#include <stdlib.h> /* abs() free() malloc() qsort() realloc() */
+#include <string.h> /* memcmp() memcpy() strcmp() strlen() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -32,6 +34,8 @@
 #include "utils/dynarray.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
+#include "utils/macros.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
@@ -43,6 +47,41 @@
 #include "status.h"
 #include "types.h"
 
+/* Minimal number of entries for which sorting is spread among threads. */
+#define PARALLEL_SORT_MIN 32768
+
+/* Type of function that compares two entries by the key of current sorting
+ * round.  Returns positive value if f is greater than s, zero if they are
+ * equal, otherwise negative value is returned. */
+typedef int (*key_cmp_func)(const dir_entry_t *f, const dir_entry_t *s);
+
+/* State of sorting array of pointers to entries on multiple threads. */
+typedef struct
+{
+	dir_entry_t **ptrs; /* Array which is being sorted. */
+	dir_entry_t **tmp;  /* Buffer of the same size for merging. */
+	size_t count;       /* Number of elements in the arrays. */
+	size_t run;         /* Length of sorted runs at the current stage. */
+}
+psort_t;
+
+/* Location of precomputed sort key of an entry in the buffer of keys. */
+typedef struct
+{
+	size_t offset; /* Offset of the key in the buffer. */
+	int len;       /* Length of the key or -1 if it isn't usable. */
+}
+name_key_t;
+
+/* Buffer with keys of all entries that are being sorted. */
+typedef struct
+{
+	char *data;  /* Bytes of all keys. */
+	size_t len;  /* Number of used bytes. */
+	size_t size; /* Number of allocated bytes. */
+}
+keys_buf_t;
+
 static void sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 		size_t nchildren, int root);
 static void sort_sequence(dir_entry_t *entries, size_t nentries);
@@ -50,7 +89,31 @@ static void sort_by_groups(dir_entry_t *entries, signed char key,
 		size_t nentries);
 static void sort_by_key(dir_entry_t *entries, size_t nentries, signed char key,
 		void *data);
+static key_cmp_func pick_key_cmp(SortingKey key);
+static int build_name_keys(const dir_entry_t *entries, size_t nentries,
+		int ignore_case);
+static int make_name_key(const char name[], int ignore_case, keys_buf_t *buf);
+static int put_key_bytes(keys_buf_t *buf, const char bytes[], size_t len);
+static void free_name_keys(void);
+static int compare_name_keys(const dir_entry_t *f, const dir_entry_t *s);
+static int build_sizes(const dir_entry_t *entries, size_t nentries);
+static int compare_known_sizes(const dir_entry_t *f, const dir_entry_t *s);
+static int sort_in_parallel(dir_entry_t *entries, size_t nentries);
+static void sort_run(int idx, int worker, void *arg);
+static void merge_runs(int idx, int worker, void *arg);
+static void apply_order(dir_entry_t *entries, dir_entry_t **ptrs,
+		size_t nentries);
+static int compare_entry_ptrs(const void *one, const void *two);
 static int sort_dir_list(const void *one, const void *two);
+static int compare_by_key(const dir_entry_t *first, const dir_entry_t *second);
+static int compare_by_all_keys(const dir_entry_t *f, const dir_entry_t *s);
+static int compare_with_key(const dir_entry_t *f, const dir_entry_t *s,
+		signed char key);
+static int compare_names(const dir_entry_t *f, const dir_entry_t *s);
+static int compare_inames(const dir_entry_t *f, const dir_entry_t *s);
+static int compare_paths(const dir_entry_t *f, const dir_entry_t *s);
+static int compare_ipaths(const dir_entry_t *f, const dir_entry_t *s);
+static int compare_mtimes(const dir_entry_t *f, const dir_entry_t *s);
 TSTATIC int strnumcmp(const char s[], const char t[]);
 #if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
 static int vercmp(const char s[], const char t[]);
@@ -82,6 +145,16 @@ static int sort_descending;
 static SortingKey sort_type;
 /* Sorting key specific data. */
 static void *sort_data;
+/* Comparator for the key of current sorting round. */
+static key_cmp_func sort_key_cmp;
+/* Comparator that is used for names which lack precomputed keys. */
+static key_cmp_func name_key_fallback;
+/* Precomputed keys of entries indexed by their tags. */
+static name_key_t *name_keys;
+/* Bytes of precomputed keys. */
+static char *name_keys_data;
+/* Precomputed sizes of entries indexed by their tags. */
+static uint64_t *sizes;
 
 void
 sort_view(view_t *v)
@@ -175,6 +248,47 @@ sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 	}
 }
 
+int
+sort_find_insert_pos(view_t *v, const dir_entry_t *entry)
+{
+	if(v->sort[0] > SK_LAST)
+	{
+		/* Unsorted list. */
+		return v->list_rows;
+	}
+
+	/* Groups are compared by regular expressions compiled for a whole sorting
+	 * round. */
+	if(ui_view_sort_list_contains(v->sort, SK_BY_GROUPS))
+	{
+		return -1;
+	}
+
+	view = v;
+	view_sort = v->sort;
+	view_sort_groups = v->sort_groups;
+	custom_view = flist_custom_active(v);
+
+	/* Place the entry after all equal ones like a stable sort would do for an
+	 * entry at the end of the list. */
+	int l = 0, u = v->list_rows;
+	while(l < u)
+	{
+		const int i = l + (u - l)/2;
+		const dir_entry_t *const e = &v->dir_entry[i];
+		if((is_parent_dir(e->name) && fentry_is_dir(e)) ||
+				compare_by_all_keys(entry, e) >= 0)
+		{
+			l = i + 1;
+		}
+		else
+		{
+			u = i;
+		}
+	}
+	return l;
+}
+
 void
 sort_entries(view_t *v, entries_t entries)
 {
@@ -261,14 +375,434 @@ sort_by_key(dir_entry_t *entries, size_t nentries, signed char key, void *data)
 	sort_descending = (key < 0);
 	sort_type = (SortingKey)abs(key);
 	sort_data = data;
+	sort_key_cmp = pick_key_cmp(sort_type);
+
+	const int load_stats = fentry_key_needs_stats(sort_type);
 
 	unsigned int i;
 	for(i = 0U; i < nentries; ++i)
 	{
 		entries[i].tag = i;
+		if(load_stats)
+		{
+			fentry_load_stats(&entries[i]);
+		}
+	}
+
+	/* Names are turned into keys once instead of normalizing them on each
+	 * comparison. */
+	const int keyed = (sort_type == SK_BY_NAME || sort_type == SK_BY_INAME)
+	               && build_name_keys(entries, nentries,
+	                                  sort_type == SK_BY_INAME) == 0;
+	if(keyed)
+	{
+		name_key_fallback = sort_key_cmp;
+		sort_key_cmp = &compare_name_keys;
+	}
+
+	/* Getting size of a directory can calculate it and update dcache, which
+	 * should happen on this thread, so do it for all entries beforehand. */
+	const int sized = sort_key_cmp == &compare_file_sizes
+	               && nentries >= PARALLEL_SORT_MIN
+	               && build_sizes(entries, nentries) == 0;
+	if(sized)
+	{
+		sort_key_cmp = &compare_known_sizes;
+	}
+
+	/* Only specialized comparators that don't query file system are known to be
+	 * safe to call from multiple threads. */
+	if(sort_key_cmp == &compare_by_key || sort_key_cmp == &compare_file_sizes ||
+			sort_in_parallel(entries, nentries) != 0)
+	{
+		safe_qsort(entries, nentries, sizeof(*entries), &sort_dir_list);
+	}
+
+	if(keyed)
+	{
+		free_name_keys();
+	}
+	if(sized)
+	{
+		free(sizes);
+		sizes = NULL;
+	}
+}
+
+/* Picks comparison function for the key.  Common keys get specialized
+ * functions to avoid dispatching on the key for every comparison.  Returns the
+ * function. */
+static key_cmp_func
+pick_key_cmp(SortingKey key)
+{
+	switch(key)
+	{
+		case SK_BY_NAME:
+			return custom_view ? &compare_paths : &compare_names;
+		case SK_BY_INAME:
+			return custom_view ? &compare_ipaths : &compare_inames;
+		case SK_BY_SIZE:
+			return &compare_file_sizes;
+		case SK_BY_TIME_MODIFIED:
+			return &compare_mtimes;
+
+		default:
+			return &compare_by_key;
+	}
+}
+
+/* Computes sort keys for names of entries, which must be tagged with their
+ * indexes.  Keys are ordered by memcmp() exactly like names are ordered by
+ * compare_full_file_names(), entries for which this can't be guaranteed get
+ * unusable keys.  Returns zero on success, otherwise non-zero is returned. */
+static int
+build_name_keys(const dir_entry_t *entries, size_t nentries, int ignore_case)
+{
+	if(nentries < 2U)
+	{
+		return 1;
+	}
+
+	keys_buf_t buf = { .data = NULL, .len = 0U, .size = 0U };
+	name_keys = malloc(sizeof(*name_keys)*nentries);
+	if(name_keys == NULL)
+	{
+		return 1;
+	}
+
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		const char *name = entries[i].name;
+		char short_path[PATH_MAX + 1];
+		if(custom_view)
+		{
+			get_short_path_of(view, &entries[i], NF_NONE, 0, sizeof(short_path),
+					short_path);
+			name = short_path;
+		}
+
+		const size_t offset = buf.len;
+		const int error = make_name_key(name, ignore_case, &buf);
+		if(error < 0)
+		{
+			free(buf.data);
+			free(name_keys);
+			name_keys = NULL;
+			return 1;
+		}
+
+		name_keys[i].offset = offset;
+		name_keys[i].len = (error == 0) ? (int)(buf.len - offset) : -1;
+		if(error != 0)
+		{
+			buf.len = offset;
+		}
+	}
+
+	name_keys_data = buf.data;
+	return 0;
+}
+
+/* Appends key of the name to the buffer.  The key starts with a byte that puts
+ * dot files first followed by (case-folded) name in which runs of digits are
+ * replaced with '0', their length and digits themselves if numbers are sorted
+ * naturally.  Case-folded keys end with original name preceded by a '\0' to
+ * break ties.  Returns zero on success, positive number if the name has
+ * numbers with leading zeros, whose ordering isn't reproduced by the key, or
+ * negative number on memory error. */
+static int
+make_name_key(const char name[], int ignore_case, keys_buf_t *buf)
+{
+	const char *val = name;
+	char lowered[NAME_MAX + 1];
+	if(ignore_case)
+	{
+		/* Same truncation as in compare_file_names(). */
+		(void)str_to_lower(name, lowered, sizeof(lowered));
+		val = lowered;
+	}
+
+	const char dot_rank = (name[0] == '.') ? 0 : 1;
+	if(put_key_bytes(buf, &dot_rank, 1U) != 0)
+	{
+		return -1;
+	}
+
+	if(!cfg.sort_numbers)
+	{
+		if(put_key_bytes(buf, val, strlen(val)) != 0)
+		{
+			return -1;
+		}
+	}
+	else
+	{
+#if !defined(HAVE_STRVERSCMP_FUNC) || !HAVE_STRVERSCMP_FUNC
+		return 1;
+#else
+		/* Within runs of non-zero digits strverscmp() compares lengths first and
+		 * digits second, while against other characters any digit compares like
+		 * '0' does. */
+		val = skip_leading_zeros(val);
+		while(*val != '\0')
+		{
+			if(!isdigit((unsigned char)*val))
+			{
+				if(put_key_bytes(buf, val++, 1U) != 0)
+				{
+					return -1;
+				}
+				continue;
+			}
+
+			if(*val == '0')
+			{
+				return 1;
+			}
+
+			const char *end = val;
+			while(isdigit((unsigned char)*end))
+			{
+				++end;
+			}
+
+			const size_t len = end - val;
+			if(len > UCHAR_MAX)
+			{
+				return 1;
+			}
+
+			const char header[] = { '0', (char)len };
+			if(put_key_bytes(buf, header, sizeof(header)) != 0 ||
+					put_key_bytes(buf, val, len) != 0)
+			{
+				return -1;
+			}
+			val = end;
+		}
+#endif
+	}
+
+	if(ignore_case)
+	{
+		if(put_key_bytes(buf, "", 1U) != 0 ||
+				put_key_bytes(buf, name, strlen(name)) != 0)
+		{
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* Appends bytes to the buffer growing it geometrically.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+put_key_bytes(keys_buf_t *buf, const char bytes[], size_t len)
+{
+	if(buf->len + len > buf->size)
+	{
+		size_t size = (buf->size == 0U) ? 4096U : buf->size*2U;
+		while(buf->len + len > size)
+		{
+			size *= 2U;
+		}
+
+		char *data = realloc(buf->data, size);
+		if(data == NULL)
+		{
+			return 1;
+		}
+
+		buf->data = data;
+		buf->size = size;
+	}
+
+	memcpy(buf->data + buf->len, bytes, len);
+	buf->len += len;
+	return 0;
+}
+
+/* Frees keys computed by build_name_keys(). */
+static void
+free_name_keys(void)
+{
+	free(name_keys);
+	name_keys = NULL;
+	free(name_keys_data);
+	name_keys_data = NULL;
+}
+
+/* Compares names of two entries via their precomputed keys falling back to
+ * regular comparison of names if any of the keys is unusable. */
+static int
+compare_name_keys(const dir_entry_t *f, const dir_entry_t *s)
+{
+	const name_key_t *const fkey = &name_keys[f->tag];
+	const name_key_t *const skey = &name_keys[s->tag];
+	if(fkey->len < 0 || skey->len < 0)
+	{
+		return name_key_fallback(f, s);
+	}
+
+	const int result = memcmp(name_keys_data + fkey->offset,
+			name_keys_data + skey->offset, MIN(fkey->len, skey->len));
+	return (result != 0) ? result : fkey->len - skey->len;
+}
+
+/* Computes sizes of entries, which must be tagged with their indexes.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+build_sizes(const dir_entry_t *entries, size_t nentries)
+{
+	sizes = malloc(sizeof(*sizes)*nentries);
+	if(sizes == NULL)
+	{
+		return 1;
 	}
 
-	safe_qsort(entries, nentries, sizeof(*entries), &sort_dir_list);
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		sizes[i] = fentry_get_size(view, &entries[i]);
+	}
+	return 0;
+}
+
+/* Compares sizes of two entries computed by build_sizes().  Returns standard
+ * -1, 0, 1 for comparisons. */
+static int
+compare_known_sizes(const dir_entry_t *f, const dir_entry_t *s)
+{
+	const uint64_t fsize = sizes[f->tag];
+	const uint64_t ssize = sizes[s->tag];
+	return (fsize < ssize) ? -1 : (fsize > ssize);
+}
+
+/* Sorts big list of entries by splitting it into runs, sorting them on
+ * separate threads and merging the results also in parallel.  Pointers to
+ * entries are sorted rather than entries themselves to move less data around.
+ * Returns zero on success and non-zero if the list should be sorted in
+ * a regular way. */
+static int
+sort_in_parallel(dir_entry_t *entries, size_t nentries)
+{
+	const int nworkers = parallel_get_nworkers();
+	if(nentries < PARALLEL_SORT_MIN || nworkers < 2)
+	{
+		return 1;
+	}
+
+	psort_t ps = {
+		.ptrs = malloc(sizeof(*ps.ptrs)*nentries),
+		.tmp = malloc(sizeof(*ps.tmp)*nentries),
+		.count = nentries,
+		.run = DIV_ROUND_UP(nentries, nworkers),
+	};
+	if(ps.ptrs == NULL || ps.tmp == NULL)
+	{
+		free(ps.ptrs);
+		free(ps.tmp);
+		return 1;
+	}
+
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		ps.ptrs[i] = &entries[i];
+	}
+
+	(void)parallel_for(DIV_ROUND_UP(nentries, ps.run), nworkers, &sort_run, &ps,
+			&no_cancellation);
+
+	while(ps.run < nentries)
+	{
+		(void)parallel_for(DIV_ROUND_UP(nentries, 2U*ps.run), nworkers,
+				&merge_runs, &ps, &no_cancellation);
+
+		dir_entry_t **const t = ps.ptrs;
+		ps.ptrs = ps.tmp;
+		ps.tmp = t;
+		ps.run *= 2U;
+	}
+
+	apply_order(entries, ps.ptrs, nentries);
+
+	free(ps.ptrs);
+	free(ps.tmp);
+	return 0;
+}
+
+/* parallel_for() callback that sorts a single run of pointers. */
+static void
+sort_run(int idx, int worker, void *arg)
+{
+	psort_t *const ps = arg;
+	const size_t from = idx*ps->run;
+	const size_t to = MIN(from + ps->run, ps->count);
+	qsort(&ps->ptrs[from], to - from, sizeof(*ps->ptrs), &compare_entry_ptrs);
+}
+
+/* parallel_for() callback that merges a pair of adjacent sorted runs of
+ * pointers into the buffer. */
+static void
+merge_runs(int idx, int worker, void *arg)
+{
+	psort_t *const ps = arg;
+	const size_t from = 2U*idx*ps->run;
+	const size_t mid = MIN(from + ps->run, ps->count);
+	const size_t to = MIN(mid + ps->run, ps->count);
+
+	size_t i = from, j = mid, k = from;
+	while(i < mid && j < to)
+	{
+		ps->tmp[k++] = (sort_dir_list(ps->ptrs[j], ps->ptrs[i]) < 0)
+		             ? ps->ptrs[j++]
+		             : ps->ptrs[i++];
+	}
+	while(i < mid)
+	{
+		ps->tmp[k++] = ps->ptrs[i++];
+	}
+	while(j < to)
+	{
+		ps->tmp[k++] = ps->ptrs[j++];
+	}
+}
+
+/* Reorders entries in place to match order of pointers to them by following
+ * cycles of the permutation.  Destroys contents of ptrs. */
+static void
+apply_order(dir_entry_t *entries, dir_entry_t **ptrs, size_t nentries)
+{
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		if(ptrs[i] == &entries[i])
+		{
+			continue;
+		}
+
+		const dir_entry_t saved = entries[i];
+		size_t k = i;
+		while(ptrs[k] != &entries[i])
+		{
+			dir_entry_t *const next = ptrs[k];
+			entries[k] = *next;
+			ptrs[k] = &entries[k];
+			k = next - entries;
+		}
+		entries[k] = saved;
+		ptrs[k] = &entries[k];
+	}
+}
+
+/* qsort() comparator for an array of pointers to entries. */
+static int
+compare_entry_ptrs(const void *one, const void *two)
+{
+	return sort_dir_list(*(dir_entry_t *const *)one, *(dir_entry_t *const *)two);
 }
 
 /* Compares file names containing numbers correctly. */
@@ -332,27 +866,90 @@ skip_leading_zeros(const char str[])
 }
 #endif
 
+/* qsort() comparator for entries that handles ".." entries, descending order
+ * and ties, while delegating the rest to comparator of the current key. */
 static int
 sort_dir_list(const void *one, const void *two)
 {
-	/* TODO: refactor this function sort_dir_list(). */
-
-	int retval;
 	const dir_entry_t *const first = one;
 	const dir_entry_t *const second = two;
 
-	const int first_is_dir = fentry_is_dir(first);
-	const int second_is_dir = fentry_is_dir(second);
-
-	if(first_is_dir && is_parent_dir(first->name))
+	if(is_parent_dir(first->name) && fentry_is_dir(first))
 	{
 		return -1;
 	}
-	if(second_is_dir && is_parent_dir(second->name))
+	if(is_parent_dir(second->name) && fentry_is_dir(second))
 	{
 		return 1;
 	}
 
+	int retval = sort_key_cmp(first, second);
+	if(retval == 0)
+	{
+		retval = first->tag - second->tag;
+	}
+	else if(sort_descending)
+	{
+		retval = -retval;
+	}
+
+	return retval;
+}
+
+/* Compares two entries by all sorting keys in the order of their significance,
+ * which is reverse to the order of sorting rounds in sort_sequence().  Returns
+ * positive value if f is greater than s, zero if they are equal, otherwise
+ * negative value is returned. */
+static int
+compare_by_all_keys(const dir_entry_t *f, const dir_entry_t *s)
+{
+	int result = 0;
+
+	if(!ui_view_sort_list_contains(view_sort, SK_BY_DIR))
+	{
+		result = compare_with_key(f, s, SK_BY_DIR);
+	}
+
+	int i;
+	for(i = 0; i < SK_COUNT && result == 0; ++i)
+	{
+		if(abs(view_sort[i]) <= SK_LAST)
+		{
+			result = compare_with_key(f, s, view_sort[i]);
+		}
+	}
+
+	return result;
+}
+
+/* Compares two entries by a single key, which is negative for descending
+ * order.  Returns positive value if f is greater than s, zero if they are
+ * equal, otherwise negative value is returned. */
+static int
+compare_with_key(const dir_entry_t *f, const dir_entry_t *s, signed char key)
+{
+	sort_descending = (key < 0);
+	sort_type = (SortingKey)abs(key);
+	sort_data = NULL;
+	sort_key_cmp = pick_key_cmp(sort_type);
+
+	const int result = sort_key_cmp(f, s);
+	return (sort_descending ? -result : result);
+}
+
+/* Compares two entries by the key of current sorting round in a generic
+ * way.  Returns positive value if first is greater than second, zero if they
+ * are equal, otherwise negative value is returned. */
+static int
+compare_by_key(const dir_entry_t *first, const dir_entry_t *second)
+{
+	/* TODO: refactor this function compare_by_key(). */
+
+	int retval;
+
+	const int first_is_dir = fentry_is_dir(first);
+	const int second_is_dir = fentry_is_dir(second);
+
 	retval = 0;
 	switch(sort_type)
 	{
@@ -478,18 +1075,45 @@ sort_dir_list(const void *one, const void *two)
 #endif
 	}
 
-	if(retval == 0)
-	{
-		retval = first->tag - second->tag;
-	}
-	else if(sort_descending)
-	{
-		retval = -retval;
-	}
-
 	return retval;
 }
 
+/* Compares names of two entries of a regular view. */
+static int
+compare_names(const dir_entry_t *f, const dir_entry_t *s)
+{
+	return compare_full_file_names(f->name, s->name, 0);
+}
+
+/* Compares names of two entries of a regular view ignoring case. */
+static int
+compare_inames(const dir_entry_t *f, const dir_entry_t *s)
+{
+	return compare_full_file_names(f->name, s->name, 1);
+}
+
+/* Compares short paths of two entries of a custom view. */
+static int
+compare_paths(const dir_entry_t *f, const dir_entry_t *s)
+{
+	return compare_entry_names(f, s, 0);
+}
+
+/* Compares short paths of two entries of a custom view ignoring case. */
+static int
+compare_ipaths(const dir_entry_t *f, const dir_entry_t *s)
+{
+	return compare_entry_names(f, s, 1);
+}
+
+/* Compares modification times of two entries.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_mtimes(const dir_entry_t *f, const dir_entry_t *s)
+{
+	return (f->mtime < s->mtime) ? -1 : (f->mtime > s->mtime);
+}
+
 /* Compares two file sizes.  Returns standard -1, 0, 1 for comparisons. */
 static int
 compare_file_sizes(const dir_entry_t *f, const dir_entry_t *s)
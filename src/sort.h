@@ -26,6 +26,11 @@
 /* Sorts entries of the view according to its sorting configuration. */
 void sort_view(view_t *view);
 
+/* Finds position at which the entry should be inserted into the sorted list of
+ * the view to keep it sorted.  Returns the position or -1 if it can't be
+ * determined, in which case the whole list needs to be sorted. */
+int sort_find_insert_pos(view_t *view, const dir_entry_t *entry);
+
 /* Sorts specified entries using global settings of the view. */
 void sort_entries(view_t *view, entries_t entries);
 
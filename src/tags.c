@@ -82,6 +82,7 @@ const char *tags[] = {
 	"vifm-'laststatus'",
 	"vifm-'lines'",
 	"vifm-'locateprg'",
+	"vifm-'locateroots'",
 	"vifm-'ls'",
 	"vifm-'lsoptions'",
 	"vifm-'lsview'",
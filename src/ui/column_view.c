@@ -180,6 +180,20 @@ columns_clear(columns_t *cols)
 	cols->count = 0;
 }
 
+int
+columns_has_column(const columns_t *cols, int column_id)
+{
+	size_t i;
+	for(i = 0U; i < cols->count; ++i)
+	{
+		if(cols->list[i].info.column_id == column_id)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
 void
 columns_clear_column_descs(void)
 {
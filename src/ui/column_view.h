@@ -113,6 +113,10 @@ void columns_add_column(columns_t *cols, column_info_t info);
 /* Clears list of columns of the cols. */
 void columns_clear(columns_t *cols);
 
+/* Checks whether there is a column with specified id among the cols.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int columns_has_column(const columns_t *cols, int column_id);
+
 /* Performs actual formatting of columns. */
 void columns_format_line(columns_t *cols, void *format_data,
 		size_t max_line_width);
@@ -1628,6 +1628,8 @@ format_time(void *data, size_t buf_len, char buf[], const format_info_t *info)
 	struct tm *tm_ptr;
 	const column_data_t *cdt = info->data;
 
+	fentry_load_stats(cdt->entry);
+
 	switch(info->id)
 	{
 		case SK_BY_TIME_MODIFIED:
@@ -1673,6 +1675,8 @@ format_group(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
 
+	fentry_load_stats(cdt->entry);
+
 	buf[0] = ' ';
 	get_gid_string(cdt->entry, info->id == SK_BY_GROUP_ID, buf_len - 1, buf + 1);
 }
@@ -1683,6 +1687,8 @@ format_owner(void *data, size_t buf_len, char buf[], const format_info_t *info)
 {
 	const column_data_t *cdt = info->data;
 
+	fentry_load_stats(cdt->entry);
+
 	buf[0] = ' ';
 	get_uid_string(cdt->entry, info->id == SK_BY_OWNER_ID, buf_len - 1, buf + 1);
 }
@@ -91,6 +91,8 @@ typedef struct
 }
 tree_print_state_t;
 
+static void prefetch_entry(view_t *view, int pos,
+		const preview_area_t *parea);
 static const char * view_entry(const dir_entry_t *entry,
 		const preview_area_t *parea, quickview_cache_t *cache);
 static const char * view_file(const char path[], const preview_area_t *parea,
@@ -226,6 +228,97 @@ qv_draw(view_t *view)
 	ui_view_title_update(other_view);
 }
 
+void
+qv_prefetch(view_t *view)
+{
+	/* Position of the cursor during previous call and direction of its last
+	 * movement. */
+	static const view_t *last_view;
+	static int last_pos = -1;
+	static int direction = 1;
+
+	if(cfg.preview_prefetch == 0 || !curr_stats.preview.on ||
+			curr_stats.load_stage < 2 || curr_stats.number_of_windows == 1 ||
+			view != curr_view)
+	{
+		return;
+	}
+
+	if(view == last_view && view->list_pos != last_pos)
+	{
+		direction = (view->list_pos < last_pos ? -1 : 1);
+	}
+	last_view = view;
+	last_pos = view->list_pos;
+
+	/* Viewers might use relative path, so try to make sure that we're at correct
+	 * location. */
+	(void)vifm_chdir(flist_get_dir(view));
+
+	const preview_area_t parea = {
+		.source = view,
+		.view = other_view,
+		.def_col = cfg.cs.color[WIN_COLOR],
+		.x = ui_qv_left(other_view),
+		.y = ui_qv_top(other_view),
+		.w = ui_qv_width(other_view),
+		.h = ui_qv_height(other_view),
+	};
+
+	vcache_prefetch_begin();
+
+	const int orig_pos = view->list_pos;
+	int pos = orig_pos;
+	int i;
+	for(i = 0; i < cfg.preview_prefetch; ++i)
+	{
+		pos += direction;
+		if(pos < 0 || pos >= view->list_rows)
+		{
+			break;
+		}
+		prefetch_entry(view, pos, &parea);
+	}
+	view->list_pos = orig_pos;
+
+	vcache_prefetch_end();
+}
+
+/* Starts making preview of a regular file at specified position in the view if
+ * it's going to be produced by an external viewer. */
+static void
+prefetch_entry(view_t *view, int pos, const preview_area_t *parea)
+{
+	const dir_entry_t *entry = &view->dir_entry[pos];
+	if(entry->type != FT_REG || fentry_is_fake(entry))
+	{
+		return;
+	}
+
+	char path[PATH_MAX + 1];
+	qv_get_path_to_explore(entry, path, sizeof(path));
+
+	const char *viewer = qv_get_viewer(path);
+	if(viewer == NULL || ft_viewer_kind(viewer) != VK_TEXTUAL)
+	{
+		return;
+	}
+
+	/* Macros are expanded relative to the current file. */
+	view->list_pos = pos;
+	curr_stats.preview_hint = parea;
+
+	MacroFlags flags = MF_NONE;
+	char *expanded = qv_expand_viewer(view, viewer, &flags);
+	if(expanded != NULL)
+	{
+		(void)vcache_prefetch(path, expanded, flags, MAX_PREVIEW_LINES);
+		free(expanded);
+	}
+
+	curr_stats.preview_hint = NULL;
+}
+
 const char *
 qv_draw_on(const dir_entry_t *entry, const preview_area_t *parea)
 {
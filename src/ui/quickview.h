@@ -55,6 +55,11 @@ int qv_can_show(void);
  * doesn't make sense (e.g. only one pane is visible). */
 void qv_draw(struct view_t *view);
 
+/* Speculatively previews files that follow current one in the direction of
+ * the last cursor movement.  Does nothing unless prefetching is enabled and
+ * quick view is shown. */
+void qv_prefetch(struct view_t *view);
+
 /* Draws file entry on an area.  Returns preview clear command or NULL. */
 const char * qv_draw_on(const struct dir_entry_t *entry,
 		const preview_area_t *parea);
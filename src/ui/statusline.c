@@ -185,6 +185,7 @@ update_stat_window_old(view_t *view, int lazy_redraw)
 	friendly_size_notation(fentry_get_size(view, curr), sizeof(size_buf),
 			size_buf);
 
+	fentry_load_stats(curr);
 	get_uid_string(curr, 0, sizeof(id_buf), id_buf);
 	if(id_buf[0] != '\0')
 		strcat(id_buf, ":");
@@ -393,9 +394,11 @@ parse_view_macros(view_t *view, const char **format, const char macros[],
 #endif
 				break;
 			case 'u':
+				fentry_load_stats(curr);
 				get_uid_string(curr, 0, sizeof(buf), buf);
 				break;
 			case 'g':
+				fentry_load_stats(curr);
 				get_gid_string(curr, 0, sizeof(buf), buf);
 				break;
 			case 's':
@@ -216,10 +216,12 @@ typedef struct dir_entry_t dir_entry_t;
 /* Description of a single directory entry. */
 struct dir_entry_t
 {
-	char *name;       /* File name. */
+	char *name;       /* File name.  Allocated on a heap or in an arena depending
+	                     on arena_name field. */
 	char *origin;     /* Location where this file comes from.  Either points to
 	                     view_t::curr_dir for non-cv views or is allocated on
-	                     a heap depending on owns_origin field. */
+	                     a heap depending on owns_origin field (arena_origin
+	                     field tells which kind of allocation was used). */
 	uint64_t size;    /* File size in bytes. */
 #ifndef _WIN32
 	uid_t uid;        /* Owning user id. */
@@ -261,7 +263,11 @@ struct dir_entry_t
 	unsigned int temporary : 1;    /* Whether this is temporary node. */
 	unsigned int dir_link : 1;     /* Whether this is symlink to a directory. */
 	unsigned int owns_origin : 1;  /* Whether this entry is custom one. */
+	unsigned int arena_name : 1;   /* Whether name is from str_arena_t. */
+	unsigned int arena_origin : 1; /* Whether owned origin is from str_arena_t. */
 	unsigned int folded : 1;       /* Whether this entry is folded. */
+	unsigned int partial_stats : 1; /* Whether owner and access/change times
+	                                   weren't loaded yet. */
 };
 
 /* List of entries bundled with its size. */
@@ -349,14 +355,25 @@ struct local_filter_t
 	int *poshist;
 	/* Number of elements in the poshist field. */
 	size_t poshist_len;
+
+	/* Results of the last matching of the unfiltered array against the filter.
+	 * Zero element means that corresponding entry didn't match. */
+	char *matched;
+	/* Number of elements in the matched field. */
+	size_t matched_len;
+	/* Value of the filter that produced the matched array or NULL. */
+	char *matched_filter;
+	/* Compilation flags of the filter that produced the matched array. */
+	int matched_cflags;
 };
 
-/* Cached file list coupled with a watcher. */
+/* Cached file list coupled with a listing of a directory it was made from.
+ * Listings are shared among caches and are updated on changes. */
 typedef struct
 {
-	fswatch_t *watch;  /* Watcher for the path. */
-	char *dir;         /* Path to watched directory. */
-	entries_t entries; /* Cached list of entries. */
+	struct flist_listing_t *listing; /* Listing which is in use. */
+	char *dir;                       /* Path to listed directory. */
+	entries_t entries;               /* Cached list of entries. */
 }
 cached_entries_t;
 
@@ -393,6 +410,11 @@ struct view_t
 
 	fswatch_t *watch;  /* Monitor that checks for directory changes. */
 	char *watched_dir; /* Path for which the monitor was created. */
+	/* Monitor of directories of a tree view or NULL if it wasn't set up yet. */
+	fswatch_t *tree_watch;
+	/* Whether setting up tree_watch has failed, in which case directories of
+	 * the tree are polled until it's reloaded. */
+	int tree_watch_failed;
 
 	char *last_dir; /* Location visited by the view before the current one. */
 
@@ -413,6 +435,9 @@ struct view_t
 	int filtered;  /* number of files filtered out and not shown in list */
 	int selected_files; /* Number of currently selected files. */
 	dir_entry_t *dir_entry; /* Must be handled via dynarray unit. */
+	/* Arena for strings of entries which are loaded in bulk.  Replaced on every
+	 * full load to let chunks of previous lists go away with them. */
+	struct str_arena_t *names_arena;
 
 	/* Last position that was displayed on the screen. */
 	char *last_curr_file; /* To account for file replacement. */
@@ -0,0 +1,868 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "findex.h"
+
+#include <dirent.h> /* DIR dirent */
+#include <regex.h> /* regex_t regexec() regfree() */
+#include <unistd.h> /* getpid() unlink() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* int64_t uint32_t */
+#include <stdio.h> /* EOF FILE fclose() feof() ferror() fputc() fread() fwrite()
+                      snprintf() */
+#include <stdlib.h> /* bsearch() calloc() free() malloc() qsort() realloc() */
+#include <string.h> /* memchr() memcmp() memcpy() memmove() strcmp() strcspn()
+                       strdup() strlen() strpbrk() strstr() */
+#include <time.h> /* time_t time() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "dynarray.h"
+#include "fs.h"
+#include "fswalk.h"
+#include "globs.h"
+#include "macros.h"
+#include "path.h"
+#include "regexp.h"
+#include "str.h"
+#include "string_array.h"
+#include "utils.h"
+
+/* Identifier of the file format. */
+#define MAGIC "VIFMIDX"
+
+/* Version of the file format.  Increment on changing layout of the file. */
+#define FORMAT_VERSION 2
+
+/* Header of the file. */
+typedef struct
+{
+	char magic[8];     /* MAGIC. */
+	uint32_t version;  /* FORMAT_VERSION. */
+	uint32_t nroots;   /* Number of roots. */
+	uint32_t npaths;   /* Number of paths. */
+	uint32_t unused;   /* Padding for alignment of the next field, zero. */
+	int64_t scan_time; /* Time of the full scan that built the index. */
+}
+header_t;
+
+struct findex_t
+{
+	strlist_t roots;  /* Roots of the index. */
+	char **paths;     /* Sorted full paths of files. */
+	int npaths;       /* Number of elements in the paths array. */
+	time_t scan_time; /* Time of the full scan that built the index. */
+};
+
+/* Paths found by a single thread. */
+typedef struct
+{
+	char **items; /* Paths (dynarray). */
+	int count;    /* Number of elements in the items array. */
+}
+found_t;
+
+/* Direct child of a directory that is being updated. */
+typedef struct
+{
+	char *name; /* Name of the file. */
+	int is_dir; /* Whether it's a directory. */
+	int seen;   /* Whether it's already in the index. */
+}
+child_t;
+
+static findex_t * alloc_index(char *roots[], int nroots);
+static int collect_tree(const char root[], int nworkers,
+		const cancellation_t *cancellation, strlist_t *paths);
+static int collect_file(const char path[], const char name[], int is_dir,
+		int worker, void *arg);
+static void sort_paths(strlist_t *paths);
+static int path_cmp(const void *a, const void *b);
+static int is_indexed_dir(const findex_t *index, const char path[]);
+static child_t * list_children(const char dir[], int *count);
+static int child_cmp(const void *a, const void *b);
+static void free_children(child_t *children, int count);
+static int lower_bound(const findex_t *index, const char path[]);
+static int write_index(FILE *fp, const findex_t *index);
+static int write_varint(FILE *fp, size_t value);
+static char * read_whole_file(const char path[], size_t *size);
+static findex_t * parse_index(const char data[], size_t size);
+static const char * read_varint(const char data[], const char *end,
+		size_t *value);
+
+findex_t *
+findex_build(char *roots[], int nroots, int nworkers,
+		const cancellation_t *cancellation)
+{
+	findex_t *const index = alloc_index(roots, nroots);
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	strlist_t paths = {};
+
+	int i;
+	for(i = 0; i < nroots; ++i)
+	{
+		if(collect_tree(roots[i], nworkers, cancellation, &paths) != 0)
+		{
+			break;
+		}
+	}
+
+	if(i != nroots || cancellation_requested(cancellation))
+	{
+		free_string_array(paths.items, paths.nitems);
+		findex_free(index);
+		return NULL;
+	}
+
+	/* Roots can overlap, which is handled by dropping duplicates. */
+	sort_paths(&paths);
+
+	index->paths = paths.items;
+	index->npaths = paths.nitems;
+	index->scan_time = time(NULL);
+	return index;
+}
+
+/* Allocates an empty index for the roots.  Returns the index or NULL on
+ * error. */
+static findex_t *
+alloc_index(char *roots[], int nroots)
+{
+	findex_t *const index = calloc(1, sizeof(*index));
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	index->roots.items = copy_string_array(roots, nroots);
+	index->roots.nitems = nroots;
+	if(index->roots.items == NULL && nroots != 0)
+	{
+		free(index);
+		return NULL;
+	}
+
+	return index;
+}
+
+/* Appends paths of all files under the root to the list.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+collect_tree(const char root[], int nworkers,
+		const cancellation_t *cancellation, strlist_t *paths)
+{
+	found_t *const found = calloc(nworkers, sizeof(*found));
+	if(found == NULL)
+	{
+		return 1;
+	}
+
+	fswalk(root, nworkers, &collect_file, found, cancellation);
+
+	int failed = 0;
+	int i;
+	for(i = 0; i < nworkers; ++i)
+	{
+		char **const items = (failed || found[i].count == 0)
+		                   ? NULL
+		                   : reallocarray(paths->items,
+		                                  paths->nitems + found[i].count,
+		                                  sizeof(*items));
+		if(items == NULL)
+		{
+			failed |= (found[i].count != 0);
+			free_string_array(found[i].items, found[i].count);
+			continue;
+		}
+
+		memcpy(items + paths->nitems, found[i].items,
+				sizeof(*items)*found[i].count);
+		paths->items = items;
+		paths->nitems += found[i].count;
+		dynarray_free(found[i].items);
+	}
+
+	free(found);
+	return failed;
+}
+
+/* Records path of a file.  Implements fswalk_func. */
+static int
+collect_file(const char path[], const char name[], int is_dir, int worker,
+		void *arg)
+{
+	found_t *const found = (found_t *)arg + worker;
+
+	char *const copy = strdup(path);
+	char **const items = (copy == NULL)
+	                   ? NULL
+	                   : dynarray_extend(found->items, sizeof(*items));
+	if(items == NULL)
+	{
+		free(copy);
+		return 1;
+	}
+
+	found->items = items;
+	found->items[found->count++] = copy;
+	return 1;
+}
+
+/* Sorts the paths and removes duplicates. */
+static void
+sort_paths(strlist_t *paths)
+{
+	safe_qsort(paths->items, paths->nitems, sizeof(*paths->items), &path_cmp);
+
+	int i, j = 0;
+	for(i = 0; i < paths->nitems; ++i)
+	{
+		if(j != 0 && strcmp(paths->items[j - 1], paths->items[i]) == 0)
+		{
+			free(paths->items[i]);
+			continue;
+		}
+		paths->items[j++] = paths->items[i];
+	}
+	paths->nitems = j;
+}
+
+/* Compares two paths byte by byte for sorting. */
+static int
+path_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+findex_t *
+findex_load(const char path[])
+{
+	size_t size;
+	char *const data = read_whole_file(path, &size);
+	if(data == NULL)
+	{
+		return NULL;
+	}
+
+	findex_t *const index = parse_index(data, size);
+	free(data);
+	return index;
+}
+
+int
+findex_save(const findex_t *index, const char path[])
+{
+	/* Write to a temporary file and rename it to not expose partially written
+	 * index to other instances. */
+	char tmp_path[PATH_MAX + 32];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+
+	FILE *const fp = os_fopen(tmp_path, "wb");
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	const int failed = write_index(fp, index);
+	if(fclose(fp) != 0 || failed)
+	{
+		(void)unlink(tmp_path);
+		return 1;
+	}
+
+#ifdef _WIN32
+	/* Renaming doesn't replace existing files on Windows. */
+	(void)unlink(path);
+#endif
+
+	if(os_rename(tmp_path, path) != 0)
+	{
+		(void)unlink(tmp_path);
+		return 1;
+	}
+
+	return 0;
+}
+
+void
+findex_free(findex_t *index)
+{
+	if(index == NULL)
+	{
+		return;
+	}
+
+	free_string_array(index->roots.items, index->roots.nitems);
+	free_string_array(index->paths, index->npaths);
+	free(index);
+}
+
+int
+findex_has_roots(const findex_t *index, char *roots[], int nroots)
+{
+	return string_array_equal(index->roots.items, index->roots.nitems, roots,
+			nroots);
+}
+
+int
+findex_size(const findex_t *index)
+{
+	return index->npaths;
+}
+
+time_t
+findex_scan_time(const findex_t *index)
+{
+	return index->scan_time;
+}
+
+int
+findex_update_dir(findex_t *index, const char dir[])
+{
+	/* Symbolic links aren't followed on building the index, so only real paths
+	 * can be found in it. */
+	char real[PATH_MAX + 1];
+	if(os_realpath(dir, real) != real || !is_indexed_dir(index, real))
+	{
+		return 0;
+	}
+
+	/* Paths of all files under the directory start with the prefix and are less
+	 * than the upper bound, which ends with a character following the slash. */
+	char prefix[PATH_MAX + 2];
+	snprintf(prefix, sizeof(prefix), "%s%s", real,
+			ends_with_slash(real) ? "" : "/");
+	const size_t prefix_len = strlen(prefix);
+	char upper[PATH_MAX + 2];
+	copy_str(upper, sizeof(upper), prefix);
+	upper[prefix_len - 1] = '/' + 1;
+
+	const int lo = lower_bound(index, prefix);
+	const int hi = lower_bound(index, upper);
+
+	int nchildren;
+	child_t *const children = list_children(real, &nchildren);
+	if(nchildren < 0)
+	{
+		return 0;
+	}
+
+	/* First decide what to do without changing the index, so that it stays
+	 * intact on running out of memory. */
+	char *const keep = calloc(hi - lo + 1, 1);
+	if(keep == NULL)
+	{
+		free_children(children, nchildren);
+		return 0;
+	}
+
+	int nkept = 0;
+	int i;
+	for(i = lo; i < hi; ++i)
+	{
+		const char *const rest = index->paths[i] + prefix_len;
+		const size_t len = strcspn(rest, "/");
+
+		char name[NAME_MAX + 1];
+		copy_str(name, MIN(sizeof(name), len + 1U), rest);
+
+		const child_t key = { .name = name };
+		child_t *const child = (nchildren == 0)
+		                     ? NULL
+		                     : bsearch(&key, children, nchildren, sizeof(*children),
+		                               &child_cmp);
+		if(child == NULL || (rest[len] != '\0' && !child->is_dir))
+		{
+			continue;
+		}
+
+		child->seen |= (rest[len] == '\0');
+		keep[i - lo] = 1;
+		++nkept;
+	}
+
+	strlist_t added = {};
+	for(i = 0; i < nchildren; ++i)
+	{
+		if(children[i].seen)
+		{
+			continue;
+		}
+
+		char *const path = format_str("%s%s", prefix, children[i].name);
+		if(path == NULL)
+		{
+			continue;
+		}
+
+		const int nadded = added.nitems;
+		added.nitems = put_into_string_array(&added.items, added.nitems, path);
+		if(added.nitems == nadded)
+		{
+			free(path);
+		}
+	}
+	free_children(children, nchildren);
+
+	if(nkept == hi - lo && added.nitems == 0)
+	{
+		free(keep);
+		return 0;
+	}
+
+	sort_paths(&added);
+
+	const int nmerged = nkept + added.nitems;
+	const int new_count = index->npaths - (hi - lo) + nmerged;
+	char **const merged = reallocarray(NULL, nmerged + 1, sizeof(*merged));
+	char **const paths = (merged == NULL || new_count <= index->npaths)
+	                   ? index->paths
+	                   : reallocarray(index->paths, new_count, sizeof(*paths));
+	if(merged == NULL || paths == NULL)
+	{
+		free(merged);
+		free(keep);
+		free_string_array(added.items, added.nitems);
+		return 0;
+	}
+	index->paths = paths;
+
+	/* Merge kept paths with the new ones, both lists are sorted. */
+	int a = 0, m = 0;
+	for(i = lo; i < hi; ++i)
+	{
+		if(!keep[i - lo])
+		{
+			free(index->paths[i]);
+			continue;
+		}
+
+		while(a < added.nitems && strcmp(added.items[a], index->paths[i]) < 0)
+		{
+			merged[m++] = added.items[a++];
+		}
+		merged[m++] = index->paths[i];
+	}
+	while(a < added.nitems)
+	{
+		merged[m++] = added.items[a++];
+	}
+
+	memmove(index->paths + lo + nmerged, index->paths + hi,
+			sizeof(*index->paths)*(index->npaths - hi));
+	memcpy(index->paths + lo, merged, sizeof(*merged)*nmerged);
+	index->npaths = new_count;
+
+	free(added.items);
+	free(merged);
+	free(keep);
+	return 1;
+}
+
+/* Checks whether the path is one of the roots or is already in the index.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_indexed_dir(const findex_t *index, const char path[])
+{
+	if(is_in_string_array(index->roots.items, index->roots.nitems, path))
+	{
+		return 1;
+	}
+
+	const int pos = lower_bound(index, path);
+	return (pos < index->npaths && strcmp(index->paths[pos], path) == 0);
+}
+
+/* Lists files of a directory sorted by name.  Unreadable directory is
+ * considered empty.  Returns the list, *count is set to its size or to -1 on
+ * error. */
+static child_t *
+list_children(const char dir[], int *count)
+{
+	*count = 0;
+
+	DIR *const d = os_opendir(dir);
+	if(d == NULL)
+	{
+		return NULL;
+	}
+
+	child_t *children = NULL;
+
+	struct dirent *entry;
+	while((entry = os_readdir(d)) != NULL)
+	{
+		if(is_builtin_dir(entry->d_name))
+		{
+			continue;
+		}
+
+		child_t *const new_children = reallocarray(children, *count + 1,
+				sizeof(*children));
+		char *const path = join_paths(dir, entry->d_name);
+		char *const name = strdup(entry->d_name);
+		if(new_children == NULL || path == NULL || name == NULL)
+		{
+			children = (new_children == NULL ? children : new_children);
+			free(path);
+			free(name);
+			free_children(children, *count);
+			os_closedir(d);
+			*count = -1;
+			return NULL;
+		}
+
+		children = new_children;
+		children[*count].name = name;
+		children[*count].is_dir = entry_is_dir(path, entry);
+		children[*count].seen = 0;
+		++*count;
+
+		free(path);
+	}
+
+	os_closedir(d);
+
+	safe_qsort(children, *count, sizeof(*children), &child_cmp);
+	return children;
+}
+
+/* Compares two children by their names. */
+static int
+child_cmp(const void *a, const void *b)
+{
+	const child_t *const x = a;
+	const child_t *const y = b;
+	return strcmp(x->name, y->name);
+}
+
+/* Frees list of children. */
+static void
+free_children(child_t *children, int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(children[i].name);
+	}
+	free(children);
+}
+
+/* Finds position of the first path which is not less than the given one.
+ * Returns the position. */
+static int
+lower_bound(const findex_t *index, const char path[])
+{
+	int l = 0, u = index->npaths;
+	while(l < u)
+	{
+		const int m = l + (u - l)/2;
+		if(strcmp(index->paths[m], path) < 0)
+		{
+			l = m + 1;
+		}
+		else
+		{
+			u = m;
+		}
+	}
+	return l;
+}
+
+int
+findex_query(const findex_t *index, const char pattern[], strlist_t *results)
+{
+	int i;
+
+	if(strpbrk(pattern, "*?[") == NULL)
+	{
+		for(i = 0; i < index->npaths; ++i)
+		{
+			if(strstr(index->paths[i], pattern) != NULL)
+			{
+				results->nitems = add_to_string_array(&results->items, results->nitems,
+						index->paths[i]);
+			}
+		}
+		return 0;
+	}
+
+	char *const re = glob_to_regex(pattern, 0);
+	if(re == NULL)
+	{
+		return 1;
+	}
+
+	regex_t regex;
+	const int err = regexp_compile(&regex, re, REG_EXTENDED | REG_NOSUB);
+	free(re);
+	if(err != 0)
+	{
+		regfree(&regex);
+		return 1;
+	}
+
+	for(i = 0; i < index->npaths; ++i)
+	{
+		if(regexec(&regex, index->paths[i], 0, NULL, 0) == 0)
+		{
+			results->nitems = add_to_string_array(&results->items, results->nitems,
+					index->paths[i]);
+		}
+	}
+
+	regfree(&regex);
+	return 0;
+}
+
+/* Writes front-coded index into the file.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+write_index(FILE *fp, const findex_t *index)
+{
+	header_t header = {
+		.magic = MAGIC,
+		.version = FORMAT_VERSION,
+		.nroots = index->roots.nitems,
+		.npaths = index->npaths,
+		.scan_time = index->scan_time,
+	};
+	if(fwrite(&header, sizeof(header), 1, fp) != 1)
+	{
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < index->roots.nitems; ++i)
+	{
+		const char *const root = index->roots.items[i];
+		if(fwrite(root, strlen(root) + 1U, 1, fp) != 1)
+		{
+			return 1;
+		}
+	}
+
+	const char *prev = "";
+	for(i = 0; i < index->npaths; ++i)
+	{
+		const char *const path = index->paths[i];
+
+		size_t common = 0U;
+		while(prev[common] != '\0' && prev[common] == path[common])
+		{
+			++common;
+		}
+
+		const size_t rest_len = strlen(path + common) + 1U;
+		if(write_varint(fp, common) != 0 ||
+				fwrite(path + common, rest_len, 1, fp) != 1)
+		{
+			return 1;
+		}
+
+		prev = path;
+	}
+
+	return ferror(fp);
+}
+
+/* Writes a number using 7 bits per byte with the highest bit indicating that
+ * more bytes follow.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+write_varint(FILE *fp, size_t value)
+{
+	while(value >= 0x80U)
+	{
+		if(fputc((int)(value & 0x7fU) | 0x80, fp) == EOF)
+		{
+			return 1;
+		}
+		value >>= 7;
+	}
+	return (fputc((int)value, fp) == EOF);
+}
+
+/* Reads contents of a file into memory.  Returns newly allocated buffer or
+ * NULL on error. */
+static char *
+read_whole_file(const char path[], size_t *size)
+{
+	FILE *const fp = os_fopen(path, "rb");
+	if(fp == NULL)
+	{
+		return NULL;
+	}
+
+	char *data = NULL;
+	size_t capacity = 0U;
+	*size = 0U;
+	while(!feof(fp) && !ferror(fp))
+	{
+		if(*size == capacity)
+		{
+			const size_t new_capacity = (capacity == 0U ? 64U*1024U : capacity*2U);
+			char *const new_data = realloc(data, new_capacity);
+			if(new_data == NULL)
+			{
+				break;
+			}
+			data = new_data;
+			capacity = new_capacity;
+		}
+
+		*size += fread(data + *size, 1, capacity - *size, fp);
+	}
+
+	const int failed = ferror(fp) || !feof(fp);
+	fclose(fp);
+
+	if(failed)
+	{
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+/* Decodes contents of the index file.  Returns the index or NULL on error. */
+static findex_t *
+parse_index(const char data[], size_t size)
+{
+	header_t header;
+	if(size < sizeof(header))
+	{
+		return NULL;
+	}
+
+	memcpy(&header, data, sizeof(header));
+	if(memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != FORMAT_VERSION)
+	{
+		return NULL;
+	}
+
+	const char *p = data + sizeof(header);
+	const char *const end = data + size;
+
+	findex_t *const index = alloc_index(NULL, 0);
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	index->scan_time = header.scan_time;
+
+	uint32_t i;
+	for(i = 0U; i < header.nroots; ++i)
+	{
+		const char *const nul = memchr(p, '\0', end - p);
+		if(nul == NULL)
+		{
+			findex_free(index);
+			return NULL;
+		}
+
+		const int nroots = index->roots.nitems;
+		index->roots.nitems = add_to_string_array(&index->roots.items, nroots, p);
+		if(index->roots.nitems == nroots)
+		{
+			findex_free(index);
+			return NULL;
+		}
+
+		p = nul + 1;
+	}
+
+	/* Each path takes at least two bytes, which protects against allocating
+	 * huge array for a corrupted header. */
+	if(header.npaths > (size_t)(end - p)/2U)
+	{
+		findex_free(index);
+		return NULL;
+	}
+
+	index->paths = reallocarray(NULL, header.npaths + 1U, sizeof(*index->paths));
+	if(index->paths == NULL)
+	{
+		findex_free(index);
+		return NULL;
+	}
+
+	const char *prev = "";
+	size_t prev_len = 0U;
+	for(i = 0U; i < header.npaths; ++i)
+	{
+		size_t common;
+		p = read_varint(p, end, &common);
+		const char *const nul = (p == NULL ? NULL : memchr(p, '\0', end - p));
+		if(nul == NULL || common > prev_len)
+		{
+			findex_free(index);
+			return NULL;
+		}
+
+		const size_t rest_len = nul - p;
+		char *const path = malloc(common + rest_len + 1U);
+		if(path == NULL)
+		{
+			findex_free(index);
+			return NULL;
+		}
+
+		memcpy(path, prev, common);
+		memcpy(path + common, p, rest_len + 1U);
+		index->paths[index->npaths++] = path;
+
+		prev = path;
+		prev_len = common + rest_len;
+		p = nul + 1;
+	}
+
+	return index;
+}
+
+/* Reads a number written by write_varint().  Returns pointer past the number
+ * or NULL on error. */
+static const char *
+read_varint(const char data[], const char *end, size_t *value)
+{
+	*value = 0U;
+
+	int shift;
+	for(shift = 0; data < end && shift < 32; shift += 7)
+	{
+		const unsigned char byte = *data++;
+		*value |= (size_t)(byte & 0x7fU) << shift;
+		if((byte & 0x80U) == 0U)
+		{
+			return data;
+		}
+	}
+
+	return NULL;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
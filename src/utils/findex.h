@@ -0,0 +1,84 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FINDEX_H__
+#define VIFM__UTILS__FINDEX_H__
+
+#include <time.h> /* time_t */
+
+#include "cancellation.h"
+
+/* Index of paths of all files under a set of root directories.  Paths are kept
+ * sorted, which allows updating files of a single directory without walking
+ * the whole index.  On disk paths are front-coded: each one is stored as
+ * length of prefix it shares with the previous path followed by the rest of
+ * it, which makes the file compact and quick to load.
+ *
+ * The index isn't thread-safe, its users need to serialize access to it. */
+
+/* Opaque index type. */
+typedef struct findex_t findex_t;
+
+struct strlist_t;
+
+/* Lists all files under the roots (absolute paths without trailing slashes)
+ * using at most nworkers threads.  Symbolic links aren't followed.  Returns the
+ * index or NULL on error or cancellation. */
+findex_t * findex_build(char *roots[], int nroots, int nworkers,
+		const cancellation_t *cancellation);
+
+/* Reads index from a file.  Returns the index or NULL on error or if the file
+ * is of unknown format. */
+findex_t * findex_load(const char path[]);
+
+/* Writes index to a file replacing it at once.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int findex_save(const findex_t *index, const char path[]);
+
+/* Frees the index.  index can be NULL. */
+void findex_free(findex_t *index);
+
+/* Checks whether the index was built for the roots.  Returns non-zero if so,
+ * otherwise zero is returned. */
+int findex_has_roots(const findex_t *index, char *roots[], int nroots);
+
+/* Retrieves number of paths in the index.  Returns the number. */
+int findex_size(const findex_t *index);
+
+/* Retrieves time of the full scan that built the index, which is preserved
+ * by saving and loading it.  Returns the time. */
+time_t findex_scan_time(const findex_t *index);
+
+/* Brings direct children of the directory up to date with the file system.
+ * Contents of new subdirectories aren't listed, removed ones are dropped along
+ * with their contents.  Only roots and directories that are already in the
+ * index (judging by their real paths) are updated.  Returns non-zero if the
+ * index was changed, otherwise zero is returned. */
+int findex_update_dir(findex_t *index, const char dir[]);
+
+/* Appends paths that match the pattern to the list.  Pattern that contains
+ * "*", "?" or "[" is a glob matched against whole path, otherwise it's a
+ * substring of a path.  Returns zero on success and non-zero on invalid
+ * pattern. */
+int findex_query(const findex_t *index, const char pattern[],
+		struct strlist_t *results);
+
+#endif /* VIFM__UTILS__FINDEX_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
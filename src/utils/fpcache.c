@@ -0,0 +1,540 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "fpcache.h"
+
+#ifndef _WIN32
+#include <sys/mman.h> /* MAP_* PROT_* mmap() munmap() */
+#endif
+#include <sys/stat.h> /* stat */
+#include <fcntl.h> /* O_* open() */
+#include <unistd.h> /* close() ftruncate() getpid() unlink() */
+
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcmp() memcpy() memset() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+
+#define XXH_PRIVATE_API
+#include "xxhash.h"
+
+/* Identifier of the file format. */
+#define MAGIC "VIFMFPC"
+
+/* Version of the file format.  Increment on changing layout of records. */
+#define FORMAT_VERSION 1
+
+/* Number of records a key can be mapped to.  When all of them are occupied,
+ * the least recently used one gets overwritten. */
+#define WAYS 8
+
+/* Flags of a record. */
+enum
+{
+	RF_PREFIX = 1 << 0, /* Digest of prefix is set. */
+	RF_FULL   = 1 << 1, /* Digest of full contents is set. */
+};
+
+/* Header of the file. */
+typedef struct
+{
+	char magic[8];      /* MAGIC. */
+	uint32_t version;   /* FORMAT_VERSION. */
+	uint32_t capacity;  /* Number of records. */
+	uint32_t rec_size;  /* Size of a record. */
+	uint32_t clock;     /* Source of time stamps for records. */
+}
+header_t;
+
+/* Single record of the cache.  The structure has no padding. */
+typedef struct
+{
+	uint64_t dev;        /* Device. */
+	uint64_t inode;      /* Inode number. */
+	uint64_t size;       /* Size in bytes. */
+	int64_t mtime_sec;   /* Modification time (seconds). */
+	uint32_t mtime_nsec; /* Modification time (nanoseconds). */
+	uint32_t flags;      /* Set of RF_* flags, zero for an unused record. */
+	uint32_t stamp;      /* Time of last use. */
+	uint32_t check;      /* Checksum of the record to detect torn writes. */
+	uint64_t prefix;     /* Digest of prefix. */
+	uint64_t full_low;   /* Lower half of digest of full contents. */
+	uint64_t full_high;  /* Upper half of digest of full contents. */
+}
+record_t;
+
+struct fpcache_t
+{
+	pthread_mutex_t lock; /* Serializes access within this process. */
+	void *ptr;            /* Mapped contents of the file. */
+	size_t size;          /* Size of the mapping. */
+	header_t *header;     /* Header of the file. */
+	record_t *records;    /* Array of records. */
+	int nbuckets;         /* Number of groups of WAYS records. */
+};
+
+#ifndef _WIN32
+static int get_file_capacity(int fd);
+static int create_file(const char path[], int capacity, int old_fd,
+		int old_capacity);
+static int init_file(int fd, int capacity);
+static void copy_records(int from_fd, int from_capacity, int to_fd,
+		int to_capacity);
+static fpcache_t * map_file(int fd, int capacity);
+static size_t get_file_size(int capacity);
+#endif
+static record_t * find_record(fpcache_t *cache, const fpcache_key_t *key,
+		int flag);
+static record_t * pick_record(fpcache_t *cache, const fpcache_key_t *key);
+static record_t * get_bucket(fpcache_t *cache, const fpcache_key_t *key);
+static int record_matches(const record_t *record, const fpcache_key_t *key);
+static void touch_record(fpcache_t *cache, record_t *record);
+static uint32_t record_checksum(const record_t *record);
+
+fpcache_t *
+fpcache_open(const char path[], int capacity)
+{
+#ifndef _WIN32
+	if(capacity < WAYS)
+	{
+		return NULL;
+	}
+	capacity -= capacity%WAYS;
+
+	int fd = open(path, O_RDWR);
+	const int old_capacity = (fd == -1 ? 0 : get_file_capacity(fd));
+	if(old_capacity >= capacity)
+	{
+		capacity = old_capacity;
+	}
+	else
+	{
+		const int new_fd = create_file(path, capacity, fd, old_capacity);
+		if(fd != -1)
+		{
+			close(fd);
+		}
+
+		fd = new_fd;
+		if(fd == -1)
+		{
+			return NULL;
+		}
+	}
+
+	fpcache_t *const cache = map_file(fd, capacity);
+	close(fd);
+	return cache;
+#else
+	return NULL;
+#endif
+}
+
+#ifndef _WIN32
+
+/* Checks whether opened file is a valid cache.  Returns its capacity or zero
+ * if the file is of unknown format. */
+static int
+get_file_capacity(int fd)
+{
+	struct stat st;
+	header_t header;
+	if(fstat(fd, &st) != 0 ||
+			read(fd, &header, sizeof(header)) != sizeof(header) ||
+			memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != FORMAT_VERSION ||
+			header.rec_size != sizeof(record_t) ||
+			header.capacity < WAYS || header.capacity%WAYS != 0 ||
+			header.capacity > INT_MAX/sizeof(record_t))
+	{
+		return 0;
+	}
+
+	const int capacity = header.capacity;
+	return ((size_t)st.st_size == get_file_size(capacity) ? capacity : 0);
+}
+
+/* Creates a cache of specified capacity in place of the file at the path.  The
+ * file is prepared under a temporary name and then renamed, so that other
+ * instances which have the old file mapped keep using it undisturbed.  Records
+ * of the old file are moved to the new one if old_capacity isn't zero.
+ * Returns file descriptor of the new file or -1 on error. */
+static int
+create_file(const char path[], int capacity, int old_fd, int old_capacity)
+{
+	char tmp_path[PATH_MAX + 32];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+
+	const int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if(fd == -1)
+	{
+		return -1;
+	}
+
+	if(init_file(fd, capacity) != 0)
+	{
+		close(fd);
+		(void)unlink(tmp_path);
+		return -1;
+	}
+
+	if(old_capacity != 0)
+	{
+		copy_records(old_fd, old_capacity, fd, capacity);
+	}
+
+	if(os_rename(tmp_path, path) != 0)
+	{
+		close(fd);
+		(void)unlink(tmp_path);
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Resets the file to an empty cache of specified capacity.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+init_file(int fd, int capacity)
+{
+	const header_t header = {
+		.magic = MAGIC,
+		.version = FORMAT_VERSION,
+		.capacity = capacity,
+		.rec_size = sizeof(record_t),
+	};
+
+	if(ftruncate(fd, get_file_size(capacity)) != 0)
+	{
+		return 1;
+	}
+
+	return (lseek(fd, 0, SEEK_SET) != 0 ||
+	        write(fd, &header, sizeof(header)) != sizeof(header));
+}
+
+/* Puts valid records of one cache file into another one.  Records that don't
+ * fit are dropped. */
+static void
+copy_records(int from_fd, int from_capacity, int to_fd, int to_capacity)
+{
+	fpcache_t *const from = map_file(from_fd, from_capacity);
+	fpcache_t *const to = map_file(to_fd, to_capacity);
+
+	if(from != NULL && to != NULL)
+	{
+		/* Time stamps are preserved, so keep the clock too. */
+		to->header->clock = from->header->clock;
+
+		int i;
+		for(i = 0; i < from_capacity; ++i)
+		{
+			const record_t record = from->records[i];
+			if(record.flags == 0 || record.check != record_checksum(&record))
+			{
+				continue;
+			}
+
+			const fpcache_key_t key = {
+				.dev = record.dev,
+				.inode = record.inode,
+				.size = record.size,
+				.mtime_sec = record.mtime_sec,
+				.mtime_nsec = record.mtime_nsec,
+			};
+			*pick_record(to, &key) = record;
+		}
+	}
+
+	fpcache_close(from);
+	fpcache_close(to);
+}
+
+/* Maps opened cache file of specified capacity into memory.  Returns the cache
+ * or NULL on error. */
+static fpcache_t *
+map_file(int fd, int capacity)
+{
+	const size_t size = get_file_size(capacity);
+	void *const ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+			0);
+	if(ptr == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	fpcache_t *const cache = malloc(sizeof(*cache));
+	if(cache == NULL || pthread_mutex_init(&cache->lock, NULL) != 0)
+	{
+		free(cache);
+		munmap(ptr, size);
+		return NULL;
+	}
+
+	cache->ptr = ptr;
+	cache->size = size;
+	cache->header = ptr;
+	cache->records = (record_t *)((char *)ptr + sizeof(header_t));
+	cache->nbuckets = capacity/WAYS;
+	return cache;
+}
+
+/* Computes size of cache file of specified capacity.  Returns the size. */
+static size_t
+get_file_size(int capacity)
+{
+	return sizeof(header_t) + sizeof(record_t)*capacity;
+}
+
+#endif
+
+void
+fpcache_close(fpcache_t *cache)
+{
+	if(cache == NULL)
+	{
+		return;
+	}
+
+#ifndef _WIN32
+	(void)munmap(cache->ptr, cache->size);
+#endif
+	(void)pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+int
+fpcache_capacity(const fpcache_t *cache)
+{
+	return (cache == NULL ? 0 : cache->nbuckets*WAYS);
+}
+
+int
+fpcache_key_of(const char path[], fpcache_key_t *key)
+{
+	struct stat st;
+	if(os_stat(path, &st) != 0)
+	{
+		return 1;
+	}
+
+	key->dev = st.st_dev;
+	key->inode = st.st_ino;
+	key->size = st.st_size;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	key->mtime_sec = st.st_mtim.tv_sec;
+	key->mtime_nsec = st.st_mtim.tv_nsec;
+#else
+	key->mtime_sec = st.st_mtime;
+	key->mtime_nsec = 0;
+#endif
+	return 0;
+}
+
+int
+fpcache_get_prefix(fpcache_t *cache, const fpcache_key_t *key,
+		uint64_t *digest)
+{
+	if(cache == NULL)
+	{
+		return 1;
+	}
+
+	(void)pthread_mutex_lock(&cache->lock);
+	record_t *const record = find_record(cache, key, RF_PREFIX);
+	if(record != NULL)
+	{
+		*digest = record->prefix;
+	}
+	(void)pthread_mutex_unlock(&cache->lock);
+
+	return (record == NULL);
+}
+
+void
+fpcache_set_prefix(fpcache_t *cache, const fpcache_key_t *key,
+		uint64_t digest)
+{
+	if(cache == NULL)
+	{
+		return;
+	}
+
+	(void)pthread_mutex_lock(&cache->lock);
+	record_t *const record = pick_record(cache, key);
+	record->prefix = digest;
+	record->flags |= RF_PREFIX;
+	touch_record(cache, record);
+	(void)pthread_mutex_unlock(&cache->lock);
+}
+
+int
+fpcache_get_full(fpcache_t *cache, const fpcache_key_t *key,
+		fpcache_digest_t *digest)
+{
+	if(cache == NULL)
+	{
+		return 1;
+	}
+
+	(void)pthread_mutex_lock(&cache->lock);
+	record_t *const record = find_record(cache, key, RF_FULL);
+	if(record != NULL)
+	{
+		digest->low = record->full_low;
+		digest->high = record->full_high;
+	}
+	(void)pthread_mutex_unlock(&cache->lock);
+
+	return (record == NULL);
+}
+
+void
+fpcache_set_full(fpcache_t *cache, const fpcache_key_t *key,
+		const fpcache_digest_t *digest)
+{
+	if(cache == NULL)
+	{
+		return;
+	}
+
+	(void)pthread_mutex_lock(&cache->lock);
+	record_t *const record = pick_record(cache, key);
+	record->full_low = digest->low;
+	record->full_high = digest->high;
+	record->flags |= RF_FULL;
+	touch_record(cache, record);
+	(void)pthread_mutex_unlock(&cache->lock);
+}
+
+/* Finds valid record for the key which has the specified flag set.  Marks it
+ * as used on success.  Returns the record or NULL. */
+static record_t *
+find_record(fpcache_t *cache, const fpcache_key_t *key, int flag)
+{
+	record_t *const bucket = get_bucket(cache, key);
+
+	int i;
+	for(i = 0; i < WAYS; ++i)
+	{
+		record_t *const record = &bucket[i];
+		if(record_matches(record, key) && (record->flags & flag))
+		{
+			touch_record(cache, record);
+			return record;
+		}
+	}
+	return NULL;
+}
+
+/* Finds record to store data for the key: either the one that already holds
+ * data for it, an unused one or the least recently used one.  Returns the
+ * record, which is reset for the key if it didn't correspond to it. */
+static record_t *
+pick_record(fpcache_t *cache, const fpcache_key_t *key)
+{
+	record_t *const bucket = get_bucket(cache, key);
+	record_t *unused = NULL;
+	record_t *oldest = NULL;
+
+	int i;
+	for(i = 0; i < WAYS; ++i)
+	{
+		record_t *const record = &bucket[i];
+		if(record_matches(record, key))
+		{
+			return record;
+		}
+
+		/* Corrupted records are as good as unused ones. */
+		if(record->flags == 0 || record->check != record_checksum(record))
+		{
+			if(unused == NULL)
+			{
+				unused = record;
+			}
+		}
+		/* Difference of stamps is signed to handle wrapping of the clock. */
+		else if(oldest == NULL || (int32_t)(record->stamp - oldest->stamp) < 0)
+		{
+			oldest = record;
+		}
+	}
+
+	record_t *const victim = (unused != NULL ? unused : oldest);
+	memset(victim, 0, sizeof(*victim));
+	victim->dev = key->dev;
+	victim->inode = key->inode;
+	victim->size = key->size;
+	victim->mtime_sec = key->mtime_sec;
+	victim->mtime_nsec = key->mtime_nsec;
+	return victim;
+}
+
+/* Retrieves the first of WAYS records among which the key can be stored.
+ * Returns pointer to the first record. */
+static record_t *
+get_bucket(fpcache_t *cache, const fpcache_key_t *key)
+{
+	const uint64_t fields[] = {
+		key->dev, key->inode, key->size, key->mtime_sec, key->mtime_nsec
+	};
+	const uint64_t hash = XXH3_64bits(fields, sizeof(fields));
+	return &cache->records[(hash%cache->nbuckets)*WAYS];
+}
+
+/* Checks whether the record is a valid record for the key.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+record_matches(const record_t *record, const fpcache_key_t *key)
+{
+	return record->flags != 0
+	    && record->dev == key->dev
+	    && record->inode == key->inode
+	    && record->size == key->size
+	    && record->mtime_sec == key->mtime_sec
+	    && record->mtime_nsec == key->mtime_nsec
+	    && record->check == record_checksum(record);
+}
+
+/* Marks record as the most recently used one and updates its checksum. */
+static void
+touch_record(fpcache_t *cache, record_t *record)
+{
+	record->stamp = ++cache->header->clock;
+	record->check = record_checksum(record);
+}
+
+/* Computes checksum of the record.  Returns the checksum. */
+static uint32_t
+record_checksum(const record_t *record)
+{
+	record_t copy = *record;
+	copy.check = 0;
+	copy.stamp = 0;
+	return (uint32_t)XXH3_64bits(&copy, sizeof(copy));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
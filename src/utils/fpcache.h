@@ -0,0 +1,93 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FPCACHE_H__
+#define VIFM__UTILS__FPCACHE_H__
+
+#include <stdint.h> /* int64_t uint32_t uint64_t */
+
+/* Persistent cache of fingerprints (digests) of contents of files.  Lives in a
+ * memory-mapped file, which can be shared by several processes.  Records are
+ * identified by device, inode, size and modification time of files, so
+ * changing a file automatically invalidates its record.  Number of records is
+ * limited, least recently used ones get replaced by new ones.
+ *
+ * All functions accept NULL cache, which behaves as an always empty one. */
+
+/* Opaque cache type. */
+typedef struct fpcache_t fpcache_t;
+
+/* Identification of a state of a file. */
+typedef struct
+{
+	uint64_t dev;        /* Device. */
+	uint64_t inode;      /* Inode number. */
+	uint64_t size;       /* Size in bytes. */
+	int64_t mtime_sec;   /* Modification time (seconds). */
+	uint32_t mtime_nsec; /* Modification time (nanoseconds if available). */
+}
+fpcache_key_t;
+
+/* 128-bit digest of whole contents of a file. */
+typedef struct
+{
+	uint64_t low;  /* Lower half of the digest. */
+	uint64_t high; /* Upper half of the digest. */
+}
+fpcache_digest_t;
+
+/* Opens (or creates) the cache backed by the specified file.  Capacity is the
+ * minimal number of records, existing file of bigger capacity is used as is,
+ * while smaller or invalid one is replaced by a new file that receives
+ * records of the old one.  Returns the cache or NULL on error or if the cache
+ * is not supported on this system. */
+fpcache_t * fpcache_open(const char path[], int capacity);
+
+/* Closes the cache.  cache can be NULL. */
+void fpcache_close(fpcache_t *cache);
+
+/* Retrieves maximum number of records in the cache.  Returns the number, which
+ * is zero for NULL cache. */
+int fpcache_capacity(const fpcache_t *cache);
+
+/* Fills key with information about the file.  Returns zero on success,
+ * otherwise non-zero is returned. */
+int fpcache_key_of(const char path[], fpcache_key_t *key);
+
+/* Retrieves digest of prefix of a file.  Returns zero if it's found,
+ * otherwise non-zero is returned. */
+int fpcache_get_prefix(fpcache_t *cache, const fpcache_key_t *key,
+		uint64_t *digest);
+
+/* Stores digest of prefix of a file. */
+void fpcache_set_prefix(fpcache_t *cache, const fpcache_key_t *key,
+		uint64_t digest);
+
+/* Retrieves digest of full contents of a file.  Returns zero if it's found,
+ * otherwise non-zero is returned. */
+int fpcache_get_full(fpcache_t *cache, const fpcache_key_t *key,
+		fpcache_digest_t *digest);
+
+/* Stores digest of full contents of a file. */
+void fpcache_set_full(fpcache_t *cache, const fpcache_key_t *key,
+		const fpcache_digest_t *digest);
+
+#endif /* VIFM__UTILS__FPCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
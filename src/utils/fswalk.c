@@ -0,0 +1,117 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "fswalk.h"
+
+#include <dirent.h> /* DIR dirent */
+
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() strlen() */
+
+#include "../compat/os.h"
+#include "cancellation.h"
+#include "fs.h"
+#include "parallel.h"
+#include "path.h"
+
+/* State of a walk shared by threads. */
+typedef struct
+{
+	fswalk_func func;                   /* Client's callback. */
+	void *arg;                          /* Client's data. */
+	const cancellation_t *cancellation; /* Cancellation state. */
+}
+walk_t;
+
+static void walk_dir(parallel_pool_t *pool, void *task, int worker, void *arg);
+static void drop_dir(void *task, void *arg);
+
+void
+fswalk(const char root[], int nworkers, fswalk_func func, void *arg,
+		const cancellation_t *cancellation)
+{
+	char *const path = strdup(root);
+	if(path == NULL)
+	{
+		return;
+	}
+
+	walk_t walk = { .func = func, .arg = arg, .cancellation = cancellation };
+	parallel_run(path, nworkers, &walk_dir, &drop_dir, &walk, cancellation);
+}
+
+/* Lists a single directory and queues walking of its subdirectories that the
+ * client wants to be entered.  Implements parallel_task_func. */
+static void
+walk_dir(parallel_pool_t *pool, void *task, int worker, void *arg)
+{
+	walk_t *const walk = arg;
+	char *const path = task;
+
+	DIR *const dir = os_opendir(path);
+	if(dir == NULL)
+	{
+		free(path);
+		return;
+	}
+
+	struct dirent *d;
+	while((d = os_readdir(dir)) != NULL)
+	{
+		if(cancellation_requested(walk->cancellation))
+		{
+			break;
+		}
+
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		char *const full_path = join_paths(path, d->d_name);
+		if(full_path == NULL)
+		{
+			continue;
+		}
+
+		const char *const name = full_path + strlen(full_path)
+		                       - strlen(d->d_name);
+		const int is_dir = entry_is_dir(full_path, d);
+		if(walk->func(full_path, name, is_dir, worker, walk->arg) && is_dir)
+		{
+			parallel_push(pool, worker, full_path);
+			continue;
+		}
+
+		free(full_path);
+	}
+
+	os_closedir(dir);
+	free(path);
+}
+
+/* Frees path of a directory which won't be walked because of cancellation.
+ * Implements parallel_drop_func. */
+static void
+drop_dir(void *task, void *arg)
+{
+	free(task);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
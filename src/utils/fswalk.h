@@ -0,0 +1,45 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__FSWALK_H__
+#define VIFM__UTILS__FSWALK_H__
+
+#include "cancellation.h"
+
+/* Traversal of file system trees that lists directories on several threads. */
+
+/* Type of function that is called for every file of a tree.  path is the full
+ * path to the file, name points to its last component inside of the path.
+ * is_dir is set only for directories and not for symbolic links to them.
+ * worker is index of the thread (zero corresponds to the thread which invoked
+ * fswalk()).  Should return non-zero to enter a directory, return value is
+ * ignored for other files. */
+typedef int (*fswalk_func)(const char path[], const char name[], int is_dir,
+		int worker, void *arg);
+
+/* Calls func for every file under the root directory (excluding the root) using
+ * at most nworkers threads including the calling one.  The calls happen
+ * concurrently and in no particular order.  Symbolic links aren't followed.
+ * Returns after the walk is over or was cancelled. */
+void fswalk(const char root[], int nworkers, fswalk_func func, void *arg,
+		const cancellation_t *cancellation);
+
+#endif /* VIFM__UTILS__FSWALK_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -31,9 +31,21 @@ typedef enum
 }
 FSWatchState;
 
+struct strlist_t;
+
 /* Opaque type of a watcher. */
 typedef struct fswatch_t fswatch_t;
 
+/* Files of a directory that have changed since previous poll. */
+typedef struct
+{
+	char **names; /* Names of the files. */
+	char *added;  /* Whether corresponding file didn't exist before changes. */
+	int count;    /* Number of elements in the arrays. */
+	int complete; /* Whether the names describe all changes of the directory. */
+}
+fswatch_changes_t;
+
 /* Creates new watcher for the specified path.  Returns the watcher or NULL on
  * error. */
 fswatch_t * fswatch_create(const char path[]);
@@ -41,10 +53,42 @@ fswatch_t * fswatch_create(const char path[]);
 /* Frees a watcher.  w can be NULL. */
 void fswatch_free(fswatch_t *w);
 
+/* Checks whether changes of files of the watched directory are reported as
+ * they happen.  This isn't the case if changes are derived from modification
+ * time of the directory, which misses updates of files in place, or if the
+ * directory is on a network file system, where changes made elsewhere can go
+ * unnoticed.  Returns non-zero if so, otherwise zero is returned. */
+int fswatch_tracks_files(const fswatch_t *w);
+
 /* Checks whether any changes were made to the entity being watched since last
  * query.  Returns latest state. */
 FSWatchState fswatch_poll(fswatch_t *w);
 
+/* Same as fswatch_poll(), but also reports which files have changed.  The
+ * changes are overwritten and should be freed with fswatch_free_changes().
+ * Changes are incomplete if they can't be described by names of files (e.g.,
+ * the directory itself has changed or events were lost) or if names aren't
+ * available on this platform. */
+FSWatchState fswatch_poll_changes(fswatch_t *w, fswatch_changes_t *changes);
+
+/* Frees contents of changes filled by fswatch_poll_changes(). */
+void fswatch_free_changes(fswatch_changes_t *changes);
+
+/* Creates an empty watcher that can track several directories at once (see
+ * fswatch_add()).  Returns the watcher or NULL on error. */
+fswatch_t * fswatch_create_set(void);
+
+/* Adds directory to a watcher created by fswatch_create_set().  Adding the same
+ * directory again only updates its path.  Returns zero on success, otherwise
+ * non-zero is returned. */
+int fswatch_add(fswatch_t *w, const char path[]);
+
+/* Checks which directories of a set watcher have changed since last query and
+ * appends their paths to the list.  Directories that stopped existing are
+ * silently dropped from the set.  Returns FSWS_UPDATED if the list was
+ * extended, FSWS_UNCHANGED if it wasn't and FSWS_ERRORED on error. */
+FSWatchState fswatch_poll_set(fswatch_t *w, struct strlist_t *changed);
+
 #endif /* VIFM__UTILS__FSWATCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -20,30 +20,47 @@
 
 #include <stdlib.h> /* free() malloc() */
 
+#include "string_array.h"
+
 #ifdef HAVE_INOTIFY
 
 #include <sys/inotify.h> /* IN_* inotify_* */
 #include <sys/types.h> /* dev_t ino_t */
+#ifdef __linux__
+#include <sys/vfs.h> /* statfs() */
+#endif
 #include <unistd.h> /* close() read() */
 
 #include <errno.h> /* EAGAIN errno */
 #include <stddef.h> /* NULL */
 #include <stdint.h> /* uint32_t */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() realloc() */
+#include <string.h> /* memmove() strdup() */
 #include <time.h> /* time_t time() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "macros.h"
 #include "trie.h"
 
 /* TODO: consider implementation that could reuse already available descriptor
  *       by just removing old watch and then adding a new one. */
 
+/* Directory of a set watcher. */
+typedef struct
+{
+	int wd;      /* Watch descriptor. */
+	char *path;  /* Path to the directory. */
+	int changed; /* Whether a change was detected since last poll. */
+}
+watched_dir_t;
+
 /* Watcher data. */
 struct fswatch_t
 {
-	/* Path that's being watched. */
+	/* Path that's being watched or NULL for a set watcher. */
 	char *path;
 	/* File descriptor for inotify. */
 	int fd;
@@ -54,6 +71,12 @@ struct fswatch_t
 	/* To monitor mount events, which aren't reported by inotify. */
 	dev_t dev;
 	ino_t inode;
+	/* Whether the path is on a local file system. */
+	int local;
+	/* Directories of a set watcher sorted by their watch descriptors. */
+	watched_dir_t *dirs;
+	/* Number of elements in the dirs array. */
+	int ndirs;
 };
 
 /* Per file statistics information. */
@@ -67,9 +90,19 @@ typedef struct
 }
 notif_stat_t;
 
-static FSWatchState poll_for_replacement(fswatch_t *w);
-static int update_file_stats(fswatch_t *w, const struct inotify_event *e,
+static fswatch_t * alloc_watch(void);
+static int is_on_local_fs(const char path[]);
+static FSWatchState poll_events(fswatch_t *w, fswatch_changes_t *changes);
+static void record_change(fswatch_changes_t *changes, trie_t *reported,
+		const struct inotify_event *e);
+static FSWatchState poll_for_replacement(fswatch_t *w, int watch_lost);
+static int read_events(fswatch_t *w, time_t now);
+static void process_set_event(fswatch_t *w, const struct inotify_event *e,
 		time_t now);
+static int find_dir(const fswatch_t *w, int wd, int *pos);
+static void remove_dir(fswatch_t *w, int pos);
+static int update_file_stats(fswatch_t *w, const char key[],
+		const struct inotify_event *e, time_t now);
 
 /* Events we're interested in. */
 static const uint32_t EVENTS_MASK = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE
@@ -85,7 +118,7 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
-	fswatch_t *const w = malloc(sizeof(*w));
+	fswatch_t *const w = alloc_watch();
 	if(w == NULL)
 	{
 		return NULL;
@@ -93,39 +126,65 @@ fswatch_create(const char path[])
 
 	w->dev = st.st_dev;
 	w->inode = st.st_ino;
+	w->local = is_on_local_fs(path);
 
-	/* Create tree to collect update frequency statistics. */
-	w->stats = trie_create(&free);
-	if(w->stats == NULL)
+	/* Add directory to watch. */
+	w->wd = inotify_add_watch(w->fd, path, EVENTS_MASK);
+	if(w->wd == -1)
 	{
-		trie_free(w->stats);
-		free(w);
+		fswatch_free(w);
 		return NULL;
 	}
 
-	/* Create inotify instance. */
-	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
-	if(w->fd == -1)
+	w->path = strdup(path);
+	if(w->path == NULL)
 	{
-		trie_free(w->stats);
-		free(w);
+		fswatch_free(w);
 		return NULL;
 	}
 
-	/* Add directory to watch. */
-	w->wd = inotify_add_watch(w->fd, path, EVENTS_MASK);
-	if(w->wd == -1)
+	return w;
+}
+
+fswatch_t *
+fswatch_create_set(void)
+{
+	return alloc_watch();
+}
+
+/* Allocates a watcher that doesn't watch anything yet.  Returns the watcher or
+ * NULL on error. */
+static fswatch_t *
+alloc_watch(void)
+{
+	fswatch_t *const w = malloc(sizeof(*w));
+	if(w == NULL)
+	{
+		return NULL;
+	}
+
+	w->path = NULL;
+	w->wd = -1;
+	w->dev = 0;
+	w->inode = 0;
+	w->local = 0;
+	w->dirs = NULL;
+	w->ndirs = 0;
+
+	/* Create tree to collect update frequency statistics. */
+	w->stats = trie_create(&free);
+	if(w->stats == NULL)
 	{
-		close(w->fd);
-		trie_free(w->stats);
 		free(w);
 		return NULL;
 	}
 
-	w->path = strdup(path);
-	if(w->path == NULL)
+	/* Create inotify instance. */
+	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(w->fd == -1)
 	{
-		fswatch_free(w);
+		trie_free(w->stats);
+		free(w);
 		return NULL;
 	}
 
@@ -137,6 +196,13 @@ fswatch_free(fswatch_t *w)
 {
 	if(w != NULL)
 	{
+		int i;
+		for(i = 0; i < w->ndirs; ++i)
+		{
+			free(w->dirs[i].path);
+		}
+		free(w->dirs);
+
 		free(w->path);
 		trie_free(w->stats);
 		close(w->fd);
@@ -144,8 +210,63 @@ fswatch_free(fswatch_t *w)
 	}
 }
 
+/* Checks whether changes on the file system of the path are seen by inotify.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_on_local_fs(const char path[])
+{
+#ifdef __linux__
+	/* Changes made by other machines aren't reported for these file systems:
+	 * NFS, SMB, CIFS, SMB2, FUSE, Coda, AFS, 9P and Ceph. */
+	static const uint32_t remote_types[] = {
+		0x6969, 0x517b, 0xff534d42, 0xfe534d42, 0x65735546, 0x73757245, 0x5346414f,
+		0x01021997, 0x00c36400,
+	};
+
+	struct statfs st;
+	if(statfs(path, &st) != 0)
+	{
+		return 0;
+	}
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(remote_types); ++i)
+	{
+		if((uint32_t)st.f_type == remote_types[i])
+		{
+			return 0;
+		}
+	}
+#endif
+	return 1;
+}
+
+int
+fswatch_tracks_files(const fswatch_t *w)
+{
+	return w->local;
+}
+
 FSWatchState
 fswatch_poll(fswatch_t *w)
+{
+	return poll_events(w, NULL);
+}
+
+FSWatchState
+fswatch_poll_changes(fswatch_t *w, fswatch_changes_t *changes)
+{
+	changes->names = NULL;
+	changes->added = NULL;
+	changes->count = 0;
+	changes->complete = 1;
+	return poll_events(w, changes);
+}
+
+/* Implements fswatch_poll() optionally collecting names of changed files.
+ * Returns latest state. */
+static FSWatchState
+poll_events(fswatch_t *w, fswatch_changes_t *changes)
 {
 	enum { MAX_READS = 100 };
 	enum { BUF_LEN = (10 * (sizeof(struct inotify_event) + NAME_MAX + 1)) };
@@ -155,6 +276,18 @@ fswatch_poll(fswatch_t *w)
 	int changed = 0;
 	int nreads = 0;
 	const time_t now = time(NULL);
+	/* Set to a final state to stop processing. */
+	FSWatchState state = FSWS_UNCHANGED;
+	int done = 0;
+
+	/* Names that were already reported. */
+	trie_t *const reported = (changes == NULL)
+	                       ? NULL
+	                       : trie_create(/*free_func=*/NULL);
+	if(changes != NULL && reported == NULL)
+	{
+		changes->complete = 0;
+	}
 
 	do
 	{
@@ -167,7 +300,8 @@ fswatch_poll(fswatch_t *w)
 		{
 			if(errno != EAGAIN)
 			{
-				return FSWS_ERRORED;
+				state = FSWS_ERRORED;
+				done = 1;
 			}
 			break;
 		}
@@ -178,15 +312,189 @@ fswatch_poll(fswatch_t *w)
 			e = (struct inotify_event *)p;
 			if((e->mask & IN_IGNORED) != 0 && e->wd == w->wd)
 			{
-				return poll_for_replacement(w);
+				state = poll_for_replacement(w, /*watch_lost=*/1);
+				done = 1;
+				break;
+			}
+
+			if((e->mask & IN_Q_OVERFLOW) != 0)
+			{
+				/* Some events were lost. */
+				changed = 1;
+				if(changes != NULL)
+				{
+					changes->complete = 0;
+				}
+				continue;
 			}
 
-			if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, e, now))
+			const char *const fname = (e->len == 0U) ? "." : e->name;
+			if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, fname, e, now))
 			{
 				changed = 1;
+				if(changes != NULL)
+				{
+					record_change(changes, reported, e);
+				}
 			}
 		}
 
+		/* Limit maximum number of reads to ensure that we won't spend all our time
+		 * in this loop. */
+		if(done || ++nreads > MAX_READS)
+		{
+			break;
+		}
+	}
+	while(nread != 0);
+
+	trie_free(reported);
+
+	if(done)
+	{
+		return state;
+	}
+	return (changed ? FSWS_UPDATED : poll_for_replacement(w, /*watch_lost=*/0));
+}
+
+/* Adds file of the event to the list of changes unless it's already there. */
+static void
+record_change(fswatch_changes_t *changes, trie_t *reported,
+		const struct inotify_event *e)
+{
+	if(e->len == 0U)
+	{
+		/* The directory itself has changed. */
+		changes->complete = 0;
+	}
+
+	/* Only the first event of a file tells whether it existed before. */
+	if(!changes->complete || trie_put(reported, e->name) != 0)
+	{
+		return;
+	}
+
+	char **const names = reallocarray(changes->names, changes->count + 1,
+			sizeof(*names));
+	if(names != NULL)
+	{
+		changes->names = names;
+	}
+
+	char *const added = realloc(changes->added, changes->count + 1);
+	if(added != NULL)
+	{
+		changes->added = added;
+	}
+
+	char *const name = strdup(e->name);
+	if(names == NULL || added == NULL || name == NULL)
+	{
+		free(name);
+		changes->complete = 0;
+		return;
+	}
+
+	names[changes->count] = name;
+	added[changes->count] = ((e->mask & (IN_CREATE | IN_MOVED_TO)) != 0);
+	++changes->count;
+}
+
+int
+fswatch_add(fswatch_t *w, const char path[])
+{
+	const int wd = inotify_add_watch(w->fd, path, EVENTS_MASK | IN_ONLYDIR);
+	if(wd == -1)
+	{
+		return 1;
+	}
+
+	char *const path_copy = strdup(path);
+	if(path_copy == NULL)
+	{
+		return 1;
+	}
+
+	/* Watch descriptors are per inode, so this might be a renamed directory. */
+	int pos;
+	if(find_dir(w, wd, &pos))
+	{
+		free(w->dirs[pos].path);
+		w->dirs[pos].path = path_copy;
+		return 0;
+	}
+
+	watched_dir_t *const dirs = reallocarray(w->dirs, w->ndirs + 1,
+			sizeof(*dirs));
+	if(dirs == NULL)
+	{
+		free(path_copy);
+		(void)inotify_rm_watch(w->fd, wd);
+		return 1;
+	}
+
+	w->dirs = dirs;
+	memmove(&dirs[pos + 1], &dirs[pos], sizeof(*dirs)*(w->ndirs - pos));
+	dirs[pos].wd = wd;
+	dirs[pos].path = path_copy;
+	dirs[pos].changed = 0;
+	++w->ndirs;
+	return 0;
+}
+
+FSWatchState
+fswatch_poll_set(fswatch_t *w, strlist_t *changed)
+{
+	if(read_events(w, time(NULL)) != 0)
+	{
+		return FSWS_ERRORED;
+	}
+
+	const int old_len = changed->nitems;
+
+	int i;
+	for(i = 0; i < w->ndirs; ++i)
+	{
+		if(w->dirs[i].changed)
+		{
+			w->dirs[i].changed = 0;
+			changed->nitems = add_to_string_array(&changed->items, changed->nitems,
+					w->dirs[i].path);
+		}
+	}
+
+	return (changed->nitems != old_len ? FSWS_UPDATED : FSWS_UNCHANGED);
+}
+
+/* Reads all pending events of a set watcher marking directories as changed.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+read_events(fswatch_t *w, time_t now)
+{
+	enum { MAX_READS = 100 };
+	enum { BUF_LEN = (10 * (sizeof(struct inotify_event) + NAME_MAX + 1)) };
+
+	char buf[BUF_LEN];
+	int nread;
+	int nreads = 0;
+
+	do
+	{
+		char *p;
+		struct inotify_event *e;
+
+		nread = read(w->fd, buf, BUF_LEN);
+		if(nread < 0)
+		{
+			return (errno != EAGAIN);
+		}
+
+		for(p = buf; p < buf + nread; p += sizeof(struct inotify_event) + e->len)
+		{
+			e = (struct inotify_event *)p;
+			process_set_event(w, e, now);
+		}
+
 		/* Limit maximum number of reads to ensure that we won't spend all our time
 		 * in this loop. */
 		if(++nreads > MAX_READS)
@@ -196,12 +504,86 @@ fswatch_poll(fswatch_t *w)
 	}
 	while(nread != 0);
 
-	return (changed ? FSWS_UPDATED : poll_for_replacement(w));
+	return 0;
+}
+
+/* Updates state of a set watcher according to a single event. */
+static void
+process_set_event(fswatch_t *w, const struct inotify_event *e, time_t now)
+{
+	int pos;
+
+	if(e->mask & IN_Q_OVERFLOW)
+	{
+		/* Some events were lost, so anything could have changed. */
+		for(pos = 0; pos < w->ndirs; ++pos)
+		{
+			w->dirs[pos].changed = 1;
+		}
+		return;
+	}
+
+	if(!find_dir(w, e->wd, &pos))
+	{
+		return;
+	}
+
+	/* The directory was removed or unmounted, its parent reports that. */
+	if(e->mask & IN_IGNORED)
+	{
+		remove_dir(w, pos);
+		return;
+	}
+
+	/* Watch descriptor makes names of different directories distinct. */
+	char key[NAME_MAX + 32];
+	snprintf(key, sizeof(key), "%d/%s", e->wd, (e->len == 0U) ? "." : e->name);
+
+	if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, key, e, now))
+	{
+		w->dirs[pos].changed = 1;
+	}
+}
+
+/* Looks up directory of a set watcher by its watch descriptor.  *pos is set to
+ * position of the directory or to where it should be inserted.  Returns
+ * non-zero if the directory was found, otherwise zero is returned. */
+static int
+find_dir(const fswatch_t *w, int wd, int *pos)
+{
+	int l = 0, u = w->ndirs;
+	while(l < u)
+	{
+		const int i = l + (u - l)/2;
+		if(w->dirs[i].wd < wd)
+		{
+			l = i + 1;
+		}
+		else
+		{
+			u = i;
+		}
+	}
+
+	*pos = l;
+	return (l < w->ndirs && w->dirs[l].wd == wd);
 }
 
-/* Detects replacement of path's target.  Returns watcher's state. */
+/* Removes directory of a set watcher at the specified position. */
+static void
+remove_dir(fswatch_t *w, int pos)
+{
+	free(w->dirs[pos].path);
+	memmove(&w->dirs[pos], &w->dirs[pos + 1],
+			sizeof(*w->dirs)*(w->ndirs - pos - 1));
+	--w->ndirs;
+}
+
+/* Detects replacement of path's target.  watch_lost flag indicates that
+ * kernel has dropped the watch, in which case the target is considered to be
+ * replaced even if it got the same inode number.  Returns watcher's state. */
 static FSWatchState
-poll_for_replacement(fswatch_t *w)
+poll_for_replacement(fswatch_t *w, int watch_lost)
 {
 	struct stat st;
 	if(os_stat(w->path, &st) != 0)
@@ -209,13 +591,14 @@ poll_for_replacement(fswatch_t *w)
 		return FSWS_ERRORED;
 	}
 
-	if(w->dev == st.st_dev && w->inode == st.st_ino)
+	if(!watch_lost && w->dev == st.st_dev && w->inode == st.st_ino)
 	{
 		return FSWS_UNCHANGED;
 	}
 
 	w->dev = st.st_dev;
 	w->inode = st.st_ino;
+	w->local = is_on_local_fs(w->path);
 
 	int wd = inotify_add_watch(w->fd, w->path, EVENTS_MASK);
 	if(wd == -1)
@@ -232,24 +615,25 @@ poll_for_replacement(fswatch_t *w)
 	return FSWS_REPLACED;
 }
 
-/* Updates information about a file event is about.  Returns non-zero if this is
- * an interesting event that's worth attention (e.g. re-reading information from
- * file system), otherwise zero is returned. */
+/* Updates information about a file event is about.  The key identifies the
+ * file.  Returns non-zero if this is an interesting event that's worth
+ * attention (e.g. re-reading information from file system), otherwise zero is
+ * returned. */
 static int
-update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
+update_file_stats(fswatch_t *w, const char key[],
+		const struct inotify_event *e, time_t now)
 {
 	enum { HITS_TO_BAN_AFTER = 5, BAN_SECS = 5 };
 
 	const uint32_t IMPORTANT_EVENTS = IN_CREATE | IN_DELETE | IN_MOVED_FROM
 	                                | IN_MOVED_TO | IN_Q_OVERFLOW;
 
-	const char *const fname = (e->len == 0U) ? "." : e->name;
 	void *data;
 	notif_stat_t *stats;
 
 	/* See if we already know this file and retrieve associated information if
 	 * so. */
-	if(trie_get(w->stats, fname, &data) != 0)
+	if(trie_get(w->stats, key, &data) != 0)
 	{
 		notif_stat_t *const stats = malloc(sizeof(*stats));
 		if(stats != NULL)
@@ -257,7 +641,7 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 			stats->last_update = now;
 			stats->banned_until = 0U;
 			stats->count = 1;
-			if(trie_set(w->stats, fname, stats) != 0)
+			if(trie_set(w->stats, key, stats) != 0)
 			{
 				free(stats);
 			}
@@ -302,13 +686,17 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 
 #include "filemon.h"
 
-#include <string.h> /* strdup() */
+#include <string.h> /* memmove() strcmp() strdup() */
+
+#include "../compat/reallocarray.h"
 
 /* Watcher data. */
 struct fswatch_t
 {
 	filemon_t filemon; /* Stamp based monitoring. */
 	char *path;        /* Path to the file being watched. */
+	fswatch_t **set;   /* Separate watchers of directories of a set watcher. */
+	int nset;          /* Number of elements in the set array. */
 };
 
 fswatch_t *
@@ -333,6 +721,23 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
+	w->set = NULL;
+	w->nset = 0;
+	return w;
+}
+
+fswatch_t *
+fswatch_create_set(void)
+{
+	fswatch_t *const w = malloc(sizeof(*w));
+	if(w == NULL)
+	{
+		return NULL;
+	}
+
+	w->path = NULL;
+	w->set = NULL;
+	w->nset = 0;
 	return w;
 }
 
@@ -341,11 +746,26 @@ fswatch_free(fswatch_t *w)
 {
 	if(w != NULL)
 	{
+		int i;
+		for(i = 0; i < w->nset; ++i)
+		{
+			fswatch_free(w->set[i]);
+		}
+		free(w->set);
+
 		free(w->path);
 		free(w);
 	}
 }
 
+int
+fswatch_tracks_files(const fswatch_t *w)
+{
+	/* Modification time of a directory doesn't change on updating its files in
+	 * place. */
+	return 0;
+}
+
 FSWatchState
 fswatch_poll(fswatch_t *w)
 {
@@ -362,7 +782,85 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+FSWatchState
+fswatch_poll_changes(fswatch_t *w, fswatch_changes_t *changes)
+{
+	/* Names of changed files aren't known. */
+	changes->names = NULL;
+	changes->added = NULL;
+	changes->count = 0;
+	changes->complete = 0;
+	return fswatch_poll(w);
+}
+
+int
+fswatch_add(fswatch_t *w, const char path[])
+{
+	int i;
+	for(i = 0; i < w->nset; ++i)
+	{
+		if(strcmp(w->set[i]->path, path) == 0)
+		{
+			return 0;
+		}
+	}
+
+	fswatch_t **const set = reallocarray(w->set, w->nset + 1, sizeof(*set));
+	if(set == NULL)
+	{
+		return 1;
+	}
+	w->set = set;
+
+	set[w->nset] = fswatch_create(path);
+	if(set[w->nset] == NULL)
+	{
+		return 1;
+	}
+
+	++w->nset;
+	return 0;
+}
+
+FSWatchState
+fswatch_poll_set(fswatch_t *w, strlist_t *changed)
+{
+	const int old_len = changed->nitems;
+
+	int i = 0;
+	while(i < w->nset)
+	{
+		const FSWatchState state = fswatch_poll(w->set[i]);
+		if(state == FSWS_ERRORED)
+		{
+			fswatch_free(w->set[i]);
+			memmove(&w->set[i], &w->set[i + 1], sizeof(*w->set)*(w->nset - i - 1));
+			--w->nset;
+			continue;
+		}
+
+		if(state != FSWS_UNCHANGED)
+		{
+			changed->nitems = add_to_string_array(&changed->items, changed->nitems,
+					w->set[i]->path);
+		}
+		++i;
+	}
+
+	return (changed->nitems != old_len ? FSWS_UPDATED : FSWS_UNCHANGED);
+}
+
 #endif
 
+void
+fswatch_free_changes(fswatch_changes_t *changes)
+{
+	free_string_array(changes->names, changes->count);
+	free(changes->added);
+	changes->names = NULL;
+	changes->added = NULL;
+	changes->count = 0;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -21,11 +21,13 @@
 #include <windows.h>
 
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strdup */
+#include <string.h> /* memmove() strcmp() strdup() */
 
 #include "../compat/fs_limits.h"
+#include "../compat/reallocarray.h"
 #include "macros.h"
 #include "str.h"
+#include "string_array.h"
 #include "utf8.h"
 
 /* Watcher data. */
@@ -33,13 +35,45 @@ struct fswatch_t
 {
 	FILETIME dir_mtime;
 	HANDLE dir_watcher;
+	int local; /* Whether the path is on a local drive. */
 	wchar_t *wpath;
+	char *path;
+	/* Separate watchers of directories of a set watcher. */
+	fswatch_t **set;
+	int nset;
 };
 
+static fswatch_t * create_watch(const char path[], int recursive);
 static int get_dir_mtime(const wchar_t dir_path[], FILETIME *ft);
 
 fswatch_t *
 fswatch_create(const char path[])
+{
+	return create_watch(path, 1);
+}
+
+fswatch_t *
+fswatch_create_set(void)
+{
+	fswatch_t *const w = malloc(sizeof(*w));
+	if(w == NULL)
+	{
+		return NULL;
+	}
+
+	w->dir_watcher = INVALID_HANDLE_VALUE;
+	w->local = 0;
+	w->wpath = NULL;
+	w->path = NULL;
+	w->set = NULL;
+	w->nset = 0;
+	return w;
+}
+
+/* Creates watcher for the path, which optionally includes changes made deeper
+ * in the tree.  Returns the watcher or NULL on error. */
+static fswatch_t *
+create_watch(const char path[], int recursive)
 {
 	fswatch_t *const w = malloc(sizeof(*w));
 	if(w == NULL)
@@ -47,9 +81,20 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
+	w->set = NULL;
+	w->nset = 0;
+
+	w->path = strdup(path);
+	if(w->path == NULL)
+	{
+		free(w);
+		return NULL;
+	}
+
 	w->wpath = utf8_to_utf16(path);
 	if(w->wpath == NULL)
 	{
+		free(w->path);
 		free(w);
 		return NULL;
 	}
@@ -57,21 +102,27 @@ fswatch_create(const char path[])
 	if(get_dir_mtime(w->wpath, &w->dir_mtime) != 0)
 	{
 		free(w->wpath);
+		free(w->path);
 		free(w);
 		return NULL;
 	}
 
-	w->dir_watcher = FindFirstChangeNotificationW(w->wpath, 1,
+	w->dir_watcher = FindFirstChangeNotificationW(w->wpath, recursive,
 			FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
 			FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_SIZE |
 			FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SECURITY);
 	if(w->dir_watcher == INVALID_HANDLE_VALUE)
 	{
 		free(w->wpath);
+		free(w->path);
 		free(w);
 		return NULL;
 	}
 
+	wchar_t volume[PATH_MAX + 1];
+	w->local = GetVolumePathNameW(w->wpath, volume, ARRAY_LEN(volume))
+	        && GetDriveTypeW(volume) != DRIVE_REMOTE;
+
 	return w;
 }
 
@@ -80,12 +131,29 @@ fswatch_free(fswatch_t *w)
 {
 	if(w != NULL)
 	{
-		FindCloseChangeNotification(w->dir_watcher);
+		int i;
+		for(i = 0; i < w->nset; ++i)
+		{
+			fswatch_free(w->set[i]);
+		}
+		free(w->set);
+
+		if(w->dir_watcher != INVALID_HANDLE_VALUE)
+		{
+			FindCloseChangeNotification(w->dir_watcher);
+		}
 		free(w->wpath);
+		free(w->path);
 		free(w);
 	}
 }
 
+int
+fswatch_tracks_files(const fswatch_t *w)
+{
+	return w->local;
+}
+
 FSWatchState
 fswatch_poll(fswatch_t *w)
 {
@@ -107,6 +175,85 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+FSWatchState
+fswatch_poll_changes(fswatch_t *w, fswatch_changes_t *changes)
+{
+	/* Names of changed files aren't known. */
+	changes->names = NULL;
+	changes->added = NULL;
+	changes->count = 0;
+	changes->complete = 0;
+	return fswatch_poll(w);
+}
+
+void
+fswatch_free_changes(fswatch_changes_t *changes)
+{
+	free_string_array(changes->names, changes->count);
+	free(changes->added);
+	changes->names = NULL;
+	changes->added = NULL;
+	changes->count = 0;
+}
+
+int
+fswatch_add(fswatch_t *w, const char path[])
+{
+	int i;
+	for(i = 0; i < w->nset; ++i)
+	{
+		if(strcmp(w->set[i]->path, path) == 0)
+		{
+			return 0;
+		}
+	}
+
+	fswatch_t **const set = reallocarray(w->set, w->nset + 1, sizeof(*set));
+	if(set == NULL)
+	{
+		return 1;
+	}
+	w->set = set;
+
+	/* Each directory is watched separately to know which one has changed. */
+	set[w->nset] = create_watch(path, 0);
+	if(set[w->nset] == NULL)
+	{
+		return 1;
+	}
+
+	++w->nset;
+	return 0;
+}
+
+FSWatchState
+fswatch_poll_set(fswatch_t *w, strlist_t *changed)
+{
+	const int old_len = changed->nitems;
+
+	int i = 0;
+	while(i < w->nset)
+	{
+		const FSWatchState state = fswatch_poll(w->set[i]);
+		if(state == FSWS_ERRORED)
+		{
+			fswatch_free(w->set[i]);
+			memmove(&w->set[i], &w->set[i + 1], sizeof(*w->set)*(w->nset - i - 1));
+			--w->nset;
+			continue;
+		}
+
+		if(state != FSWS_UNCHANGED)
+		{
+			changed->nitems = add_to_string_array(&changed->items, changed->nitems,
+					w->set[i]->path);
+		}
+		++i;
+	}
+
+	return (changed->nitems != old_len ? FSWS_UPDATED : FSWS_UNCHANGED);
+}
+
 /* Gets last directory modification time.  Returns non-zero on error, otherwise
  * zero is returned. */
 static int
@@ -0,0 +1,490 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "grep.h"
+
+#ifndef _WIN32
+#include <sys/stat.h> /* S_ISREG fstat() stat */
+#include <fcntl.h> /* O_NONBLOCK O_RDONLY open() */
+#include <unistd.h> /* close() */
+#endif
+#include <regex.h> /* regex_t regexec() regfree() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fclose() fdopen() ferror() feof() fread() */
+#include <stdlib.h> /* free() realloc() */
+#include <string.h> /* memchr() memcmp() memcpy() memmove() strcspn() strdup()
+                       strlen() */
+
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "regexp.h"
+#include "str.h"
+#include "string_array.h"
+
+/* Number of bytes at the beginning of a file which are checked for NUL
+ * character to detect binary files. */
+enum { BINARY_CHECK_LEN = 32*1024 };
+
+/* Initial size of the buffer for reading files.  It's doubled for lines that
+ * don't fit in it. */
+enum { READ_CHUNK_LEN = 64*1024 };
+
+struct grep_t
+{
+	char *literal;      /* Pattern to look up literally or NULL. */
+	size_t literal_len; /* Length of the literal pattern. */
+	regex_t *res;       /* Compiled pattern per worker if literal is NULL. */
+	int nres;           /* Number of elements in res. */
+	int invert;         /* Whether lines that don't match are looked for. */
+};
+
+/* State of search in a single file. */
+typedef struct
+{
+	const grep_t *grep; /* Pattern to look for. */
+	regex_t *re;        /* Regular expression of the worker or NULL. */
+	const char *name;   /* Name of the file to prepend to matches. */
+	int line_num;       /* Number of the first line of the next chunk. */
+	strlist_t *matches; /* Where found lines are appended. */
+	int capacity;       /* Number of allocated elements of matches->items. */
+	char *buf;          /* Buffer for null-terminating lines or NULL. */
+	size_t buf_size;    /* Size of the buffer. */
+}
+file_search_t;
+
+static FILE * open_file(const char path[]);
+static int grep_stream(file_search_t *search, FILE *fp);
+static const char * find_last_nl(const char data[], size_t size);
+static void grep_chunk(file_search_t *search, const char data[], size_t size);
+static void grep_literal(file_search_t *search, const char data[],
+		size_t size);
+static void grep_lines(file_search_t *search, const char data[], size_t size);
+static const char * skip_lines(file_search_t *search, const char from[],
+		const char to[]);
+static const char * find_literal(const grep_t *grep, const char data[],
+		size_t size);
+static void add_match(file_search_t *search, const char line[], size_t len);
+
+grep_t *
+grep_compile(const char pattern[], int ignore_case, int invert, int nworkers,
+		char **error)
+{
+	*error = NULL;
+
+	grep_t *const grep = malloc(sizeof(*grep));
+	if(grep == NULL)
+	{
+		return NULL;
+	}
+
+	grep->invert = invert;
+	grep->literal = NULL;
+	grep->literal_len = strlen(pattern);
+	grep->res = NULL;
+	grep->nres = 0;
+
+	/* Literal search is way faster than matching every line against a regular
+	 * expression. */
+	if(!ignore_case && grep->literal_len != 0 &&
+			pattern[strcspn(pattern, "\\^$.[]|()*+?{}")] == '\0')
+	{
+		grep->literal = strdup(pattern);
+		if(grep->literal == NULL)
+		{
+			free(grep);
+			return NULL;
+		}
+		return grep;
+	}
+
+	/* Matching with the same regex_t is serialized by some implementations of
+	 * regexec(), so every worker gets its own copy. */
+	if(nworkers < 1)
+	{
+		nworkers = 1;
+	}
+	grep->res = reallocarray(NULL, nworkers, sizeof(*grep->res));
+	if(grep->res == NULL)
+	{
+		free(grep);
+		return NULL;
+	}
+
+	const int cflags = REG_EXTENDED | REG_NOSUB | (ignore_case ? REG_ICASE : 0);
+	while(grep->nres < nworkers)
+	{
+		regex_t *const re = &grep->res[grep->nres];
+		const int err = regexp_compile(re, pattern, cflags);
+		if(err != 0)
+		{
+			if(grep->nres == 0)
+			{
+				*error = strdup(get_regexp_error(err, re));
+			}
+			regfree(re);
+			grep_free(grep);
+			return NULL;
+		}
+		++grep->nres;
+	}
+
+	return grep;
+}
+
+void
+grep_free(grep_t *grep)
+{
+	if(grep == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < grep->nres; ++i)
+	{
+		regfree(&grep->res[i]);
+	}
+	free(grep->res);
+	free(grep->literal);
+	free(grep);
+}
+
+int
+grep_file(const grep_t *grep, int worker, const char path[], const char name[],
+		strlist_t *matches)
+{
+	FILE *const fp = open_file(path);
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	file_search_t search = {
+		.grep = grep,
+		.re = (grep->literal == NULL ? &grep->res[worker % grep->nres] : NULL),
+		.name = name,
+		.line_num = 1,
+		.matches = matches,
+		.capacity = matches->nitems,
+	};
+
+	const int failed = grep_stream(&search, fp);
+	fclose(fp);
+	free(search.buf);
+	return failed;
+}
+
+/* Opens a regular file for reading.  Returns the stream or NULL on error. */
+static FILE *
+open_file(const char path[])
+{
+#ifndef _WIN32
+	/* Non-blocking mode is to not hang on opening a FIFO, which isn't read
+	 * anyway. */
+	const int fd = open(path, O_RDONLY | O_NONBLOCK);
+	if(fd == -1)
+	{
+		return NULL;
+	}
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	FILE *const fp = fdopen(fd, "rb");
+	if(fp == NULL)
+	{
+		close(fd);
+	}
+	return fp;
+#else
+	return os_fopen(path, "rb");
+#endif
+}
+
+/* Reads the file in chunks that end at line boundaries and searches in each of
+ * them.  Unlike mapping a file, this doesn't crash if the file is truncated
+ * while it's being read.  Returns zero on success and non-zero on error. */
+static int
+grep_stream(file_search_t *search, FILE *fp)
+{
+	char *data = NULL;
+	size_t size = 0U, capacity = 0U;
+	int first_chunk = 1;
+	int failed = 0;
+
+	while(1)
+	{
+		if(size == capacity)
+		{
+			const size_t new_capacity = (capacity == 0U)
+			                          ? READ_CHUNK_LEN
+			                          : capacity*2U;
+			char *const new_data = realloc(data, new_capacity);
+			if(new_data == NULL)
+			{
+				failed = 1;
+				break;
+			}
+			data = new_data;
+			capacity = new_capacity;
+		}
+
+		/* fread() returns less than requested only at the end of file or on
+		 * error. */
+		size += fread(data + size, 1, capacity - size, fp);
+		if(ferror(fp))
+		{
+			failed = 1;
+			break;
+		}
+
+		if(first_chunk)
+		{
+			/* Check for binary file the same way "grep -I" does it.  The first chunk
+			 * is always at least as long as the checked part unless the file is
+			 * shorter. */
+			const size_t check_len = (size < BINARY_CHECK_LEN)
+			                       ? size
+			                       : BINARY_CHECK_LEN;
+			if(memchr(data, '\0', check_len) != NULL)
+			{
+				break;
+			}
+			first_chunk = 0;
+		}
+
+		if(feof(fp))
+		{
+			grep_chunk(search, data, size);
+			break;
+		}
+
+		const char *const last_nl = find_last_nl(data, size);
+		if(last_nl == NULL)
+		{
+			/* The line doesn't fit, the buffer will be enlarged. */
+			continue;
+		}
+
+		const size_t len = last_nl + 1 - data;
+		grep_chunk(search, data, len);
+		memmove(data, data + len, size - len);
+		size -= len;
+	}
+
+	free(data);
+	return failed;
+}
+
+/* Finds last new line character in the data.  Returns pointer to it or
+ * NULL. */
+static const char *
+find_last_nl(const char data[], size_t size)
+{
+	while(size != 0U)
+	{
+		if(data[--size] == '\n')
+		{
+			return &data[size];
+		}
+	}
+	return NULL;
+}
+
+/* Looks for matching lines in a piece of a file which consists of whole
+ * lines. */
+static void
+grep_chunk(file_search_t *search, const char data[], size_t size)
+{
+	if(search->grep->literal != NULL && !search->grep->invert)
+	{
+		grep_literal(search, data, size);
+	}
+	else
+	{
+		grep_lines(search, data, size);
+	}
+}
+
+/* Looks for occurrences of literal pattern in the data skipping over lines
+ * between them. */
+static void
+grep_literal(file_search_t *search, const char data[], size_t size)
+{
+	const char *const end = data + size;
+	const char *line = data;
+
+	while(line < end)
+	{
+		const char *const match = find_literal(search->grep, line, end - line);
+		if(match == NULL)
+		{
+			break;
+		}
+
+		line = skip_lines(search, line, match);
+
+		const char *line_end = memchr(match, '\n', end - match);
+		if(line_end == NULL)
+		{
+			line_end = end;
+		}
+
+		add_match(search, line, line_end - line);
+
+		line = line_end + 1;
+		++search->line_num;
+	}
+
+	/* Numbers of lines of the next chunk depend on lines of this one. */
+	if(line < end)
+	{
+		(void)skip_lines(search, line, end);
+	}
+}
+
+/* Checks every line of the data against the pattern. */
+static void
+grep_lines(file_search_t *search, const char data[], size_t size)
+{
+	const grep_t *const grep = search->grep;
+	const char *const end = data + size;
+	const char *line = data;
+
+	for(; line < end; ++search->line_num)
+	{
+		const char *line_end = memchr(line, '\n', end - line);
+		if(line_end == NULL)
+		{
+			line_end = end;
+		}
+		const size_t len = line_end - line;
+
+		int matched;
+		if(grep->literal != NULL)
+		{
+			matched = (find_literal(grep, line, len) != NULL);
+		}
+		else
+		{
+			/* Regular expressions are matched against null-terminated strings. */
+			if(len + 1U > search->buf_size)
+			{
+				char *const new_buf = realloc(search->buf, len + 1U);
+				if(new_buf == NULL)
+				{
+					break;
+				}
+				search->buf = new_buf;
+				search->buf_size = len + 1U;
+			}
+
+			memcpy(search->buf, line, len);
+			search->buf[len] = '\0';
+			matched = (regexec(search->re, search->buf, 0, NULL, 0) == 0);
+		}
+
+		if(matched != grep->invert)
+		{
+			add_match(search, line, len);
+		}
+
+		line = line_end + 1;
+	}
+}
+
+/* Counts lines in the [from; to) range of data advancing number of current
+ * line.  Returns beginning of the last line in the range. */
+static const char *
+skip_lines(file_search_t *search, const char from[], const char to[])
+{
+	const char *nl;
+	while((nl = memchr(from, '\n', to - from)) != NULL)
+	{
+		from = nl + 1;
+		++search->line_num;
+	}
+	return from;
+}
+
+/* Finds first occurrence of the literal pattern in the data.  Returns pointer
+ * to the occurrence or NULL. */
+static const char *
+find_literal(const grep_t *grep, const char data[], size_t size)
+{
+	const size_t len = grep->literal_len;
+	if(size < len)
+	{
+		return NULL;
+	}
+
+	/* memchr() is usually vectorized, so let it skip over data until the first
+	 * character of the pattern. */
+	const char *const last = data + (size - len);
+	const char *p = data;
+	while(p <= last)
+	{
+		p = memchr(p, grep->literal[0], last - p + 1);
+		if(p == NULL)
+		{
+			break;
+		}
+
+		if(memcmp(p + 1, grep->literal + 1, len - 1) == 0)
+		{
+			return p;
+		}
+		++p;
+	}
+
+	return NULL;
+}
+
+/* Appends current line along with its location to the list of matches. */
+static void
+add_match(file_search_t *search, const char line[], size_t len)
+{
+	strlist_t *const matches = search->matches;
+	if(matches->nitems == search->capacity)
+	{
+		const int capacity = (search->capacity == 0 ? 16 : search->capacity*2);
+		char **const items = reallocarray(matches->items, capacity,
+				sizeof(*items));
+		if(items == NULL)
+		{
+			return;
+		}
+		matches->items = items;
+		search->capacity = capacity;
+	}
+
+	char *const match = format_str("%s:%d:%.*s", search->name, search->line_num,
+			(int)len, line);
+	if(match != NULL)
+	{
+		matches->items[matches->nitems++] = match;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
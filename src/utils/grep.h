@@ -0,0 +1,54 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__GREP_H__
+#define VIFM__UTILS__GREP_H__
+
+/* Search of lines of files that match a pattern.  Compiled pattern can be used
+ * by several threads at the same time as long as each of them passes its own
+ * worker index. */
+
+/* Opaque type of a compiled pattern. */
+typedef struct grep_t grep_t;
+
+struct strlist_t;
+
+/* Prepares the pattern for searching.  Patterns without special characters are
+ * looked up literally, others are treated as extended regular expressions.
+ * Non-zero invert makes lines that don't match the pattern to be reported.
+ * nworkers is the number of threads that will search with the pattern.
+ * Returns the pattern or NULL on error, in which case *error is set to a newly
+ * allocated message or NULL. */
+grep_t * grep_compile(const char pattern[], int ignore_case, int invert,
+		int nworkers, char **error);
+
+/* Frees the pattern.  grep can be NULL. */
+void grep_free(grep_t *grep);
+
+/* Looks for lines of the file that match the pattern and appends them to the
+ * list in the form "<name>:<line number>:<line>".  Files that contain NUL
+ * character near their beginning are considered to be binary and are skipped.
+ * worker is index of the calling thread in the range [0; nworkers).  Returns
+ * zero on success and non-zero if the file can't be read. */
+int grep_file(const grep_t *grep, int worker, const char path[],
+		const char name[], struct strlist_t *matches);
+
+#endif /* VIFM__UTILS__GREP_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
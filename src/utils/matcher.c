@@ -20,15 +20,19 @@
 
 #include <regex.h> /* regex_t regexec() regfree() */
 
-#include <stddef.h> /* NULL */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strcspn() strdup() strlen() strrchr() */
+#include <ctype.h> /* tolower() */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* bsearch() calloc() free() malloc() qsort() */
+#include <string.h> /* memcmp() memmove() strcmp() strcspn() strdup() strlen()
+                       strrchr() */
 
+#include "../compat/fs_limits.h"
 #include "../int/file_magic.h"
 #include "globs.h"
 #include "path.h"
 #include "regexp.h"
 #include "str.h"
+#include "string_array.h"
 #include "test_helpers.h"
 
 /* Type of a matcher. */
@@ -40,6 +44,33 @@ typedef enum
 }
 MType;
 
+/* Glob of the form `prefix*suffix` (either part can be empty). */
+typedef struct
+{
+	const char *prefix; /* Case-folded part before the asterisk. */
+	size_t prefix_len;  /* Length of the prefix. */
+	const char *suffix; /* Case-folded part after the asterisk. */
+	size_t suffix_len;  /* Length of the suffix. */
+}
+infix_glob_t;
+
+/* "Faster" globs grouped by the way they are matched, so that matching against
+ * many globs doesn't need to look at each of them. */
+typedef struct
+{
+	char *buf;               /* Case-folded globs referred to by other fields. */
+	const char **literals;   /* Sorted names that are matched completely. */
+	int nliterals;           /* Number of elements in literals. */
+	const char **suffixes;   /* Sorted suffixes of `*suffix` globs. */
+	int nsuffixes;           /* Number of elements in suffixes. */
+	size_t *suffix_lens;     /* Distinct lengths of suffixes in ascending
+	                            order. */
+	int nsuffix_lens;        /* Number of elements in suffix_lens. */
+	infix_glob_t *infixes;   /* Globs with asterisk not at the start. */
+	int ninfixes;            /* Number of elements in infixes. */
+}
+fglobs_t;
+
 /* Wrapper for a regular expression, its state and compiled form. */
 struct matcher_t
 {
@@ -53,6 +84,7 @@ struct matcher_t
 	unsigned int fglobs : 1;    /* Whether this matcher is a special case of
 	                               globs ("faster" globs) that is optimized. */
 	regex_t regex; /* The expression in compiled form, unless matcher is empty. */
+	fglobs_t *fg;  /* Compiled form of faster globs or NULL. */
 };
 
 static int is_full_path(const char expr[], int re, int glob, int *strip);
@@ -62,10 +94,17 @@ static int compile_expr(matcher_t *m, int strip, int cs_by_def,
 		const char on_empty_re[], char **error);
 static int parse_glob(matcher_t *m, int strip, char **error);
 static int is_fglobs(char expr[]);
+static fglobs_t * compile_fglobs(const char globs[]);
+static void free_fglobs(fglobs_t *fg);
+static int compare_strs(const void *a, const void *b);
+static int compare_sizes(const void *a, const void *b);
+static void fold_case(char str[]);
 static int parse_re(matcher_t *m, int strip, int cs_by_def,
 		const char on_empty_re[], char **error);
 static void free_matcher_items(matcher_t *matcher);
 static int fglobs_matches(const matcher_t *matcher, const char path[]);
+static int fglobs_match_folded(const fglobs_t *fg, const char name[],
+		size_t len);
 static int fglobs_includes(const matcher_t *matcher, const matcher_t *like);
 static int is_negated(const char **expr);
 static int is_re_expr(const char expr[], int allow_empty);
@@ -237,6 +276,13 @@ parse_glob(matcher_t *m, int strip, char **error)
 
 	if(is_fglobs(m->raw))
 	{
+		m->fg = compile_fglobs(m->raw);
+		if(m->fg == NULL)
+		{
+			replace_string(error, "Failed to compile globs.");
+			return 1;
+		}
+
 		m->fglobs = 1;
 		return 0;
 	}
@@ -288,6 +334,136 @@ is_fglobs(char expr[])
 	return (glob == NULL);
 }
 
+/* Splits list of faster globs into groups that can be matched efficiently.
+ * Returns compiled globs or NULL on error. */
+static fglobs_t *
+compile_fglobs(const char globs[])
+{
+	fglobs_t *const fg = calloc(1U, sizeof(*fg));
+	if(fg == NULL)
+	{
+		return NULL;
+	}
+
+	/* Each comma can separate at most one more glob. */
+	size_t max_globs = 1U;
+	const char *c;
+	for(c = globs; *c != '\0'; ++c)
+	{
+		max_globs += (*c == ',');
+	}
+
+	fg->buf = strdup(globs);
+	fg->literals = malloc(sizeof(*fg->literals)*max_globs);
+	fg->suffixes = malloc(sizeof(*fg->suffixes)*max_globs);
+	fg->suffix_lens = malloc(sizeof(*fg->suffix_lens)*max_globs);
+	fg->infixes = malloc(sizeof(*fg->infixes)*max_globs);
+	if(fg->buf == NULL || fg->literals == NULL || fg->suffixes == NULL ||
+			fg->suffix_lens == NULL || fg->infixes == NULL)
+	{
+		free_fglobs(fg);
+		return NULL;
+	}
+
+	/* Folding case doesn't affect characters that have special meaning. */
+	fold_case(fg->buf);
+
+	char *glob = fg->buf, *state = NULL;
+	while((glob = split_and_get_dc(glob, &state)) != NULL)
+	{
+		char *const asterisk = until_first(glob, '*');
+
+		if(*asterisk == '\0')
+		{
+			/* Literal with no special characters. */
+			fg->literals[fg->nliterals++] = glob;
+		}
+		else if(asterisk == glob)
+		{
+			/* `*something` */
+			fg->suffixes[fg->nsuffixes++] = glob + 1;
+			fg->suffix_lens[fg->nsuffix_lens++] = strlen(glob + 1);
+		}
+		else if(asterisk[-1] == '\\')
+		{
+			/* Literal with one escaped asterisk, which loses the escaping. */
+			memmove(asterisk - 1, asterisk, strlen(asterisk) + 1U);
+			fg->literals[fg->nliterals++] = glob;
+		}
+		else
+		{
+			/* Either `something*` or `some*thing`. */
+			*asterisk = '\0';
+			infix_glob_t *const infix = &fg->infixes[fg->ninfixes++];
+			infix->prefix = glob;
+			infix->prefix_len = asterisk - glob;
+			infix->suffix = asterisk + 1;
+			infix->suffix_len = strlen(asterisk + 1);
+		}
+	}
+
+	qsort(fg->literals, fg->nliterals, sizeof(*fg->literals), &compare_strs);
+	qsort(fg->suffixes, fg->nsuffixes, sizeof(*fg->suffixes), &compare_strs);
+
+	/* Leave only unique lengths of suffixes. */
+	qsort(fg->suffix_lens, fg->nsuffix_lens, sizeof(*fg->suffix_lens),
+			&compare_sizes);
+	int i, j = 0;
+	for(i = 0; i < fg->nsuffix_lens; ++i)
+	{
+		if(j == 0 || fg->suffix_lens[j - 1] != fg->suffix_lens[i])
+		{
+			fg->suffix_lens[j++] = fg->suffix_lens[i];
+		}
+	}
+	fg->nsuffix_lens = j;
+
+	return fg;
+}
+
+/* Frees compiled faster globs.  fg can be NULL. */
+static void
+free_fglobs(fglobs_t *fg)
+{
+	if(fg != NULL)
+	{
+		free(fg->buf);
+		free(fg->literals);
+		free(fg->suffixes);
+		free(fg->suffix_lens);
+		free(fg->infixes);
+		free(fg);
+	}
+}
+
+/* qsort() and bsearch() comparer for pointers to strings.  Returns standard
+ * -1, 0, 1 for comparisons. */
+static int
+compare_strs(const void *a, const void *b)
+{
+	return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* qsort() comparer for sizes.  Returns standard -1, 0, 1 for comparisons. */
+static int
+compare_sizes(const void *a, const void *b)
+{
+	const size_t x = *(const size_t *)a, y = *(const size_t *)b;
+	return (x < y) ? -1 : (x > y);
+}
+
+/* Converts string to lower case byte by byte in the same way strcasecmp() does
+ * it. */
+static void
+fold_case(char str[])
+{
+	while(*str != '\0')
+	{
+		*str = tolower((unsigned char)*str);
+		++str;
+	}
+}
+
 /* Parses regexp flags.  Returns zero on success or non-zero on error with
  * *error containing description of it. */
 static int
@@ -342,9 +518,13 @@ matcher_clone(const matcher_t *matcher)
 	clone->expr = strdup(matcher->expr);
 	clone->raw = strdup(matcher->raw);
 	clone->undec = strdup(matcher->undec);
+	clone->fg = (matcher->fglobs ? compile_fglobs(matcher->raw) : NULL);
 
-	if(clone->expr == NULL || clone->raw == NULL || clone->undec == NULL)
+	if(clone->expr == NULL || clone->raw == NULL || clone->undec == NULL ||
+			(clone->fglobs && clone->fg == NULL))
 	{
+		/* Don't try to free regex that wasn't compiled. */
+		clone->fglobs = 1;
 		matcher_free(clone);
 		return NULL;
 	}
@@ -382,6 +562,7 @@ free_matcher_items(matcher_t *matcher)
 		/* Regex is compiled only for non-empty matchers of unoptimized patterns. */
 		regfree(&matcher->regex);
 	}
+	free_fglobs(matcher->fg);
 	free(matcher->expr);
 	free(matcher->raw);
 	free(matcher->undec);
@@ -422,56 +603,73 @@ matcher_matches(const matcher_t *matcher, const char path[])
 static int
 fglobs_matches(const matcher_t *matcher, const char path[])
 {
-	char *globs = strdup(matcher->raw);
-	char *glob = globs, *state = NULL;
-	while((glob = split_and_get_dc(glob, &state)) != NULL)
-	{
-		const char *asterisk = until_first(glob, '*');
+	const size_t len = strlen(path);
 
-		/* Literal with no special characters. */
-		if(*asterisk == '\0')
+	char buf[NAME_MAX + 1];
+	char *folded = buf;
+	if(len >= sizeof(buf))
+	{
+		folded = malloc(len + 1U);
+		if(folded == NULL)
 		{
-			if(strcasecmp(path, glob) == 0)
-			{
-				break;
-			}
-			continue;
+			return matcher->negated;
 		}
+	}
 
-		size_t pos = asterisk - glob;
-		/* `*something` */
-		if(pos == 0)
-		{
-			if(path[0] != '.' && ends_with_case(path + 1, glob + 1))
-			{
-				break;
-			}
-			continue;
-		}
+	memcpy(folded, path, len + 1U);
+	fold_case(folded);
+
+	const int matched = fglobs_match_folded(matcher->fg, folded, len);
+
+	if(folded != buf)
+	{
+		free(folded);
+	}
+	return matched^matcher->negated;
+}
 
-		/* Literal with one escaped asterisk. */
-		if(asterisk[-1] == '\\')
+/* Checks whether case-folded name of specified length is matched by any of
+ * the globs.  Returns non-zero if so, otherwise zero is returned. */
+static int
+fglobs_match_folded(const fglobs_t *fg, const char name[], size_t len)
+{
+	if(fg->nliterals != 0 &&
+			bsearch(&name, fg->literals, fg->nliterals, sizeof(*fg->literals),
+				&compare_strs) != NULL)
+	{
+		return 1;
+	}
+
+	/* `*something` doesn't match dot files and asterisk must match at least one
+	 * character. */
+	if(len != 0U && name[0] != '.')
+	{
+		int i;
+		for(i = 0; i < fg->nsuffix_lens && fg->suffix_lens[i] < len; ++i)
 		{
-			/* Compare parts around '\\' to ignore it. */
-			--pos;
-			if(strncasecmp(path, glob, pos) == 0 &&
-					strcasecmp(path + pos, glob + pos + 1) == 0)
+			const char *const tail = name + len - fg->suffix_lens[i];
+			if(bsearch(&tail, fg->suffixes, fg->nsuffixes, sizeof(*fg->suffixes),
+						&compare_strs) != NULL)
 			{
-				break;
+				return 1;
 			}
-			continue;
 		}
+	}
 
-		/* Either `something*` or `some*thing`.  First case work here by matching
-		 * its empty suffix. */
-		if(strncasecmp(path, glob, pos) == 0 &&
-				ends_with_case(path + pos, glob + pos + 1))
+	int i;
+	for(i = 0; i < fg->ninfixes; ++i)
+	{
+		const infix_glob_t *const infix = &fg->infixes[i];
+		if(len >= infix->prefix_len + infix->suffix_len &&
+				memcmp(name, infix->prefix, infix->prefix_len) == 0 &&
+				memcmp(name + len - infix->suffix_len, infix->suffix,
+					infix->suffix_len) == 0)
 		{
-			break;
+			return 1;
 		}
 	}
-	free(globs);
-	return (glob != NULL)^matcher->negated;
+
+	return 0;
 }
 
 int
@@ -587,12 +785,71 @@ is_mime_expr(const char expr[])
 	return surrounded_with(expr, '<', '>') && expr[2] != '\0';
 }
 
+int
+matcher_get_name_keys(const matcher_t *matcher, strlist_t *names,
+		strlist_t *exts)
+{
+	if(!matcher->fglobs || matcher->type != MT_GLOBS || matcher->negated ||
+			matcher->full_path)
+	{
+		return 1;
+	}
+
+	const fglobs_t *const fg = matcher->fg;
+	if(fg->ninfixes != 0)
+	{
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < fg->nsuffixes; ++i)
+	{
+		/* Extension of a name is fully determined only by suffixes with a dot. */
+		const char *const dot = strrchr(fg->suffixes[i], '.');
+		if(dot == NULL || dot[1] == '\0')
+		{
+			return 1;
+		}
+	}
+
+	strlist_t new_names = {}, new_exts = {};
+	for(i = 0; i < fg->nliterals; ++i)
+	{
+		new_names.nitems = add_to_string_array(&new_names.items, new_names.nitems,
+				fg->literals[i]);
+	}
+	for(i = 0; i < fg->nsuffixes; ++i)
+	{
+		new_exts.nitems = add_to_string_array(&new_exts.items, new_exts.nitems,
+				strrchr(fg->suffixes[i], '.') + 1);
+	}
+
+	if(new_names.nitems != fg->nliterals || new_exts.nitems != fg->nsuffixes)
+	{
+		free_string_array(new_names.items, new_names.nitems);
+		free_string_array(new_exts.items, new_exts.nitems);
+		return 1;
+	}
+
+	free_string_array(names->items, names->nitems);
+	free_string_array(exts->items, exts->nitems);
+	*names = new_names;
+	*exts = new_exts;
+	return 0;
+}
+
 int
 matcher_is_full_path(const matcher_t *matcher)
 {
 	return matcher->full_path;
 }
 
+int
+matcher_uses_mime(const matcher_t *matcher)
+{
+	return (matcher->type == MT_MIME);
+}
+
 TSTATIC int
 matcher_is_fast(const matcher_t *matcher)
 {
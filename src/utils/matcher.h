@@ -24,6 +24,8 @@
 
 #include "test_helpers.h"
 
+struct strlist_t;
+
 /* File path/name matcher (glob/regexp/mime-type). */
 
 /* Opaque matcher type. */
@@ -62,10 +64,22 @@ const char * matcher_get_undec(const matcher_t *matcher);
  * Returns non-zero if so, otherwise zero is returned. */
 int matcher_includes(const matcher_t *matcher, const matcher_t *like);
 
+/* Lists lower case names and extensions (parts after the last dot) of files
+ * that can be matched by the matcher.  Returns zero if the matcher can't match
+ * a file that has neither of them, otherwise non-zero is returned and the
+ * lists are left intact. */
+int matcher_get_name_keys(const matcher_t *matcher, struct strlist_t *names,
+		struct strlist_t *exts);
+
 /* Checks whether given matcher is a full path matcher.  Returns non-zero if so,
  * otherwise zero is returned. */
 int matcher_is_full_path(const matcher_t *matcher);
 
+/* Checks whether given matcher examines mime types of files, which can't be
+ * done by several threads at the same time.  Returns non-zero if so, otherwise
+ * zero is returned. */
+int matcher_uses_mime(const matcher_t *matcher);
+
 TSTATIC_DEFS(
 	int matcher_is_fast(const matcher_t *matcher);
 )
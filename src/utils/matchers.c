@@ -204,12 +204,42 @@ matchers_match_dir(const matchers_t *matchers, const char path[])
 	return (i >= matchers->count);
 }
 
+int
+matchers_get_name_keys(const matchers_t *matchers, strlist_t *names,
+		strlist_t *exts)
+{
+	/* All matchers must match, so keys of any of them will do. */
+	int i;
+	for(i = 0; i < matchers->count; ++i)
+	{
+		if(matcher_get_name_keys(matchers->list[i], names, exts) == 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
 const char *
 matchers_get_expr(const matchers_t *matchers)
 {
 	return matchers->expr;
 }
 
+int
+matchers_use_mime(const matchers_t *matchers)
+{
+	int i;
+	for(i = 0; i < matchers->count; ++i)
+	{
+		if(matcher_uses_mime(matchers->list[i]))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
 int
 matchers_includes(const matchers_t *matchers, const matchers_t *like)
 {
@@ -21,6 +21,8 @@
 
 #include "test_helpers.h"
 
+struct strlist_t;
+
 /* Opaque matchers type. */
 typedef struct matchers_t matchers_t;
 
@@ -43,9 +45,19 @@ int matchers_match(const matchers_t *matchers, const char path[]);
  * directories.  Returns non-zero if so, otherwise zero is returned. */
 int matchers_match_dir(const matchers_t *matchers, const char path[]);
 
+/* Lists lower case names and extensions of files that can be matched by the
+ * matchers.  Returns zero if the matchers can't match a file that has neither
+ * of them, otherwise non-zero is returned and the lists are left intact. */
+int matchers_get_name_keys(const matchers_t *matchers, struct strlist_t *names,
+		struct strlist_t *exts);
+
 /* Retrieves original matcher expression.  Returns the expression. */
 const char * matchers_get_expr(const matchers_t *matchers);
 
+/* Checks whether any of the matchers examines mime types of files.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int matchers_use_mime(const matchers_t *matchers);
+
 /* Checks whether matchers matches at least superset of what like is matching.
  * Returns non-zero if so, otherwise zero is returned. */
 int matchers_includes(const matchers_t *matchers, const matchers_t *like);
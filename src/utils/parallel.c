@@ -0,0 +1,549 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "parallel.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <unistd.h> /* sysconf() */
+
+#include <stdlib.h> /* realloc() free() */
+#include <string.h> /* memmove() */
+
+#include "../compat/pthread.h"
+#include "macros.h"
+
+/* Upper limit on number of threads that work on a batch of items. */
+#define MAX_WORKERS 16
+
+/* State shared by all threads processing a batch of items. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects the next field. */
+	int next;             /* Index of the next item to be handed out. */
+	int count;            /* Total number of items. */
+
+	parallel_func func;                 /* Processor of a single item. */
+	void *arg;                          /* Argument for the func. */
+	const cancellation_t *cancellation; /* Cancellation state. */
+}
+batch_t;
+
+/* Argument of a thread that processes items of a batch. */
+typedef struct
+{
+	batch_t *batch; /* Batch to work on. */
+	int worker;     /* Index of the worker. */
+	int processed;  /* Number of items processed by this worker. */
+}
+worker_t;
+
+/* Tasks of a single worker of a pool.  The owner takes tasks from the top,
+ * while other workers steal them from the bottom. */
+typedef struct
+{
+	pthread_mutex_t lock; /* Protects the rest of the fields. */
+	void **tasks;         /* Tasks in the order of their addition. */
+	int bottom;           /* Index of the oldest task. */
+	int top;              /* Index past the newest task. */
+	int capacity;         /* Number of allocated elements in tasks. */
+}
+deque_t;
+
+/* Argument of a thread that processes tasks of a pool. */
+typedef struct
+{
+	parallel_pool_t *pool; /* Pool to work on. */
+	int worker;            /* Index of the worker. */
+}
+pool_worker_t;
+
+struct parallel_pool_t
+{
+	pthread_mutex_t lock; /* Protects fields up to the deques. */
+	pthread_cond_t cond;  /* Signaled on new tasks and when all work is done. */
+	int queued;           /* Number of tasks in deques. */
+	int pending;          /* Number of queued and running tasks. */
+	int nidle;            /* Number of workers waiting for tasks. */
+	int nthreads;         /* Number of started additional threads. */
+	int max_threads;      /* Limit on the number of additional threads. */
+	pthread_t threads[MAX_WORKERS];
+	pool_worker_t workers[MAX_WORKERS];
+
+	deque_t deques[MAX_WORKERS]; /* Tasks of each of the workers. */
+	int ndeques;                 /* Number of initialized deques. */
+	int inline_only;             /* Whether tasks are processed on push. */
+
+	parallel_task_func func;            /* Processor of a single task. */
+	parallel_drop_func drop;            /* Releaser of an unprocessed task. */
+	void *arg;                          /* Argument for the func and drop. */
+	const cancellation_t *cancellation; /* Cancellation state. */
+};
+
+static void * worker_thread(void *arg);
+static int process_items(batch_t *batch, int worker);
+static int init_pool(parallel_pool_t *pool, int nworkers);
+static void free_pool(parallel_pool_t *pool);
+static void * pool_thread(void *arg);
+static void process_tasks(parallel_pool_t *pool, int worker);
+static void handle_task(parallel_pool_t *pool, int worker, void *task);
+static void finish_task(parallel_pool_t *pool);
+static void * take_task(parallel_pool_t *pool, int worker);
+static void start_thread(parallel_pool_t *pool);
+static int deque_push(deque_t *deque, void *task);
+static void * deque_pop_top(deque_t *deque);
+static void * deque_pop_bottom(deque_t *deque);
+
+int
+parallel_get_nworkers(void)
+{
+#ifndef _WIN32
+	const long n = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	const long n = info.dwNumberOfProcessors;
+#endif
+	return (n < 1 ? 1 : MIN(n, MAX_WORKERS));
+}
+
+int
+parallel_for(int count, int nworkers, parallel_func func, void *arg,
+		const cancellation_t *cancellation)
+{
+	batch_t batch = {
+		.next = 0,
+		.count = count,
+		.func = func,
+		.arg = arg,
+		.cancellation = cancellation,
+	};
+
+	pthread_t threads[MAX_WORKERS];
+	worker_t workers[MAX_WORKERS];
+	int nthreads;
+
+	/* There is no point in starting more threads than there are items. */
+	nworkers = MAX(1, MIN(MIN(nworkers, MAX_WORKERS), count));
+
+	if(pthread_mutex_init(&batch.lock, NULL) != 0)
+	{
+		/* Fallback to processing items sequentially. */
+		int i;
+		for(i = 0; i < count && !cancellation_requested(cancellation); ++i)
+		{
+			func(i, 0, arg);
+		}
+		return i;
+	}
+
+	/* Failure to start a thread isn't fatal, it only reduces parallelism. */
+	for(nthreads = 0; nthreads < nworkers - 1; ++nthreads)
+	{
+		workers[nthreads].batch = &batch;
+		workers[nthreads].worker = nthreads + 1;
+		workers[nthreads].processed = 0;
+		if(pthread_create(&threads[nthreads], NULL, &worker_thread,
+					&workers[nthreads]) != 0)
+		{
+			break;
+		}
+	}
+
+	int processed = process_items(&batch, 0);
+
+	int i;
+	for(i = 0; i < nthreads; ++i)
+	{
+		(void)pthread_join(threads[i], NULL);
+		processed += workers[i].processed;
+	}
+
+	(void)pthread_mutex_destroy(&batch.lock);
+	return processed;
+}
+
+/* Entry point of an additional thread working on a batch.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	worker_t *const worker = arg;
+	worker->processed = process_items(worker->batch, worker->worker);
+	return NULL;
+}
+
+/* Processes items of the batch until they run out or processing is
+ * cancelled.  Returns number of processed items. */
+static int
+process_items(batch_t *batch, int worker)
+{
+	int processed = 0;
+
+	while(!cancellation_requested(batch->cancellation))
+	{
+		int idx = -1;
+
+		(void)pthread_mutex_lock(&batch->lock);
+		if(batch->next < batch->count)
+		{
+			idx = batch->next++;
+		}
+		(void)pthread_mutex_unlock(&batch->lock);
+
+		if(idx < 0)
+		{
+			break;
+		}
+
+		batch->func(idx, worker, batch->arg);
+		++processed;
+	}
+
+	return processed;
+}
+
+void
+parallel_run(void *task, int nworkers, parallel_task_func func,
+		parallel_drop_func drop, void *arg, const cancellation_t *cancellation)
+{
+	parallel_pool_t pool = {
+		.func = func,
+		.drop = drop,
+		.arg = arg,
+		.cancellation = cancellation,
+	};
+
+	nworkers = MAX(1, MIN(nworkers, MAX_WORKERS));
+
+	if(init_pool(&pool, nworkers) != 0)
+	{
+		/* Fallback to processing tasks depth-first on this thread. */
+		pool.inline_only = 1;
+		handle_task(&pool, 0, task);
+		return;
+	}
+
+	parallel_push(&pool, 0, task);
+	process_tasks(&pool, 0);
+
+	/* No thread can be started at this point, because all tasks are done. */
+	(void)pthread_mutex_lock(&pool.lock);
+	const int nthreads = pool.nthreads;
+	(void)pthread_mutex_unlock(&pool.lock);
+
+	int i;
+	for(i = 0; i < nthreads; ++i)
+	{
+		(void)pthread_join(pool.threads[i], NULL);
+	}
+
+	free_pool(&pool);
+}
+
+void
+parallel_push(parallel_pool_t *pool, int worker, void *task)
+{
+	if(pool->inline_only)
+	{
+		handle_task(pool, worker, task);
+		return;
+	}
+
+	/* The task is accounted for before it's published, otherwise another worker
+	 * could take and finish it before the increment and see pending drop to
+	 * zero while this task is still running. */
+	(void)pthread_mutex_lock(&pool->lock);
+	++pool->pending;
+	++pool->queued;
+	(void)pthread_mutex_unlock(&pool->lock);
+
+	if(deque_push(&pool->deques[worker], task) != 0)
+	{
+		(void)pthread_mutex_lock(&pool->lock);
+		--pool->queued;
+		(void)pthread_mutex_unlock(&pool->lock);
+
+		handle_task(pool, worker, task);
+		finish_task(pool);
+		return;
+	}
+
+	(void)pthread_mutex_lock(&pool->lock);
+	if(pool->nidle == 0 && pool->nthreads < pool->max_threads)
+	{
+		start_thread(pool);
+	}
+	else
+	{
+		(void)pthread_cond_signal(&pool->cond);
+	}
+	(void)pthread_mutex_unlock(&pool->lock);
+}
+
+/* Initializes synchronization primitives of the pool.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+init_pool(parallel_pool_t *pool, int nworkers)
+{
+	if(pthread_mutex_init(&pool->lock, NULL) != 0)
+	{
+		return 1;
+	}
+	if(pthread_cond_init(&pool->cond, NULL) != 0)
+	{
+		(void)pthread_mutex_destroy(&pool->lock);
+		return 1;
+	}
+
+	for(pool->ndeques = 0; pool->ndeques < nworkers; ++pool->ndeques)
+	{
+		deque_t *const deque = &pool->deques[pool->ndeques];
+		if(pthread_mutex_init(&deque->lock, NULL) != 0)
+		{
+			break;
+		}
+		deque->tasks = NULL;
+		deque->bottom = 0;
+		deque->top = 0;
+		deque->capacity = 0;
+	}
+
+	if(pool->ndeques == 0)
+	{
+		free_pool(pool);
+		return 1;
+	}
+
+	pool->max_threads = pool->ndeques - 1;
+	return 0;
+}
+
+/* Frees resources of the pool. */
+static void
+free_pool(parallel_pool_t *pool)
+{
+	int i;
+	for(i = 0; i < pool->ndeques; ++i)
+	{
+		(void)pthread_mutex_destroy(&pool->deques[i].lock);
+		free(pool->deques[i].tasks);
+	}
+
+	(void)pthread_cond_destroy(&pool->cond);
+	(void)pthread_mutex_destroy(&pool->lock);
+}
+
+/* Entry point of an additional thread working on a pool.  Returns NULL. */
+static void *
+pool_thread(void *arg)
+{
+	pool_worker_t *const worker = arg;
+	process_tasks(worker->pool, worker->worker);
+	return NULL;
+}
+
+/* Processes tasks of the pool until all of them are done. */
+static void
+process_tasks(parallel_pool_t *pool, int worker)
+{
+	for(;;)
+	{
+		void *const task = take_task(pool, worker);
+		if(task != NULL)
+		{
+			handle_task(pool, worker, task);
+			finish_task(pool);
+			continue;
+		}
+
+		(void)pthread_mutex_lock(&pool->lock);
+		/* queued can be positive for a moment before a task is added to a deque,
+		 * in which case taking it is retried. */
+		while(pool->queued == 0 && pool->pending != 0)
+		{
+			++pool->nidle;
+			(void)pthread_cond_wait(&pool->cond, &pool->lock);
+			--pool->nidle;
+		}
+		const int done = (pool->pending == 0);
+		(void)pthread_mutex_unlock(&pool->lock);
+
+		if(done)
+		{
+			break;
+		}
+	}
+}
+
+/* Processes or drops the task depending on cancellation state. */
+static void
+handle_task(parallel_pool_t *pool, int worker, void *task)
+{
+	if(cancellation_requested(pool->cancellation))
+	{
+		pool->drop(task, pool->arg);
+	}
+	else
+	{
+		pool->func(pool, task, worker, pool->arg);
+	}
+}
+
+/* Accounts for completion of a task and wakes up workers if it was the last
+ * one. */
+static void
+finish_task(parallel_pool_t *pool)
+{
+	(void)pthread_mutex_lock(&pool->lock);
+	if(--pool->pending == 0)
+	{
+		(void)pthread_cond_broadcast(&pool->cond);
+	}
+	(void)pthread_mutex_unlock(&pool->lock);
+}
+
+/* Takes the newest task of the worker or steals the oldest task of some other
+ * worker.  Returns the task or NULL if there are none. */
+static void *
+take_task(parallel_pool_t *pool, int worker)
+{
+	void *task = deque_pop_top(&pool->deques[worker]);
+
+	int i;
+	for(i = 1; task == NULL && i < pool->ndeques; ++i)
+	{
+		task = deque_pop_bottom(&pool->deques[(worker + i)%pool->ndeques]);
+	}
+
+	if(task != NULL)
+	{
+		(void)pthread_mutex_lock(&pool->lock);
+		--pool->queued;
+		(void)pthread_mutex_unlock(&pool->lock);
+	}
+
+	return task;
+}
+
+/* Starts one more thread for the pool, which must be locked. */
+static void
+start_thread(parallel_pool_t *pool)
+{
+	pool_worker_t *const worker = &pool->workers[pool->nthreads];
+	worker->pool = pool;
+	worker->worker = pool->nthreads + 1;
+
+	if(pthread_create(&pool->threads[pool->nthreads], NULL, &pool_thread,
+				worker) == 0)
+	{
+		++pool->nthreads;
+	}
+	else
+	{
+		/* Failure to start a thread isn't fatal, it only reduces parallelism. */
+		pool->max_threads = pool->nthreads;
+	}
+}
+
+/* Adds a task to the top of the deque.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+deque_push(deque_t *deque, void *task)
+{
+	int error = 0;
+
+	(void)pthread_mutex_lock(&deque->lock);
+
+	if(deque->top == deque->capacity && deque->bottom != 0)
+	{
+		memmove(deque->tasks, deque->tasks + deque->bottom,
+				sizeof(*deque->tasks)*(deque->top - deque->bottom));
+		deque->top -= deque->bottom;
+		deque->bottom = 0;
+	}
+
+	if(deque->top == deque->capacity)
+	{
+		const int capacity = (deque->capacity == 0 ? 64 : deque->capacity*2);
+		void **const tasks = realloc(deque->tasks, sizeof(*tasks)*capacity);
+		if(tasks == NULL)
+		{
+			error = 1;
+		}
+		else
+		{
+			deque->tasks = tasks;
+			deque->capacity = capacity;
+		}
+	}
+
+	if(!error)
+	{
+		deque->tasks[deque->top++] = task;
+	}
+
+	(void)pthread_mutex_unlock(&deque->lock);
+	return error;
+}
+
+/* Removes the newest task of the deque.  Returns the task or NULL. */
+static void *
+deque_pop_top(deque_t *deque)
+{
+	void *task = NULL;
+
+	(void)pthread_mutex_lock(&deque->lock);
+	if(deque->top != deque->bottom)
+	{
+		task = deque->tasks[--deque->top];
+		if(deque->top == deque->bottom)
+		{
+			deque->top = 0;
+			deque->bottom = 0;
+		}
+	}
+	(void)pthread_mutex_unlock(&deque->lock);
+
+	return task;
+}
+
+/* Removes the oldest task of the deque.  Returns the task or NULL. */
+static void *
+deque_pop_bottom(deque_t *deque)
+{
+	void *task = NULL;
+
+	(void)pthread_mutex_lock(&deque->lock);
+	if(deque->top != deque->bottom)
+	{
+		task = deque->tasks[deque->bottom++];
+		if(deque->top == deque->bottom)
+		{
+			deque->top = 0;
+			deque->bottom = 0;
+		}
+	}
+	(void)pthread_mutex_unlock(&deque->lock);
+
+	return task;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
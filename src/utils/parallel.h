@@ -0,0 +1,73 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__PARALLEL_H__
+#define VIFM__UTILS__PARALLEL_H__
+
+#include "cancellation.h"
+
+/* Facilities for processing independent pieces of work on several threads. */
+
+/* Type of function that processes a single item.  idx is index of the item,
+ * worker is index of the thread processing it (zero corresponds to the thread
+ * which invoked parallel_for()). */
+typedef void (*parallel_func)(int idx, int worker, void *arg);
+
+/* Pool of tasks that can produce more tasks while being processed. */
+typedef struct parallel_pool_t parallel_pool_t;
+
+/* Type of function that processes a single task of a pool.  worker is index of
+ * the thread processing it (zero corresponds to the thread which invoked
+ * parallel_run()), it should be passed to parallel_push() on adding new
+ * tasks. */
+typedef void (*parallel_task_func)(parallel_pool_t *pool, void *task,
+		int worker, void *arg);
+
+/* Type of function that releases a task which won't be processed because of
+ * cancellation. */
+typedef void (*parallel_drop_func)(void *task, void *arg);
+
+/* Retrieves number of threads that is reasonable to use for parallel
+ * processing.  Returns positive number. */
+int parallel_get_nworkers(void);
+
+/* Calls func for every item index in the range [0; count) using at most
+ * nworkers threads including the calling one.  Items are handed out in order
+ * of their indexes, but can complete in any order.  No new items are started
+ * after cancellation is requested.  Returns number of processed items. */
+int parallel_for(int count, int nworkers, parallel_func func, void *arg,
+		const cancellation_t *cancellation);
+
+/* Calls func for the initial task and all tasks added to the pool while
+ * processing it using at most nworkers threads including the calling one.
+ * Every worker handles its most recently added tasks first and steals the
+ * oldest tasks of other workers when it runs out of its own.  Additional
+ * threads are started only when there is work for them.  Once cancellation is
+ * requested, tasks that haven't been started are passed to drop instead of
+ * func.  Returns after all tasks are handled. */
+void parallel_run(void *task, int nworkers, parallel_task_func func,
+		parallel_drop_func drop, void *arg, const cancellation_t *cancellation);
+
+/* Adds a task to the pool on behalf of the worker.  The task is processed
+ * right away if it can't be queued. */
+void parallel_push(parallel_pool_t *pool, int worker, void *task);
+
+#endif /* VIFM__UTILS__PARALLEL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -19,6 +19,7 @@
 
 #include "str.h"
 
+#include <assert.h> /* assert() */
 #include <ctype.h> /* tolower() isspace() */
 #include <limits.h> /* INT_MAX INT_MIN LONG_MAX LONG_MIN */
 #include <stdarg.h> /* va_list va_start() va_copy() va_end() */
@@ -810,6 +811,25 @@ expand_tabulation(const char line[], size_t max, size_t tab_stops, char buf[])
 	return line;
 }
 
+char *
+expand_tabulation_a(const char line[], size_t tab_stops)
+{
+	const size_t tab_count = chars_in_str(line, '\t');
+	const size_t extra_line_len = tab_count*tab_stops;
+	const size_t expanded_line_len = (strlen(line) - tab_count) + extra_line_len;
+	char *const expanded_line = malloc(expanded_line_len + 1);
+
+	if(expanded_line != NULL)
+	{
+		const char *const end = expand_tabulation(line, (size_t)-1, tab_stops,
+				expanded_line);
+		assert(*end == '\0' && "The line should be processed till the end");
+		(void)end;
+	}
+
+	return expanded_line;
+}
+
 wchar_t
 get_first_wchar(const char str[])
 {
@@ -239,6 +239,12 @@ char * format_str(const char format[], ...) _gnuc_printf(1, 2);
 const char * expand_tabulation(const char line[], size_t max, size_t tab_stops,
 		char buf[]);
 
+/* Clones the line replacing all occurrences of horizontal tabulation character
+ * with appropriate number of spaces.  The tab_stops parameter shows how many
+ * character position are taken by one tabulation.  Returns newly allocated
+ * string or NULL if there is not enough memory. */
+char * expand_tabulation_a(const char line[], size_t tab_stops);
+
 /* Returns the first wide character of a multi-byte string. */
 wchar_t get_first_wchar(const char str[]);
 
@@ -0,0 +1,159 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "str_arena.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() strlen() */
+
+/* Size of the first chunk of an arena. */
+#define FIRST_CHUNK_SIZE 4096U
+
+/* Upper limit on size of chunks that are allocated for an arena. */
+#define MAX_CHUNK_SIZE (256U*1024U)
+
+/* Chunk of memory from which strings are allocated.  Each string is preceded
+ * by a pointer to its chunk. */
+typedef struct
+{
+	size_t size; /* Size of the data part. */
+	int refs;    /* Number of live strings plus one while arena uses it. */
+	/* Data of the chunk follows the header. */
+}
+chunk_t;
+
+/* Arena itself. */
+struct str_arena_t
+{
+	chunk_t *chunk;   /* Chunk that is being filled or NULL. */
+	size_t used;      /* Number of used bytes of the chunk. */
+	size_t next_size; /* Size of the next chunk. */
+};
+
+static chunk_t * get_chunk(str_arena_t *arena, size_t size);
+static void unref_chunk(chunk_t *chunk);
+
+str_arena_t *
+str_arena_create(void)
+{
+	str_arena_t *const arena = malloc(sizeof(*arena));
+	if(arena == NULL)
+	{
+		return NULL;
+	}
+
+	arena->chunk = NULL;
+	arena->used = 0U;
+	arena->next_size = FIRST_CHUNK_SIZE;
+	return arena;
+}
+
+void
+str_arena_free(str_arena_t *arena)
+{
+	if(arena != NULL)
+	{
+		if(arena->chunk != NULL)
+		{
+			unref_chunk(arena->chunk);
+		}
+		free(arena);
+	}
+}
+
+char *
+str_arena_dup(str_arena_t *arena, const char str[])
+{
+	const size_t len = strlen(str) + 1U;
+	/* Keep headers of strings aligned. */
+	const size_t size = (sizeof(chunk_t *) + len + sizeof(chunk_t *) - 1U)
+	                  & ~(sizeof(chunk_t *) - 1U);
+
+	chunk_t *const chunk = get_chunk(arena, size);
+	if(chunk == NULL)
+	{
+		return NULL;
+	}
+
+	char *const data = (char *)(chunk + 1) + arena->used;
+	arena->used += size;
+	__sync_add_and_fetch(&chunk->refs, 1);
+
+	memcpy(data, &chunk, sizeof(chunk));
+	memcpy(data + sizeof(chunk), str, len);
+	return data + sizeof(chunk);
+}
+
+/* Retrieves chunk which has at least size bytes available, allocating a new
+ * one if necessary.  Returns the chunk or NULL on error. */
+static chunk_t *
+get_chunk(str_arena_t *arena, size_t size)
+{
+	if(arena->chunk != NULL && arena->chunk->size - arena->used >= size)
+	{
+		return arena->chunk;
+	}
+
+	const size_t chunk_size = (size > arena->next_size ? size : arena->next_size);
+	chunk_t *const chunk = malloc(sizeof(*chunk) + chunk_size);
+	if(chunk == NULL)
+	{
+		return NULL;
+	}
+
+	chunk->size = chunk_size;
+	chunk->refs = 1;
+
+	if(arena->chunk != NULL)
+	{
+		unref_chunk(arena->chunk);
+	}
+
+	arena->chunk = chunk;
+	arena->used = 0U;
+	if(arena->next_size < MAX_CHUNK_SIZE)
+	{
+		arena->next_size *= 2U;
+	}
+	return chunk;
+}
+
+void
+str_arena_release(char str[])
+{
+	if(str != NULL)
+	{
+		chunk_t *chunk;
+		memcpy(&chunk, str - sizeof(chunk), sizeof(chunk));
+		unref_chunk(chunk);
+	}
+}
+
+/* Drops one reference to the chunk freeing it when no references are left. */
+static void
+unref_chunk(chunk_t *chunk)
+{
+	if(__sync_sub_and_fetch(&chunk->refs, 1) == 0)
+	{
+		free(chunk);
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
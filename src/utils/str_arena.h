@@ -0,0 +1,50 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STR_ARENA_H__
+#define VIFM__UTILS__STR_ARENA_H__
+
+/* Arena for strings which are allocated in bulk.  Strings are placed one after
+ * another in large chunks of memory, so allocation amounts to bumping a
+ * pointer.  A chunk is freed in one go after the arena has moved on to the next
+ * chunk and all of the strings it contains were released.
+ *
+ * An arena must be used by one thread at a time, but strings can be released
+ * from any thread and outlive the arena. */
+
+/* Declaration of opaque arena type. */
+typedef struct str_arena_t str_arena_t;
+
+/* Creates an empty arena.  Returns the arena or NULL on error. */
+str_arena_t * str_arena_create(void);
+
+/* Frees the arena.  Strings allocated from it remain valid until they are
+ * released. */
+void str_arena_free(str_arena_t *arena);
+
+/* Copies the string into the arena.  Returns pointer to the copy or NULL on
+ * error. */
+char * str_arena_dup(str_arena_t *arena, const char str[]);
+
+/* Releases string returned by str_arena_dup().  The str can be NULL. */
+void str_arena_release(char str[]);
+
+#endif /* VIFM__UTILS__STR_ARENA_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
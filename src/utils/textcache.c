@@ -0,0 +1,408 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "textcache.h"
+
+#include <sys/stat.h> /* S_IRWXU stat */
+#ifndef _WIN32
+#include <sys/time.h> /* utimes() */
+#endif
+#include <dirent.h> /* DIR dirent */
+#include <unistd.h> /* getpid() unlink() */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* EOF FILE fclose() fprintf() fputc() fputs() fread()
+                      ftell() sscanf() snprintf() */
+#include <stdlib.h> /* free() malloc() qsort() */
+#include <string.h> /* memcmp() strcmp() strdup() strlen() strspn() */
+#include <time.h> /* time_t time() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "file_streams.h"
+#include "fs.h"
+#include "str.h"
+#include "string_array.h"
+
+#define XXH_PRIVATE_API
+#include "xxhash.h"
+
+/* Identifier and version of the file format.  Change version on changing
+ * layout of files. */
+#define MAGIC "VIFMTC1"
+
+/* Length of names of files with values. */
+enum { NAME_LEN = 32 };
+
+/* Age in seconds after which temporary file is considered to be left behind by
+ * an instance that has crashed while writing it. */
+#define STALE_TMP_AGE (60*60)
+
+struct textcache_t
+{
+	char *dir;         /* Directory with files of the cache. */
+	uint64_t max_size; /* Size budget. */
+	uint64_t written;  /* Number of bytes written since last trimming. */
+	int trimmed;       /* Whether trimming was performed at least once. */
+};
+
+/* Information about a single file of the cache. */
+typedef struct
+{
+	char name[NAME_LEN + 1]; /* Name of the file. */
+	uint64_t size;           /* Its size. */
+	time_t mtime;            /* Time of last use. */
+}
+value_file_t;
+
+static void get_value_path(const textcache_t *cache, const char key[],
+		char buf[], size_t buf_len);
+static int read_value(FILE *fp, const char key[], strlist_t *lines,
+		int *complete);
+static int write_value(FILE *fp, const char key[], const strlist_t *lines,
+		int complete);
+static void trim_cache(textcache_t *cache);
+static int is_value_name(const char name[]);
+static int is_tmp_name(const char name[]);
+static int mtime_cmp(const void *a, const void *b);
+
+textcache_t *
+textcache_open(const char dir[], uint64_t max_size)
+{
+#ifndef _WIN32
+	if(max_size == 0U || make_path(dir, S_IRWXU) != 0)
+	{
+		return NULL;
+	}
+
+	textcache_t *const cache = malloc(sizeof(*cache));
+	if(cache == NULL)
+	{
+		return NULL;
+	}
+
+	cache->dir = strdup(dir);
+	if(cache->dir == NULL)
+	{
+		free(cache);
+		return NULL;
+	}
+
+	cache->max_size = max_size;
+	cache->written = 0U;
+	cache->trimmed = 0;
+	return cache;
+#else
+	return NULL;
+#endif
+}
+
+void
+textcache_close(textcache_t *cache)
+{
+	if(cache != NULL)
+	{
+		free(cache->dir);
+		free(cache);
+	}
+}
+
+int
+textcache_get(textcache_t *cache, const char key[], strlist_t *lines,
+		int *complete)
+{
+	if(cache == NULL)
+	{
+		return 1;
+	}
+
+	char path[PATH_MAX + 1];
+	get_value_path(cache, key, path, sizeof(path));
+
+	FILE *const fp = os_fopen(path, "rb");
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	const int failed = read_value(fp, key, lines, complete);
+	fclose(fp);
+
+#ifndef _WIN32
+	if(!failed)
+	{
+		/* Modification time serves as the time of last use. */
+		(void)utimes(path, NULL);
+	}
+#endif
+
+	return failed;
+}
+
+void
+textcache_put(textcache_t *cache, const char key[], const strlist_t *lines,
+		int complete)
+{
+	if(cache == NULL)
+	{
+		return;
+	}
+
+	char path[PATH_MAX + 1];
+	get_value_path(cache, key, path, sizeof(path));
+
+	/* Write to a temporary file and rename it to not expose partially written
+	 * values to other instances. */
+	char tmp_path[PATH_MAX + 32];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+
+	FILE *const fp = os_fopen(tmp_path, "wb");
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	const int failed = write_value(fp, key, lines, complete);
+	const long size = ftell(fp);
+	if(fclose(fp) != 0 || failed || os_rename(tmp_path, path) != 0)
+	{
+		(void)unlink(tmp_path);
+		return;
+	}
+
+	cache->written += (size > 0 ? size : 0);
+	if(!cache->trimmed || cache->written > cache->max_size/8U)
+	{
+		trim_cache(cache);
+	}
+}
+
+/* Forms path to the file that holds value of the key. */
+static void
+get_value_path(const textcache_t *cache, const char key[], char buf[],
+		size_t buf_len)
+{
+	const XXH128_hash_t hash = XXH3_128bits(key, strlen(key));
+	snprintf(buf, buf_len, "%s/%016llx%016llx", cache->dir,
+			(unsigned long long)hash.high64, (unsigned long long)hash.low64);
+}
+
+/* Reads value from the file checking that it belongs to the key.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+read_value(FILE *fp, const char key[], strlist_t *lines, int *complete)
+{
+	char *const header = read_line(fp, NULL);
+	if(header == NULL)
+	{
+		return 1;
+	}
+
+	char magic[sizeof(MAGIC)];
+	int is_complete, nlines;
+	size_t key_len;
+	const int parsed = sscanf(header, "%7s %d %d %zu", magic, &is_complete,
+			&nlines, &key_len);
+	free(header);
+	if(parsed != 4 || strcmp(magic, MAGIC) != 0 || nlines < 0 ||
+			key_len != strlen(key))
+	{
+		return 1;
+	}
+
+	char stored_key[key_len + 1];
+	if(fread(stored_key, 1, key_len + 1, fp) != key_len + 1 ||
+			memcmp(stored_key, key, key_len) != 0 || stored_key[key_len] != '\n')
+	{
+		return 1;
+	}
+
+	strlist_t result = {};
+	while(result.nitems < nlines)
+	{
+		char *const line = read_line(fp, NULL);
+		if(line == NULL)
+		{
+			break;
+		}
+
+		const int old_len = result.nitems;
+		result.nitems = put_into_string_array(&result.items, result.nitems, line);
+		if(result.nitems == old_len)
+		{
+			free(line);
+			break;
+		}
+	}
+
+	if(result.nitems != nlines)
+	{
+		free_string_array(result.items, result.nitems);
+		return 1;
+	}
+
+	*lines = result;
+	*complete = (is_complete != 0);
+	return 0;
+}
+
+/* Writes value along with its key to the file.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+write_value(FILE *fp, const char key[], const strlist_t *lines, int complete)
+{
+	if(fprintf(fp, "%s %d %d %zu\n%s\n", MAGIC, complete ? 1 : 0, lines->nitems,
+				strlen(key), key) < 0)
+	{
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < lines->nitems; ++i)
+	{
+		if(fputs(lines->items[i], fp) == EOF || fputc('\n', fp) == EOF)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Removes least recently used files of the cache if their total size exceeds
+ * the budget.  Some space is freed beyond that to do it less often.  Stale
+ * temporary files are removed unconditionally. */
+static void
+trim_cache(textcache_t *cache)
+{
+	cache->trimmed = 1;
+	cache->written = 0U;
+
+	DIR *const dir = os_opendir(cache->dir);
+	if(dir == NULL)
+	{
+		return;
+	}
+
+	value_file_t *files = NULL;
+	size_t nfiles = 0U, capacity = 0U;
+	uint64_t total = 0U;
+	const time_t now = time(NULL);
+
+	struct dirent *d;
+	while((d = os_readdir(dir)) != NULL)
+	{
+		const int is_tmp = is_tmp_name(d->d_name);
+		if(!is_tmp && !is_value_name(d->d_name))
+		{
+			continue;
+		}
+
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/%s", cache->dir, d->d_name);
+
+		struct stat st;
+		if(os_stat(path, &st) != 0)
+		{
+			continue;
+		}
+
+		if(is_tmp)
+		{
+			if(now - st.st_mtime > STALE_TMP_AGE)
+			{
+				(void)unlink(path);
+			}
+			continue;
+		}
+
+		if(nfiles == capacity)
+		{
+			const size_t new_capacity = (capacity == 0U ? 64U : capacity*2U);
+			value_file_t *const new_files = reallocarray(files, new_capacity,
+					sizeof(*files));
+			if(new_files == NULL)
+			{
+				break;
+			}
+			files = new_files;
+			capacity = new_capacity;
+		}
+
+		copy_str(files[nfiles].name, sizeof(files[nfiles].name), d->d_name);
+		files[nfiles].size = st.st_size;
+		files[nfiles].mtime = st.st_mtime;
+		total += st.st_size;
+		++nfiles;
+	}
+	os_closedir(dir);
+
+	if(total > cache->max_size)
+	{
+		qsort(files, nfiles, sizeof(*files), &mtime_cmp);
+
+		const uint64_t target = cache->max_size - cache->max_size/4U;
+		size_t i;
+		for(i = 0U; i < nfiles && total > target; ++i)
+		{
+			char path[PATH_MAX + 1];
+			snprintf(path, sizeof(path), "%s/%s", cache->dir, files[i].name);
+			if(unlink(path) == 0)
+			{
+				total -= files[i].size;
+			}
+		}
+	}
+
+	free(files);
+}
+
+/* Checks whether file name looks like a name of a file with a value.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_value_name(const char name[])
+{
+	return strlen(name) == NAME_LEN
+	    && strspn(name, "0123456789abcdef") == NAME_LEN;
+}
+
+/* Checks whether file name looks like a name of a temporary file produced by
+ * textcache_put().  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_tmp_name(const char name[])
+{
+	const size_t len = strlen(name);
+	return len > NAME_LEN + 1U
+	    && strspn(name, "0123456789abcdef") == NAME_LEN
+	    && name[NAME_LEN] == '.'
+	    && strspn(name + NAME_LEN + 1, "0123456789") == len - (NAME_LEN + 1U);
+}
+
+/* qsort() comparer that orders files from least to most recently used.
+ * Returns standard -1, 0, 1 for comparisons. */
+static int
+mtime_cmp(const void *a, const void *b)
+{
+	const value_file_t *const x = a;
+	const value_file_t *const y = b;
+	return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
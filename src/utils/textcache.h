@@ -0,0 +1,58 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__TEXTCACHE_H__
+#define VIFM__UTILS__TEXTCACHE_H__
+
+#include <stdint.h> /* uint64_t */
+
+/* Persistent cache of lines of text in a directory, which can be shared by
+ * several processes.  Each value is stored in a separate file named after hash
+ * of its key.  Total size of the files is kept within a budget by removing
+ * least recently used ones.
+ *
+ * All functions accept NULL cache, which behaves as an always empty one. */
+
+/* Opaque cache type. */
+typedef struct textcache_t textcache_t;
+
+struct strlist_t;
+
+/* Opens (or creates) the cache in the specified directory.  Max size is in
+ * bytes.  Returns the cache or NULL on error or if the cache is not supported
+ * on this system. */
+textcache_t * textcache_open(const char dir[], uint64_t max_size);
+
+/* Closes the cache.  cache can be NULL. */
+void textcache_close(textcache_t *cache);
+
+/* Retrieves lines stored under the key.  *complete is set to value passed to
+ * textcache_put().  Returns zero if they are found, otherwise non-zero is
+ * returned. */
+int textcache_get(textcache_t *cache, const char key[],
+		struct strlist_t *lines, int *complete);
+
+/* Stores lines under the key replacing previous value if any.  Drops least
+ * recently used values if the cache grew too large. */
+void textcache_put(textcache_t *cache, const char key[],
+		const struct strlist_t *lines, int complete);
+
+#endif /* VIFM__UTILS__TEXTCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
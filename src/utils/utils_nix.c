@@ -325,9 +325,8 @@ prepare_for_exec(void)
 	{
 		view_t *view = tab_info.view;
 		fswatch_free(view->watch);
-		fswatch_free(view->left_column.watch);
-		fswatch_free(view->right_column.watch);
 	}
+	flist_free_listing_watchers();
 }
 
 char *
@@ -20,9 +20,12 @@
 
 #include <fcntl.h> /* F_GETFL O_NONBLOCK fcntl() */
 
+#include <ctype.h> /* tolower() */
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* FILE */
-#include <stdlib.h> /* free() */
-#include <string.h> /* memmove() memset() strcmp() */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strcmp() strlen() */
 #include <time.h> /* time_t time() */
 
 #include "cfg/config.h"
@@ -31,30 +34,39 @@
 #include "ui/cancellation.h"
 #include "ui/quickview.h"
 #include "ui/ui.h"
-#include "utils/darray.h"
 #include "utils/file_streams.h"
 #include "utils/filemon.h"
+#include "utils/fpcache.h"
 #include "utils/fs.h"
 #include "utils/path.h"
 #include "utils/selector.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/textcache.h"
 #include "background.h"
 #include "filetype.h"
 #include "status.h"
 
+/* Import xxhash directly, it's used only by a couple of units. */
+#define XXH_PRIVATE_API
+#include "utils/xxhash.h"
+
 /* Maximum number of seconds to wait for data. */
 enum { MAX_RUN_TIME_S = 60 };
 
 /* Maximum number of seconds to wait for process to cancel. */
 enum { MAX_KILL_DELAY_S = 2 };
 
+/* Maximum number of viewers that are run speculatively at the same time. */
+enum { MAX_PREFETCH_JOBS = 2 };
+
 /* Cached output of a specific previewer for a specific file. */
 typedef struct vcache_entry_t
 {
 	char *path;        /* Full path to the file. */
 	char *viewer;      /* Viewer of the file. */
+	char *disk_key;    /* Key to store output on disk under or NULL. */
 	bg_job_t *job;     /* If not NULL, source of file contents. */
 	filemon_t filemon; /* Timestamp for the file. */
 	strlist_t lines;   /* Top lines of preview contents. */
@@ -62,25 +74,42 @@ typedef struct vcache_entry_t
 	time_t kill_timer; /* Since when we're waiting for the job to die or zero. */
 	size_t size;       /* Size taken up by this entry (lower bound). */
 	int max_lines;     /* Number of lines requested. */
+	uint64_t hash;     /* Hash of the path and the viewer. */
+
+	struct vcache_entry_t *prev;  /* Less recently used entry or NULL. */
+	struct vcache_entry_t *next;  /* More recently used entry or NULL. */
+	struct vcache_entry_t *chain; /* Next entry in the same bucket or NULL. */
 
 	/* Value of maxtreedepth for this entry. */
 	int max_tree_depth;
+	/* Round of prefetching in which this entry was last requested. */
+	unsigned int prefetch_round;
 	/* Whether cache contains complete output of the viewer. */
 	unsigned int complete : 1;
 	/* Whether last line is truncated. */
 	unsigned int truncated : 1;
 	/* Value of toptreestats for this entry. */
 	unsigned int top_tree_stats : 1;
+	/* Whether entry was populated speculatively and wasn't looked up since. */
+	unsigned int prefetched : 1;
 }
 vcache_entry_t;
 
 TSTATIC size_t vcache_entry_size(void);
 static void wait_async_finish(vcache_entry_t *centry);
-static vcache_entry_t * find_cache_entry(const char full_path[],
-		const char viewer[], int max_lines);
-static vcache_entry_t * alloc_cache_entry(void);
+static uint64_t hash_key(const char path[], const char viewer[]);
+static vcache_entry_t * find_cache_entry(uint64_t hash,
+		const char full_path[], const char viewer[]);
+static vcache_entry_t * alloc_cache_entry(uint64_t hash);
 static void compact_cache(void);
-static vcache_entry_t * new_cache_entry(void);
+static int count_prefetch_jobs(void);
+static vcache_entry_t * new_cache_entry(uint64_t hash);
+static void drop_cache_entry(vcache_entry_t *centry);
+static void lru_append(vcache_entry_t *centry);
+static void lru_unlink(vcache_entry_t *centry);
+static void map_insert(vcache_entry_t *centry);
+static void map_remove(vcache_entry_t *centry);
+static void map_grow(void);
 TSTATIC void vcache_reset(size_t max_size);
 static void free_cache_entry(vcache_entry_t *centry);
 static int is_cache_match(const vcache_entry_t *centry, const char path[],
@@ -90,6 +119,9 @@ static int is_cache_valid(const vcache_entry_t *centry, const char path[],
 static void update_cache_entry(vcache_entry_t *centry, const char path[],
 		const char viewer[], MacroFlags flags, int max_lines, const char **error);
 static void update_sizes(vcache_entry_t *centry);
+static int load_from_disk(vcache_entry_t *centry, MacroFlags flags);
+static void store_on_disk(vcache_entry_t *centry);
+static textcache_t * get_disk_cache(void);
 static int pull_async(vcache_entry_t *centry);
 static int read_async_output(vcache_entry_t *centry);
 static void cancel_job(vcache_entry_t *centry);
@@ -103,27 +135,40 @@ static strlist_t view_external(vcache_entry_t *centry, MacroFlags flags,
 		const char **error);
 TSTATIC strlist_t read_lines(FILE *fp, int max_lines, int *complete);
 
-/* Cache of viewers' output.  Ordered from least to most recently used. */
-static vcache_entry_t **cache;
-/* Declarations to enable use of DA_* on cache. */
-static DA_INSTANCE(cache);
+/* Least recently used entry of the cache or NULL.  Entries are linked from
+ * least to most recently used one. */
+static vcache_entry_t *lru_head;
+/* Most recently used entry of the cache or NULL. */
+static vcache_entry_t *lru_tail;
+/* Hash map of entries by path and viewer with chaining. */
+static vcache_entry_t **buckets;
+/* Number of buckets, which is either zero or a power of two. */
+static size_t nbuckets;
+/* Number of entries in the cache. */
+static size_t nentries;
 /* Amount of memory taken up by the cache (lower bound). */
 static size_t cache_size;
 /* Maximum size of the cache. */
 static size_t max_cache_size = 3U*1024*1024;
+/* Number of the current round of prefetching. */
+static unsigned int prefetch_round;
+/* Persistent cache of outputs of external viewers or NULL. */
+static textcache_t *disk_cache;
+/* Size of the persistent cache in MiB the cache was opened for. */
+static int disk_cache_size;
 
 void
 vcache_finish(void)
 {
-	size_t i;
-	for(i = 0U; i < DA_SIZE(cache); ++i)
+	vcache_entry_t *centry;
+	for(centry = lru_head; centry != NULL; centry = centry->next)
 	{
-		if(cache[i]->job != NULL)
+		if(centry->job != NULL)
 		{
-			bg_job_cancel(cache[i]->job);
-			bg_job_terminate(cache[i]->job);
-			bg_job_decref(cache[i]->job);
-			cache[i]->job = NULL;
+			bg_job_cancel(centry->job);
+			bg_job_terminate(centry->job);
+			bg_job_decref(centry->job);
+			centry->job = NULL;
 		}
 	}
 }
@@ -147,12 +192,12 @@ vcache_check(vcache_is_previewed_cb is_previewed)
 
 	/* TODO: consider doing this in a separate thread. */
 
-	size_t i;
-	for(i = 0U; i < DA_SIZE(cache); ++i)
+	vcache_entry_t *centry;
+	for(centry = lru_head; centry != NULL; centry = centry->next)
 	{
-		if(cache[i]->job != NULL)
+		if(centry->job != NULL)
 		{
-			changed |= (pull_async(cache[i]) && is_previewed(cache[i]->path));
+			changed |= (pull_async(centry) && is_previewed(centry->path));
 		}
 	}
 
@@ -182,15 +227,21 @@ vcache_lookup(const char full_path[], const char viewer[], MacroFlags flags,
 		return non_cache.lines;
 	}
 
-	vcache_entry_t *centry = find_cache_entry(full_path, viewer, max_lines);
-	if(centry != NULL && is_cache_valid(centry, full_path, viewer, max_lines))
+	const uint64_t hash = hash_key(full_path, viewer);
+	vcache_entry_t *centry = find_cache_entry(hash, full_path, viewer);
+	if(centry != NULL)
 	{
-		return centry->lines;
+		/* The entry is wanted now and is no longer subject to cancellation. */
+		centry->prefetched = 0;
+		if(is_cache_valid(centry, full_path, viewer, max_lines))
+		{
+			return centry->lines;
+		}
 	}
 
 	if(centry == NULL)
 	{
-		centry = alloc_cache_entry();
+		centry = alloc_cache_entry(hash);
 		if(centry == NULL)
 		{
 			*error = "Failed to allocate cache entry";
@@ -218,6 +269,78 @@ vcache_lookup(const char full_path[], const char viewer[], MacroFlags flags,
 	return centry->lines;
 }
 
+void
+vcache_prefetch_begin(void)
+{
+	++prefetch_round;
+}
+
+int
+vcache_prefetch(const char full_path[], const char viewer[], MacroFlags flags,
+		int max_lines)
+{
+	/* Only external viewers run in background, they also shouldn't depend on
+	 * state of the TUI. */
+	if(is_null_or_empty(viewer) || vlua_handler_cmd(curr_stats.vlua, viewer) ||
+			ma_flags_present(flags, MF_NO_CACHE) ||
+			ma_flags_present(flags, MF_KEEP_IN_FG) ||
+			ma_flags_present(flags, MF_PIPE_FILE_LIST) ||
+			ma_flags_present(flags, MF_PIPE_FILE_LIST_Z))
+	{
+		return 1;
+	}
+
+	const uint64_t hash = hash_key(full_path, viewer);
+	vcache_entry_t *centry = find_cache_entry(hash, full_path, viewer);
+	if(centry != NULL)
+	{
+		centry->prefetch_round = prefetch_round;
+		if(centry->job != NULL)
+		{
+			/* A job that's being killed will be restarted on the next round. */
+			return (centry->kill_timer != 0);
+		}
+		if(is_cache_valid(centry, full_path, viewer, max_lines))
+		{
+			return 0;
+		}
+	}
+
+	if(count_prefetch_jobs() >= MAX_PREFETCH_JOBS)
+	{
+		return 1;
+	}
+
+	if(centry == NULL)
+	{
+		centry = alloc_cache_entry(hash);
+		if(centry == NULL)
+		{
+			return 1;
+		}
+		centry->prefetch_round = prefetch_round;
+	}
+
+	const char *error = NULL;
+	update_cache_entry(centry, full_path, viewer, flags, max_lines, &error);
+	centry->prefetched = 1;
+	return (error != NULL);
+}
+
+void
+vcache_prefetch_end(void)
+{
+	vcache_entry_t *centry;
+	for(centry = lru_head; centry != NULL; centry = centry->next)
+	{
+		if(centry->prefetched && centry->job != NULL &&
+				centry->kill_timer == 0 && centry->prefetch_round != prefetch_round)
+		{
+			cancel_job(centry);
+		}
+	}
+}
+
 /* Waits for asynchronous job to be done. */
 static void
 wait_async_finish(vcache_entry_t *centry)
@@ -258,34 +381,73 @@ wait_async_finish(vcache_entry_t *centry)
 		/* Reading is performed in conditional expression. */
 	}
 
-	if(ui_cancellation_requested())
+	const int cancelled = ui_cancellation_requested();
+	if(cancelled)
 	{
 		centry->lines.nitems = add_to_string_array(&centry->lines.items,
 				centry->lines.nitems, "[cancelled]");
 	}
 	ui_cancellation_pop();
 
+	centry->complete = !cancelled
+	                && (centry->kill_timer == 0 || !bg_job_was_killed(job));
 	bg_job_decref(centry->job);
 	centry->job = NULL;
+
+	if(cancelled)
+	{
+		/* Output isn't what the viewer produces. */
+		update_string(&centry->disk_key, NULL);
+	}
+	else
+	{
+		store_on_disk(centry);
+	}
 }
 
-/* Looks up existing cache entry that matches specified set of parameters.
- * Returns the entry or NULL. */
-static vcache_entry_t *
-find_cache_entry(const char full_path[], const char viewer[], int max_lines)
+/* Computes hash of the key of a cache entry in a way that's consistent with
+ * is_cache_match().  Returns the hash. */
+static uint64_t
+hash_key(const char path[], const char viewer[])
 {
-	size_t i;
-	for(i = 0U; i < DA_SIZE(cache); ++i)
+	/* Some additional space is allocated for adding slashes. */
+	char canonic[strlen(path) + 8];
+	canonicalize_path(path, canonic, sizeof(canonic));
+#ifdef _WIN32
+	/* Paths are compared ignoring case on Windows. */
+	char *p;
+	for(p = canonic; *p != '\0'; ++p)
 	{
-		if(is_cache_match(cache[i], full_path, viewer))
-		{
-			vcache_entry_t *centry = cache[i];
+		*p = tolower((unsigned char)*p);
+	}
+#endif
 
-			/* Make the most recently used entry the last one. */
-			memmove(cache + i, cache + i + 1,
-					sizeof(*cache)*(DA_SIZE(cache) - 1U - i));
-			cache[DA_SIZE(cache) - 1U] = centry;
+	const uint64_t hash = XXH3_64bits(canonic, strlen(canonic));
+	if(viewer == NULL)
+	{
+		return hash;
+	}
+	return XXH3_64bits_withSeed(viewer, strlen(viewer), hash + 1U);
+}
 
+/* Looks up existing cache entry that matches specified set of parameters and
+ * marks it as the most recently used one.  Returns the entry or NULL. */
+static vcache_entry_t *
+find_cache_entry(uint64_t hash, const char full_path[], const char viewer[])
+{
+	if(nbuckets == 0U)
+	{
+		return NULL;
+	}
+
+	vcache_entry_t *centry;
+	for(centry = buckets[hash & (nbuckets - 1U)]; centry != NULL;
+			centry = centry->chain)
+	{
+		if(centry->hash == hash && is_cache_match(centry, full_path, viewer))
+		{
+			lru_unlink(centry);
+			lru_append(centry);
 			return centry;
 		}
 	}
@@ -293,9 +455,9 @@ find_cache_entry(const char full_path[], const char viewer[], int max_lines)
 }
 
 /* Allocates a zero-initialized cache entry.  When cache size limit is reached
- * older cache entries are reused.  Returns the entry or NULL. */
+ * older cache entries are dropped.  Returns the entry or NULL. */
 static vcache_entry_t *
-alloc_cache_entry(void)
+alloc_cache_entry(uint64_t hash)
 {
 	if(max_cache_size == 0U)
 	{
@@ -303,71 +465,213 @@ alloc_cache_entry(void)
 	}
 
 	compact_cache();
-	return new_cache_entry();
+	return new_cache_entry(hash);
 }
 
-/* Shrinks cache if its size is larger than the limit. */
+/* Shrinks cache if its size is larger than the limit by dropping least
+ * recently used entries. */
 static void
 compact_cache(void)
 {
-	if(cache == NULL)
-	{
-		return;
-	}
-
-	size_t i;
-	size_t j = 0U;
-	for(i = 0U; i < DA_SIZE(cache) && cache_size >= max_cache_size; ++i)
+	vcache_entry_t *centry = lru_head;
+	while(centry != NULL && cache_size >= max_cache_size)
 	{
-		vcache_entry_t *centry = cache[i];
+		vcache_entry_t *const next = centry->next;
 		if(centry->job != NULL)
 		{
-			cache[j++] = centry;
 			/* Give it a chance to finish gracefully. */
 			cancel_job(centry);
-			continue;
 		}
+		else
+		{
+			drop_cache_entry(centry);
+		}
+		centry = next;
+	}
+}
 
-		cache_size -= centry->size;
-		free_cache_entry(centry);
-		free(centry);
+/* Counts speculatively started viewers that are still running.  Returns the
+ * number. */
+static int
+count_prefetch_jobs(void)
+{
+	int count = 0;
+
+	vcache_entry_t *centry;
+	for(centry = lru_head; centry != NULL; centry = centry->next)
+	{
+		count += (centry->prefetched && centry->job != NULL);
 	}
 
-	memmove(cache + j, cache + i, sizeof(*cache)*(DA_SIZE(cache) - i));
-	DA_REMOVE_AFTER(cache, cache + j + DA_SIZE(cache) - i);
+	return count;
 }
 
 /* Allocates a new cache entry unconditionally.  Returns the entry. */
 static vcache_entry_t *
-new_cache_entry(void)
+new_cache_entry(uint64_t hash)
 {
-	vcache_entry_t **centry = DA_EXTEND(cache);
+	vcache_entry_t *const centry = calloc(1, sizeof(*centry));
 	if(centry == NULL)
 	{
 		return NULL;
 	}
 
-	*centry = calloc(1, sizeof(**centry));
-	if(*centry == NULL)
+	centry->hash = hash;
+	/* Growing the map walks LRU list, so add entry to the map first to not
+	 * process it twice. */
+	map_insert(centry);
+	lru_append(centry);
+	++nentries;
+	return centry;
+}
+
+/* Removes entry from the cache and frees it. */
+static void
+drop_cache_entry(vcache_entry_t *centry)
+{
+	lru_unlink(centry);
+	map_remove(centry);
+	--nentries;
+
+	cache_size -= centry->size;
+	free_cache_entry(centry);
+	free(centry);
+}
+
+/* Makes the entry the most recently used one. */
+static void
+lru_append(vcache_entry_t *centry)
+{
+	centry->prev = lru_tail;
+	centry->next = NULL;
+	if(lru_tail != NULL)
 	{
-		return NULL;
+		lru_tail->next = centry;
+	}
+	else
+	{
+		lru_head = centry;
+	}
+	lru_tail = centry;
+}
+
+/* Excludes the entry from the list of entries ordered by use. */
+static void
+lru_unlink(vcache_entry_t *centry)
+{
+	if(centry->prev != NULL)
+	{
+		centry->prev->next = centry->next;
+	}
+	else
+	{
+		lru_head = centry->next;
+	}
+
+	if(centry->next != NULL)
+	{
+		centry->next->prev = centry->prev;
+	}
+	else
+	{
+		lru_tail = centry->prev;
 	}
 
-	DA_COMMIT(cache);
-	return *centry;
+	centry->prev = NULL;
+	centry->next = NULL;
+}
+
+/* Adds the entry to the hash map growing the map if necessary. */
+static void
+map_insert(vcache_entry_t *centry)
+{
+	if(nentries >= nbuckets)
+	{
+		map_grow();
+	}
+
+	/* Entries are reachable via LRU list even if the map couldn't be
+	 * allocated. */
+	if(nbuckets != 0U)
+	{
+		vcache_entry_t **const bucket = &buckets[centry->hash & (nbuckets - 1U)];
+		centry->chain = *bucket;
+		*bucket = centry;
+	}
+}
+
+/* Removes the entry from the hash map. */
+static void
+map_remove(vcache_entry_t *centry)
+{
+	if(nbuckets == 0U)
+	{
+		return;
+	}
+
+	vcache_entry_t **link = &buckets[centry->hash & (nbuckets - 1U)];
+	while(*link != NULL && *link != centry)
+	{
+		link = &(*link)->chain;
+	}
+
+	if(*link != NULL)
+	{
+		*link = centry->chain;
+		centry->chain = NULL;
+	}
+}
+
+/* Doubles number of buckets and redistributes entries among them.  Leaves the
+ * map intact on failure. */
+static void
+map_grow(void)
+{
+	const size_t new_nbuckets = (nbuckets == 0U ? 64U : nbuckets*2U);
+	vcache_entry_t **const new_buckets = calloc(new_nbuckets,
+			sizeof(*new_buckets));
+	if(new_buckets == NULL)
+	{
+		return;
+	}
+
+	vcache_entry_t *centry;
+	for(centry = lru_head; centry != NULL; centry = centry->next)
+	{
+		vcache_entry_t **const bucket =
+			&new_buckets[centry->hash & (new_nbuckets - 1U)];
+		centry->chain = *bucket;
+		*bucket = centry;
+	}
+
+	free(buckets);
+	buckets = new_buckets;
+	nbuckets = new_nbuckets;
 }
 
 /* Invalidates all cache entries and changes size limit. */
 TSTATIC void
 vcache_reset(size_t max_size)
 {
-	size_t i;
-	for(i = 0U; i < DA_SIZE(cache); ++i)
+	vcache_entry_t *centry = lru_head;
+	while(centry != NULL)
 	{
-		free_cache_entry(cache[i]);
-		free(cache[i]);
+		vcache_entry_t *const next = centry->next;
+		free_cache_entry(centry);
+		free(centry);
+		centry = next;
 	}
-	DA_REMOVE_ALL(cache);
+	lru_head = NULL;
+	lru_tail = NULL;
+
+	free(buckets);
+	buckets = NULL;
+	nbuckets = 0U;
+	nentries = 0U;
+
+	textcache_close(disk_cache);
+	disk_cache = NULL;
+	disk_cache_size = 0;
 
 	max_cache_size = max_size;
 	cache_size = 0;
@@ -379,6 +683,7 @@ free_cache_entry(vcache_entry_t *centry)
 {
 	update_string(&centry->path, NULL);
 	update_string(&centry->viewer, NULL);
+	update_string(&centry->disk_key, NULL);
 
 	free_string_array(centry->lines.items, centry->lines.nitems);
 	centry->lines.items = NULL;
@@ -451,7 +756,10 @@ update_cache_entry(vcache_entry_t *centry, const char path[],
 	if(centry->job == NULL)
 	{
 		free_string_array(centry->lines.items, centry->lines.nitems);
-		centry->lines = view_entry(centry, flags, error);
+		if(!load_from_disk(centry, flags))
+		{
+			centry->lines = view_entry(centry, flags, error);
+		}
 
 		update_sizes(centry);
 	}
@@ -479,6 +787,104 @@ update_sizes(vcache_entry_t *centry)
 	cache_size += centry->size;
 }
 
+/* Tries to fill the entry with output of its external viewer saved by this or
+ * some other instance.  Remembers key for storing output otherwise.  Returns
+ * non-zero on success, otherwise zero is returned. */
+static int
+load_from_disk(vcache_entry_t *centry, MacroFlags flags)
+{
+	update_string(&centry->disk_key, NULL);
+
+	/* Output of builtin and Lua viewers isn't worth storing, list of files is
+	 * passed to the viewer from the outside of the key. */
+	textcache_t *const cache = get_disk_cache();
+	if(cache == NULL || is_null_or_empty(centry->viewer) ||
+			vlua_handler_cmd(curr_stats.vlua, centry->viewer) ||
+			ma_flags_present(flags, MF_PIPE_FILE_LIST) ||
+			ma_flags_present(flags, MF_PIPE_FILE_LIST_Z))
+	{
+		return 0;
+	}
+
+	fpcache_key_t key;
+	if(fpcache_key_of(centry->path, &key) != 0)
+	{
+		return 0;
+	}
+
+	centry->disk_key = format_str("%s\n%s\n%llu:%llu:%llu:%lld.%lu",
+			centry->viewer, centry->path, (unsigned long long)key.dev,
+			(unsigned long long)key.inode, (unsigned long long)key.size,
+			(long long)key.mtime_sec, (unsigned long)key.mtime_nsec);
+	if(centry->disk_key == NULL)
+	{
+		return 0;
+	}
+
+	strlist_t lines;
+	int complete;
+	if(textcache_get(cache, centry->disk_key, &lines, &complete) != 0)
+	{
+		return 0;
+	}
+
+	if(!complete && lines.nitems < centry->max_lines)
+	{
+		free_string_array(lines.items, lines.nitems);
+		return 0;
+	}
+
+	centry->lines = lines;
+	centry->complete = complete;
+	centry->truncated = 0;
+	update_string(&centry->disk_key, NULL);
+	return 1;
+}
+
+/* Saves output of a finished viewer if it's complete or has enough lines. */
+static void
+store_on_disk(vcache_entry_t *centry)
+{
+	if(centry->disk_key == NULL)
+	{
+		return;
+	}
+
+	if(centry->complete || !need_more_async_output(centry))
+	{
+		strlist_t lines = centry->lines;
+		if(!centry->complete && lines.nitems > centry->max_lines)
+		{
+			/* Drop partial line past the limit. */
+			lines.nitems = centry->max_lines;
+		}
+		textcache_put(get_disk_cache(), centry->disk_key, &lines,
+				centry->complete);
+	}
+
+	update_string(&centry->disk_key, NULL);
+}
+
+/* Opens or reopens persistent cache if its size has changed.  Returns the
+ * cache or NULL if it's disabled or unavailable. */
+static textcache_t *
+get_disk_cache(void)
+{
+	if(disk_cache_size != cfg.preview_disk_cache)
+	{
+		textcache_close(disk_cache);
+		disk_cache = NULL;
+
+		disk_cache_size = cfg.preview_disk_cache;
+		if(disk_cache_size > 0 && cfg.vcache_dir[0] != '\0')
+		{
+			disk_cache = textcache_open(cfg.vcache_dir,
+					(uint64_t)disk_cache_size*1024U*1024U);
+		}
+	}
+	return disk_cache;
+}
+
 /* Updates single entry backed by an asynchronous job.  Returns non-zero if
  * entry was updated, otherwise zero is returned. */
 static int
@@ -520,6 +926,8 @@ pull_async(vcache_entry_t *centry)
 		bg_job_decref(centry->job);
 		centry->job = NULL;
 		changed = 1;
+
+		store_on_disk(centry);
 	}
 
 	return changed;
@@ -61,6 +61,22 @@ struct strlist_t vcache_lookup(const char full_path[], const char viewer[],
 		MacroFlags flags, ViewerKind kind, int max_lines, int sync,
 		const char **error);
 
+/* Starts new round of prefetching.  Should be followed by a number of
+ * vcache_prefetch() calls and a vcache_prefetch_end() call. */
+void vcache_prefetch_begin(void);
+
+/* Starts an asynchronous viewer for the file in advance unless its output is
+ * already cached or being produced.  Does nothing for viewers that can't be
+ * run in background and when too many viewers are already run this way.
+ * Returns zero if preview is cached or is being made, otherwise non-zero is
+ * returned. */
+int vcache_prefetch(const char full_path[], const char viewer[],
+		MacroFlags flags, int max_lines);
+
+/* Ends a round of prefetching by cancelling viewers that were started in
+ * advance for files that weren't requested during this round. */
+void vcache_prefetch_end(void);
+
 TSTATIC_DEFS(
 	struct strlist_t read_lines(FILE *fp, int max_lines, int *complete);
 	void vcache_reset(size_t max_size);
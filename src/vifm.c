@@ -83,6 +83,7 @@
 #include "flist_pos.h"
 #include "fops_common.h"
 #include "ipc.h"
+#include "locate_index.h"
 #include "marks.h"
 #include "ops.h"
 #include "opt_handlers.h"
@@ -677,6 +678,7 @@ void _gnuc_noreturn
 vifm_exit(int exit_code)
 {
 	vcache_finish();
+	locidx_finish();
 	plugs_free(curr_stats.plugs);
 	vlua_finish(curr_stats.vlua);
 	ipc_free(curr_stats.ipc);
@@ -81,5 +81,15 @@ TEST(add_duplicate_columns_ok)
 	columns_add_column(columns, column_info);
 }
 
+TEST(presence_of_columns_is_checked)
+{
+	assert_true(columns_has_column(columns, COL1_ID));
+	assert_true(columns_has_column(columns, COL2_ID));
+
+	columns_clear(columns);
+	assert_false(columns_has_column(columns, COL1_ID));
+	assert_false(columns_has_column(columns, COL2_ID));
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -430,6 +430,7 @@ TEST(compare_is_completed)
 {
 	ASSERT_COMPLETION(L"compare by", L"compare bycontents");
 	ASSERT_COMPLETION(L"compare bysize list", L"compare bysize listall");
+	ASSERT_COMPLETION(L"compare withb", L"compare withbytecmp");
 }
 
 TEST(symlinks_in_paths_are_not_resolved, IF(not_windows))
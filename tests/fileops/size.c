@@ -11,6 +11,7 @@
 #include "../../src/cfg/config.h"
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
+#include "../../src/utils/cancellation.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/fs.h"
 #include "../../src/filelist.h"
@@ -132,6 +133,35 @@ TEST(symlinks_to_dirs, IF(not_windows))
 	assert_success(rmdir(SANDBOX_PATH "/dir"));
 }
 
+TEST(nested_directories_are_summed_up_and_cached, IF(not_windows))
+{
+	create_dir(SANDBOX_PATH "/dir");
+	create_dir(SANDBOX_PATH "/dir/a");
+	create_dir(SANDBOX_PATH "/dir/a/b");
+	create_dir(SANDBOX_PATH "/dir/c");
+	make_file(SANDBOX_PATH "/dir/file", "1");
+	make_file(SANDBOX_PATH "/dir/a/file", "12");
+	make_file(SANDBOX_PATH "/dir/a/b/file", "123");
+	make_file(SANDBOX_PATH "/dir/c/file", "1234");
+
+	assert_ulong_equal(10, fops_dir_size(SANDBOX_PATH "/dir", 0,
+				&no_cancellation));
+
+	assert_int_equal(10, wait_for_size(SANDBOX_PATH "/dir"));
+	assert_int_equal(5, wait_for_size(SANDBOX_PATH "/dir/a"));
+	assert_int_equal(3, wait_for_size(SANDBOX_PATH "/dir/a/b"));
+	assert_int_equal(4, wait_for_size(SANDBOX_PATH "/dir/c"));
+
+	remove_file(SANDBOX_PATH "/dir/file");
+	remove_file(SANDBOX_PATH "/dir/a/file");
+	remove_file(SANDBOX_PATH "/dir/a/b/file");
+	remove_file(SANDBOX_PATH "/dir/c/file");
+	remove_dir(SANDBOX_PATH "/dir/a/b");
+	remove_dir(SANDBOX_PATH "/dir/a");
+	remove_dir(SANDBOX_PATH "/dir/c");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
 static void
 setup_single_entry(view_t *view, const char name[])
 {
@@ -110,6 +110,39 @@ TEST(multiple_viewers)
 	free_string_array(viewers.items, viewers.nitems);
 }
 
+TEST(order_of_viewers_does_not_depend_on_kind_of_pattern)
+{
+	set_viewers("*.TGZ", "prog1 a");
+	set_viewers("/\\.tgz$/", "prog1 b");
+	set_viewers("Archive.tgz", "prog1 c");
+	set_viewers("*.zip,*.tgz", "prog1 d");
+	set_viewers("arch*", "prog1 e");
+	set_viewers("*.tgz,Archive.tgz", "prog1 f");
+	set_viewers("*.gz", "prog1 g");
+	set_viewers("{*.tgz}{other.tgz}", "prog1 h");
+
+	ft_init(&prog1_available);
+
+	strlist_t viewers = ft_get_viewers("/some/path/archive.tgz");
+	assert_int_equal(6, viewers.nitems);
+	assert_string_equal("prog1 a", viewers.items[0]);
+	assert_string_equal("prog1 b", viewers.items[1]);
+	assert_string_equal("prog1 c", viewers.items[2]);
+	assert_string_equal("prog1 d", viewers.items[3]);
+	assert_string_equal("prog1 e", viewers.items[4]);
+	assert_string_equal("prog1 f", viewers.items[5]);
+	free_string_array(viewers.items, viewers.nitems);
+
+	viewers = ft_get_viewers("other.tgz");
+	assert_int_equal(5, viewers.nitems);
+	assert_string_equal("prog1 h", viewers.items[4]);
+	free_string_array(viewers.items, viewers.nitems);
+
+	assert_string_equal("prog1 e", ft_get_viewer("arch"));
+	assert_string_equal("prog1 g", ft_get_viewer("x.gz"));
+	assert_string_equal("prog1 b", ft_get_viewer(".tgz"));
+}
+
 TEST(pattern_list, IF(has_mime_type_detection))
 {
 	char cmd[1024];
@@ -176,6 +176,24 @@ file_is_copied(const char original[])
 	delete_test_file(SANDBOX_PATH "/copy");
 }
 
+TEST(file_is_copied_with_cloning_and_syncing)
+{
+	io_args_t args = {
+		.arg1.src = TEST_DATA_PATH "/various-sizes/double-block-size-plus-one-file",
+		.arg2.dst = SANDBOX_PATH "/copy",
+		.arg4.fast_file_cloning = 1,
+		.arg4.data_sync = 1,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_true(files_are_identical(SANDBOX_PATH "/copy", args.arg1.src));
+
+	delete_test_file(SANDBOX_PATH "/copy");
+}
+
 TEST(appending_works_for_files)
 {
 	uint64_t size;
@@ -442,6 +460,30 @@ TEST(overwrite_removal_handles_errors, IF(regular_unix_user))
 /* Windows lacks definitions of some declarations. */
 #ifndef _WIN32
 
+static int
+has_proc_fs(void)
+{
+	return (get_file_size("/proc/self/status") == 0U &&
+	        path_exists("/proc/self/status", DEREF));
+}
+
+/* Files of /proc report zero size, but do have contents. */
+TEST(file_with_wrong_size_is_copied, IF(has_proc_fs))
+{
+	io_args_t args = {
+		.arg1.src = "/proc/self/status",
+		.arg2.dst = SANDBOX_PATH "/status",
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_int_equal(IO_RES_SUCCEEDED, iop_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+
+	assert_true(get_file_size(SANDBOX_PATH "/status") > 0U);
+
+	delete_test_file(SANDBOX_PATH "/status");
+}
+
 /* No named fifo in file systems on Windows. */
 TEST(fifo_is_copied, IF(not_windows))
 {
@@ -18,8 +18,13 @@
 #include "../../src/utils/str.h"
 #include "../../src/cmd_core.h"
 #include "../../src/cmd_handlers.h"
+#include "../../src/filelist.h"
+
+static void make_builtin_sandbox(void);
+static void remove_builtin_sandbox(void);
 
 static char test_data[PATH_MAX + 1];
+static char sandbox[PATH_MAX + 1];
 
 SETUP_ONCE()
 {
@@ -27,6 +32,7 @@ SETUP_ONCE()
 	assert_non_null(get_cwd(cwd, sizeof(cwd)));
 
 	make_abs_path(test_data, sizeof(test_data), TEST_DATA_PATH, "", cwd);
+	make_abs_path(sandbox, sizeof(sandbox), SANDBOX_PATH, "", cwd);
 }
 
 SETUP()
@@ -123,5 +129,126 @@ TEST(p_macro_works, IF(not_windows))
 	assert_failure(cmds_dispatch("find a$NO_SUCH_VAR", &lwin, CIT_COMMAND));
 }
 
+TEST(builtin_find_matches_names, IF(not_windows))
+{
+	make_builtin_sandbox();
+
+	assert_success(cmds_dispatch("find a", &lwin, CIT_COMMAND));
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("Find a", lwin.custom.title);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("a", lwin.dir_entry[1].name);
+
+	assert_success(cmds_dispatch("find /^[ab]$/", &lwin, CIT_COMMAND));
+	assert_int_equal(3, lwin.list_rows);
+
+	remove_builtin_sandbox();
+}
+
+TEST(builtin_find_accepts_path, IF(not_windows))
+{
+	make_builtin_sandbox();
+
+	assert_success(cmds_dispatch("find dir *", &lwin, CIT_COMMAND));
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("Find dir *", lwin.custom.title);
+
+	remove_builtin_sandbox();
+}
+
+TEST(builtin_find_accepts_path_with_spaces, IF(not_windows))
+{
+	make_builtin_sandbox();
+	create_dir(SANDBOX_PATH "/dir name");
+	create_file(SANDBOX_PATH "/dir name/file");
+
+	assert_success(cmds_dispatch("find dir\\ name *", &lwin, CIT_COMMAND));
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("file", lwin.dir_entry[0].name);
+
+	assert_success(cmds_dispatch("find \"dir name\" *", &lwin, CIT_COMMAND));
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("file", lwin.dir_entry[0].name);
+
+	remove_file(SANDBOX_PATH "/dir name/file");
+	remove_dir(SANDBOX_PATH "/dir name");
+	remove_builtin_sandbox();
+}
+
+TEST(builtin_find_respects_dot_files_and_filters, IF(not_windows))
+{
+	make_builtin_sandbox();
+
+	lwin.hide_dot = 0;
+	assert_success(replace_matcher(&lwin.manual_filter, "^dir/$"));
+
+	assert_success(cmds_dispatch("find a", &lwin, CIT_COMMAND));
+	assert_int_equal(1, lwin.list_rows);
+
+	assert_success(cmds_dispatch("find .a", &lwin, CIT_COMMAND));
+	assert_int_equal(1, lwin.list_rows);
+
+	remove_builtin_sandbox();
+}
+
+TEST(builtin_find_searches_in_selection, IF(not_windows))
+{
+	make_builtin_sandbox();
+
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("dir", lwin.dir_entry[0].name);
+	lwin.dir_entry[0].selected = 1;
+	lwin.selected_files = 1;
+
+	assert_success(cmds_dispatch("find a", &lwin, CIT_COMMAND));
+	assert_int_equal(1, lwin.list_rows);
+
+	char dir[PATH_MAX + 1];
+	snprintf(dir, sizeof(dir), "%s/dir", sandbox);
+	assert_true(paths_are_equal(lwin.dir_entry[0].origin, dir));
+
+	remove_builtin_sandbox();
+}
+
+TEST(builtin_find_reports_no_matches_and_bad_patterns, IF(not_windows))
+{
+	make_builtin_sandbox();
+
+	assert_failure(cmds_dispatch("find nothing", &lwin, CIT_COMMAND));
+	assert_false(flist_custom_active(&lwin));
+
+	assert_success(cmds_dispatch("find /(/", &lwin, CIT_COMMAND));
+	assert_false(flist_custom_active(&lwin));
+
+	remove_builtin_sandbox();
+}
+
+static void
+make_builtin_sandbox(void)
+{
+	assert_success(cmds_dispatch("set findprg=", &lwin, CIT_COMMAND));
+
+	assert_success(chdir(SANDBOX_PATH));
+	strcpy(lwin.curr_dir, sandbox);
+	lwin.hide_dot = 1;
+
+	create_file(SANDBOX_PATH "/a");
+	create_file(SANDBOX_PATH "/.a");
+	create_dir(SANDBOX_PATH "/dir");
+	create_file(SANDBOX_PATH "/dir/a");
+	create_file(SANDBOX_PATH "/dir/b");
+}
+
+static void
+remove_builtin_sandbox(void)
+{
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/.a");
+	remove_file(SANDBOX_PATH "/dir/a");
+	remove_file(SANDBOX_PATH "/dir/b");
+	remove_dir(SANDBOX_PATH "/dir");
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
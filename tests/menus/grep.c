@@ -0,0 +1,149 @@
+#include <stic.h>
+
+#include <unistd.h> /* chdir() */
+
+#include <stdio.h> /* FILE fclose() fopen() fwrite() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/engine/keys.h"
+#include "../../src/engine/mode.h"
+#include "../../src/modes/menu.h"
+#include "../../src/modes/modes.h"
+#include "../../src/modes/wk.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/cmd_core.h"
+
+static char sandbox[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+
+	make_abs_path(sandbox, sizeof(sandbox), SANDBOX_PATH, "", cwd);
+}
+
+SETUP()
+{
+	modes_init();
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	opt_handlers_setup();
+
+	cmds_init();
+
+	curr_stats.load_stage = -1;
+
+	assert_success(cmds_dispatch("set grepprg=", &lwin, CIT_COMMAND));
+
+	assert_success(chdir(SANDBOX_PATH));
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), sandbox);
+	lwin.hide_dot = 1;
+
+	make_file(SANDBOX_PATH "/a", "x\nfoo\nbar foo");
+	create_dir(SANDBOX_PATH "/dir");
+	make_file(SANDBOX_PATH "/dir/b", "foo\n");
+	make_file(SANDBOX_PATH "/.hidden", "foo\n");
+}
+
+TEARDOWN()
+{
+	(void)vle_keys_exec(WK_ESC);
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/dir/b");
+	remove_dir(SANDBOX_PATH "/dir");
+	remove_file(SANDBOX_PATH "/.hidden");
+
+	opt_handlers_teardown();
+
+	vle_cmds_reset();
+	vle_keys_reset();
+
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	curr_stats.load_stage = 0;
+}
+
+TEST(builtin_grep_finds_lines, IF(not_windows))
+{
+	assert_success(cmds_dispatch("grep foo", &lwin, CIT_COMMAND));
+
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(3, m->len);
+	assert_string_equal("a:2:foo", m->items[0]);
+	assert_string_equal("a:3:bar foo", m->items[1]);
+	assert_string_equal("dir/b:1:foo", m->items[2]);
+}
+
+TEST(builtin_grep_inverts_regexp_matches, IF(not_windows))
+{
+	assert_success(cmds_dispatch("grep! ^f.o$", &lwin, CIT_COMMAND));
+
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(2, m->len);
+	assert_string_equal("a:1:x", m->items[0]);
+	assert_string_equal("a:3:bar foo", m->items[1]);
+}
+
+TEST(builtin_grep_respects_dot_files_and_filters, IF(not_windows))
+{
+	lwin.hide_dot = 0;
+	assert_success(replace_matcher(&lwin.manual_filter, "^dir/$"));
+
+	assert_success(cmds_dispatch("grep foo", &lwin, CIT_COMMAND));
+
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(3, m->len);
+	assert_string_equal(".hidden:1:foo", m->items[0]);
+	assert_string_equal("a:2:foo", m->items[1]);
+	assert_string_equal("a:3:bar foo", m->items[2]);
+}
+
+TEST(builtin_grep_skips_binary_files, IF(not_windows))
+{
+	FILE *const fp = fopen(SANDBOX_PATH "/bin", "wb");
+	assert_non_null(fp);
+	assert_int_equal(8, fwrite("foo\n\0bin", 1, 8, fp));
+	fclose(fp);
+
+	assert_success(cmds_dispatch("grep foo", &lwin, CIT_COMMAND));
+
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(3, m->len);
+	assert_string_equal("dir/b:1:foo", m->items[2]);
+
+	remove_file(SANDBOX_PATH "/bin");
+}
+
+TEST(builtin_grep_expands_tabs, IF(not_windows))
+{
+	cfg.tab_stop = 8;
+	make_file(SANDBOX_PATH "/dir/b", "\tfoo\n");
+
+	assert_success(cmds_dispatch("grep foo", &lwin, CIT_COMMAND));
+
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(3, m->len);
+	assert_string_equal("dir/b:1:        foo", m->items[2]);
+}
+
+TEST(builtin_grep_reports_bad_pattern, IF(not_windows))
+{
+	assert_success(cmds_dispatch("grep (", &lwin, CIT_COMMAND));
+	assert_true(vle_mode_is(NORMAL_MODE));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -0,0 +1,130 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include <stdio.h> /* snprintf() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/engine/keys.h"
+#include "../../src/engine/mode.h"
+#include "../../src/modes/menu.h"
+#include "../../src/modes/modes.h"
+#include "../../src/modes/wk.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/cmd_core.h"
+#include "../../src/locate_index.h"
+
+static char root[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+
+	make_abs_path(root, sizeof(root), SANDBOX_PATH, "root", cwd);
+}
+
+SETUP()
+{
+	modes_init();
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	opt_handlers_setup();
+
+	cmds_init();
+
+	curr_stats.load_stage = -1;
+
+	char cmd[PATH_MAX + 32];
+	snprintf(cmd, sizeof(cmd), "set locateprg= locateroots=%s", root);
+	assert_success(cmds_dispatch(cmd, &lwin, CIT_COMMAND));
+	copy_str(cfg.locate_index_file, sizeof(cfg.locate_index_file),
+			SANDBOX_PATH "/index");
+
+	create_dir(SANDBOX_PATH "/root");
+	create_file(SANDBOX_PATH "/root/alpha");
+	create_dir(SANDBOX_PATH "/root/dir");
+	create_file(SANDBOX_PATH "/root/dir/beta");
+}
+
+TEARDOWN()
+{
+	(void)vle_keys_exec(WK_ESC);
+
+	locidx_finish();
+	cfg.locate_index_file[0] = '\0';
+
+	remove_dir_content(SANDBOX_PATH "/root");
+	remove_dir(SANDBOX_PATH "/root");
+	(void)unlink(SANDBOX_PATH "/index");
+
+	opt_handlers_teardown();
+
+	vle_cmds_reset();
+	vle_keys_reset();
+
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	curr_stats.load_stage = 0;
+}
+
+TEST(builtin_locate_lists_matches)
+{
+	assert_success(cmds_dispatch("locate beta", &lwin, CIT_COMMAND));
+
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(1, m->len);
+	assert_true(ends_with(m->items[0], "/root/dir/beta"));
+	assert_string_equal("Locate beta", m->title);
+}
+
+TEST(builtin_locate_supports_globs)
+{
+	assert_success(cmds_dispatch("locate */root/*a", &lwin, CIT_COMMAND));
+
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(2, m->len);
+}
+
+TEST(index_is_stored_and_updated)
+{
+	assert_success(cmds_dispatch("locate beta", &lwin, CIT_COMMAND));
+	(void)vle_keys_exec(WK_ESC);
+	assert_true(path_exists(SANDBOX_PATH "/index", NODEREF));
+
+	/* Index is read back from disk and doesn't know about the new file. */
+	locidx_finish();
+	create_file(SANDBOX_PATH "/root/dir/new");
+	assert_failure(cmds_dispatch("locate new", &lwin, CIT_COMMAND));
+	assert_true(vle_mode_is(NORMAL_MODE));
+
+	char dir[PATH_MAX + 1];
+	snprintf(dir, sizeof(dir), "%s/dir", root);
+	locidx_dir_changed(dir);
+
+	assert_success(cmds_dispatch("locate new", &lwin, CIT_COMMAND));
+	const menu_data_t *const m = menu_get_current();
+	assert_int_equal(1, m->len);
+}
+
+TEST(relative_roots_are_rejected)
+{
+	assert_success(cmds_dispatch("set locateroots=relative", &lwin,
+				CIT_COMMAND));
+	assert_success(cmds_dispatch("locate beta", &lwin, CIT_COMMAND));
+	assert_true(vle_mode_is(NORMAL_MODE));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
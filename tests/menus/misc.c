@@ -1,13 +1,16 @@
 #include <stic.h>
 
 #include <stddef.h> /* NULL */
-#include <string.h> /* strcpy() */
+#include <string.h> /* strcpy() strdup() */
+#include <unistd.h> /* usleep() */
 
 #include <test-utils.h>
 
 #include "../../src/compat/fs_limits.h"
 #include "../../src/cfg/config.h"
 #include "../../src/engine/keys.h"
+#include "../../src/engine/mode.h"
+#include "../../src/menus/menus.h"
 #include "../../src/modes/menu.h"
 #include "../../src/modes/modes.h"
 #include "../../src/modes/wk.h"
@@ -17,6 +20,8 @@
 #include "../../src/filelist.h"
 #include "../../src/status.h"
 
+static void wait_for_capture(int len);
+
 /* This tests various menus and generic things that need mode activation. */
 
 SETUP()
@@ -161,5 +166,67 @@ TEST(locate_menu_can_escape_args, IF(not_windows))
 	assert_success(remove(script_path));
 }
 
+TEST(menu_is_filled_while_command_runs, IF(not_windows))
+{
+	static menu_data_t m;
+	menus_init_data(&m, &lwin, strdup("Lines"), strdup("No lines"));
+
+	replace_string(&cfg.shell, "/bin/sh");
+	cfg.tab_stop = 8;
+	curr_stats.load_stage = 2;
+
+	assert_success(menus_capture(&lwin,
+				"echo first; sleep 0.1; echo second; printf 'third\tline'",
+				/*user_sh=*/0, &m, MF_NONE));
+	assert_true(vle_mode_is(MENU_MODE));
+	assert_true(m.len >= 1);
+	assert_string_equal("first", m.items[0]);
+
+	wait_for_capture(3);
+	assert_int_equal(3, m.len);
+	assert_string_equal("second", m.items[1]);
+	assert_string_equal("third   line", m.items[2]);
+	assert_string_equal("Lines", m.title);
+
+	(void)vle_keys_exec(WK_ESC);
+	assert_true(vle_mode_is(NORMAL_MODE));
+}
+
+TEST(leaving_menu_cancels_command, IF(not_windows))
+{
+	static menu_data_t m;
+	menus_init_data(&m, &lwin, strdup("Lines"), strdup("No lines"));
+	m.stashable = 1;
+
+	replace_string(&cfg.shell, "/bin/sh");
+	curr_stats.load_stage = 2;
+
+	assert_success(menus_capture(&lwin, "echo first; exec sleep 1",
+				/*user_sh=*/0, &m, MF_NONE));
+	assert_true(vle_mode_is(MENU_MODE));
+	assert_int_equal(1, m.len);
+
+	(void)vle_keys_exec(WK_ESC);
+	assert_true(vle_mode_is(NORMAL_MODE));
+
+	assert_success(cmds_dispatch("copen", &lwin, CIT_COMMAND));
+	assert_true(vle_mode_is(MENU_MODE));
+	assert_int_equal(1, menu_get_current()->len);
+	assert_string_equal("Lines(cancelled)", menu_get_current()->title);
+	(void)vle_keys_exec(WK_ESC);
+}
+
+/* Pulls output of a command into the menu until it has enough lines. */
+static void
+wait_for_capture(int len)
+{
+	int i;
+	for(i = 0; i < 500 && menu_get_current()->len < len; ++i)
+	{
+		usleep(10000);
+		menus_check_capture();
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
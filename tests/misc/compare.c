@@ -3,12 +3,17 @@
 #include <sys/stat.h> /* chmod() */
 #include <unistd.h> /* rmdir() symlink() */
 
-#include <stdio.h> /* FILE fopen() fwrite() fclose() remove() */
+#include <stdio.h> /* FILE fopen() fprintf() fputc() fwrite() fclose()
+                      remove() snprintf() */
 #include <string.h> /* strcpy() */
 
 #include <test-utils.h>
 
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
 #include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
 #include "../../src/compare.h"
 
 /* These tests are about comparison strategies and not about handling of unusual
@@ -381,5 +386,117 @@ TEST(content_difference_is_detected)
 	remove_dir(SANDBOX_PATH "/b");
 }
 
+TEST(fingerprints_are_cached, IF(not_windows))
+{
+	copy_str(cfg.fpcache_file, sizeof(cfg.fpcache_file), SANDBOX_PATH "/cache");
+
+	int i;
+	for(i = 0; i < 2; ++i)
+	{
+		strcpy(lwin.curr_dir, TEST_DATA_PATH "/compare/b");
+		compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+
+		assert_int_equal(CV_COMPARE, lwin.custom.type);
+		assert_int_equal(4, lwin.list_rows);
+		assert_int_equal(1, lwin.dir_entry[0].id);
+		assert_int_equal(1, lwin.dir_entry[1].id);
+		assert_int_equal(2, lwin.dir_entry[2].id);
+		assert_int_equal(3, lwin.dir_entry[3].id);
+
+		assert_true(get_file_size(cfg.fpcache_file) > 0);
+	}
+
+	remove_file(cfg.fpcache_file);
+	cfg.fpcache_file[0] = '\0';
+}
+
+/* Tests that many files of the same size are grouped as they should be even
+ * though their fingerprints are computed in parallel. */
+TEST(many_files_of_identical_size_are_grouped)
+{
+	int i;
+	for(i = 0; i < 40; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/f%02d", SANDBOX_PATH, i);
+		FILE *fp = fopen(path, "wb");
+		assert_non_null(fp);
+		fprintf(fp, "g%d\n", i%4);
+		fclose(fp);
+	}
+
+	strcpy(lwin.curr_dir, SANDBOX_PATH);
+	compare_one_pane(&lwin, CT_CONTENTS, LT_ALL, CF_NONE);
+
+	assert_int_equal(CV_COMPARE, lwin.custom.type);
+	assert_int_equal(40, lwin.list_rows);
+	for(i = 0; i < 40; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "f%02d", (i%10)*4 + i/10);
+		assert_string_equal(name, lwin.dir_entry[i].name);
+		assert_int_equal(1 + i/10, lwin.dir_entry[i].id);
+	}
+
+	for(i = 0; i < 40; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/f%02d", SANDBOX_PATH, i);
+		remove_file(path);
+	}
+}
+
+/* Tests that files which differ only past the sampled prefix are told apart
+ * and that all of them are checked against each other. */
+TEST(files_with_identical_prefix_are_compared_fully)
+{
+	/* Files 0 and 3 as well as 1 and 4 have identical contents. */
+	const char tails[] = { 'a', 'b', 'c', 'a', 'b' };
+
+	int flags;
+	for(flags = 0; flags < 2; ++flags)
+	{
+		int i;
+		for(i = 0; i < 5; ++i)
+		{
+			char path[PATH_MAX + 1];
+			snprintf(path, sizeof(path), "%s/f%d", SANDBOX_PATH, i);
+			FILE *fp = fopen(path, "wb");
+			assert_non_null(fp);
+			int j;
+			for(j = 0; j < 8*1024; ++j)
+			{
+				fputc('x', fp);
+			}
+			fputc(tails[i], fp);
+			fclose(fp);
+		}
+
+		strcpy(lwin.curr_dir, SANDBOX_PATH);
+		compare_one_pane(&lwin, CT_CONTENTS, LT_ALL,
+				flags ? CF_BYTE_CHECK : CF_NONE);
+
+		assert_int_equal(CV_COMPARE, lwin.custom.type);
+		assert_int_equal(5, lwin.list_rows);
+		assert_string_equal("f0", lwin.dir_entry[0].name);
+		assert_string_equal("f3", lwin.dir_entry[1].name);
+		assert_string_equal("f1", lwin.dir_entry[2].name);
+		assert_string_equal("f4", lwin.dir_entry[3].name);
+		assert_string_equal("f2", lwin.dir_entry[4].name);
+		assert_int_equal(lwin.dir_entry[0].id, lwin.dir_entry[1].id);
+		assert_int_equal(lwin.dir_entry[2].id, lwin.dir_entry[3].id);
+		assert_true(lwin.dir_entry[1].id != lwin.dir_entry[2].id);
+		assert_true(lwin.dir_entry[3].id != lwin.dir_entry[4].id);
+		assert_true(lwin.dir_entry[0].id != lwin.dir_entry[4].id);
+
+		for(i = 0; i < 5; ++i)
+		{
+			char path[PATH_MAX + 1];
+			snprintf(path, sizeof(path), "%s/f%d", SANDBOX_PATH, i);
+			remove_file(path);
+		}
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
@@ -329,6 +329,73 @@ TEST(cursor_is_moved_to_nearest_neighbour)
 	local_filter_cancel(&lwin);
 }
 
+TEST(refined_local_filter_gives_same_results)
+{
+	char path[PATH_MAX + 1];
+
+	flist_custom_start(&lwin, "test");
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/dos-eof", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/dos-line-endings",
+			cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/two-lines", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/very-long-line", cwd);
+	flist_custom_add(&lwin, path);
+	assert_true(flist_custom_finish(&lwin, CV_REGULAR, 0) == 0);
+
+	assert_int_equal(0, local_filter_set(&lwin, "lin"));
+	local_filter_update_view(&lwin, 0);
+	assert_int_equal(3, lwin.list_rows);
+
+	assert_int_equal(0, local_filter_set(&lwin, "line-"));
+	local_filter_update_view(&lwin, 0);
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("dos-line-endings", lwin.dir_entry[0].name);
+
+	/* Shorter pattern brings back entries that were filtered out. */
+	assert_int_equal(0, local_filter_set(&lwin, "line"));
+	local_filter_update_view(&lwin, 0);
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("dos-line-endings", lwin.dir_entry[0].name);
+	assert_string_equal("two-lines", lwin.dir_entry[1].name);
+	assert_string_equal("very-long-line", lwin.dir_entry[2].name);
+
+	/* Pattern that doesn't contain previous one. */
+	assert_int_equal(0, local_filter_set(&lwin, "long"));
+	local_filter_update_view(&lwin, 0);
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("very-long-line", lwin.dir_entry[0].name);
+
+	local_filter_accept(&lwin, /*update_history=*/0);
+	assert_int_equal(1, lwin.list_rows);
+}
+
+TEST(extending_regexp_filter_checks_all_entries)
+{
+	char path[PATH_MAX + 1];
+
+	flist_custom_start(&lwin, "test");
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/binary-data", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/two-lines", cwd);
+	flist_custom_add(&lwin, path);
+	assert_true(flist_custom_finish(&lwin, CV_REGULAR, 0) == 0);
+
+	assert_int_equal(0, local_filter_set(&lwin, "two"));
+	local_filter_update_view(&lwin, 0);
+	assert_int_equal(1, lwin.list_rows);
+
+	/* Contains previous value, but matches more. */
+	assert_int_equal(0, local_filter_set(&lwin, "two|data"));
+	local_filter_update_view(&lwin, 0);
+	assert_int_equal(2, lwin.list_rows);
+
+	local_filter_cancel(&lwin);
+	assert_int_equal(2, lwin.list_rows);
+}
+
 TEST(removed_filename_filter_is_stored)
 {
 	assert_success(filter_set(&lwin.auto_filter, "a"));
@@ -3,6 +3,7 @@
 #include <sys/stat.h> /* chmod() */
 
 #include <limits.h> /* INT_MAX */
+#include <stdio.h> /* snprintf() */
 #include <string.h> /* memset() strcpy() */
 #include <time.h> /* time() */
 
@@ -24,6 +25,8 @@
 #include "../../src/fops_misc.h"
 #include "../../src/status.h"
 
+static int using_inotify(void);
+
 static char cwd[PATH_MAX + 1];
 
 SETUP_ONCE()
@@ -468,6 +471,87 @@ TEST(cache_handles_noexec_dirs, IF(regular_unix_user))
 	assert_success(rmdir(SANDBOX_PATH "/dir"));
 }
 
+TEST(caches_share_listing_of_a_directory, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	create_file(SANDBOX_PATH "/dir/a");
+
+	cached_entries_t cache1 = {}, cache2 = {};
+	assert_true(flist_update_cache(&lwin, &cache1, SANDBOX_PATH "/dir"));
+	assert_true(flist_update_cache(&lwin, &cache2, SANDBOX_PATH "/dir"));
+	assert_true(cache1.listing == cache2.listing);
+	assert_int_equal(1, cache2.entries.nentries);
+	assert_false(flist_update_cache(&lwin, &cache1, SANDBOX_PATH "/dir"));
+
+	create_file(SANDBOX_PATH "/dir/b");
+	assert_true(flist_update_cache(&lwin, &cache1, SANDBOX_PATH "/dir"));
+	assert_true(flist_update_cache(&lwin, &cache2, SANDBOX_PATH "/dir"));
+	assert_true(cache1.listing == cache2.listing);
+	assert_int_equal(2, cache1.entries.nentries);
+	assert_int_equal(2, cache2.entries.nentries);
+
+	flist_free_cache(&cache1);
+	flist_free_cache(&cache2);
+
+	assert_success(remove(SANDBOX_PATH "/dir/a"));
+	assert_success(remove(SANDBOX_PATH "/dir/b"));
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+}
+
+TEST(file_list_is_loaded_from_shared_listing, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	create_file(SANDBOX_PATH "/dir/a");
+	create_file(SANDBOX_PATH "/dir/b");
+	create_file(SANDBOX_PATH "/dir/.hidden");
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "dir",
+			cwd);
+
+	cached_entries_t cache = {};
+	assert_true(flist_update_cache(&lwin, &cache, lwin.curr_dir));
+
+	lwin.hide_dot = 1;
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+
+	flist_free_cache(&cache);
+
+	assert_success(remove(SANDBOX_PATH "/dir/a"));
+	assert_success(remove(SANDBOX_PATH "/dir/b"));
+	assert_success(remove(SANDBOX_PATH "/dir/.hidden"));
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+}
+
+TEST(targets_of_links_in_shared_listing_are_updated, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	create_file(SANDBOX_PATH "/target");
+	assert_success(make_symlink("../target", SANDBOX_PATH "/dir/link"));
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "dir",
+			cwd);
+
+	cached_entries_t cache = {};
+	assert_true(flist_update_cache(&lwin, &cache, lwin.curr_dir));
+	assert_int_equal(1, cache.entries.nentries);
+	assert_false(fentry_is_dir(&cache.entries.entries[0]));
+
+	assert_success(remove(SANDBOX_PATH "/target"));
+	assert_success(os_mkdir(SANDBOX_PATH "/target", 0700));
+
+	populate_dir_list(&lwin, 0);
+	assert_int_equal(1, lwin.list_rows);
+	assert_true(fentry_is_dir(&lwin.dir_entry[0]));
+
+	flist_free_cache(&cache);
+
+	assert_success(remove(SANDBOX_PATH "/dir/link"));
+	assert_success(rmdir(SANDBOX_PATH "/dir"));
+	assert_success(rmdir(SANDBOX_PATH "/target"));
+}
+
 TEST(filename_is_formatted_according_to_column_and_filetype)
 {
 	char origin[] = "";
@@ -584,5 +668,92 @@ TEST(fentry_points_to_works, IF(not_windows))
 	remove_file(SANDBOX_PATH "/link");
 }
 
+TEST(lazily_loaded_stats_match_lstat, IF(not_windows))
+{
+	create_file(SANDBOX_PATH "/file");
+
+	struct stat s;
+	assert_success(os_lstat(SANDBOX_PATH "/file", &s));
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+	load_dir_list(&lwin, 1);
+	assert_int_equal(1, lwin.list_rows);
+
+	/* Sorting by name doesn't need owner, but it must be available anyway. */
+	fentry_load_stats(&lwin.dir_entry[0]);
+	assert_false(lwin.dir_entry[0].partial_stats);
+	assert_int_equal(s.st_uid, lwin.dir_entry[0].uid);
+	assert_int_equal(s.st_gid, lwin.dir_entry[0].gid);
+	assert_int_equal(s.st_ctime, lwin.dir_entry[0].ctime);
+
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(stats_needed_for_sorting_are_loaded, IF(not_windows))
+{
+	create_file(SANDBOX_PATH "/file");
+
+	struct stat s;
+	assert_success(os_lstat(SANDBOX_PATH "/file", &s));
+
+	lwin.sort[0] = SK_BY_OWNER_ID;
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+	load_dir_list(&lwin, 1);
+	assert_int_equal(1, lwin.list_rows);
+
+	assert_false(lwin.dir_entry[0].partial_stats);
+	assert_int_equal(s.st_uid, lwin.dir_entry[0].uid);
+
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(big_directories_are_loaded_completely, IF(not_windows))
+{
+	char path[PATH_MAX + 1];
+	int i;
+
+	for(i = 0; i < 300; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%03d", SANDBOX_PATH, i);
+		create_file(path);
+	}
+	create_file(SANDBOX_PATH "/.hidden");
+
+	/* Make sure that the directory is considered to be big. */
+	struct stat s;
+	assert_success(os_stat(SANDBOX_PATH, &s));
+	assert_true(s.st_size > s.st_blksize);
+
+	lwin.hide_dot = 1;
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+	assert_success(populate_dir_list(&lwin, 0));
+
+	assert_int_equal(300, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		snprintf(path, sizeof(path), "file%03d", i);
+		assert_string_equal(path, lwin.dir_entry[i].name);
+		assert_int_equal(FT_REG, lwin.dir_entry[i].type);
+	}
+
+	for(i = 0; i < 300; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/file%03d", SANDBOX_PATH, i);
+		remove_file(path);
+	}
+	remove_file(SANDBOX_PATH "/.hidden");
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
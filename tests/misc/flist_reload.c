@@ -12,6 +12,9 @@
 #include "../../src/utils/fs.h"
 #include "../../src/utils/str.h"
 #include "../../src/filelist.h"
+#include "../../src/sort.h"
+
+static int using_inotify(void);
 
 static view_t *const view = &lwin;
 
@@ -95,5 +98,59 @@ TEST(selection_is_preserved)
 	assert_int_equal(2, view->selected_files);
 }
 
+TEST(changes_are_applied_without_reloading, IF(using_inotify))
+{
+	view->sort[0] = SK_BY_NAME;
+	memset(&view->sort[1], SK_NONE, sizeof(view->sort) - 1);
+	sort_view(view);
+
+	view->list_pos = 2;
+	view->dir_entry[3].selected = 1;
+	view->selected_files = 1;
+
+	/* The first checks set up watching. */
+	check_if_filelist_has_changed(view);
+	check_if_filelist_has_changed(view);
+	(void)ui_view_query_scheduled_event(view);
+
+	assert_success(os_mkdir("10", 0000));
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(5, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("1", view->dir_entry[1].name);
+	assert_string_equal("10", view->dir_entry[2].name);
+	assert_string_equal("2", view->dir_entry[3].name);
+	assert_string_equal("3", view->dir_entry[4].name);
+	assert_int_equal(3, view->list_pos);
+	assert_true(view->dir_entry[4].selected);
+	assert_int_equal(1, view->selected_files);
+
+	(void)rmdir("1");
+	(void)rmdir("3");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(3, view->list_rows);
+	assert_string_equal("0", view->dir_entry[0].name);
+	assert_string_equal("10", view->dir_entry[1].name);
+	assert_string_equal("2", view->dir_entry[2].name);
+	assert_int_equal(2, view->list_pos);
+	assert_int_equal(0, view->selected_files);
+
+	(void)rmdir("10");
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
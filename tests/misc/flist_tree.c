@@ -32,6 +32,7 @@ static void verify_tree_node(column_data_t *cdt, int idx,
 static void column_line_print(const char buf[], size_t offset, AlignType align,
 		const char full_column[], const format_info_t *info);
 static int remove_selected(view_t *view, const dir_entry_t *entry, void *arg);
+static int using_inotify(void);
 
 static char cwd[PATH_MAX + 1], test_data[PATH_MAX + 1];
 
@@ -496,6 +497,88 @@ TEST(dotdirs_do_not_mess_up_change_detection)
 	assert_int_equal(UUE_NONE, ui_view_query_scheduled_event(&lwin));
 }
 
+TEST(only_changed_subtree_is_reloaded, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/nested-dir", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/nested-dir/sub", 0700));
+	create_file(SANDBOX_PATH "/nested-dir/sub/a");
+	create_file(SANDBOX_PATH "/nested-dir/z");
+	create_file(SANDBOX_PATH "/b");
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	assert_success(load_tree(&lwin, SANDBOX_PATH, cwd));
+	assert_int_equal(5, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[2].name);
+	lwin.dir_entry[2].selected = 1;
+	lwin.selected_files = 1;
+	lwin.list_pos = 2;
+
+	/* The first checks set up watching. */
+	check_if_filelist_has_changed(&lwin);
+	check_if_filelist_has_changed(&lwin);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	create_file(SANDBOX_PATH "/nested-dir/sub/0");
+	check_if_filelist_has_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+
+	assert_int_equal(6, lwin.list_rows);
+	validate_tree(&lwin);
+	assert_string_equal("0", lwin.dir_entry[2].name);
+	assert_string_equal("a", lwin.dir_entry[3].name);
+	assert_true(lwin.dir_entry[3].selected);
+	assert_int_equal(1, lwin.selected_files);
+	assert_int_equal(3, lwin.list_pos);
+
+	assert_success(remove(SANDBOX_PATH "/nested-dir/sub/0"));
+	check_if_filelist_has_changed(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(5, lwin.list_rows);
+	validate_tree(&lwin);
+
+	assert_success(remove(SANDBOX_PATH "/nested-dir/sub/a"));
+	assert_success(remove(SANDBOX_PATH "/nested-dir/z"));
+	assert_success(rmdir(SANDBOX_PATH "/nested-dir/sub"));
+	assert_success(rmdir(SANDBOX_PATH "/nested-dir"));
+	assert_success(remove(SANDBOX_PATH "/b"));
+}
+
+TEST(tree_is_polled_if_watching_fails, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/nested-dir", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/nested-dir/sub", 0700));
+
+	assert_success(load_tree(&lwin, SANDBOX_PATH, cwd));
+
+	/* The first check sets up watching of the root. */
+	check_if_filelist_has_changed(&lwin);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	/* Watching a directory that doesn't exist fails. */
+	assert_success(rmdir(SANDBOX_PATH "/nested-dir/sub"));
+
+	check_if_filelist_has_changed(&lwin);
+	assert_null(lwin.tree_watch);
+	assert_true(lwin.tree_watch_failed);
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(&lwin));
+
+	/* No more attempts to watch, but changes are still detected. */
+	check_if_filelist_has_changed(&lwin);
+	assert_null(lwin.tree_watch);
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(&lwin));
+
+	/* Reloading gives watching another chance. */
+	assert_success(load_tree(&lwin, SANDBOX_PATH, cwd));
+	assert_false(lwin.tree_watch_failed);
+	check_if_filelist_has_changed(&lwin);
+	check_if_filelist_has_changed(&lwin);
+	assert_non_null(lwin.tree_watch);
+
+	assert_success(rmdir(SANDBOX_PATH "/nested-dir"));
+}
+
 TEST(tree_reload_preserves_selection)
 {
 	assert_success(load_tree(&lwin, TEST_DATA_PATH "/tree", cwd));
@@ -679,5 +762,15 @@ remove_selected(view_t *view, const dir_entry_t *entry, void *arg)
 	return !entry->selected;
 }
 
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
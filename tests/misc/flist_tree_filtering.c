@@ -3,6 +3,7 @@
 #include <unistd.h> /* rmdir() symlink() */
 
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* remove() */
 #include <string.h> /* memset() */
 
@@ -300,6 +301,47 @@ TEST(filtering_and_nesting_limit)
 	assert_int_equal(2, lwin.list_rows);
 }
 
+TEST(wide_tree_is_built_in_the_same_order)
+{
+	char path[PATH_MAX + 1];
+	int i;
+	for(i = 0; i < 8; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/d%d", SANDBOX_PATH, i);
+		assert_success(os_mkdir(path, 0700));
+		snprintf(path, sizeof(path), "%s/d%d/sub", SANDBOX_PATH, i);
+		assert_success(os_mkdir(path, 0700));
+		snprintf(path, sizeof(path), "%s/d%d/sub/f0", SANDBOX_PATH, i);
+		create_file(path);
+		snprintf(path, sizeof(path), "%s/d%d/sub/f1", SANDBOX_PATH, i);
+		create_file(path);
+	}
+	assert_success(os_mkdir(SANDBOX_PATH "/skip", 0700));
+	create_file(SANDBOX_PATH "/skip/file");
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	(void)replace_matcher(&lwin.manual_filter, "^skip/$");
+
+	assert_success(load_tree(&lwin, SANDBOX_PATH, cwd));
+	assert_int_equal(32, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+	validate_tree(&lwin);
+
+	for(i = 0; i < 8; ++i)
+	{
+		dir_entry_t *const entry = &lwin.dir_entry[i*4];
+		snprintf(path, sizeof(path), "d%d", i);
+		assert_string_equal(path, entry->name);
+		assert_int_equal(3, entry->child_count);
+		assert_string_equal("sub", entry[1].name);
+		assert_string_equal("f0", entry[2].name);
+		assert_string_equal("f1", entry[3].name);
+	}
+
+	remove_dir_content(SANDBOX_PATH);
+}
+
 static void
 column_line_print(const char buf[], size_t offset, AlignType align,
 		const char full_column[], const format_info_t *info)
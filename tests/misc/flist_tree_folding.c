@@ -433,6 +433,53 @@ TEST(lazy_unfolding_and_filtering)
 	assert_int_equal(2, lwin.list_rows);
 }
 
+TEST(folds_are_toggled_without_reloading_tree)
+{
+	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd, 0));
+	assert_int_equal(3, lwin.list_rows);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	lwin.list_pos = 0;
+	assert_string_equal("dir1", lwin.dir_entry[lwin.list_pos].name);
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(5, lwin.list_rows);
+	assert_false(lwin.dir_entry[0].folded);
+	assert_string_equal("dir2", lwin.dir_entry[1].name);
+	assert_true(lwin.dir_entry[1].folded);
+	validate_tree(&lwin);
+
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(3, lwin.list_rows);
+	assert_true(lwin.dir_entry[0].folded);
+	validate_tree(&lwin);
+}
+
+TEST(folding_in_place_updates_counters)
+{
+	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd, 0));
+	lwin.list_pos = 0;
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(5, lwin.list_rows);
+
+	/* Child of the directory and an unrelated entry. */
+	lwin.dir_entry[1].selected = 1;
+	lwin.dir_entry[1].search_match = 1;
+	lwin.dir_entry[4].selected = 1;
+	lwin.dir_entry[4].search_match = 2;
+	lwin.selected_files = 2;
+	lwin.matches = 2;
+
+	lwin.list_pos = 0;
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(3, lwin.list_rows);
+	assert_int_equal(1, lwin.selected_files);
+	assert_int_equal(1, lwin.matches);
+}
+
 TEST(folding_is_reset_on_leaving_tree)
 {
 	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd,
@@ -712,7 +712,19 @@ TEST(previewoptions)
 	assert_int_equal(10, cfg.max_tree_depth);
 	assert_false(cfg.hard_graphics_clear);
 
+	assert_success(cmds_dispatch("set previewoptions=prefetch:3,diskcache:5",
+				&lwin, CIT_COMMAND));
+	assert_int_equal(3, cfg.preview_prefetch);
+	assert_int_equal(5, cfg.preview_disk_cache);
+	assert_failure(cmds_dispatch("set previewoptions=prefetch:-1", &lwin,
+				CIT_COMMAND));
+	assert_string_equal("\"prefetch\" can't be negative, got: -1",
+			vle_tb_get_data(vle_err));
+	assert_int_equal(3, cfg.preview_prefetch);
+
 	assert_success(cmds_dispatch("set previewoptions=", &lwin, CIT_COMMAND));
+	assert_int_equal(0, cfg.preview_prefetch);
+	assert_int_equal(0, cfg.preview_disk_cache);
 	assert_int_equal(0, cfg.graphics_delay);
 	assert_false(cfg.hard_graphics_clear);
 	assert_int_equal(0, cfg.max_tree_depth);
@@ -3,14 +3,17 @@
 #include <unistd.h> /* chdir() unlink() */
 
 #include <locale.h> /* LC_ALL setlocale() */
-#include <string.h> /* memset() strcpy() */
+#include <stdlib.h> /* abs() */
+#include <string.h> /* memset() strcmp() strcpy() */
 
 #include <test-utils.h>
 
 #include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/str.h"
+#include "../../src/filelist.h"
 #include "../../src/sort.h"
 #include "../../src/status.h"
 
@@ -18,6 +21,9 @@
 #define ASSERT_STRCMP_EQUAL(a, b) \
 		do { assert_int_equal(SIGN(a), SIGN(b)); } while(0)
 
+static void check_name_order(signed char key);
+static int reference_name_cmp(const char s[], const char t[], int ignore_case);
+
 SETUP_ONCE()
 {
 	(void)setlocale(LC_ALL, "");
@@ -68,6 +74,53 @@ TEST(special_chars_ignore_case_sort)
 	assert_string_equal("_", lwin.dir_entry[0].name);
 }
 
+TEST(big_lists_are_sorted_like_small_ones)
+{
+	enum { COUNT = 40000 };
+
+	free_dir_entries(&lwin.dir_entry, &lwin.list_rows);
+	lwin.dir_entry = dynarray_cextend(NULL, COUNT*sizeof(*lwin.dir_entry));
+	lwin.list_rows = COUNT;
+
+	int i;
+	for(i = 0; i < COUNT; ++i)
+	{
+		/* Reverse order of names and plenty of equal sizes. */
+		lwin.dir_entry[i].name = format_str("f%05d", COUNT - 1 - i);
+		lwin.dir_entry[i].type = FT_REG;
+		lwin.dir_entry[i].origin = lwin.curr_dir;
+		lwin.dir_entry[i].size = (i*7919) % 100;
+	}
+
+	lwin.sort[0] = -SK_BY_SIZE;
+	lwin.sort[1] = SK_BY_NAME;
+	memset(&lwin.sort[2], SK_NONE, sizeof(lwin.sort) - 2);
+
+	sort_view(&lwin);
+
+	for(i = 1; i < COUNT; ++i)
+	{
+		const dir_entry_t *const prev = &lwin.dir_entry[i - 1];
+		const dir_entry_t *const curr = &lwin.dir_entry[i];
+		assert_true(prev->size >= curr->size);
+		if(prev->size == curr->size)
+		{
+			assert_true(strcmp(prev->name, curr->name) < 0);
+		}
+	}
+}
+
+TEST(name_keys_order_entries_like_name_comparison)
+{
+	cfg.sort_numbers = 0;
+	check_name_order(SK_BY_NAME);
+	check_name_order(-SK_BY_INAME);
+
+	cfg.sort_numbers = 1;
+	check_name_order(SK_BY_NAME);
+	check_name_order(-SK_BY_INAME);
+}
+
 /* Windows is really bad at handling links. */
 #ifndef _WIN32
 
@@ -497,5 +550,79 @@ TEST(inode_sorting_works)
 
 #endif
 
+/* Sorts a bunch of pseudo-random names by the key and verifies that order of
+ * each pair of neighbours agrees with plain comparison of names. */
+static void
+check_name_order(signed char key)
+{
+	enum { COUNT = 1000 };
+	static const char alphabet[] = "aB0012._z9";
+
+	free_dir_entries(&lwin.dir_entry, &lwin.list_rows);
+	lwin.dir_entry = dynarray_cextend(NULL, COUNT*sizeof(*lwin.dir_entry));
+	lwin.list_rows = COUNT;
+
+	unsigned int seed = 1;
+	int i;
+	for(i = 0; i < COUNT; ++i)
+	{
+		char name[16];
+		int len = 1 + i%8;
+		int j;
+		for(j = 0; j < len; ++j)
+		{
+			seed = seed*1103515245U + 12345U;
+			name[j] = alphabet[(seed >> 16)%(sizeof(alphabet) - 1)];
+		}
+		name[len] = '\0';
+
+		lwin.dir_entry[i].name = strdup(name);
+		lwin.dir_entry[i].type = FT_REG;
+		lwin.dir_entry[i].origin = lwin.curr_dir;
+	}
+
+	lwin.sort[0] = key;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	sort_view(&lwin);
+
+	const int ignore_case = (abs(key) == SK_BY_INAME);
+	for(i = 1; i < COUNT; ++i)
+	{
+		const char *prev = lwin.dir_entry[i - 1].name;
+		const char *curr = lwin.dir_entry[i].name;
+		int cmp = reference_name_cmp(prev, curr, ignore_case);
+		assert_true(key < 0 ? cmp >= 0 : cmp <= 0);
+	}
+}
+
+/* Compares names the way sorting by name is documented to do it. */
+static int
+reference_name_cmp(const char s[], const char t[], int ignore_case)
+{
+	if((s[0] == '.') != (t[0] == '.'))
+	{
+		return (s[0] == '.') ? -1 : 1;
+	}
+
+	char s_buf[NAME_MAX + 1];
+	char t_buf[NAME_MAX + 1];
+	copy_str(s_buf, sizeof(s_buf), s);
+	copy_str(t_buf, sizeof(t_buf), t);
+	if(ignore_case)
+	{
+		(void)str_to_lower(s, s_buf, sizeof(s_buf));
+		(void)str_to_lower(t, t_buf, sizeof(t_buf));
+	}
+
+	int result = cfg.sort_numbers ? strnumcmp(s_buf, t_buf)
+	                              : strcmp(s_buf, t_buf);
+	if(result == 0 && ignore_case)
+	{
+		result = strcmp(s, t);
+	}
+	return result;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -7,11 +7,14 @@
 
 #include <test-utils.h>
 
+#include "../../src/cfg/config.h"
 #include "../../src/engine/var.h"
 #include "../../src/engine/variables.h"
 #include "../../src/lua/vlua.h"
 #include "../../src/ui/quickview.h"
 #include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
 #include "../../src/utils/string_array.h"
 #include "../../src/background.h"
 #include "../../src/status.h"
@@ -259,6 +262,51 @@ TEST(cache_entries_are_reused)
 	assert_string_equal("first line", lines.items[0]);
 }
 
+TEST(least_recently_used_entries_are_dropped)
+{
+	/* Each file takes up two bytes. */
+	vcache_reset((vcache_entry_size() + 2)*3);
+
+	make_file(SANDBOX_PATH "/1", "a\nb\n");
+	make_file(SANDBOX_PATH "/2", "a\nb\n");
+	make_file(SANDBOX_PATH "/3", "a\nb\n");
+	make_file(SANDBOX_PATH "/4", "a\nb\n");
+
+	strlist_t lines;
+	lines = vcache_lookup(SANDBOX_PATH "/1", NULL, MF_NONE, VK_TEXTUAL, 2,
+			VC_SYNC, &error);
+	assert_int_equal(2, lines.nitems);
+	lines = vcache_lookup(SANDBOX_PATH "/2", NULL, MF_NONE, VK_TEXTUAL, 2,
+			VC_SYNC, &error);
+	assert_int_equal(2, lines.nitems);
+	lines = vcache_lookup(SANDBOX_PATH "/3", NULL, MF_NONE, VK_TEXTUAL, 2,
+			VC_SYNC, &error);
+	assert_int_equal(2, lines.nitems);
+
+	/* Use the first file via a different path to make it recently used. */
+	lines = vcache_lookup(SANDBOX_PATH "/.//1", NULL, MF_NONE,
+			VK_TEXTUAL, 1, VC_SYNC, &error);
+	assert_int_equal(2, lines.nitems);
+
+	/* This drops the second file. */
+	lines = vcache_lookup(SANDBOX_PATH "/4", NULL, MF_NONE, VK_TEXTUAL, 2,
+			VC_SYNC, &error);
+	assert_int_equal(2, lines.nitems);
+
+	/* Cached entries have more lines than requested. */
+	lines = vcache_lookup(SANDBOX_PATH "/1", NULL, MF_NONE, VK_TEXTUAL, 1,
+			VC_SYNC, &error);
+	assert_int_equal(2, lines.nitems);
+	lines = vcache_lookup(SANDBOX_PATH "/2", NULL, MF_NONE, VK_TEXTUAL, 1,
+			VC_SYNC, &error);
+	assert_int_equal(1, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/1");
+	remove_file(SANDBOX_PATH "/2");
+	remove_file(SANDBOX_PATH "/3");
+	remove_file(SANDBOX_PATH "/4");
+}
+
 TEST(viewers_are_cached_independently)
 {
 	strlist_t lines1 = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa",
@@ -418,6 +466,140 @@ TEST(kill_all_async_previews_on_exit, IF(not_windows))
 	}
 }
 
+TEST(prefetched_output_is_reused, IF(not_windows))
+{
+	vcache_prefetch_begin();
+	assert_success(vcache_prefetch(TEST_DATA_PATH "/read/two-lines", "echo aaa",
+				MF_NONE, 10));
+	vcache_prefetch_end();
+
+	assert_true(wait_for_cache());
+
+	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa",
+			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, &error);
+	assert_string_equal(NULL, error);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("aaa", lines.items[0]);
+}
+
+TEST(prefetching_is_limited_and_skips_unsuitable_viewers, IF(not_windows))
+{
+	vcache_prefetch_begin();
+	assert_failure(vcache_prefetch(TEST_DATA_PATH "/read/two-lines", NULL,
+				MF_NONE, 10));
+	assert_failure(vcache_prefetch(TEST_DATA_PATH "/read/two-lines", "echo",
+				MF_NO_CACHE, 10));
+	assert_success(vcache_prefetch(TEST_DATA_PATH "/read/two-lines", "sleep 10",
+				MF_NONE, 10));
+	assert_success(vcache_prefetch(TEST_DATA_PATH "/read/dos-eof", "sleep 10",
+				MF_NONE, 10));
+	assert_failure(vcache_prefetch(TEST_DATA_PATH "/read/dos-line-endings",
+				"sleep 10", MF_NONE, 10));
+	vcache_prefetch_end();
+
+	/* Looked up entry is no longer counted as a prefetched one. */
+	(void)vcache_lookup(TEST_DATA_PATH "/read/two-lines", "sleep 10", MF_NONE,
+			VK_TEXTUAL, 10, VC_ASYNC, &error);
+
+	vcache_prefetch_begin();
+	assert_success(vcache_prefetch(TEST_DATA_PATH "/read/dos-eof", "sleep 10",
+				MF_NONE, 10));
+	assert_success(vcache_prefetch(TEST_DATA_PATH "/read/dos-line-endings",
+				"sleep 10", MF_NONE, 10));
+	vcache_prefetch_end();
+
+	vcache_finish();
+}
+
+TEST(prefetching_of_files_that_are_not_needed_is_cancelled, IF(not_windows))
+{
+	vcache_prefetch_begin();
+	assert_success(vcache_prefetch(TEST_DATA_PATH "/read/two-lines", "sleep 10",
+				MF_NONE, 10));
+	vcache_prefetch_end();
+
+	vcache_prefetch_begin();
+	vcache_prefetch_end();
+
+	/* Viewer that's being cancelled isn't reported as a working one. */
+	vcache_prefetch_begin();
+	assert_failure(vcache_prefetch(TEST_DATA_PATH "/read/two-lines", "sleep 10",
+				MF_NONE, 10));
+	vcache_prefetch_end();
+
+	vcache_finish();
+}
+
+TEST(output_is_reused_from_disk, IF(not_windows))
+{
+	copy_str(cfg.vcache_dir, sizeof(cfg.vcache_dir), SANDBOX_PATH "/vcache");
+	cfg.preview_disk_cache = 1;
+
+	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa",
+			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, &error);
+	assert_string_equal(NULL, error);
+	assert_string_equal("[...]", lines.items[0]);
+
+	/* Output is stored after the viewer exits. */
+	int i;
+	for(i = 0; i < 1000 && count_dir_items(SANDBOX_PATH "/vcache") == 0; ++i)
+	{
+		usleep(5000);
+		(void)vcache_check(&is_previewed);
+	}
+	assert_int_equal(1, count_dir_items(SANDBOX_PATH "/vcache"));
+
+	/* Drops in-memory part of the cache. */
+	vcache_reset(1024);
+
+	lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa", MF_NONE,
+			VK_TEXTUAL, 10, VC_ASYNC, &error);
+	assert_string_equal(NULL, error);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("aaa", lines.items[0]);
+
+	/* Different viewer isn't affected. */
+	lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo bbb", MF_NONE,
+			VK_TEXTUAL, 10, VC_ASYNC, &error);
+	assert_string_equal("[...]", lines.items[0]);
+	vcache_finish();
+
+	cfg.preview_disk_cache = 0;
+	cfg.vcache_dir[0] = '\0';
+	vcache_reset(1024);
+	remove_dir_content(SANDBOX_PATH "/vcache");
+	remove_dir(SANDBOX_PATH "/vcache");
+}
+
+TEST(output_of_synchronous_viewer_is_stored_on_disk, IF(not_windows))
+{
+	copy_str(cfg.vcache_dir, sizeof(cfg.vcache_dir), SANDBOX_PATH "/vcache");
+	cfg.preview_disk_cache = 1;
+
+	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa",
+			MF_NONE, VK_TEXTUAL, 10, VC_SYNC, &error);
+	assert_string_equal(NULL, error);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("aaa", lines.items[0]);
+	assert_int_equal(1, count_dir_items(SANDBOX_PATH "/vcache"));
+
+	/* Drops in-memory part of the cache. */
+	vcache_reset(1024);
+
+	lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa", MF_NONE,
+			VK_TEXTUAL, 10, VC_ASYNC, &error);
+	assert_string_equal(NULL, error);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("aaa", lines.items[0]);
+	vcache_finish();
+
+	cfg.preview_disk_cache = 0;
+	cfg.vcache_dir[0] = '\0';
+	vcache_reset(1024);
+	remove_dir_content(SANDBOX_PATH "/vcache");
+	remove_dir(SANDBOX_PATH "/vcache");
+}
+
 static int
 wait_for_cache(void)
 {
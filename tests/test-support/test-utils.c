@@ -95,6 +95,7 @@ conf_setup(void)
 	update_string(&cfg.tab_line, "");
 	update_string(&cfg.grep_prg, "");
 	update_string(&cfg.locate_prg, "");
+	update_string(&cfg.locate_roots, "");
 	update_string(&cfg.media_prg, "");
 	update_string(&cfg.vborder_filler, "");
 	update_string(&cfg.hborder_filler, "");
@@ -136,6 +137,7 @@ conf_teardown(void)
 	update_string(&cfg.tab_line, NULL);
 	update_string(&cfg.grep_prg, NULL);
 	update_string(&cfg.locate_prg, NULL);
+	update_string(&cfg.locate_roots, NULL);
 	update_string(&cfg.media_prg, NULL);
 	update_string(&cfg.vborder_filler, NULL);
 	update_string(&cfg.hborder_filler, NULL);
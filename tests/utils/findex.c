@@ -0,0 +1,208 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/cancellation.h"
+#include "../../src/utils/findex.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+
+static findex_t * build_index(void);
+static int query_count(const findex_t *index, const char pattern[]);
+
+static char root[PATH_MAX + 1];
+
+SETUP_ONCE()
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+
+	make_abs_path(root, sizeof(root), SANDBOX_PATH, "root", cwd);
+}
+
+SETUP()
+{
+	create_dir(SANDBOX_PATH "/root");
+	create_file(SANDBOX_PATH "/root/a.c");
+	create_dir(SANDBOX_PATH "/root/dir");
+	create_file(SANDBOX_PATH "/root/dir/b.h");
+	create_dir(SANDBOX_PATH "/root/dir/sub");
+	create_file(SANDBOX_PATH "/root/dir/sub/c.c");
+	create_file(SANDBOX_PATH "/root/dir-x");
+}
+
+TEARDOWN()
+{
+	remove_dir_content(SANDBOX_PATH "/root");
+	remove_dir(SANDBOX_PATH "/root");
+}
+
+TEST(all_files_are_indexed)
+{
+	findex_t *const index = build_index();
+	assert_int_equal(6, findex_size(index));
+	findex_free(index);
+}
+
+TEST(substring_is_searched)
+{
+	findex_t *const index = build_index();
+
+	strlist_t found = {};
+	assert_success(findex_query(index, "b.h", &found));
+	assert_int_equal(1, found.nitems);
+	assert_true(ends_with(found.items[0], "/root/dir/b.h"));
+	free_string_array(found.items, found.nitems);
+
+	assert_int_equal(5, query_count(index, "dir"));
+	assert_int_equal(0, query_count(index, "nothing"));
+
+	findex_free(index);
+}
+
+TEST(glob_matches_whole_path)
+{
+	findex_t *const index = build_index();
+
+	assert_int_equal(2, query_count(index, "*.c"));
+	assert_int_equal(0, query_count(index, "*.c*h"));
+	assert_int_equal(1, query_count(index, "*/dir/?.h"));
+	assert_int_equal(0, query_count(index, "a.c*"));
+
+	findex_free(index);
+}
+
+TEST(index_is_saved_and_loaded)
+{
+	findex_t *const index = build_index();
+	assert_success(findex_save(index, SANDBOX_PATH "/index"));
+
+	findex_t *const loaded = findex_load(SANDBOX_PATH "/index");
+	assert_non_null(loaded);
+	assert_int_equal(findex_size(index), findex_size(loaded));
+	assert_true(findex_scan_time(index) == findex_scan_time(loaded));
+
+	char *roots[] = { root };
+	assert_true(findex_has_roots(loaded, roots, 1));
+	assert_int_equal(2, query_count(loaded, "*.c"));
+
+	findex_free(loaded);
+	findex_free(index);
+	remove_file(SANDBOX_PATH "/index");
+}
+
+TEST(bad_file_is_not_loaded)
+{
+	make_file(SANDBOX_PATH "/index", "VIFMIDX");
+	assert_null(findex_load(SANDBOX_PATH "/index"));
+	remove_file(SANDBOX_PATH "/index");
+
+	assert_null(findex_load(SANDBOX_PATH "/no-such-file"));
+}
+
+TEST(directory_is_updated)
+{
+	findex_t *const index = build_index();
+
+	char dir[PATH_MAX + 1];
+	snprintf(dir, sizeof(dir), "%s/dir", root);
+
+	assert_false(findex_update_dir(index, dir));
+
+	remove_file(SANDBOX_PATH "/root/dir/sub/c.c");
+	remove_dir(SANDBOX_PATH "/root/dir/sub");
+	create_dir(SANDBOX_PATH "/root/dir/new");
+	create_file(SANDBOX_PATH "/root/dir/new/d.c");
+
+	assert_true(findex_update_dir(index, dir));
+	assert_int_equal(5, findex_size(index));
+	assert_int_equal(0, query_count(index, "sub"));
+	assert_int_equal(1, query_count(index, "/root/dir/new"));
+	assert_int_equal(1, query_count(index, "dir-x"));
+
+	/* Contents of the new directory are added only after updating it. */
+	snprintf(dir, sizeof(dir), "%s/dir/new", root);
+	assert_true(findex_update_dir(index, dir));
+	assert_int_equal(6, findex_size(index));
+	assert_int_equal(1, query_count(index, "/root/dir/new/d.c"));
+
+	findex_free(index);
+}
+
+TEST(directories_missing_in_index_are_ignored)
+{
+	findex_t *const index = build_index();
+
+	create_dir(SANDBOX_PATH "/root/dir/new");
+	create_file(SANDBOX_PATH "/root/dir/new/d.c");
+
+	char dir[PATH_MAX + 1];
+	snprintf(dir, sizeof(dir), "%s/dir/new", root);
+	assert_false(findex_update_dir(index, dir));
+	assert_int_equal(6, findex_size(index));
+
+	findex_free(index);
+}
+
+TEST(symbolic_links_are_resolved, IF(not_windows))
+{
+	findex_t *const index = build_index();
+
+	create_dir(SANDBOX_PATH "/outside");
+	create_file(SANDBOX_PATH "/outside/e.c");
+	assert_success(make_symlink("../outside", SANDBOX_PATH "/root/link"));
+	assert_success(make_symlink("dir", SANDBOX_PATH "/root/dir-link"));
+
+	/* Link to a directory outside of the root doesn't extend the index. */
+	char dir[PATH_MAX + 1];
+	snprintf(dir, sizeof(dir), "%s/link", root);
+	assert_false(findex_update_dir(index, dir));
+
+	/* Link to an indexed directory updates it under its real path. */
+	create_file(SANDBOX_PATH "/root/dir/f.c");
+	snprintf(dir, sizeof(dir), "%s/dir-link", root);
+	assert_true(findex_update_dir(index, dir));
+	assert_int_equal(1, query_count(index, "/root/dir/f.c"));
+	assert_int_equal(0, query_count(index, "e.c"));
+
+	remove_file(SANDBOX_PATH "/outside/e.c");
+	remove_dir(SANDBOX_PATH "/outside");
+	findex_free(index);
+}
+
+TEST(directories_outside_of_roots_are_ignored)
+{
+	findex_t *const index = build_index();
+
+	char dir[PATH_MAX + 1];
+	snprintf(dir, sizeof(dir), "%s-not", root);
+	assert_false(findex_update_dir(index, dir));
+
+	findex_free(index);
+}
+
+static findex_t *
+build_index(void)
+{
+	char *roots[] = { root };
+	findex_t *const index = findex_build(roots, 1, 4, &no_cancellation);
+	assert_non_null(index);
+	return index;
+}
+
+static int
+query_count(const findex_t *index, const char pattern[])
+{
+	strlist_t found = {};
+	assert_success(findex_query(index, pattern, &found));
+	free_string_array(found.items, found.nitems);
+	return found.nitems;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
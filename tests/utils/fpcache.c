@@ -0,0 +1,241 @@
+#include <stic.h>
+
+#include <stdint.h> /* uint64_t */
+
+#include <test-utils.h>
+
+#include "../../src/utils/fpcache.h"
+
+static fpcache_key_t make_key(int n);
+
+TEST(null_cache_is_empty)
+{
+	const fpcache_key_t key = make_key(1);
+	uint64_t digest;
+	fpcache_digest_t full;
+
+	fpcache_set_prefix(NULL, &key, 10);
+	assert_failure(fpcache_get_prefix(NULL, &key, &digest));
+	fpcache_set_full(NULL, &key, &full);
+	assert_failure(fpcache_get_full(NULL, &key, &full));
+	fpcache_close(NULL);
+}
+
+TEST(key_of_missing_file_is_not_available)
+{
+	fpcache_key_t key;
+	assert_failure(fpcache_key_of(SANDBOX_PATH "/no-such-file", &key));
+}
+
+TEST(key_of_file_is_available)
+{
+	fpcache_key_t key;
+	assert_success(fpcache_key_of(TEST_DATA_PATH "/read/two-lines", &key));
+	assert_true(key.size > 0U);
+}
+
+TEST(too_small_cache_is_not_created)
+{
+	assert_null(fpcache_open(SANDBOX_PATH "/cache", 1));
+	no_remove_file(SANDBOX_PATH "/cache");
+	assert_int_equal(0, fpcache_capacity(NULL));
+}
+
+TEST(digests_are_stored_and_retrieved, IF(not_windows))
+{
+	fpcache_t *const cache = fpcache_open(SANDBOX_PATH "/cache", 64);
+	assert_non_null(cache);
+
+	const fpcache_key_t key = make_key(1);
+	uint64_t digest;
+	fpcache_digest_t full = { .low = 1, .high = 2 };
+
+	assert_failure(fpcache_get_prefix(cache, &key, &digest));
+	assert_failure(fpcache_get_full(cache, &key, &full));
+
+	fpcache_set_prefix(cache, &key, 10);
+	assert_success(fpcache_get_prefix(cache, &key, &digest));
+	assert_ulong_equal(10, digest);
+	assert_failure(fpcache_get_full(cache, &key, &full));
+
+	full.low = 1;
+	full.high = 2;
+	fpcache_set_full(cache, &key, &full);
+	full.low = 0;
+	full.high = 0;
+	assert_success(fpcache_get_full(cache, &key, &full));
+	assert_ulong_equal(1, full.low);
+	assert_ulong_equal(2, full.high);
+	assert_success(fpcache_get_prefix(cache, &key, &digest));
+	assert_ulong_equal(10, digest);
+
+	fpcache_close(cache);
+	remove_file(SANDBOX_PATH "/cache");
+}
+
+TEST(changed_file_misses_cache, IF(not_windows))
+{
+	fpcache_t *const cache = fpcache_open(SANDBOX_PATH "/cache", 64);
+	assert_non_null(cache);
+
+	fpcache_key_t key = make_key(1);
+	uint64_t digest;
+
+	fpcache_set_prefix(cache, &key, 10);
+	++key.mtime_nsec;
+	assert_failure(fpcache_get_prefix(cache, &key, &digest));
+	--key.mtime_nsec;
+	++key.size;
+	assert_failure(fpcache_get_prefix(cache, &key, &digest));
+	--key.size;
+	++key.inode;
+	assert_failure(fpcache_get_prefix(cache, &key, &digest));
+
+	fpcache_close(cache);
+	remove_file(SANDBOX_PATH "/cache");
+}
+
+TEST(cache_is_persistent, IF(not_windows))
+{
+	const fpcache_key_t key = make_key(1);
+	uint64_t digest;
+
+	fpcache_t *cache = fpcache_open(SANDBOX_PATH "/cache", 64);
+	assert_non_null(cache);
+	fpcache_set_prefix(cache, &key, 10);
+	fpcache_close(cache);
+
+	cache = fpcache_open(SANDBOX_PATH "/cache", 64);
+	assert_non_null(cache);
+	assert_success(fpcache_get_prefix(cache, &key, &digest));
+	assert_ulong_equal(10, digest);
+	fpcache_close(cache);
+
+	remove_file(SANDBOX_PATH "/cache");
+}
+
+TEST(bigger_cache_is_used_as_is, IF(not_windows))
+{
+	const fpcache_key_t key = make_key(1);
+	uint64_t digest;
+
+	fpcache_t *cache = fpcache_open(SANDBOX_PATH "/cache", 128);
+	assert_non_null(cache);
+	fpcache_set_prefix(cache, &key, 10);
+	fpcache_close(cache);
+
+	cache = fpcache_open(SANDBOX_PATH "/cache", 64);
+	assert_non_null(cache);
+	assert_int_equal(128, fpcache_capacity(cache));
+	assert_success(fpcache_get_prefix(cache, &key, &digest));
+	assert_ulong_equal(10, digest);
+	fpcache_close(cache);
+
+	remove_file(SANDBOX_PATH "/cache");
+}
+
+TEST(growing_cache_keeps_records, IF(not_windows))
+{
+	fpcache_t *cache = fpcache_open(SANDBOX_PATH "/cache", 64);
+	assert_non_null(cache);
+	assert_int_equal(64, fpcache_capacity(cache));
+
+	int i;
+	for(i = 0; i < 16; ++i)
+	{
+		const fpcache_key_t key = make_key(i);
+		fpcache_set_prefix(cache, &key, i);
+	}
+	fpcache_close(cache);
+
+	cache = fpcache_open(SANDBOX_PATH "/cache", 1024);
+	assert_non_null(cache);
+	assert_int_equal(1024, fpcache_capacity(cache));
+	for(i = 0; i < 16; ++i)
+	{
+		const fpcache_key_t key = make_key(i);
+		uint64_t digest;
+		assert_success(fpcache_get_prefix(cache, &key, &digest));
+		assert_ulong_equal(i, digest);
+	}
+	fpcache_close(cache);
+
+	remove_file(SANDBOX_PATH "/cache");
+}
+
+TEST(recreating_cache_does_not_affect_opened_one, IF(not_windows))
+{
+	const fpcache_key_t key = make_key(1);
+	uint64_t digest;
+
+	fpcache_t *const cache = fpcache_open(SANDBOX_PATH "/cache", 64);
+	assert_non_null(cache);
+
+	/* Cache of bigger capacity replaces the file. */
+	fpcache_t *const other = fpcache_open(SANDBOX_PATH "/cache", 128);
+	assert_non_null(other);
+
+	fpcache_set_prefix(cache, &key, 10);
+	assert_failure(fpcache_get_prefix(other, &key, &digest));
+	assert_success(fpcache_get_prefix(cache, &key, &digest));
+	assert_ulong_equal(10, digest);
+
+	fpcache_close(other);
+	fpcache_close(cache);
+	remove_file(SANDBOX_PATH "/cache");
+}
+
+TEST(least_recently_used_record_is_evicted, IF(not_windows))
+{
+	/* Single group of records. */
+	fpcache_t *const cache = fpcache_open(SANDBOX_PATH "/cache", 8);
+	assert_non_null(cache);
+
+	int i;
+	uint64_t digest;
+	for(i = 0; i < 8; ++i)
+	{
+		const fpcache_key_t key = make_key(i);
+		fpcache_set_prefix(cache, &key, i);
+	}
+
+	/* Use the first record to make the second one the oldest. */
+	fpcache_key_t key = make_key(0);
+	assert_success(fpcache_get_prefix(cache, &key, &digest));
+
+	key = make_key(8);
+	fpcache_set_prefix(cache, &key, 8);
+
+	for(i = 0; i < 9; ++i)
+	{
+		key = make_key(i);
+		if(i == 1)
+		{
+			assert_failure(fpcache_get_prefix(cache, &key, &digest));
+		}
+		else
+		{
+			assert_success(fpcache_get_prefix(cache, &key, &digest));
+			assert_ulong_equal(i, digest);
+		}
+	}
+
+	fpcache_close(cache);
+	remove_file(SANDBOX_PATH "/cache");
+}
+
+static fpcache_key_t
+make_key(int n)
+{
+	const fpcache_key_t key = {
+		.dev = 1,
+		.inode = 100 + n,
+		.size = 1000 + n,
+		.mtime_sec = 123456789,
+		.mtime_nsec = 42,
+	};
+	return key;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,126 @@
+#include <stic.h>
+
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_* */
+
+#include <stdio.h> /* remove() */
+#include <stdlib.h> /* qsort() */
+#include <string.h> /* strcmp() */
+
+#include <test-utils.h>
+
+#include "../../src/utils/cancellation.h"
+#include "../../src/utils/fswalk.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+
+static int collect_file(const char path[], const char name[], int is_dir,
+		int worker, void *arg);
+static int collect_top_level(const char path[], const char name[], int is_dir,
+		int worker, void *arg);
+static int sort_cmp(const void *a, const void *b);
+
+/* Directory in which the tree is created. */
+#define ROOT SANDBOX_PATH "/root"
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+SETUP()
+{
+	create_dir(ROOT);
+	create_file(ROOT "/a");
+	create_dir(ROOT "/dir");
+	create_file(ROOT "/dir/b");
+	create_dir(ROOT "/dir/sub");
+	create_file(ROOT "/dir/sub/c");
+}
+
+TEARDOWN()
+{
+	remove_file(ROOT "/a");
+	remove_file(ROOT "/dir/b");
+	remove_file(ROOT "/dir/sub/c");
+	remove_dir(ROOT "/dir/sub");
+	remove_dir(ROOT "/dir");
+	remove_dir(ROOT);
+}
+
+TEST(every_file_is_visited_once)
+{
+	strlist_t names = {};
+	fswalk(ROOT, 4, &collect_file, &names, &no_cancellation);
+
+	assert_int_equal(5, names.nitems);
+	qsort(names.items, names.nitems, sizeof(*names.items), &sort_cmp);
+	assert_string_equal("a", names.items[0]);
+	assert_string_equal("b", names.items[1]);
+	assert_string_equal("c", names.items[2]);
+	assert_string_equal("dir/", names.items[3]);
+	assert_string_equal("sub/", names.items[4]);
+
+	free_string_array(names.items, names.nitems);
+}
+
+TEST(directories_can_be_skipped)
+{
+	strlist_t names = {};
+	fswalk(ROOT, 4, &collect_top_level, &names, &no_cancellation);
+
+	assert_int_equal(2, names.nitems);
+	free_string_array(names.items, names.nitems);
+}
+
+TEST(symbolic_links_are_not_followed, IF(not_windows))
+{
+	assert_success(make_symlink("dir", ROOT "/link"));
+
+	strlist_t names = {};
+	fswalk(ROOT, 4, &collect_file, &names, &no_cancellation);
+	assert_int_equal(6, names.nitems);
+	free_string_array(names.items, names.nitems);
+
+	assert_success(remove(ROOT "/link"));
+}
+
+TEST(missing_root_is_fine)
+{
+	strlist_t names = {};
+	fswalk(ROOT "/no-such-dir", 4, &collect_file, &names,
+			&no_cancellation);
+	assert_int_equal(0, names.nitems);
+}
+
+/* Records name of a file marking directories with a trailing slash and enters
+ * all directories. */
+static int
+collect_file(const char path[], const char name[], int is_dir, int worker,
+		void *arg)
+{
+	strlist_t *const names = arg;
+
+	char *const entry = format_str("%s%s", name, is_dir ? "/" : "");
+
+	pthread_mutex_lock(&lock);
+	names->nitems = put_into_string_array(&names->items, names->nitems, entry);
+	pthread_mutex_unlock(&lock);
+
+	return 1;
+}
+
+/* Records name of a file and doesn't enter any directories. */
+static int
+collect_top_level(const char path[], const char name[], int is_dir,
+		int worker, void *arg)
+{
+	(void)collect_file(path, name, is_dir, worker, arg);
+	return 0;
+}
+
+/* Compares two strings for qsort(). */
+static int
+sort_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -2,11 +2,14 @@
 
 #include <stdio.h> /* remove() snprintf() */
 
+#include <test-utils.h>
+
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
 #include "../../src/utils/fs.h"
 #include "../../src/utils/fswatch.h"
 #include "../../src/utils/path.h"
+#include "../../src/utils/string_array.h"
 
 static int using_inotify(void);
 
@@ -182,6 +185,107 @@ TEST(file_recreation_removes_ban, IF(using_inotify))
 	assert_success(remove(SANDBOX_PATH "/testdir"));
 }
 
+TEST(set_reports_changed_directories, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir1", 0700));
+	assert_success(os_mkdir(SANDBOX_PATH "/dir2", 0700));
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create_set());
+	assert_success(fswatch_add(watch, SANDBOX_PATH "/dir1"));
+	assert_success(fswatch_add(watch, SANDBOX_PATH "/dir2"));
+
+	strlist_t changed = {};
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll_set(watch, &changed));
+
+	create_file(SANDBOX_PATH "/dir2/file");
+	assert_int_equal(FSWS_UPDATED, fswatch_poll_set(watch, &changed));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll_set(watch, &changed));
+	assert_int_equal(1, changed.nitems);
+	assert_string_equal(SANDBOX_PATH "/dir2", changed.items[0]);
+	free_string_array(changed.items, changed.nitems);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/dir2/file"));
+	assert_success(remove(SANDBOX_PATH "/dir2"));
+	assert_success(remove(SANDBOX_PATH "/dir1"));
+}
+
+TEST(removed_directory_is_dropped_from_set, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create_set());
+	assert_success(fswatch_add(watch, SANDBOX_PATH "/dir"));
+
+	strlist_t changed = {};
+	assert_success(remove(SANDBOX_PATH "/dir"));
+	(void)fswatch_poll_set(watch, &changed);
+	free_string_array(changed.items, changed.nitems);
+
+	changed.items = NULL;
+	changed.nitems = 0;
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+	create_file(SANDBOX_PATH "/dir/file");
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll_set(watch, &changed));
+	assert_int_equal(0, changed.nitems);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/dir/file"));
+	assert_success(remove(SANDBOX_PATH "/dir"));
+}
+
+TEST(changed_names_are_reported, IF(using_inotify))
+{
+	create_file(SANDBOX_PATH "/old");
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+
+	create_file(SANDBOX_PATH "/new");
+	assert_success(remove(SANDBOX_PATH "/old"));
+
+	fswatch_changes_t changes;
+	assert_int_equal(FSWS_UPDATED, fswatch_poll_changes(watch, &changes));
+	assert_true(changes.complete);
+	assert_int_equal(2, changes.count);
+	assert_string_equal("new", changes.names[0]);
+	assert_true(changes.added[0]);
+	assert_string_equal("old", changes.names[1]);
+	assert_false(changes.added[1]);
+	fswatch_free_changes(&changes);
+
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll_changes(watch, &changes));
+	assert_int_equal(0, changes.count);
+	fswatch_free_changes(&changes);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/new"));
+}
+
+TEST(changes_of_directory_itself_are_incomplete, IF(using_inotify))
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir", 0700));
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(SANDBOX_PATH "/dir"));
+
+	assert_success(os_chmod(SANDBOX_PATH "/dir", 0755));
+
+	fswatch_changes_t changes;
+	assert_int_equal(FSWS_UPDATED, fswatch_poll_changes(watch, &changes));
+	assert_false(changes.complete);
+	fswatch_free_changes(&changes);
+
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/dir"));
+}
+
 static int
 using_inotify(void)
 {
@@ -0,0 +1,175 @@
+#include <stic.h>
+
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* memcpy() memset() strcpy() strlen() */
+
+#include <test-utils.h>
+
+#include "../../src/utils/grep.h"
+#include "../../src/utils/string_array.h"
+
+static strlist_t grep_in(const char pattern[], int ignore_case, int invert);
+
+SETUP()
+{
+	make_file(SANDBOX_PATH "/file", "first\nSecond line\n\nthe second\nlast");
+}
+
+TEARDOWN()
+{
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(literal_pattern)
+{
+	strlist_t matches = grep_in("second", 0, 0);
+	assert_int_equal(1, matches.nitems);
+	assert_string_equal("file:4:the second", matches.items[0]);
+	free_string_array(matches.items, matches.nitems);
+
+	matches = grep_in("t", 0, 0);
+	assert_int_equal(3, matches.nitems);
+	assert_string_equal("file:1:first", matches.items[0]);
+	assert_string_equal("file:4:the second", matches.items[1]);
+	assert_string_equal("file:5:last", matches.items[2]);
+	free_string_array(matches.items, matches.nitems);
+}
+
+TEST(inverted_literal_pattern)
+{
+	strlist_t matches = grep_in("e", 0, 1);
+	assert_int_equal(3, matches.nitems);
+	assert_string_equal("file:1:first", matches.items[0]);
+	assert_string_equal("file:3:", matches.items[1]);
+	assert_string_equal("file:5:last", matches.items[2]);
+	free_string_array(matches.items, matches.nitems);
+}
+
+TEST(regular_expression)
+{
+	strlist_t matches = grep_in("^.e", 0, 0);
+	assert_int_equal(1, matches.nitems);
+	assert_string_equal("file:2:Second line", matches.items[0]);
+	free_string_array(matches.items, matches.nitems);
+}
+
+TEST(case_can_be_ignored)
+{
+	strlist_t matches = grep_in("second", 1, 0);
+	assert_int_equal(2, matches.nitems);
+	assert_string_equal("file:2:Second line", matches.items[0]);
+	assert_string_equal("file:4:the second", matches.items[1]);
+	free_string_array(matches.items, matches.nitems);
+}
+
+TEST(empty_pattern_matches_every_line)
+{
+	strlist_t matches = grep_in("", 0, 0);
+	assert_int_equal(5, matches.nitems);
+	free_string_array(matches.items, matches.nitems);
+}
+
+TEST(lines_are_not_split_between_reads)
+{
+	/* 8191 lines of 8 bytes put the match across the 64 KiB boundary, which is
+	 * followed by a line longer than the initial buffer. */
+	enum { SHORT_LINES = 8191, LONG_LINE = 200*1024 };
+	const char match[] = "a needle\n";
+	const char tail[] = "\nneedle";
+
+	const size_t len = SHORT_LINES*8 + strlen(match) + LONG_LINE + strlen(tail);
+	char *const contents = malloc(len + 1);
+	char *p = contents;
+	int i;
+	for(i = 0; i < SHORT_LINES; ++i, p += 8)
+	{
+		memcpy(p, "aaaaaaa\n", 8);
+	}
+	memcpy(p, match, strlen(match));
+	p += strlen(match);
+	memset(p, 'x', LONG_LINE);
+	p += LONG_LINE;
+	strcpy(p, tail);
+
+	make_file(SANDBOX_PATH "/file", contents);
+	free(contents);
+
+	strlist_t matches = grep_in("needle", 0, 0);
+	assert_int_equal(2, matches.nitems);
+	assert_string_equal("file:8192:a needle", matches.items[0]);
+	assert_string_equal("file:8194:needle", matches.items[1]);
+	free_string_array(matches.items, matches.nitems);
+
+	matches = grep_in("ne+dle$", 0, 0);
+	assert_int_equal(2, matches.nitems);
+	assert_string_equal("file:8192:a needle", matches.items[0]);
+	assert_string_equal("file:8194:needle", matches.items[1]);
+	free_string_array(matches.items, matches.nitems);
+
+	matches = grep_in("a", 0, 1);
+	assert_int_equal(2, matches.nitems);
+	assert_int_equal(LONG_LINE + strlen("file:8193:"), strlen(matches.items[0]));
+	assert_string_equal("file:8194:needle", matches.items[1]);
+	free_string_array(matches.items, matches.nitems);
+}
+
+TEST(many_matches_are_collected)
+{
+	enum { NLINES = 1000 };
+	char *const contents = malloc(NLINES*2 + 1);
+	int i;
+	for(i = 0; i < NLINES; ++i)
+	{
+		contents[i*2] = 'x';
+		contents[i*2 + 1] = '\n';
+	}
+	contents[NLINES*2] = '\0';
+
+	make_file(SANDBOX_PATH "/file", contents);
+	free(contents);
+
+	strlist_t matches = grep_in("x", 0, 0);
+	assert_int_equal(NLINES, matches.nitems);
+	assert_string_equal("file:1:x", matches.items[0]);
+	assert_string_equal("file:1000:x", matches.items[NLINES - 1]);
+	free_string_array(matches.items, matches.nitems);
+}
+
+TEST(bad_pattern_is_reported)
+{
+	char *error;
+	assert_null(grep_compile("(", 0, 0, 1, &error));
+	assert_non_null(error);
+	free(error);
+}
+
+TEST(missing_file_is_an_error)
+{
+	char *error;
+	grep_t *const grep = grep_compile("x", 0, 0, 1, &error);
+	assert_non_null(grep);
+
+	strlist_t matches = {};
+	assert_failure(grep_file(grep, 0, SANDBOX_PATH "/no-file", "no-file",
+				&matches));
+	assert_int_equal(0, matches.nitems);
+
+	grep_free(grep);
+}
+
+static strlist_t
+grep_in(const char pattern[], int ignore_case, int invert)
+{
+	char *error;
+	grep_t *const grep = grep_compile(pattern, ignore_case, invert, 2, &error);
+	assert_non_null(grep);
+
+	strlist_t matches = {};
+	assert_success(grep_file(grep, 1, SANDBOX_PATH "/file", "file", &matches));
+
+	grep_free(grep);
+	return matches;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -369,6 +369,39 @@ TEST(fast_globs)
 	matcher_free(m);
 }
 
+TEST(many_fast_globs_are_matched)
+{
+	char *error;
+	matcher_t *m, *clone;
+
+	m = matcher_alloc("{*.c,*.H,*.tar.gz,*,,x,Makefile,*.txt,README*,a*z,*.c,"
+	                  "x\\*y}", 0, 1, "", &error);
+	assert_non_null(m);
+	assert_null(error);
+	assert_true(matcher_is_fast(m));
+	assert_non_null(clone = matcher_clone(m));
+	matcher_free(m);
+
+	assert_true(matcher_matches(clone, "file.c"));
+	assert_true(matcher_matches(clone, "file.h"));
+	assert_true(matcher_matches(clone, "FILE.TAR.GZ"));
+	assert_true(matcher_matches(clone, "some,x"));
+	assert_true(matcher_matches(clone, "makefile"));
+	assert_true(matcher_matches(clone, "ReadMe.md"));
+	assert_true(matcher_matches(clone, "az"));
+	assert_true(matcher_matches(clone, "abcz"));
+	assert_true(matcher_matches(clone, "x*y"));
+
+	assert_false(matcher_matches(clone, ".c"));
+	assert_false(matcher_matches(clone, ".file.c"));
+	assert_false(matcher_matches(clone, "file.gz"));
+	assert_false(matcher_matches(clone, "Makefile.am"));
+	assert_false(matcher_matches(clone, "za"));
+	assert_false(matcher_matches(clone, "xay"));
+
+	matcher_free(clone);
+}
+
 TEST(regexps_are_cloned)
 {
 	char *error;
@@ -206,6 +206,22 @@ TEST(mime_patterns)
 	free_string_array(list, count);
 }
 
+TEST(use_of_mime_types_is_detected)
+{
+	char *error = NULL;
+	matchers_t *ms;
+
+	assert_non_null(ms = matchers_alloc("{*.c}{{/tmp/*}}/x/", 0, 1, "", &error));
+	assert_null(error);
+	assert_false(matchers_use_mime(ms));
+	matchers_free(ms);
+
+	assert_non_null(ms = matchers_alloc("{*.c}<text/*>", 0, 1, "", &error));
+	assert_null(error);
+	assert_true(matchers_use_mime(ms));
+	matchers_free(ms);
+}
+
 TEST(matchers_are_cloned)
 {
 	char *error = NULL;
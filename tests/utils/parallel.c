@@ -0,0 +1,168 @@
+#include <stic.h>
+
+#include <stdint.h> /* intptr_t */
+#include <string.h> /* memset() */
+
+#include "../../src/utils/cancellation.h"
+#include "../../src/utils/parallel.h"
+
+static void mark_item(int idx, int worker, void *arg);
+static void count_worker(int idx, int worker, void *arg);
+static int cancel_hook(void *arg);
+static void spawn_task(parallel_pool_t *pool, void *task, int worker,
+		void *arg);
+static void drop_task(void *task, void *arg);
+
+/* Number of tasks in a tree of tasks. */
+#define NTASKS 1000
+
+TEST(number_of_workers_is_positive)
+{
+	assert_true(parallel_get_nworkers() > 0);
+}
+
+TEST(empty_range_is_fine)
+{
+	assert_int_equal(0, parallel_for(0, 4, &mark_item, NULL, &no_cancellation));
+}
+
+TEST(every_item_is_processed_once)
+{
+	int items[1000];
+	memset(items, 0, sizeof(items));
+
+	assert_int_equal(1000,
+			parallel_for(1000, 8, &mark_item, items, &no_cancellation));
+
+	int i;
+	for(i = 0; i < 1000; ++i)
+	{
+		assert_int_equal(1, items[i]);
+	}
+}
+
+TEST(single_worker_is_the_calling_thread)
+{
+	int workers[10];
+	memset(workers, -1, sizeof(workers));
+
+	assert_int_equal(10,
+			parallel_for(10, 1, &count_worker, workers, &no_cancellation));
+
+	int i;
+	for(i = 0; i < 10; ++i)
+	{
+		assert_int_equal(0, workers[i]);
+	}
+}
+
+TEST(cancellation_stops_processing)
+{
+	int items[100];
+	memset(items, 0, sizeof(items));
+
+	const cancellation_t cancellation = { .hook = &cancel_hook };
+	assert_int_equal(0, parallel_for(100, 4, &mark_item, items, &cancellation));
+
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		assert_int_equal(0, items[i]);
+	}
+}
+
+TEST(tasks_added_by_tasks_are_processed_once)
+{
+	int items[NTASKS];
+	memset(items, 0, sizeof(items));
+
+	parallel_run((void *)(intptr_t)1, 8, &spawn_task, &drop_task, items,
+			&no_cancellation);
+
+	int i;
+	for(i = 0; i < NTASKS; ++i)
+	{
+		assert_int_equal(1, items[i]);
+	}
+}
+
+TEST(tasks_are_processed_by_single_worker)
+{
+	int items[NTASKS];
+	memset(items, 0, sizeof(items));
+
+	parallel_run((void *)(intptr_t)1, 1, &spawn_task, &drop_task, items,
+			&no_cancellation);
+
+	int i;
+	for(i = 0; i < NTASKS; ++i)
+	{
+		assert_int_equal(1, items[i]);
+	}
+}
+
+TEST(cancelled_tasks_are_dropped)
+{
+	int items[NTASKS];
+	memset(items, 0, sizeof(items));
+
+	const cancellation_t cancellation = { .hook = &cancel_hook };
+	parallel_run((void *)(intptr_t)1, 4, &spawn_task, &drop_task, items,
+			&cancellation);
+
+	assert_int_equal(-1, items[0]);
+	int i;
+	for(i = 1; i < NTASKS; ++i)
+	{
+		assert_int_equal(0, items[i]);
+	}
+}
+
+static void
+mark_item(int idx, int worker, void *arg)
+{
+	int *items = arg;
+	++items[idx];
+}
+
+static void
+count_worker(int idx, int worker, void *arg)
+{
+	int *workers = arg;
+	workers[idx] = worker;
+}
+
+static int
+cancel_hook(void *arg)
+{
+	return 1;
+}
+
+/* Marks the task and adds its children in a binary tree of tasks.  Tasks are
+ * numbered starting with one. */
+static void
+spawn_task(parallel_pool_t *pool, void *task, int worker, void *arg)
+{
+	int *items = arg;
+	const int n = (intptr_t)task;
+	++items[n - 1];
+
+	if(2*n <= NTASKS)
+	{
+		parallel_push(pool, worker, (void *)(intptr_t)(2*n));
+	}
+	if(2*n + 1 <= NTASKS)
+	{
+		parallel_push(pool, worker, (void *)(intptr_t)(2*n + 1));
+	}
+}
+
+static void
+drop_task(void *task, void *arg)
+{
+	int *items = arg;
+	--items[(intptr_t)task - 1];
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
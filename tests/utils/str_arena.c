@@ -0,0 +1,98 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() strcmp() */
+
+#include "../../src/utils/str_arena.h"
+
+TEST(strings_are_copied)
+{
+	str_arena_t *const arena = str_arena_create();
+	assert_non_null(arena);
+
+	char buf[] = "name";
+	char *const copy = str_arena_dup(arena, buf);
+	buf[0] = 'N';
+	assert_string_equal("name", copy);
+
+	char *const empty = str_arena_dup(arena, "");
+	assert_string_equal("", empty);
+	assert_string_equal("name", copy);
+
+	str_arena_release(copy);
+	str_arena_release(empty);
+	str_arena_free(arena);
+}
+
+TEST(strings_outlive_arena)
+{
+	str_arena_t *const arena = str_arena_create();
+	char *const a = str_arena_dup(arena, "a");
+	char *const b = str_arena_dup(arena, "b");
+	str_arena_free(arena);
+
+	assert_string_equal("a", a);
+	assert_string_equal("b", b);
+
+	str_arena_release(b);
+	assert_string_equal("a", a);
+	str_arena_release(a);
+}
+
+TEST(strings_span_multiple_chunks)
+{
+	enum { COUNT = 10000 };
+	static char *strs[COUNT];
+
+	str_arena_t *const arena = str_arena_create();
+
+	int i;
+	for(i = 0; i < COUNT; ++i)
+	{
+		char buf[32];
+		snprintf(buf, sizeof(buf), "string-%d", i);
+		strs[i] = str_arena_dup(arena, buf);
+		assert_non_null(strs[i]);
+	}
+
+	/* Release every other string to free nothing but leave gaps. */
+	for(i = 0; i < COUNT; i += 2)
+	{
+		str_arena_release(strs[i]);
+	}
+
+	for(i = 1; i < COUNT; i += 2)
+	{
+		char buf[32];
+		snprintf(buf, sizeof(buf), "string-%d", i);
+		assert_string_equal(buf, strs[i]);
+		str_arena_release(strs[i]);
+	}
+
+	str_arena_free(arena);
+}
+
+TEST(long_strings_are_supported)
+{
+	static char buf[1024*1024];
+	memset(buf, 'x', sizeof(buf) - 1);
+
+	str_arena_t *const arena = str_arena_create();
+	char *const small = str_arena_dup(arena, "small");
+	char *const big = str_arena_dup(arena, buf);
+	assert_int_equal(0, strcmp(buf, big));
+	assert_string_equal("small", small);
+
+	str_arena_release(big);
+	str_arena_release(small);
+	str_arena_free(arena);
+}
+
+TEST(null_pointers_are_ignored)
+{
+	str_arena_release(NULL);
+	str_arena_free(NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
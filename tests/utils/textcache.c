@@ -0,0 +1,154 @@
+#include <stic.h>
+
+#ifndef _WIN32
+#include <sys/time.h> /* timeval utimes() */
+#endif
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/utils/textcache.h"
+
+static void put_line(textcache_t *cache, const char key[], const char line[]);
+static void make_all_old(void);
+
+TEST(null_cache_is_empty)
+{
+	char *items[] = { "line" };
+	strlist_t lines = { .items = items, .nitems = 1 };
+	int complete;
+
+	textcache_put(NULL, "key", &lines, 1);
+	assert_failure(textcache_get(NULL, "key", &lines, &complete));
+	textcache_close(NULL);
+}
+
+TEST(cache_of_zero_size_is_not_created)
+{
+	assert_null(textcache_open(SANDBOX_PATH "/cache", 0));
+}
+
+TEST(values_are_stored_and_retrieved, IF(not_windows))
+{
+	textcache_t *cache = textcache_open(SANDBOX_PATH "/cache", 1024*1024);
+	assert_non_null(cache);
+
+	char *items[] = { "first", "", "third" };
+	strlist_t lines = { .items = items, .nitems = 3 };
+	textcache_put(cache, "key\nwith newline", &lines, 0);
+	textcache_close(cache);
+
+	/* Reopening the cache emulates another instance. */
+	cache = textcache_open(SANDBOX_PATH "/cache", 1024*1024);
+	assert_non_null(cache);
+
+	int complete = 1;
+	assert_failure(textcache_get(cache, "key", &lines, &complete));
+	assert_success(textcache_get(cache, "key\nwith newline", &lines, &complete));
+	assert_false(complete);
+	assert_int_equal(3, lines.nitems);
+	assert_string_equal("first", lines.items[0]);
+	assert_string_equal("", lines.items[1]);
+	assert_string_equal("third", lines.items[2]);
+	free_string_array(lines.items, lines.nitems);
+
+	textcache_close(cache);
+	remove_dir_content(SANDBOX_PATH "/cache");
+	remove_dir(SANDBOX_PATH "/cache");
+}
+
+TEST(least_recently_used_values_are_dropped, IF(not_windows))
+{
+	/* Each value takes up a bit more than a third of the budget. */
+	textcache_t *const cache = textcache_open(SANDBOX_PATH "/cache", 1000);
+	assert_non_null(cache);
+
+	char line[331];
+	memset(line, 'x', sizeof(line) - 1U);
+	line[sizeof(line) - 1U] = '\0';
+
+	put_line(cache, "a", line);
+	put_line(cache, "b", line);
+	make_all_old();
+
+	strlist_t lines;
+	int complete;
+	assert_success(textcache_get(cache, "a", &lines, &complete));
+	free_string_array(lines.items, lines.nitems);
+
+	put_line(cache, "c", line);
+
+	assert_success(textcache_get(cache, "a", &lines, &complete));
+	free_string_array(lines.items, lines.nitems);
+	assert_failure(textcache_get(cache, "b", &lines, &complete));
+	assert_success(textcache_get(cache, "c", &lines, &complete));
+	assert_true(complete);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal(line, lines.items[0]);
+	free_string_array(lines.items, lines.nitems);
+
+	textcache_close(cache);
+	remove_dir_content(SANDBOX_PATH "/cache");
+	remove_dir(SANDBOX_PATH "/cache");
+}
+
+TEST(stale_temporary_files_are_removed, IF(not_windows))
+{
+	textcache_t *const cache = textcache_open(SANDBOX_PATH "/cache", 1000);
+	assert_non_null(cache);
+
+	const char *const stale = SANDBOX_PATH "/cache/"
+	                          "0123456789abcdef0123456789abcdef.1";
+	const char *const fresh = SANDBOX_PATH "/cache/"
+	                          "0123456789abcdef0123456789abcdef.2";
+	create_file(stale);
+	make_all_old();
+	create_file(fresh);
+
+	put_line(cache, "a", "line");
+
+	assert_false(path_exists(stale, NODEREF));
+	assert_true(path_exists(fresh, NODEREF));
+
+	textcache_close(cache);
+	remove_dir_content(SANDBOX_PATH "/cache");
+	remove_dir(SANDBOX_PATH "/cache");
+}
+
+static void
+put_line(textcache_t *cache, const char key[], const char line[])
+{
+	char *items[] = { (char *)line };
+	const strlist_t lines = { .items = items, .nitems = 1 };
+	textcache_put(cache, key, &lines, 1);
+}
+
+/* Moves time of last use of all values of the cache into the past. */
+static void
+make_all_old(void)
+{
+	int len;
+	char **files = list_all_files(SANDBOX_PATH "/cache", &len);
+
+	int i;
+	for(i = 0; i < len; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/%s", SANDBOX_PATH "/cache", files[i]);
+
+#ifndef _WIN32
+		struct timeval tv[2] = { { .tv_sec = 1000 }, { .tv_sec = 1000 } };
+		assert_success(utimes(path, tv));
+#endif
+	}
+
+	free_string_array(files, len);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */